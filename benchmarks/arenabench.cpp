@@ -0,0 +1,89 @@
+/*
+ * File:    arenabench.cpp
+ * Author:  Sam Rappl
+ *
+ * Measures the cost of reading a composition from JSON and then freeing it,
+ * with every object on its own heap allocation (deleted one at a time) and
+ * with everything owned by the composition's Arena.
+ */
+
+#include <vector>
+#include "utilities.h"
+#include "benchmark.h"
+
+const int num_parts = 20;
+const int events_per_part = 5000;
+
+/**
+ * Reads the parts of a composition the way utilities.h did before Arenas:
+ * each event is a separate heap allocation, and the caller must delete them.
+ */
+void legacy_parse_and_free(const nlohmann::json &j) {
+    std::vector<Part*> parts;
+    for (int i = 0; i < j["parts"].size(); i++) {
+        Part *p = new Part();
+        from_json(j.at("parts").at(i), *p);
+        parts.push_back(p);
+    }
+    for (int i = 0; i < parts.size(); i++) {
+        for (auto it = parts[i]->begin(); it != parts[i]->end(); it++) {
+            delete *it;
+        }
+        delete parts[i];
+    }
+}
+
+int main() {
+    Composition source;
+    source.set_initial_tempo(120);
+    std::vector<Part*> parts;
+    std::vector<Note> notes(events_per_part);
+    for (int i = 0; i < events_per_part; i++) {
+        notes[i] = Note(c4 + i % 12, eighth_note);
+    }
+    for (int i = 0; i < num_parts; i++) {
+        Part *p = new Part("part" + std::to_string(i));
+        for (int k = 0; k < events_per_part; k++) {
+            p->append_note(&notes[k]);
+        }
+        parts.push_back(p);
+        source.add_part(*p);
+    }
+    nlohmann::json j;
+    to_json(j, source);
+
+    // Warm up the allocator so neither side pays for first touching memory
+    legacy_parse_and_free(j);
+
+    report_header("new/delete", "Arena");
+    int num_notes = num_parts * events_per_part;
+    double before = time_us(20, [&]() {
+        std::vector<Note*> made(num_notes);
+        for (int i = 0; i < num_notes; i++) {
+            made[i] = new Note(c4, eighth_note);
+        }
+        for (int i = 0; i < num_notes; i++) {
+            delete made[i];
+        }
+    });
+    double after = time_us(20, [&]() {
+        Arena arena;
+        for (int i = 0; i < num_notes; i++) {
+            do_not_optimize(arena.make<Note>(c4, eighth_note));
+        }
+    });
+    report("allocate + free 100k notes", before, after);
+
+    // Reading the JSON DOM dominates this measurement
+    before = time_us(5, [&]() { legacy_parse_and_free(j); });
+    after = time_us(5, [&]() {
+        Composition comp;
+        from_json(j, comp);
+    });
+    report("parse + free 100k notes", before, after);
+
+    for (int i = 0; i < parts.size(); i++) {
+        delete parts[i];
+    }
+    return 0;
+}
@@ -0,0 +1,59 @@
+/*
+ * File:    benchmark.h
+ * Author:  Sam Rappl
+ *
+ */
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+/**
+ * Runs the given function the given number of times and returns the average
+ * wall time of one run in microseconds.
+ *
+ * @param runs The number of times to run the function.
+ * @param fn The function to time.
+ * @return The average time of one run in microseconds.
+ */
+template <typename F>
+double time_us(int runs, F fn) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < runs; i++) {
+        fn();
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::micro>(end - start).count() / runs;
+}
+
+/**
+ * Prints one line of a benchmark comparison.
+ *
+ * @param name The name of the measurement.
+ * @param before The time taken by the old code path.
+ * @param after The time taken by the new code path.
+ */
+inline void report(std::string name, double before, double after) {
+    std::printf("%-40s %12.1f us %12.1f us %8.2fx\n", name.c_str(), before, after,
+            after > 0 ? before / after : 0.0);
+}
+
+/**
+ * Prints the header of a benchmark comparison table.
+ */
+inline void report_header(std::string before, std::string after) {
+    std::printf("%-40s %15s %15s %9s\n", "", before.c_str(), after.c_str(), "speedup");
+}
+
+/**
+ * Keeps the compiler from optimizing away a computed value.
+ */
+template <typename T>
+void do_not_optimize(const T &value) {
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+#endif /* BENCHMARK_H */
@@ -0,0 +1,105 @@
+/*
+ * File:    binaryloadbench.cpp
+ * Author:  Sam Rappl
+ *
+ * Compares the time to load a large Composition from a JSON file, with the
+ * nlohmann::json document and with the SAX reader, against loading it from a
+ * binary composition file. Also times mapping the binary file and walking its
+ * events in place, which is all a job that only reads the events needs.
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+#include "utilities.h"
+#include "sax_reader.h"
+#include "binary_format.h"
+#include "benchmark.h"
+
+const int num_parts = 64;
+const int notes_per_part = 4000;
+const int runs = 5;
+
+void build_composition(Composition &comp) {
+    ArenaScope scope(&comp.get_arena());
+    for (int i = 0; i < num_parts; i++) {
+        Part *p = arena_make<Part>("part" + std::to_string(i));
+        p->append_dynamic(arena_make<Dynamic>(mf));
+        for (int k = 0; k < notes_per_part; k++) {
+            if (k % 4 == 3) {
+                p->append_chord(arena_make<Chord>(c_major_chord, quarter_note));
+            }
+            else {
+                Note *n = arena_make<Note>(c3 + k % 24, eighth_note);
+                n->set_staccato(k % 2 == 0);
+                p->append_note(n);
+            }
+        }
+        comp.add_part(*p);
+    }
+}
+
+std::string temp_path() {
+    char path[] = "/tmp/binaryloadbenchXXXXXX";
+    close(mkstemp(path));
+    return path;
+}
+
+double file_mb(const std::string &path) {
+    std::ifstream in(path.c_str(), std::ios::ate | std::ios::binary);
+    return in.tellg() / (1024.0 * 1024.0);
+}
+
+int main() {
+    std::string json_path = temp_path();
+    std::string binary_path = temp_path();
+    {
+        Composition comp;
+        build_composition(comp);
+        std::ofstream out(json_path.c_str());
+        write_json(out, comp);
+        out.close();
+        write_binary(binary_path, comp);
+    }
+    std::printf("%d parts x %d events: %.1f MB of JSON, %.1f MB binary\n\n", num_parts,
+            notes_per_part, file_mb(json_path), file_mb(binary_path));
+
+    double dom = time_us(runs, [&]() {
+        std::ifstream in(json_path.c_str());
+        nlohmann::json j = nlohmann::json::parse(in);
+        Composition comp;
+        from_json(j, comp);
+        do_not_optimize(comp);
+    });
+    double sax = time_us(runs, [&]() {
+        std::ifstream in(json_path.c_str());
+        Composition comp;
+        sax_from_json(in, comp);
+        do_not_optimize(comp);
+    });
+    double binary = time_us(runs, [&]() {
+        Composition comp;
+        read_binary(binary_path, comp);
+        do_not_optimize(comp);
+    });
+    double mapped = time_us(runs, [&]() {
+        BinaryComposition bin(binary_path);
+        long total = 0;
+        for (int i = 0; i < bin.get_num_parts(); i++) {
+            BinaryPartView part = bin.get_part(i);
+            for (const BinaryEvent *e = part.begin(); e != part.end(); e++) {
+                total += e->duration;
+            }
+        }
+        do_not_optimize(total);
+    });
+
+    report_header("json", "binary");
+    report("load composition (dom json)", dom, binary);
+    report("load composition (sax json)", sax, binary);
+    report("scan events (dom json vs mmap view)", dom, mapped);
+    std::remove(json_path.c_str());
+    std::remove(binary_path.c_str());
+    return 0;
+}
@@ -0,0 +1,99 @@
+/*
+ * File:    checkpointbench.cpp
+ * Author:  Sam Rappl
+ *
+ * Times executeShell over a 40 packet tree without a checkpoint and with one
+ * saved after each packet, with packets which return at once, so that the
+ * shell's own work is all that is measured, and with packets which take 5 ms.
+ * The shell writes each checkpoint to a string; a CheckpointWriter's thread
+ * writes it to disk, so it also counts how many of the saves reached the disk.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+#include "utilities.h"
+#include "benchmark.h"
+
+const int num_packets = 40;
+static int packet_ms = 0;
+
+std::string execute(std::string path, std::string mode, std::string input) {
+    if (mode == "driver") {
+        Composition comp;
+        return to_json_string(comp);
+    }
+    if (mode == "play") {
+        return "";
+    }
+    if (mode == "control" || mode == "finalcontrol") {
+        return input;
+    }
+    if (packet_ms > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(packet_ms));
+    }
+    Arena arena;
+    ArenaScope scope(&arena);
+    Part *p = arena_make<Part>(path);
+    for (int k = 0; k < 50; k++) {
+        p->append_note(arena_make<Note>(c4 + k % 12, eighth_note));
+    }
+    return to_json_string(*p);
+}
+
+double run_shell(const std::string &checkpoint_path, int runs) {
+    return time_us(runs, [&]() {
+        std::vector<PacketPart> nodes(num_packets);
+        for (int i = 0; i < num_packets; i++) {
+            nodes[i].set_packet_path("/packet" + std::to_string(i));
+            nodes[i].set_mode("melody");
+            if (i > 0) {
+                nodes[(i - 1) / 3].append_child(&nodes[i]);
+            }
+        }
+        ShellOptions options;
+        options.checkpoint_path = checkpoint_path;
+        do_not_optimize(executeShell(execute, &nodes[0], "driver", "control", options));
+    });
+}
+
+/**
+ * Counts the checkpoints written when 40 compositions are saved as fast as the
+ * shell can write them to strings.
+ */
+int count_written(const std::string &path) {
+    Composition comp;
+    ArenaScope scope(&comp.get_arena());
+    CheckpointWriter writer(path);
+    for (int i = 0; i < num_packets; i++) {
+        Part *p = arena_make<Part>("/packet" + std::to_string(i));
+        for (int k = 0; k < 50; k++) {
+            p->append_note(arena_make<Note>(c4 + k % 12, eighth_note));
+        }
+        comp.add_part(*p);
+        writer.save(comp);
+    }
+    writer.flush();
+    return writer.get_written();
+}
+
+int main() {
+    char dir[] = "/tmp/checkpointbenchXXXXXX";
+    if (mkdtemp(dir) == NULL) {
+        std::printf("Could not make a temporary directory.\n");
+        return 1;
+    }
+    std::string path = std::string(dir) + "/checkpoint.json";
+    std::printf("%d packets, checkpoint in %s\n\n", num_packets, dir);
+    run_shell("", 1);
+    report_header("no checkpoint", "checkpoint");
+    report("packets return at once", run_shell("", 10), run_shell(path, 10));
+    packet_ms = 5;
+    report("packets take 5 ms", run_shell("", 3), run_shell(path, 3));
+    std::printf("\n%d of %d saves written to disk\n", count_written(path), num_packets);
+    std::system((std::string("rm -rf ") + dir).c_str());
+    return 0;
+}
@@ -0,0 +1,175 @@
+/*
+ * File:    compositionbench.cpp
+ * Author:  Sam Rappl
+ *
+ * Compares building a Composition with 10k Parts and PatternSegments when
+ * names are found with a linear scan against the name indexes in Composition,
+ * and building and searching a timeline of 10k tempo changes with linear scans
+ * against the sorted metrics timeline.
+ */
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "composition.h"
+#include "benchmark.h"
+
+const int num_parts = 10000;
+const int num_tempo_changes = 10000;
+
+/**
+ * Adds a Part unless one with the same name is in the list, scanning the list
+ * the way Composition::add_part used to.
+ */
+bool scan_add_part(std::vector<Part*> &parts, Part &p) {
+    for (int i = 0; i < parts.size(); i++) {
+        if (parts[i]->get_name() == p.get_name()) {
+            return false;
+        }
+    }
+    parts.push_back(&p);
+    return true;
+}
+
+/**
+ * Finds the PatternSegment with the given name by scanning the list.
+ */
+PatternSegment* scan_get_pattern_segment(std::vector<PatternSegment*> &segments,
+        std::string name) {
+    for (int i = 0; i < segments.size(); i++) {
+        if (segments[i]->get_name() == name) {
+            return segments[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Inserts a tempo change into a list of composition metrics sorted by position,
+ * scanning the list the way Composition::add_tempo_change used to.
+ */
+void scan_add_tempo_change(std::vector<CompositionMetrics*> &metrics,
+        CompositionMetrics *change) {
+    for (int i = 0; i < metrics.size(); i++) {
+        if (metrics[i]->position == change->position) {
+            metrics[i]->tempo = change->tempo;
+            return;
+        }
+    }
+    for (std::vector<CompositionMetrics*>::iterator it = metrics.begin();
+            it != metrics.end(); ++it) {
+        if ((*it)->position > change->position) {
+            metrics.insert(it, change);
+            return;
+        }
+    }
+    metrics.push_back(change);
+}
+
+/**
+ * Finds the composition metrics in effect at the given position by scanning
+ * backwards, the way Composition::get_composition_metrics_at_position used to.
+ */
+CompositionMetrics* scan_metrics_at(std::vector<CompositionMetrics*> &metrics, int pos) {
+    for (int i = metrics.size() - 1; i >= 0; i--) {
+        if (pos >= metrics[i]->position) {
+            return metrics[i];
+        }
+    }
+    return NULL;
+}
+
+int main() {
+    std::vector<Part> parts;
+    std::vector<PatternSegment> segments;
+    std::vector<std::string> names;
+    for (int i = 0; i < num_parts; i++) {
+        names.push_back("instrument " + std::to_string(i));
+        parts.push_back(Part(names[i]));
+        segments.push_back(PatternSegment(names[i], whole_note));
+    }
+
+    report_header("linear scan", "hash index");
+    double before = time_us(1, [&]() {
+        std::vector<Part*> added;
+        std::vector<PatternSegment*> registered;
+        std::vector<std::string> pattern;
+        for (int i = 0; i < num_parts; i++) {
+            scan_add_part(added, parts[i]);
+            if (scan_get_pattern_segment(registered, names[i]) == NULL) {
+                registered.push_back(&segments[i]);
+            }
+        }
+        for (int i = 0; i < num_parts; i++) {
+            if (scan_get_pattern_segment(registered, names[i]) != NULL) {
+                pattern.push_back(names[i]);
+            }
+        }
+        do_not_optimize(pattern);
+    });
+    double after = time_us(10, [&]() {
+        Composition comp;
+        for (int i = 0; i < num_parts; i++) {
+            comp.add_part(parts[i]);
+            comp.register_pattern_segment(&segments[i]);
+        }
+        for (int i = 0; i < num_parts; i++) {
+            comp.add_to_pattern(names[i]);
+        }
+        do_not_optimize(comp);
+    });
+    report("build composition with 10k parts", before, after);
+
+    // Tempo changes at random positions, as rubato automation produces them.
+    std::srand(1);
+    std::vector<CompositionMetrics> changes(num_tempo_changes);
+    std::vector<int> lookups(num_tempo_changes);
+    for (int i = 0; i < num_tempo_changes; i++) {
+        changes[i].position = 1 + std::rand() % (num_tempo_changes * sixteenth_note);
+        changes[i].tempo = 60 + i % 2;
+        lookups[i] = std::rand() % (num_tempo_changes * sixteenth_note);
+    }
+    std::vector<CompositionMetrics*> scanned;
+    CompositionMetrics first;
+    report_header("linear scan", "timeline");
+    before = time_us(1, [&]() {
+        scanned.assign(1, &first);
+        for (int i = 0; i < num_tempo_changes; i++) {
+            scan_add_tempo_change(scanned, &changes[i]);
+        }
+    });
+    Composition timed;
+    after = time_us(1, [&]() {
+        timed.set_initial_tempo(80);
+        for (int i = 0; i < num_tempo_changes; i++) {
+            timed.add_tempo_change(changes[i].tempo, changes[i].position);
+        }
+    });
+    report("add 10k tempo changes one at a time", before, after);
+    after = time_us(10, [&]() {
+        Composition bulk;
+        std::vector<CompositionMetrics*> batch(1, &first);
+        for (int i = 0; i < num_tempo_changes; i++) {
+            batch.push_back(&changes[i]);
+        }
+        bulk.add_all_composition_metrics(batch);
+        do_not_optimize(bulk);
+    });
+    report("add 10k tempo changes in bulk", before, after);
+    before = time_us(1, [&]() {
+        long sum = 0;
+        for (int i = 0; i < num_tempo_changes; i++) {
+            sum += scan_metrics_at(scanned, lookups[i])->tempo;
+        }
+        do_not_optimize(sum);
+    });
+    after = time_us(10, [&]() {
+        long sum = 0;
+        for (int i = 0; i < num_tempo_changes; i++) {
+            sum += timed.get_composition_metrics_at_position(lookups[i])->tempo;
+        }
+        do_not_optimize(sum);
+    });
+    report("10k metrics lookups", before, after);
+    return 0;
+}
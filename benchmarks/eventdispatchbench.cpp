@@ -0,0 +1,107 @@
+/*
+ * File:    eventdispatchbench.cpp
+ * Author:  Sam Rappl
+ *
+ * Compares finding an event's type through dynamic_cast with the EventKind
+ * tag, on position queries and on JSON serialization of a large Part.
+ */
+
+#include <vector>
+#include "utilities.h"
+#include "benchmark.h"
+
+const int num_events = 100000;
+const int num_queries = 200;
+
+/**
+ * The position walk Part used before events were tagged with their kind.
+ */
+int legacy_position_of(Part &part, std::vector<Event*>::iterator it) {
+    int pos = 0;
+    while (it != part.begin()) {
+        it--;
+        Event *e = *it;
+        Note *n = nullptr;
+        Chord *c = nullptr;
+        if ((n = dynamic_cast<Note*>(e))) {
+            pos += n->get_duration();
+        }
+        else if ((c = dynamic_cast<Chord*>(e))) {
+            pos += c->get_duration();
+        }
+    }
+    return pos;
+}
+
+/**
+ * The Part serializer used before events were tagged with their kind.
+ */
+void legacy_to_json(nlohmann::json &j, const Part &part) {
+    j = nlohmann::json{
+        {"name", part.get_name()},
+        {"events", nlohmann::json::array()},
+        {"length", part.get_length()}
+    };
+    std::vector<Event*>::const_iterator it;
+    for (it = part.const_begin(); it != part.const_end(); it++) {
+        Event *e = *it;
+        Note *n = nullptr;
+        Chord *c = nullptr;
+        Dynamic *d = nullptr;
+        if ((n = dynamic_cast<Note*>(e))) {
+            j["events"].push_back(*n);
+        }
+        else if ((c = dynamic_cast<Chord*>(e))) {
+            j["events"].push_back(*c);
+        }
+        else if ((d = dynamic_cast<Dynamic*>(e))) {
+            j["events"].push_back(*d);
+        }
+    }
+}
+
+int main() {
+    std::vector<Note> notes(num_events);
+    std::vector<Chord> chords(num_events / 8);
+    std::vector<Dynamic> dynamics(num_events / 16);
+    Part part("bench");
+    for (int i = 0; i < num_events; i++) {
+        if (i % 16 == 0) {
+            part.append_dynamic(&dynamics[i / 16]);
+        }
+        if (i % 8 == 0) {
+            part.append_chord(&chords[i / 8]);
+        }
+        else {
+            notes[i] = Note(c4 + i % 24, eighth_note);
+            part.append_note(&notes[i]);
+        }
+    }
+
+    int stride = part.get_num_events() / num_queries;
+    report_header("dynamic_cast", "EventKind");
+    double before = time_us(1, [&]() {
+        for (int q = 0; q < num_queries; q++) {
+            do_not_optimize(legacy_position_of(part, part.begin() + q * stride));
+        }
+    });
+    double after = time_us(1, [&]() {
+        for (int q = 0; q < num_queries; q++) {
+            do_not_optimize(part.get_position_of(part.begin() + q * stride));
+        }
+    });
+    report("get_position_of x200", before, after);
+
+    before = time_us(5, [&]() {
+        nlohmann::json j;
+        legacy_to_json(j, part);
+        do_not_optimize(j);
+    });
+    after = time_us(5, [&]() {
+        nlohmann::json j;
+        to_json(j, part);
+        do_not_optimize(j);
+    });
+    report("to_json(Part)", before, after);
+    return 0;
+}
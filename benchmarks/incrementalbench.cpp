@@ -0,0 +1,92 @@
+/*
+ * File:    incrementalbench.cpp
+ * Author:  Sam Rappl
+ *
+ * Runs executeShell over a 40 packet tree after changing one node's mode, by
+ * clearing every node's execution and running the whole tree again, and by
+ * running only the dirty nodes, the changed node and its descendants, while
+ * reusing the Parts of the rest. Each packet takes 5 ms and the control
+ * module 1 ms.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+#include "utilities.h"
+#include "benchmark.h"
+
+const int num_packets = 40;
+const int packet_ms = 5;
+const int control_ms = 1;
+
+std::string execute(std::string path, std::string mode, std::string input) {
+    if (mode == "driver") {
+        Composition comp;
+        return to_json_string(comp);
+    }
+    if (mode == "play") {
+        return "";
+    }
+    if (mode == "control" || mode == "finalcontrol") {
+        std::this_thread::sleep_for(std::chrono::milliseconds(control_ms));
+        return input;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(packet_ms));
+    Arena arena;
+    ArenaScope scope(&arena);
+    Part *p = arena_make<Part>(path);
+    for (int k = 0; k < 50; k++) {
+        p->append_note(arena_make<Note>(c4 + k % 12, eighth_note));
+    }
+    return to_json_string(*p);
+}
+
+void clear_all(PacketPart *node) {
+    node->clear_execution();
+    for (int i = 0; i < node->get_children().size(); i++) {
+        clear_all(node->get_children()[i]);
+    }
+}
+
+/**
+ * Runs the tree once, changes the mode of one node and times running it again.
+ */
+double rerun(int changed, bool incremental, int &dirty) {
+    std::vector<PacketPart> nodes(num_packets);
+    for (int i = 0; i < num_packets; i++) {
+        nodes[i].set_packet_path("/packet" + std::to_string(i));
+        nodes[i].set_mode("melody");
+        if (i > 0) {
+            nodes[(i - 1) / 3].append_child(&nodes[i]);
+        }
+    }
+    executeShell(execute, &nodes[0], "driver", "control");
+    nodes[changed].set_mode("harmony");
+    if (!incremental) {
+        clear_all(&nodes[0]);
+    }
+    dirty = nodes[0].get_dirty().size();
+    return time_us(1, [&]() {
+        do_not_optimize(executeShell(execute, &nodes[0], "driver", "control"));
+    });
+}
+
+int main() {
+    std::printf("%d packets of %d ms, control module %d ms\n\n", num_packets, packet_ms,
+            control_ms);
+    report_header("whole tree", "dirty nodes");
+    int changed[] = { 39, 1, 0 };
+    const char *names[] = { "changed a leaf", "changed a child of the root",
+            "changed the root" };
+    for (int i = 0; i < 3; i++) {
+        int all;
+        int dirty;
+        double before = rerun(changed[i], false, all);
+        double after = rerun(changed[i], true, dirty);
+        report(names[i], before, after);
+        std::printf("%-40s %15d %15d packets run\n", "", all, dirty);
+    }
+    return 0;
+}
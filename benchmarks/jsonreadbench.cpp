@@ -0,0 +1,146 @@
+/*
+ * File:    jsonreadbench.cpp
+ * Author:  Sam Rappl
+ *
+ * Compares reading a large Composition from a JSON file by parsing it into a
+ * nlohmann::json document and calling from_json against streaming it through
+ * sax_from_json. Peak memory is measured by reading the file once in a fresh
+ * child process for each reader, so neither reader sees the other's heap.
+ *
+ * Usage: jsonreadbench [dom|sax <file>]
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+#include "utilities.h"
+#include "sax_reader.h"
+#include "benchmark.h"
+
+const int num_parts = 64;
+const int notes_per_part = 4000;
+const int runs = 3;
+
+/**
+ * Writes a composition with num_parts Parts of notes_per_part notes and chords
+ * to the given file.
+ */
+void write_composition(const char *path) {
+    Composition comp;
+    ArenaScope scope(&comp.get_arena());
+    for (int i = 0; i < num_parts; i++) {
+        Part *p = arena_make<Part>("part" + std::to_string(i));
+        p->append_dynamic(arena_make<Dynamic>(mf));
+        for (int k = 0; k < notes_per_part; k++) {
+            if (k % 4 == 3) {
+                p->append_chord(arena_make<Chord>(c_major_chord, quarter_note));
+            }
+            else {
+                Note *n = arena_make<Note>(c3 + k % 24, eighth_note);
+                n->set_staccato(k % 2 == 0);
+                p->append_note(n);
+            }
+        }
+        comp.add_part(*p);
+    }
+    nlohmann::json j;
+    to_json(j, comp);
+    std::ofstream out(path);
+    out << j;
+}
+
+void read_dom(const char *path) {
+    std::ifstream in(path);
+    nlohmann::json j = nlohmann::json::parse(in);
+    Composition comp;
+    from_json(j, comp);
+    do_not_optimize(comp);
+}
+
+void read_sax(const char *path) {
+    std::ifstream in(path);
+    Composition comp;
+    sax_from_json(in, comp);
+    do_not_optimize(comp);
+}
+
+/**
+ * Returns the peak resident set size of this process in kilobytes, as reported
+ * by the VmHWM line of /proc/self/status.
+ */
+long own_peak_rss_kb() {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, 6, "VmHWM:") == 0) {
+            return std::atol(line.c_str() + 6);
+        }
+    }
+    return 0;
+}
+
+/**
+ * Runs this program again to read the file once with the given reader and
+ * returns the peak resident set size of that process in kilobytes. The child's
+ * own high water mark is used because ru_maxrss is carried over from the
+ * parent through fork and exec.
+ */
+long peak_rss_kb(const char *mode, const char *path) {
+    char self[4096];
+    ssize_t len = readlink("/proc/self/exe", self, sizeof(self) - 1);
+    if (len < 0) {
+        return 0;
+    }
+    self[len] = '\0';
+    std::string command = std::string(self) + " " + mode + " " + path;
+    FILE *child = popen(command.c_str(), "r");
+    long kb = 0;
+    if (child == NULL || std::fscanf(child, "%ld", &kb) != 1) {
+        std::fprintf(stderr, "%s reader failed\n", mode);
+    }
+    if (child != NULL) {
+        pclose(child);
+    }
+    return kb;
+}
+
+int main(int argc, char **argv) {
+    if (argc == 3) {
+        if (std::strcmp(argv[1], "dom") == 0) {
+            read_dom(argv[2]);
+        }
+        else {
+            read_sax(argv[2]);
+        }
+        std::printf("%ld\n", own_peak_rss_kb());
+        return 0;
+    }
+    char path[] = "/tmp/jsonreadbenchXXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        std::perror("mkstemp");
+        return 1;
+    }
+    close(fd);
+    write_composition(path);
+    std::ifstream in(path, std::ios::ate);
+    double mb = in.tellg() / (1024.0 * 1024.0);
+    std::printf("%d parts x %d events, %.1f MB of JSON\n\n", num_parts, notes_per_part, mb);
+
+    double dom = time_us(runs, [&]() { read_dom(path); });
+    double sax = time_us(runs, [&]() { read_sax(path); });
+    report_header("dom", "sax");
+    report("read composition", dom, sax);
+    std::printf("%-40s %12.1f MB/s %10.1f MB/s\n", "throughput", mb / (dom / 1e6),
+            mb / (sax / 1e6));
+
+    long dom_rss = peak_rss_kb("dom", path);
+    long sax_rss = peak_rss_kb("sax", path);
+    std::printf("%-40s %12ld KB %12ld KB %8.2fx\n", "peak RSS", dom_rss, sax_rss,
+            sax_rss > 0 ? (double)dom_rss / sax_rss : 0.0);
+    std::remove(path);
+    return 0;
+}
@@ -0,0 +1,126 @@
+/*
+ * File:    jsonwritebench.cpp
+ * Author:  Sam Rappl
+ *
+ * Compares writing a large Composition as JSON text by building a
+ * nlohmann::json document with to_json and calling dump against streaming it
+ * with to_json_string, and counts the heap allocations made by each.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include "utilities.h"
+#include "benchmark.h"
+
+const int num_parts = 64;
+const int notes_per_part = 4000;
+const int runs = 5;
+
+/** The number of calls to operator new so far. */
+static long allocations = 0;
+
+// Every form of operator new and delete is replaced, so that memory is always
+// freed by the same allocator that handed it out. They are kept out of line so
+// the compiler does not pair a new expression with the free inside them.
+
+__attribute__((noinline)) void* operator new(std::size_t size) {
+    allocations++;
+    void *p = std::malloc(size == 0 ? 1 : size);
+    if (p == NULL) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+__attribute__((noinline)) void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+__attribute__((noinline)) void operator delete(void *p) noexcept { std::free(p); }
+__attribute__((noinline)) void operator delete[](void *p) noexcept { operator delete(p); }
+__attribute__((noinline)) void operator delete(void *p, std::size_t) noexcept { operator delete(p); }
+__attribute__((noinline)) void operator delete[](void *p, std::size_t) noexcept { operator delete(p); }
+
+#ifdef __cpp_aligned_new
+__attribute__((noinline)) void* operator new(std::size_t size, std::align_val_t align) {
+    allocations++;
+    std::size_t a = static_cast<std::size_t>(align);
+    void *p = std::aligned_alloc(a, size == 0 ? a : (size + a - 1) / a * a);
+    if (p == NULL) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+__attribute__((noinline)) void* operator new[](std::size_t size, std::align_val_t align) {
+    return operator new(size, align);
+}
+
+__attribute__((noinline)) void operator delete(void *p, std::align_val_t) noexcept { std::free(p); }
+__attribute__((noinline)) void operator delete[](void *p, std::align_val_t) noexcept { std::free(p); }
+__attribute__((noinline)) void operator delete(void *p, std::size_t, std::align_val_t) noexcept {
+    std::free(p);
+}
+__attribute__((noinline)) void operator delete[](void *p, std::size_t, std::align_val_t) noexcept {
+    std::free(p);
+}
+#endif
+
+/**
+ * Fills the given composition with num_parts Parts of notes_per_part notes and
+ * chords.
+ */
+void build_composition(Composition &comp) {
+    ArenaScope scope(&comp.get_arena());
+    for (int i = 0; i < num_parts; i++) {
+        Part *p = arena_make<Part>("part" + std::to_string(i));
+        p->append_dynamic(arena_make<Dynamic>(mf));
+        for (int k = 0; k < notes_per_part; k++) {
+            if (k % 4 == 3) {
+                p->append_chord(arena_make<Chord>(c_major_chord, quarter_note));
+            }
+            else {
+                Note *n = arena_make<Note>(c3 + k % 24, eighth_note);
+                n->set_staccato(k % 2 == 0);
+                p->append_note(n);
+            }
+        }
+        comp.add_part(*p);
+    }
+}
+
+std::string write_dom(const Composition &comp) {
+    nlohmann::json j;
+    to_json(j, comp);
+    return j.dump();
+}
+
+int main() {
+    Composition comp;
+    build_composition(comp);
+    int num_events = num_parts * (notes_per_part + 1);
+    std::string text = to_json_string(comp);
+    double mb = text.size() / (1024.0 * 1024.0);
+    std::printf("%d parts x %d events, %.1f MB of JSON, output %s\n\n", num_parts,
+            notes_per_part, mb, write_dom(comp) == text ? "identical" : "DIFFERS");
+
+    double dom = time_us(runs, [&]() { do_not_optimize(write_dom(comp)); });
+    double stream = time_us(runs, [&]() { do_not_optimize(to_json_string(comp)); });
+    report_header("dom + dump", "streaming");
+    report("write composition", dom, stream);
+    std::printf("%-40s %12.1f MB/s %10.1f MB/s\n", "throughput", mb / (dom / 1e6),
+            mb / (stream / 1e6));
+
+    long before = allocations;
+    do_not_optimize(write_dom(comp));
+    long dom_allocations = allocations - before;
+    before = allocations;
+    do_not_optimize(to_json_string(comp));
+    long stream_allocations = allocations - before;
+    std::printf("%-40s %15ld %15ld\n", "allocations", dom_allocations, stream_allocations);
+    std::printf("%-40s %15.2f %15.4f\n", "allocations per event",
+            (double)dom_allocations / num_events, (double)stream_allocations / num_events);
+    return 0;
+}
@@ -0,0 +1,113 @@
+/*
+ * File:    keybench.cpp
+ * Author:  Sam Rappl
+ *
+ * Compares the scale queries of Key, which read its pitch class mask and
+ * lookup tables, with the loops over the scale they replaced.
+ */
+
+#include <vector>
+#include "composition_metrics.h"
+#include "benchmark.h"
+
+const int num_queries = 10000000;
+
+bool loop_is_in_scale(const std::vector<int> &scale, int pitch) {
+    int pmod = pitch % 12;
+    for (int i = 0; i < scale.size(); i++) {
+        if (pmod == scale[i] % 12) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int loop_position_in_scale(const std::vector<int> &scale, int pitch) {
+    int pmod = pitch % 12;
+    for (int i = 0; i < scale.size(); i++) {
+        if (pmod == scale[i] % 12) {
+            return i + 1;
+        }
+    }
+    return -1;
+}
+
+int loop_next_pitch_in_scale(const std::vector<int> &scale, int pitch) {
+    int num_octaves = pitch / 12;
+    int pmod = pitch % 12;
+    int index_of_next = -1;
+    for (int i = 0; i < scale.size(); i++) {
+        if (pmod == scale[i] % 12) {
+            index_of_next = i+1;
+        }
+    }
+    if (index_of_next == -1) {
+        for (int i = 0; i < scale.size() - 1; i++) {
+            if (pmod > scale[i] % 12 && pmod < scale[i+1] % 12) {
+                index_of_next = i + 1;
+            }
+        }
+    }
+    return scale[index_of_next] % 12 + num_octaves * 12;
+}
+
+int main() {
+    Key key(c3, lydian_intervals);
+    std::vector<int> scale = key.get_scale();
+    // Skip the tonic, which the old next_pitch_in_scale read out of bounds for.
+    std::vector<int> pitches;
+    for (int i = 0; pitches.size() < 4096; i++) {
+        int pitch = 24 + (i * 7) % 80;
+        if (pitch % 12 != 0) {
+            pitches.push_back(pitch);
+        }
+    }
+
+    report_header("loop", "tables");
+    double before = time_us(1, [&]() {
+        long sum = 0;
+        for (int i = 0; i < num_queries; i++) {
+            sum += loop_is_in_scale(scale, pitches[i & 4095]);
+        }
+        do_not_optimize(sum);
+    });
+    double after = time_us(1, [&]() {
+        long sum = 0;
+        for (int i = 0; i < num_queries; i++) {
+            sum += key.is_in_scale(pitches[i & 4095]);
+        }
+        do_not_optimize(sum);
+    });
+    report("10M is_in_scale", before, after);
+    before = time_us(1, [&]() {
+        long sum = 0;
+        for (int i = 0; i < num_queries; i++) {
+            sum += loop_position_in_scale(scale, pitches[i & 4095]);
+        }
+        do_not_optimize(sum);
+    });
+    after = time_us(1, [&]() {
+        long sum = 0;
+        for (int i = 0; i < num_queries; i++) {
+            sum += key.position_in_scale(pitches[i & 4095]);
+        }
+        do_not_optimize(sum);
+    });
+    report("10M position_in_scale", before, after);
+    before = time_us(1, [&]() {
+        long sum = 0;
+        for (int i = 0; i < num_queries; i++) {
+            sum += loop_next_pitch_in_scale(scale, pitches[i & 4095]);
+        }
+        do_not_optimize(sum);
+    });
+    after = time_us(1, [&]() {
+        long sum = 0;
+        for (int i = 0; i < num_queries; i++) {
+            sum += key.next_pitch_in_scale(pitches[i & 4095]);
+        }
+        do_not_optimize(sum);
+    });
+    report("10M next_pitch_in_scale", before, after);
+    return 0;
+}
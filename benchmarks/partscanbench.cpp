@@ -0,0 +1,63 @@
+/*
+ * File:    partscanbench.cpp
+ * Author:  Sam Rappl
+ *
+ * Compares finding the Dynamics of every note in a Part by walking back from
+ * each note with the Dynamic index.
+ */
+
+#include <cstdio>
+#include <vector>
+#include "part.h"
+#include "benchmark.h"
+
+const int num_sparse_notes = 20000;
+
+/**
+ * Finds the Dynamic in effect at an event by walking back to the nearest
+ * Dynamic, the way Part::get_current_dynamics used to.
+ */
+Dynamic walk_back_to_dynamics(Part &part, std::vector<Event*>::iterator it) {
+    while (true) {
+        if ((*it)->is_dynamic()) {
+            return *static_cast<Dynamic*>(*it);
+        }
+        if (it == part.begin()) {
+            return Dynamic();
+        }
+        it--;
+    }
+}
+
+int main() {
+    // One Dynamic at the start, so every walk back goes to the beginning.
+    Part sparse("sparse");
+    Dynamic loud(f);
+    std::vector<Note> sparse_notes(num_sparse_notes, Note(c4, eighth_note));
+    sparse.append_dynamic(&loud);
+    for (int i = 0; i < num_sparse_notes; i++) {
+        sparse.append_note(&sparse_notes[i]);
+    }
+    report_header("walk back", "Dynamic index");
+    double before = time_us(1, [&]() {
+        long sum = 0;
+        for (auto it = sparse.begin(); it != sparse.end(); it++) {
+            sum += walk_back_to_dynamics(sparse, it).volume;
+        }
+        do_not_optimize(sum);
+    });
+    double search = time_us(10, [&]() {
+        long sum = 0;
+        for (auto it = sparse.begin(); it != sparse.end(); it++) {
+            sum += sparse.get_current_dynamics(it).volume;
+        }
+        do_not_optimize(sum);
+    });
+    double after = time_us(10, [&]() {
+        std::vector<Dynamic> all = sparse.get_all_current_dynamics();
+        do_not_optimize(all);
+    });
+    report("dynamics of 20k notes (per note)", before, search);
+    report("dynamics of 20k notes (batch)", before, after);
+    return 0;
+}
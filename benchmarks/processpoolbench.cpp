@@ -0,0 +1,74 @@
+/*
+ * File:    processpoolbench.cpp
+ * Author:  Sam Rappl
+ *
+ * Runs executeShell over a 20 packet tree with every packet and module a
+ * stand-in packet process (tools/standinpacket), started cold for each call as
+ * a fresh process, and kept warm in a ProcessPool. Each stand-in waits before
+ * serving, as loading an interpreter or model does, and a couple of
+ * milliseconds per call. The warm pool is timed on its first run, which
+ * starts the workers, and on a second run which reuses them.
+ */
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "utilities.h"
+#include "benchmark.h"
+
+#ifndef STANDIN_PACKET
+#define STANDIN_PACKET "../tools/standinpacket"
+#endif
+
+const int num_packets = 20;
+const char *work_ms = "2";
+
+static std::string startup_ms = "0";
+static ProcessPool *warm = NULL;
+
+std::vector<std::string> command(const std::string &path) {
+    return std::vector<std::string>{ STANDIN_PACKET, "--startup-ms", startup_ms, "--work-ms",
+            work_ms, path };
+}
+
+/** Starts a new stand-in process for each call. */
+std::string cold_execute(std::string path, std::string mode, std::string input) {
+    ProcessPool pool(command);
+    return pool.execute(path, mode, input);
+}
+
+std::string warm_execute(std::string path, std::string mode, std::string input) {
+    return warm->execute(path, mode, input);
+}
+
+double run_shell(callback execute) {
+    std::vector<PacketPart> nodes(num_packets);
+    for (int i = 0; i < num_packets; i++) {
+        nodes[i].set_packet_path("/packet" + std::to_string(i));
+        nodes[i].set_mode("melody");
+        if (i > 0) {
+            nodes[(i - 1) / 3].append_child(&nodes[i]);
+        }
+    }
+    return time_us(1, [&]() {
+        do_not_optimize(executeShell(execute, &nodes[0], "driver", "control"));
+    });
+}
+
+int main() {
+    std::printf("%d packets, %s ms per call\n\n", num_packets, work_ms);
+    report_header("cold", "warm pool");
+    const char *startups[] = { "0", "50" };
+    for (int i = 0; i < 2; i++) {
+        startup_ms = startups[i];
+        double cold = run_shell(cold_execute);
+        ProcessPool pool(command);
+        warm = &pool;
+        double first = run_shell(warm_execute);
+        double second = run_shell(warm_execute);
+        report(std::string(startups[i]) + " ms startup, first run", cold, first);
+        report(std::string(startups[i]) + " ms startup, warm run", cold, second);
+        std::printf("%-40s %d workers started\n", "", pool.get_started());
+    }
+    return 0;
+}
@@ -0,0 +1,107 @@
+/*
+ * File:    resultcachebench.cpp
+ * Author:  Sam Rappl
+ *
+ * Runs executeShell over a 40 packet tree with a ResultCache: cold, again with
+ * nothing changed, and after editing one packet's file, which changes the Part
+ * it returns. Each stand-in packet is a file and takes 20 ms; the control
+ * module takes 1 ms. Every packet after the edited one in depth first order is
+ * passed its new Part, so runs again: editing the last leaf reruns one packet,
+ * editing an early one reruns most of the tree.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "utilities.h"
+#include "benchmark.h"
+
+const int num_packets = 40;
+const int packet_ms = 20;
+const int control_ms = 1;
+
+static int packet_calls = 0;
+
+/** Returns a Part whose pitch is set by the size of the packet's file. */
+std::string execute(std::string path, std::string mode, std::string input) {
+    if (mode == "driver") {
+        Composition comp;
+        return to_json_string(comp);
+    }
+    if (mode == "play") {
+        return "";
+    }
+    if (mode == "control" || mode == "finalcontrol") {
+        std::this_thread::sleep_for(std::chrono::milliseconds(control_ms));
+        return input;
+    }
+    packet_calls++;
+    std::this_thread::sleep_for(std::chrono::milliseconds(packet_ms));
+    struct stat st;
+    stat(path.c_str(), &st);
+    Arena arena;
+    ArenaScope scope(&arena);
+    Part *p = arena_make<Part>(path);
+    for (int k = 0; k < 50; k++) {
+        p->append_note(arena_make<Note>(c4 + (st.st_size + k) % 12, eighth_note));
+    }
+    return to_json_string(*p);
+}
+
+double run_shell(const std::vector<std::string> &paths, ResultCache &cache) {
+    std::vector<PacketPart> nodes(num_packets);
+    for (int i = 0; i < num_packets; i++) {
+        nodes[i].set_packet_path(paths[i]);
+        nodes[i].set_mode("melody");
+        if (i > 0) {
+            nodes[(i - 1) / 3].append_child(&nodes[i]);
+        }
+    }
+    ShellOptions options;
+    options.cache = &cache;
+    packet_calls = 0;
+    return time_us(1, [&]() {
+        do_not_optimize(executeShell(execute, &nodes[0], "driver", "control", options));
+    }) / 1000;
+}
+
+void edit(const std::string &path) {
+    std::ofstream out(path.c_str(), std::ios::app);
+    out << "edit\n";
+}
+
+int main() {
+    char dir[] = "/tmp/resultcachebenchXXXXXX";
+    mkdtemp(dir);
+    std::vector<std::string> paths;
+    for (int i = 0; i < num_packets; i++) {
+        paths.push_back(std::string(dir) + "/packet" + std::to_string(i));
+        std::ofstream(paths[i].c_str()) << "packet\n";
+    }
+    // Depth first order with up to three children per node ends at node 39
+    // and visits node 13 fourth.
+    ResultCache cache;
+    std::printf("%d packets of %d ms, control module %d ms\n\n", num_packets, packet_ms,
+            control_ms);
+    std::printf("%-36s %12s %14s\n", "run", "total", "packets run");
+    double ms = run_shell(paths, cache);
+    std::printf("%-36s %9.1f ms %14d\n", "cold", ms, packet_calls);
+    ms = run_shell(paths, cache);
+    std::printf("%-36s %9.1f ms %14d\n", "nothing changed", ms, packet_calls);
+    edit(paths[39]);
+    ms = run_shell(paths, cache);
+    std::printf("%-36s %9.1f ms %14d\n", "edited last leaf (packet39)", ms, packet_calls);
+    edit(paths[13]);
+    ms = run_shell(paths, cache);
+    std::printf("%-36s %9.1f ms %14d\n", "edited early leaf (packet13)", ms, packet_calls);
+    for (int i = 0; i < num_packets; i++) {
+        std::remove(paths[i].c_str());
+    }
+    rmdir(dir);
+    return 0;
+}
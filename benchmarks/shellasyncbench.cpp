@@ -0,0 +1,107 @@
+/*
+ * File:    shellasyncbench.cpp
+ * Author:  Sam Rappl
+ *
+ * Runs executeShell over a 40 packet tree with a blocking callback, and
+ * executeShellAsync with the same callback wrapped to run on the calling
+ * thread and on a pool of threads. Each stand-in packet and the control module
+ * wait a few milliseconds, as a module run as an external process leaves the
+ * shell waiting, and then decode their input and encode their output. With a
+ * single worker every packet is passed exactly what executeShell passes it, so
+ * the async run gains only by running the control module alongside the next
+ * packet and by encoding and decoding while they run.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+#include "utilities.h"
+#include "benchmark.h"
+
+const int num_packets = 40;
+const int module_ms = 10;
+const int driver_parts = 4;
+const int driver_events = 200;
+const int packet_events = 50;
+const int runs = 3;
+
+Part* make_part(const std::string &name, int num_events, int first_pitch) {
+    Part *p = arena_make<Part>(name);
+    for (int k = 0; k < num_events; k++) {
+        p->append_note(arena_make<Note>(first_pitch + k % 12, eighth_note));
+    }
+    return p;
+}
+
+std::string execute(std::string path, std::string mode, std::string input) {
+    if (mode == "driver") {
+        Composition comp;
+        ArenaScope scope(&comp.get_arena());
+        for (int i = 0; i < driver_parts; i++) {
+            comp.add_part(*make_part("driver" + std::to_string(i), driver_events, c3));
+        }
+        return to_json_string(comp);
+    }
+    if (mode == "play") {
+        return "";
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(module_ms));
+    nlohmann::json comp = nlohmann::json::parse(input);
+    if (mode == "control" || mode == "finalcontrol") {
+        return comp.dump();
+    }
+    Arena arena;
+    ArenaScope scope(&arena);
+    return to_json_string(*make_part(path, packet_events, c4 + comp["parts"].size() % 12));
+}
+
+/**
+ * Builds a packet tree of num_packets nodes where each node has up to three
+ * children.
+ */
+void build_tree(std::vector<PacketPart> &nodes) {
+    for (int i = 0; i < nodes.size(); i++) {
+        nodes[i].set_packet_path("/packet" + std::to_string(i));
+        nodes[i].set_mode("melody");
+        if (i > 0) {
+            nodes[(i - 1) / 3].append_child(&nodes[i]);
+        }
+    }
+}
+
+int main() {
+    std::printf("%d packets, %d ms per packet and control call, driver %d x %d events, "
+            "%d events per packet\n\n", num_packets, module_ms, driver_parts, driver_events,
+            packet_events);
+    std::string expected;
+    double sync = time_us(runs, [&]() {
+        std::vector<PacketPart> nodes(num_packets);
+        build_tree(nodes);
+        expected = executeShell(execute, &nodes[0], "driver", "control");
+    });
+    std::string shim_out;
+    double shim = time_us(runs, [&]() {
+        std::vector<PacketPart> nodes(num_packets);
+        build_tree(nodes);
+        shim_out = executeShellAsync(make_async_callback(execute), &nodes[0], "driver",
+                "control");
+    });
+    std::string pool_out;
+    double pooled = time_us(runs, [&]() {
+        WorkerPool pool(2);
+        std::vector<PacketPart> nodes(num_packets);
+        build_tree(nodes);
+        pool_out = executeShellAsync(make_async_callback(execute, pool), &nodes[0], "driver",
+                "control");
+    });
+    if (shim_out != expected || pool_out != expected) {
+        std::printf("async output differs from executeShell\n");
+        return 1;
+    }
+    report_header("executeShell", "async");
+    report("blocking shim on the calling thread", sync, shim);
+    report("async callback on 2 threads", sync, pooled);
+    return 0;
+}
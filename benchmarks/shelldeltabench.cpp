@@ -0,0 +1,99 @@
+/*
+ * File:    shelldeltabench.cpp
+ * Author:  Sam Rappl
+ *
+ * Runs executeShell over packet trees of growing size with the control module
+ * sent the whole composition on every call, and with it accepting deltas. The
+ * stand-in control module keeps the composition it was last sent and applies
+ * each delta to it, as a real one would. Reports the total time and the bytes
+ * sent to the control module.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "utilities.h"
+#include "benchmark.h"
+
+const int driver_parts = 4;
+const int driver_events = 1000;
+const int packet_events = 200;
+
+static long control_bytes = 0;
+static nlohmann::json control_doc;
+
+Part* make_part(const std::string &name, int num_events, int first_pitch) {
+    Part *p = arena_make<Part>(name);
+    for (int k = 0; k < num_events; k++) {
+        p->append_note(arena_make<Note>(first_pitch + k % 12, eighth_note));
+    }
+    return p;
+}
+
+std::string execute(std::string path, std::string mode, std::string input) {
+    if (mode == "driver") {
+        Composition comp;
+        ArenaScope scope(&comp.get_arena());
+        for (int i = 0; i < driver_parts; i++) {
+            comp.add_part(*make_part("driver" + std::to_string(i), driver_events, c3));
+        }
+        return to_json_string(comp);
+    }
+    if (mode == "control") {
+        control_bytes += input.size();
+        nlohmann::json doc = nlohmann::json::parse(input);
+        if (doc.is_array()) {
+            control_doc.patch(doc).swap(control_doc);
+        }
+        else {
+            control_doc.swap(doc);
+        }
+        return "{}";
+    }
+    if (mode == "finalcontrol" || mode == "play") {
+        return "{}";
+    }
+    Arena arena;
+    ArenaScope scope(&arena);
+    return to_json_string(*make_part(path, packet_events, c4));
+}
+
+/**
+ * Runs a tree of the given number of packets where each node has up to three
+ * children, and returns the time taken in milliseconds.
+ */
+double run_shell(int num_packets, const ShellOptions &options) {
+    std::vector<PacketPart> nodes(num_packets);
+    for (int i = 0; i < num_packets; i++) {
+        nodes[i].set_packet_path("/packet" + std::to_string(i));
+        nodes[i].set_mode("melody");
+        if (i > 0) {
+            nodes[(i - 1) / 3].append_child(&nodes[i]);
+        }
+    }
+    control_bytes = 0;
+    return time_us(1, [&]() {
+        do_not_optimize(executeShell(execute, &nodes[0], "driver", "control", options));
+    }) / 1000;
+}
+
+int main() {
+    ShellOptions full;
+    ShellOptions deltas;
+    deltas.delta_receivers.insert("control");
+    std::printf("driver %d x %d events, %d events per packet\n\n", driver_parts,
+            driver_events, packet_events);
+    std::printf("%-10s %14s %14s %16s %16s\n", "packets", "full", "deltas",
+            "full bytes", "delta bytes");
+    int sizes[] = { 20, 50, 100 };
+    for (int i = 0; i < 3; i++) {
+        double full_ms = run_shell(sizes[i], full);
+        long full_bytes = control_bytes;
+        double delta_ms = run_shell(sizes[i], deltas);
+        long delta_bytes = control_bytes;
+        std::printf("%-10d %11.1f ms %11.1f ms %16ld %16ld\n", sizes[i], full_ms, delta_ms,
+                full_bytes, delta_bytes);
+    }
+    return 0;
+}
@@ -0,0 +1,108 @@
+/*
+ * File:    shellparallelbench.cpp
+ * Author:  Sam Rappl
+ *
+ * Runs executeShell over packet trees with growing numbers of workers. Each
+ * stand-in packet either sleeps, as a packet run as an external process leaves
+ * the shell waiting, or does a fixed amount of work on the CPU which takes as
+ * long on one core. The packets do not read the composition, so they are all
+ * declared independent. Reports the total time and the speedup over a single
+ * worker. The CPU bound packets can only run faster with more cores.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+#include "utilities.h"
+#include "benchmark.h"
+
+const int packet_ms = 20;
+const int packet_events = 20;
+
+static bool spin = false;
+static long spin_iterations = 0;
+
+/** Does a fixed amount of work on the CPU. */
+void burn(long iterations) {
+    unsigned long x = 1;
+    for (long i = 0; i < iterations; i++) {
+        x = x * 6364136223846793005UL + 1442695040888963407UL;
+    }
+    do_not_optimize(x);
+}
+
+std::string execute(std::string path, std::string mode, std::string input) {
+    if (mode == "driver") {
+        Composition comp;
+        return to_json_string(comp);
+    }
+    if (mode == "control" || mode == "finalcontrol") {
+        return input;
+    }
+    if (mode == "play") {
+        return "";
+    }
+    if (spin) {
+        burn(spin_iterations);
+    }
+    else {
+        std::this_thread::sleep_for(std::chrono::milliseconds(packet_ms));
+    }
+    Arena arena;
+    ArenaScope scope(&arena);
+    Part *p = arena_make<Part>(path);
+    for (int k = 0; k < packet_events; k++) {
+        p->append_note(arena_make<Note>(c4 + k % 12, eighth_note));
+    }
+    return to_json_string(*p);
+}
+
+/**
+ * Runs a tree of the given number of packets where each node has up to the
+ * given number of children, and returns the time taken in milliseconds.
+ */
+double run_shell(int num_packets, int fan_out, int num_workers) {
+    std::vector<PacketPart> nodes(num_packets);
+    for (int i = 0; i < num_packets; i++) {
+        nodes[i].set_packet_path("/packet" + std::to_string(i));
+        nodes[i].set_mode("melody");
+        if (i > 0) {
+            nodes[(i - 1) / fan_out].append_child(&nodes[i]);
+        }
+    }
+    ShellOptions options;
+    options.num_workers = num_workers;
+    for (int i = 0; i < num_packets; i++) {
+        options.independent_packets.insert(nodes[i].get_packet_path());
+    }
+    return time_us(1, [&]() {
+        do_not_optimize(executeShell(execute, &nodes[0], "driver", "control", options));
+    }) / 1000;
+}
+
+int main() {
+    double us = time_us(1, []() { burn(100000000); });
+    spin_iterations = 100000000 * (packet_ms * 1000.0 / us);
+    std::printf("%d ms per packet, %u hardware threads\n\n", packet_ms,
+            std::thread::hardware_concurrency());
+    std::printf("%-24s %8s %12s %10s\n", "tree", "workers", "total", "speedup");
+    const char *names[] = { "sleep, 40 x fan-out 3", "sleep, 40 x fan-out 8",
+            "spin, 40 x fan-out 8" };
+    int fan_outs[] = { 3, 8, 8 };
+    bool spins[] = { false, false, true };
+    int workers[] = { 1, 2, 4, 8 };
+    for (int t = 0; t < 3; t++) {
+        spin = spins[t];
+        double serial = 0;
+        for (int w = 0; w < 4; w++) {
+            double ms = run_shell(40, fan_outs[t], workers[w]);
+            if (w == 0) {
+                serial = ms;
+            }
+            std::printf("%-24s %8d %9.1f ms %9.2fx\n", names[t], workers[w], ms, serial / ms);
+        }
+    }
+    return 0;
+}
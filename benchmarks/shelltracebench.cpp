@@ -0,0 +1,75 @@
+/*
+ * File:    shelltracebench.cpp
+ * Author:  Sam Rappl
+ *
+ * Times executeShell over a 40 packet tree of packets which return at once, so
+ * that the shell's own work is all that is measured, without a ShellTrace and
+ * with one. It is built twice: shelltracebench with SHELL_TRACING defined and
+ * shelltracebench_untraced without, where the hooks compile to nothing. The
+ * traced build then prints the summary of one run.
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include "utilities.h"
+#include "benchmark.h"
+
+const int num_packets = 40;
+
+std::string execute(std::string path, std::string mode, std::string input) {
+    if (mode == "driver") {
+        Composition comp;
+        return to_json_string(comp);
+    }
+    if (mode == "play") {
+        return "";
+    }
+    if (mode == "control" || mode == "finalcontrol") {
+        return input;
+    }
+    Arena arena;
+    ArenaScope scope(&arena);
+    Part *p = arena_make<Part>(path);
+    for (int k = 0; k < 50; k++) {
+        p->append_note(arena_make<Note>(c4 + k % 12, eighth_note));
+    }
+    return to_json_string(*p);
+}
+
+double run_shell(ShellTrace *trace) {
+    return time_us(10, [&]() {
+        std::vector<PacketPart> nodes(num_packets);
+        for (int i = 0; i < num_packets; i++) {
+            nodes[i].set_packet_path("/packet" + std::to_string(i));
+            nodes[i].set_mode("melody");
+            if (i > 0) {
+                nodes[(i - 1) / 3].append_child(&nodes[i]);
+            }
+        }
+        ShellOptions options;
+        options.trace = trace;
+        do_not_optimize(executeShell(execute, &nodes[0], "driver", "control", options));
+    });
+}
+
+int main() {
+    std::printf("%d packets, tracing %s\n\n", num_packets,
+            ShellTrace::compiled_in() ? "compiled in" : "compiled out");
+    ShellTrace trace;
+    run_shell(NULL);
+    report_header("no trace", "trace");
+    report("executeShell", run_shell(NULL), run_shell(&trace));
+    if (ShellTrace::compiled_in()) {
+        trace.clear();
+        run_shell(&trace);
+        std::vector<TraceRecord> records = trace.get_records();
+        std::printf("\n%d calls recorded over 10 runs\n\n", (int) records.size());
+        ShellTrace one;
+        for (int i = 0; i < records.size() / 10; i++) {
+            one.add(records[i]);
+        }
+        one.write_summary(std::cout);
+    }
+    return 0;
+}
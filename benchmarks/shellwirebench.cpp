@@ -0,0 +1,107 @@
+/*
+ * File:    shellwirebench.cpp
+ * Author:  Sam Rappl
+ *
+ * Runs executeShell over a 20 packet tree with each wire format and reports the
+ * time spent by the shell, the time spent by stand-in packets and control
+ * module decoding and encoding what they are sent, and the bytes sent through
+ * the callback. The driver returns a composition of 8 Parts of 2000 events and
+ * each packet adds a Part of 500 notes.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "utilities.h"
+#include "benchmark.h"
+
+const int num_packets = 20;
+const int driver_parts = 8;
+const int driver_events = 2000;
+const int packet_events = 500;
+const int runs = 3;
+
+static WireFormat format = WIRE_JSON;
+static long bytes_sent = 0;
+static double callback_us = 0;
+
+Part* make_part(const std::string &name, int num_events, int first_pitch) {
+    Part *p = arena_make<Part>(name);
+    for (int k = 0; k < num_events; k++) {
+        if (k % 4 == 3) {
+            p->append_chord(arena_make<Chord>(c_major_chord, quarter_note));
+        }
+        else {
+            p->append_note(arena_make<Note>(first_pitch + k % 12, eighth_note));
+        }
+    }
+    return p;
+}
+
+/**
+ * Stands in for the driver module, packets and control module. Each decodes its
+ * input and encodes its output in the wire format, as a real module would.
+ */
+std::string execute(std::string path, std::string mode, std::string input) {
+    auto start = std::chrono::steady_clock::now();
+    bytes_sent += input.size();
+    std::string out;
+    if (mode == "driver") {
+        Composition comp;
+        ArenaScope scope(&comp.get_arena());
+        for (int i = 0; i < driver_parts; i++) {
+            comp.add_part(*make_part("driver" + std::to_string(i), driver_events, c3));
+        }
+        out = encode_wire(comp, format);
+    }
+    else if (mode == "control" || mode == "finalcontrol") {
+        out = encode_wire(decode_wire(input, format), format);
+    }
+    else if (mode != "play") {
+        nlohmann::json comp = decode_wire(input, format);
+        Arena arena;
+        ArenaScope scope(&arena);
+        nlohmann::json j;
+        to_json(j, *make_part(path, packet_events, c4 + comp["parts"].size() % 12));
+        out = encode_wire(j, format);
+    }
+    bytes_sent += out.size();
+    callback_us += std::chrono::duration<double, std::micro>(
+            std::chrono::steady_clock::now() - start).count();
+    return out;
+}
+
+/**
+ * Builds a packet tree of num_packets nodes where each node has up to three
+ * children, and runs it.
+ */
+void run_shell() {
+    std::vector<PacketPart> nodes(num_packets);
+    for (int i = 0; i < num_packets; i++) {
+        nodes[i].set_packet_path("/packet" + std::to_string(i));
+        nodes[i].set_mode("melody");
+        if (i > 0) {
+            nodes[(i - 1) / 3].append_child(&nodes[i]);
+        }
+    }
+    do_not_optimize(executeShell(execute, &nodes[0], "driver", "control", format));
+}
+
+int main() {
+    const char *names[] = { "json", "cbor", "msgpack" };
+    WireFormat formats[] = { WIRE_JSON, WIRE_CBOR, WIRE_MSGPACK };
+    std::printf("%d packets, driver %d x %d events, %d events per packet\n\n",
+            num_packets, driver_parts, driver_events, packet_events);
+    std::printf("%-10s %15s %15s %15s %15s\n", "", "total", "shell", "modules", "bytes sent");
+    for (int f = 0; f < 3; f++) {
+        format = formats[f];
+        bytes_sent = 0;
+        callback_us = 0;
+        double total = time_us(runs, run_shell);
+        std::printf("%-10s %12.1f ms %12.1f ms %12.1f ms %15ld\n", names[f], total / 1000,
+                (total - callback_us / runs) / 1000, callback_us / runs / 1000,
+                bytes_sent / runs);
+    }
+    return 0;
+}
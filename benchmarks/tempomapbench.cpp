@@ -0,0 +1,75 @@
+/*
+ * File:    tempomapbench.cpp
+ * Author:  Sam Rappl
+ *
+ * Compares converting note positions to seconds by walking the tempo changes
+ * from the start of the composition for each note, as exporters did, with the
+ * TempoMap's binary search and its batch conversion.
+ */
+
+#include <cstdio>
+#include <vector>
+#include "composition.h"
+#include "benchmark.h"
+
+const int num_tempo_changes = 2000;
+const int num_notes = 100000;
+
+/**
+ * Converts a position to seconds by adding up the time spent at each tempo
+ * before it.
+ */
+double walk_ticks_to_seconds(const std::vector<CompositionMetrics*> &metrics, int ticks) {
+    double seconds = 0;
+    for (int i = 0; i < metrics.size(); i++) {
+        int end = i + 1 < metrics.size() && metrics[i + 1]->position < ticks ?
+                metrics[i + 1]->position : ticks;
+        seconds += (end - metrics[i]->position) * 60.0 / (metrics[i]->tempo * quarter_note);
+        if (end == ticks) {
+            break;
+        }
+    }
+    return seconds;
+}
+
+int main() {
+    Composition comp;
+    comp.set_initial_tempo(100);
+    for (int i = 1; i < num_tempo_changes; i++) {
+        comp.add_tempo_change(80 + i % 40, i * quarter_note);
+    }
+    std::vector<CompositionMetrics*> metrics = comp.get_all_composition_metrics();
+    std::vector<int> ticks(num_notes);
+    for (int i = 0; i < num_notes; i++) {
+        ticks[i] = (long)i * num_tempo_changes * quarter_note / num_notes;
+    }
+
+    report_header("walk", "TempoMap");
+    double before = time_us(1, [&]() {
+        double sum = 0;
+        for (int i = 0; i < num_notes; i++) {
+            sum += walk_ticks_to_seconds(metrics, ticks[i]);
+        }
+        do_not_optimize(sum);
+    });
+    double build = time_us(10, [&]() {
+        TempoMap map = comp.get_tempo_map();
+        do_not_optimize(map);
+    });
+    TempoMap map = comp.get_tempo_map();
+    double after = time_us(10, [&]() {
+        double sum = 0;
+        for (int i = 0; i < num_notes; i++) {
+            sum += map.ticks_to_seconds(ticks[i]);
+        }
+        do_not_optimize(sum);
+    });
+    report("100k positions to seconds (search)", before, after);
+    after = time_us(10, [&]() {
+        std::vector<double> seconds = map.ticks_to_seconds(ticks);
+        do_not_optimize(seconds);
+    });
+    report("100k positions to seconds (batch)", before, after);
+    std::printf("building the map of 2000 tempo changes takes %.1f us\n", build);
+    return 0;
+}
@@ -0,0 +1,258 @@
+/*
+ * File:    arena.h
+ * Author:  Sam Rappl
+ *
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <utility>
+#include <vector>
+
+/**
+ * An Arena owns the music events and other objects that make up a Composition.
+ * Memory is handed out by bumping a pointer through large blocks, and objects of
+ * the same type are grouped into typed pools so they sit next to each other in
+ * memory. Nothing is freed one object at a time: every object is destroyed and
+ * every block is freed together when the Arena is released or destroyed.
+ */
+class Arena {
+public:
+
+    /** The size of each block of memory requested from the system. */
+    static const size_t block_size = 64 * 1024;
+
+    /**
+     * Constructs an empty Arena. No memory is allocated until the first object
+     * is made.
+     */
+    Arena() : blocks(), block_sizes(), cursor(NULL), remaining(0), pools(), allocated(0), reserved(0) {}
+
+    ~Arena() { release(); }
+
+    /**
+     * Constructs an object of type T in this Arena. The object lives until the
+     * Arena is released.
+     *
+     * @param args The arguments to pass to T's constructor.
+     * @return A pointer to the new object.
+     */
+    template <typename T, typename... Args>
+    T* make(Args&&... args) {
+        return pool<T>().make(std::forward<Args>(args)...);
+    }
+
+    /**
+     * Returns raw memory of the given size and alignment from this Arena.
+     *
+     * @param size The number of bytes needed.
+     * @param align The alignment needed. Must be a power of 2.
+     * @return A pointer to the memory.
+     */
+    void* allocate(size_t size, size_t align = alignof(std::max_align_t)) {
+        size_t padding = (align - (size_t)cursor % align) % align;
+        if (cursor == NULL || padding + size > remaining) {
+            size_t needed = size + align > block_size ? size + align : block_size;
+            cursor = static_cast<char*>(std::malloc(needed));
+            if (cursor == NULL) {
+                throw std::bad_alloc();
+            }
+            blocks.push_back(cursor);
+            block_sizes.push_back(needed);
+            remaining = needed;
+            reserved += needed;
+            padding = (align - (size_t)cursor % align) % align;
+        }
+        void *p = cursor + padding;
+        cursor += padding + size;
+        remaining -= padding + size;
+        allocated += size;
+        return p;
+    }
+
+    /**
+     * Destroys every object made in this Arena and frees all of its memory.
+     */
+    void release() {
+        for (int i = pools.size() - 1; i >= 0; i--) {
+            if (pools[i] != NULL) {
+                pools[i]->destroy_all();
+                delete pools[i];
+            }
+        }
+        pools.clear();
+        for (int i = 0; i < blocks.size(); i++) {
+            std::free(blocks[i]);
+        }
+        blocks.clear();
+        block_sizes.clear();
+        cursor = NULL;
+        remaining = 0;
+        allocated = 0;
+        reserved = 0;
+    }
+
+    /**
+     * Returns the number of bytes handed out by this Arena since it was last
+     * released.
+     *
+     * @return The number of bytes allocated.
+     */
+    size_t bytes_allocated() const { return allocated; }
+
+    /**
+     * Returns the number of bytes of system memory held by this Arena.
+     *
+     * @return The number of bytes reserved.
+     */
+    size_t bytes_reserved() const { return reserved; }
+
+    /**
+     * Returns true if the given object was made in this Arena.
+     *
+     * @param p A pointer to the object.
+     * @return true if p points into one of this Arena's blocks.
+     */
+    bool contains(const void *p) const {
+        const char *c = static_cast<const char*>(p);
+        for (int i = 0; i < blocks.size(); i++) {
+            if (c >= blocks[i] && c < blocks[i] + block_sizes[i]) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    /**
+     * The type independent part of a typed pool, so the Arena can destroy the
+     * objects in its pools without knowing their types.
+     */
+    struct PoolBase {
+        virtual ~PoolBase() {}
+        virtual void destroy_all() = 0;
+    };
+
+    /**
+     * A pool of objects of one type. Objects are made in slabs of
+     * objects_per_slab carved out of the Arena's blocks.
+     */
+    template <typename T>
+    struct Pool : public PoolBase {
+        static const int objects_per_slab = 64;
+
+        Pool(Arena &arena) : arena(arena), slabs(), used(objects_per_slab) {}
+
+        template <typename... Args>
+        T* make(Args&&... args) {
+            if (used == objects_per_slab) {
+                slabs.push_back(static_cast<T*>(arena.allocate(
+                        sizeof(T) * objects_per_slab, alignof(T))));
+                used = 0;
+            }
+            T *object = new (slabs.back() + used) T(std::forward<Args>(args)...);
+            used++;
+            return object;
+        }
+
+        void destroy_all() {
+            // Every slab but the last is full.
+            for (int i = slabs.size() - 1; i >= 0; i--) {
+                int count = i == slabs.size() - 1 ? used : objects_per_slab;
+                for (int k = count - 1; k >= 0; k--) {
+                    slabs[i][k].~T();
+                }
+            }
+            slabs.clear();
+            used = objects_per_slab;
+        }
+
+        Arena &arena;
+        std::vector<T*> slabs;
+        int used;
+    };
+
+    /**
+     * Returns a small number, unique to each type, used to find its pool.
+     */
+    static int next_pool_id() {
+        static std::atomic<int> id(0);
+        return id.fetch_add(1);
+    }
+
+    template <typename T>
+    static int pool_id() {
+        static const int id = next_pool_id();
+        return id;
+    }
+
+    template <typename T>
+    Pool<T>& pool() {
+        int id = pool_id<T>();
+        if (id >= pools.size()) {
+            pools.resize(id + 1, NULL);
+        }
+        if (pools[id] == NULL) {
+            pools[id] = new Pool<T>(*this);
+        }
+        return *static_cast<Pool<T>*>(pools[id]);
+    }
+
+    std::vector<char*> blocks;
+    std::vector<size_t> block_sizes;
+    char *cursor;
+    size_t remaining;
+    std::vector<PoolBase*> pools;
+    size_t allocated;
+    size_t reserved;
+};
+
+/**
+ * Makes the given Arena the one that the JSON readers in utilities.h allocate
+ * from, for as long as the ArenaScope exists on this thread.
+ */
+class ArenaScope {
+public:
+    ArenaScope(Arena *arena) : previous(current_slot()) { current_slot() = arena; }
+    ~ArenaScope() { current_slot() = previous; }
+
+    /**
+     * Returns the Arena of the innermost ArenaScope on this thread, or NULL if
+     * there is none.
+     */
+    static Arena* current() { return current_slot(); }
+
+private:
+    static Arena*& current_slot() {
+        static thread_local Arena *arena = NULL;
+        return arena;
+    }
+
+    Arena *previous;
+};
+
+/**
+ * Constructs an object in the current Arena (see ArenaScope), or on the heap
+ * if there is no current Arena, in which case the caller owns the object.
+ *
+ * @param args The arguments to pass to T's constructor.
+ * @return A pointer to the new object.
+ */
+template <typename T, typename... Args>
+T* arena_make(Args&&... args) {
+    Arena *arena = ArenaScope::current();
+    if (arena != NULL) {
+        return arena->make<T>(std::forward<Args>(args)...);
+    }
+    return new T(std::forward<Args>(args)...);
+}
+
+#endif /* ARENA_H */
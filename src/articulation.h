@@ -0,0 +1,120 @@
+/*
+ * File:    articulation.h
+ * Author:  Sam Rappl
+ *
+ */
+
+#ifndef ARTICULATION_H
+#define ARTICULATION_H
+
+#include <cstdint>
+
+/**
+ * Bits of the articulation flag word used to store the triplet, dot, staccato,
+ * tenuto, accent, fermata, tie and slur markings of Notes and Chords, and the
+ * crescendo and decrescendo markings of Dynamics.
+ */
+enum Articulation {
+    ARTICULATION_TRIPLET = 1 << 0,
+    ARTICULATION_DOTTED = 1 << 1,
+    ARTICULATION_DOUBLE_DOTTED = 1 << 2,
+    ARTICULATION_STACCATO = 1 << 3,
+    ARTICULATION_TENUTO = 1 << 4,
+    ARTICULATION_ACCENT = 1 << 5,
+    ARTICULATION_FERMATA = 1 << 6,
+    ARTICULATION_TIED = 1 << 7,
+    ARTICULATION_SLURRED = 1 << 8,
+    ARTICULATION_CRESC = 1 << 9,
+    ARTICULATION_DECRESC = 1 << 10
+};
+
+/** The number of articulation bits used by Notes and Chords. */
+const int num_note_articulations = 9;
+
+/**
+ * The JSON key of each Note and Chord articulation bit, indexed by bit number.
+ */
+const char* const articulation_keys[num_note_articulations] = {
+    "triplet", "dotted", "double_dotted", "staccato", "tenuto",
+    "accent", "fermata", "tied", "slurred"
+};
+
+/**
+ * Articulated holds the articulation markings of a Note or Chord packed into a
+ * single 16 bit word (see Articulation for the meaning of each bit).
+ */
+struct Articulated {
+
+    /**
+     * Constructs an Articulated object with the given markings.
+     *
+     * @param flags The articulation flag word.
+     */
+    Articulated(uint16_t flags = 0) : flags(flags) {}
+
+    /**
+     * Packs the given markings into an articulation flag word.
+     *
+     * @return The articulation flag word with a bit set for every marking given.
+     */
+    static uint16_t pack(bool triplet, bool dotted, bool double_dotted, bool staccato,
+            bool tenuto, bool accent, bool fermata, bool tied, bool slurred) {
+        return (triplet ? ARTICULATION_TRIPLET : 0) |
+                (dotted ? ARTICULATION_DOTTED : 0) |
+                (double_dotted ? ARTICULATION_DOUBLE_DOTTED : 0) |
+                (staccato ? ARTICULATION_STACCATO : 0) |
+                (tenuto ? ARTICULATION_TENUTO : 0) |
+                (accent ? ARTICULATION_ACCENT : 0) |
+                (fermata ? ARTICULATION_FERMATA : 0) |
+                (tied ? ARTICULATION_TIED : 0) |
+                (slurred ? ARTICULATION_SLURRED : 0);
+    }
+
+    /**
+     * Returns whether the given marking is set.
+     *
+     * @param a The marking to check.
+     * @return Whether the marking is set.
+     */
+    bool has(Articulation a) const { return (flags & a) != 0; }
+
+    /**
+     * Turns the given marking on or off.
+     *
+     * @param a The marking to change.
+     * @param on Whether the marking should be set.
+     */
+    void set(Articulation a, bool on = true) {
+        if (on) {
+            flags |= a;
+        }
+        else {
+            flags &= ~a;
+        }
+    }
+
+    bool is_triplet() const { return has(ARTICULATION_TRIPLET); }
+    bool is_dotted() const { return has(ARTICULATION_DOTTED); }
+    bool is_double_dotted() const { return has(ARTICULATION_DOUBLE_DOTTED); }
+    bool is_staccato() const { return has(ARTICULATION_STACCATO); }
+    bool is_tenuto() const { return has(ARTICULATION_TENUTO); }
+    bool is_accented() const { return has(ARTICULATION_ACCENT); }
+    bool has_fermata() const { return has(ARTICULATION_FERMATA); }
+    bool is_tied() const { return has(ARTICULATION_TIED); }
+    bool is_slurred() const { return has(ARTICULATION_SLURRED); }
+
+    void set_triplet(bool on = true) { set(ARTICULATION_TRIPLET, on); }
+    void set_dotted(bool on = true) { set(ARTICULATION_DOTTED, on); }
+    void set_double_dotted(bool on = true) { set(ARTICULATION_DOUBLE_DOTTED, on); }
+    void set_staccato(bool on = true) { set(ARTICULATION_STACCATO, on); }
+    void set_tenuto(bool on = true) { set(ARTICULATION_TENUTO, on); }
+    void set_accented(bool on = true) { set(ARTICULATION_ACCENT, on); }
+    void set_fermata(bool on = true) { set(ARTICULATION_FERMATA, on); }
+    void set_tied(bool on = true) { set(ARTICULATION_TIED, on); }
+    void set_slurred(bool on = true) { set(ARTICULATION_SLURRED, on); }
+
+    /** The articulation flag word. */
+    uint16_t flags;
+};
+
+#endif /* ARTICULATION_H */
@@ -0,0 +1,664 @@
+/*
+ * File:    binary_format.h
+ * Author:  Sam Rappl
+ *
+ */
+
+#ifndef BINARY_FORMAT_H
+#define BINARY_FORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "composition.h"
+#include "visit.h"
+
+/*
+ * The FuseMuse binary composition format stores a Composition as a header
+ * followed by sections of fixed-width records. Each section starts on an 8 byte
+ * boundary. Records refer to each other by index, and to names, paths and modes
+ * by index into the string table. Values are in the byte order of the machine
+ * that wrote the file; a reader on a machine of the other byte order rejects
+ * the file because the version does not match.
+ *
+ *     header
+ *     strings       BinaryString[]   offset and length in string_bytes
+ *     string_bytes  char[]           NUL terminated strings
+ *     metrics       BinaryMetrics[]  sorted by position
+ *     intervals     int32_t[]        key intervals of the metrics
+ *     parts         BinaryPart[]     the Composition's Parts, then the chord
+ *                                    progressions and PacketPart parts
+ *     events        BinaryEvent[]    the events of every Part, in Part order
+ *     pitches       uint8_t[]        chord pitches
+ *     segments      BinarySegment[]
+ *     pattern       uint32_t[]       string index of each pattern entry
+ *     packets       BinaryPacket[]   the packet tree in breadth first order,
+ *                                    so each node's children are contiguous
+ */
+
+/** The first four bytes of a binary composition file. */
+const char binary_magic[4] = { 'F', 'M', 'B', 'C' };
+
+/** The version of the binary composition format written by write_binary. */
+const uint32_t binary_version = 1;
+
+/** Marks a missing record index, such as the root of an empty packet tree. */
+const uint32_t binary_none = 0xffffffff;
+
+/**
+ * The position and number of records of a section of the file.
+ */
+struct BinarySection {
+    uint64_t offset;
+    uint64_t count;
+};
+
+struct BinaryHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t num_composition_parts;
+    uint32_t packet_root;
+    BinarySection strings;
+    BinarySection string_bytes;
+    BinarySection metrics;
+    BinarySection intervals;
+    BinarySection parts;
+    BinarySection events;
+    BinarySection pitches;
+    BinarySection segments;
+    BinarySection pattern;
+    BinarySection packets;
+};
+
+struct BinaryString {
+    uint32_t offset;
+    uint32_t length;
+};
+
+struct BinaryMetrics {
+    int32_t position;
+    uint32_t tempo;
+    int32_t tonic;
+    uint32_t first_interval;
+    uint32_t num_intervals;
+    int8_t num;
+    int8_t denom;
+    uint16_t padding;
+};
+
+struct BinaryPart {
+    uint32_t name;
+    int32_t length;
+    uint32_t first_event;
+    uint32_t num_events;
+};
+
+/**
+ * A music event. value is the pitch of a Note, the volume of a Dynamic, or the
+ * index of the first of a Chord's num_pitches pitches in the pitches section.
+ * flags holds the articulations of a Note or Chord, or ARTICULATION_CRESC and
+ * ARTICULATION_DECRESC for a Dynamic.
+ */
+struct BinaryEvent {
+    uint8_t kind;
+    uint8_t num_pitches;
+    uint16_t flags;
+    int32_t duration;
+    int32_t value;
+};
+
+struct BinarySegment {
+    uint32_t name;
+    int32_t duration;
+    uint32_t chord_progression;
+};
+
+struct BinaryPacket {
+    uint32_t packet_path;
+    uint32_t mode;
+    uint32_t part;
+    uint32_t first_child;
+    uint32_t num_children;
+    uint32_t executed;
+};
+
+// ************************WRITER**************************
+/**
+ * Collects the sections of a binary composition file while walking a
+ * Composition. Use write_binary rather than this class directly.
+ */
+class BinaryWriter {
+public:
+    BinaryWriter() : string_indices() {
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, binary_magic, sizeof(binary_magic));
+        header.version = binary_version;
+        header.packet_root = binary_none;
+    }
+
+    /**
+     * Writes the given Composition to the given stream.
+     *
+     * @param out The stream to write to.
+     * @param comp The Composition to write.
+     */
+    void write(std::ostream &out, const Composition &comp) {
+        const std::vector<CompositionMetrics*> &all_metrics = comp.get_all_composition_metrics();
+        for (int i = 0; i < all_metrics.size(); i++) {
+            add_metrics(*all_metrics[i]);
+        }
+        const std::vector<Part*> &comp_parts = comp.get_parts();
+        for (int i = 0; i < comp_parts.size(); i++) {
+            add_part(*comp_parts[i]);
+        }
+        header.num_composition_parts = comp_parts.size();
+        const std::vector<PatternSegment*> &comp_segments = comp.get_pattern_segments();
+        for (int i = 0; i < comp_segments.size(); i++) {
+            BinarySegment s;
+            s.name = add_string(comp_segments[i]->get_name());
+            s.duration = comp_segments[i]->get_duration();
+            s.chord_progression = add_part(comp_segments[i]->get_chord_progression());
+            segments.push_back(s);
+        }
+        const std::vector<std::string> &comp_pattern = comp.get_pattern();
+        for (int i = 0; i < comp_pattern.size(); i++) {
+            pattern.push_back(add_string(comp_pattern[i]));
+        }
+        if (comp.get_packet_tree_root() != NULL) {
+            header.packet_root = 0;
+            add_packet_tree(comp.get_packet_tree_root());
+        }
+
+        uint64_t offset = sizeof(BinaryHeader);
+        place(header.strings, strings, offset);
+        place(header.string_bytes, string_bytes, offset);
+        place(header.metrics, metrics, offset);
+        place(header.intervals, intervals, offset);
+        place(header.parts, parts, offset);
+        place(header.events, events, offset);
+        place(header.pitches, pitches, offset);
+        place(header.segments, segments, offset);
+        place(header.pattern, pattern, offset);
+        place(header.packets, packets, offset);
+
+        out.write((const char*)&header, sizeof(header));
+        uint64_t written = sizeof(header);
+        emit(out, header.strings, strings, written);
+        emit(out, header.string_bytes, string_bytes, written);
+        emit(out, header.metrics, metrics, written);
+        emit(out, header.intervals, intervals, written);
+        emit(out, header.parts, parts, written);
+        emit(out, header.events, events, written);
+        emit(out, header.pitches, pitches, written);
+        emit(out, header.segments, segments, written);
+        emit(out, header.pattern, pattern, written);
+        emit(out, header.packets, packets, written);
+    }
+
+private:
+    /**
+     * A visitor which appends the record of a music event.
+     */
+    struct EventRecorder {
+        EventRecorder(BinaryWriter &w) : w(w) {}
+        void operator()(const Note &n) { w.add_event(EVENT_NOTE, 0, n.flags, n.get_duration(), n.pitch); }
+        void operator()(const Chord &c) {
+            if (c.pitches.size() > 255) {
+                throw std::string("A Chord of more than 255 pitches cannot be written in "
+                        "the binary format.");
+            }
+            w.add_event(EVENT_CHORD, c.pitches.size(), c.flags, c.get_duration(), w.pitches.size());
+            for (int i = 0; i < c.pitches.size(); i++) {
+                w.pitches.push_back(c.pitches[i]);
+            }
+        }
+        void operator()(const Dynamic &d) {
+            uint16_t flags = (d.cresc ? ARTICULATION_CRESC : 0) |
+                    (d.decresc ? ARTICULATION_DECRESC : 0);
+            w.add_event(EVENT_DYNAMIC, 0, flags, d.duration, d.volume);
+        }
+        BinaryWriter &w;
+    };
+
+    uint32_t add_string(const std::string &s) {
+        std::unordered_map<std::string, uint32_t>::iterator it = string_indices.find(s);
+        if (it != string_indices.end()) {
+            return it->second;
+        }
+        BinaryString record;
+        record.offset = string_bytes.size();
+        record.length = s.size();
+        string_bytes.insert(string_bytes.end(), s.begin(), s.end());
+        string_bytes.push_back('\0');
+        strings.push_back(record);
+        string_indices.emplace(s, strings.size() - 1);
+        return strings.size() - 1;
+    }
+
+    void add_metrics(const CompositionMetrics &m) {
+        const std::vector<int> &key_intervals = m.key.get_intervals();
+        BinaryMetrics record;
+        std::memset(&record, 0, sizeof(record));
+        record.position = m.position;
+        record.tempo = m.tempo;
+        record.tonic = m.key.get_tonic();
+        record.first_interval = intervals.size();
+        record.num_intervals = key_intervals.size();
+        record.num = m.time_signature.num;
+        record.denom = m.time_signature.denom;
+        intervals.insert(intervals.end(), key_intervals.begin(), key_intervals.end());
+        metrics.push_back(record);
+    }
+
+    uint32_t add_part(const Part &p) {
+        BinaryPart record;
+        record.name = add_string(p.get_name());
+        record.length = p.get_length();
+        record.first_event = events.size();
+        std::vector<Event*>::const_iterator it;
+        for (it = p.const_begin(); it != p.const_end(); it++) {
+            visit(**it, EventRecorder(*this));
+        }
+        record.num_events = events.size() - record.first_event;
+        parts.push_back(record);
+        return parts.size() - 1;
+    }
+
+    void add_event(EventKind kind, int num_pitches, uint16_t flags, int duration, int value) {
+        BinaryEvent record;
+        record.kind = kind;
+        record.num_pitches = num_pitches;
+        record.flags = flags;
+        record.duration = duration;
+        record.value = value;
+        events.push_back(record);
+    }
+
+    void add_packet_tree(PacketPart *root) {
+        std::vector<PacketPart*> order(1, root);
+        for (int i = 0; i < order.size(); i++) {
+            const std::vector<PacketPart*> &children = order[i]->get_children();
+            BinaryPacket record;
+            record.packet_path = add_string(order[i]->get_packet_path());
+            record.mode = add_string(order[i]->get_mode());
+            record.part = add_part(order[i]->get_part());
+            record.first_child = order.size();
+            record.num_children = children.size();
+            record.executed = order[i]->has_been_executed();
+            packets.push_back(record);
+            order.insert(order.end(), children.begin(), children.end());
+        }
+    }
+
+    template <typename T>
+    static void place(BinarySection &section, const std::vector<T> &records, uint64_t &offset) {
+        offset = (offset + 7) & ~(uint64_t)7;
+        section.offset = offset;
+        section.count = records.size();
+        offset += records.size() * sizeof(T);
+    }
+
+    template <typename T>
+    static void emit(std::ostream &out, const BinarySection &section,
+            const std::vector<T> &records, uint64_t &written) {
+        static const char zeros[8] = { 0 };
+        out.write(zeros, section.offset - written);
+        out.write((const char*)records.data(), records.size() * sizeof(T));
+        written = section.offset + records.size() * sizeof(T);
+    }
+
+    BinaryHeader header;
+    std::unordered_map<std::string, uint32_t> string_indices;
+    std::vector<BinaryString> strings;
+    std::vector<char> string_bytes;
+    std::vector<BinaryMetrics> metrics;
+    std::vector<int32_t> intervals;
+    std::vector<BinaryPart> parts;
+    std::vector<BinaryEvent> events;
+    std::vector<uint8_t> pitches;
+    std::vector<BinarySegment> segments;
+    std::vector<uint32_t> pattern;
+    std::vector<BinaryPacket> packets;
+};
+
+/**
+ * Writes the given Composition to the given stream in the binary composition
+ * format.
+ *
+ * @param out The stream to write to, opened in binary mode.
+ * @param comp The Composition to write.
+ */
+inline void write_binary(std::ostream &out, const Composition &comp) {
+    BinaryWriter().write(out, comp);
+}
+
+/**
+ * Writes the given Composition to the file at the given path in the binary
+ * composition format.
+ *
+ * @param path The path of the file.
+ * @param comp The Composition to write.
+ * @return Whether the file was written.
+ */
+inline bool write_binary(const std::string &path, const Composition &comp) {
+    std::ofstream out(path.c_str(), std::ios::binary);
+    write_binary(out, comp);
+    out.close();
+    return !out.fail();
+}
+
+// ************************READER**************************
+/**
+ * A read-only view of a Part's events in a BinaryComposition.
+ */
+class BinaryPartView {
+public:
+    BinaryPartView(const char *name, const BinaryPart *part, const BinaryEvent *events,
+            const uint8_t *pitches) : name(name), part(part), events(events),
+            pitches(pitches) {}
+
+    const char* get_name() const { return name; }
+    int get_length() const { return part->length; }
+    int size() const { return part->num_events; }
+    const BinaryEvent& operator[](int i) const { return events[part->first_event + i]; }
+    const BinaryEvent* begin() const { return events + part->first_event; }
+    const BinaryEvent* end() const { return events + part->first_event + part->num_events; }
+
+    /**
+     * Returns the pitches of a chord event of this Part.
+     *
+     * @param event A chord event of this Part.
+     * @return A pointer to its event.num_pitches pitches.
+     */
+    const uint8_t* get_pitches(const BinaryEvent &event) const { return pitches + event.value; }
+
+private:
+    const char *name;
+    const BinaryPart *part;
+    const BinaryEvent *events;
+    const uint8_t *pitches;
+};
+
+/**
+ * A BinaryComposition maps a file in the binary composition format into memory
+ * and reads Parts and events from it in place, without parsing or copying. The
+ * file stays mapped until the BinaryComposition is destroyed, so views taken
+ * from it must not outlive it. Use to_composition to build an ordinary
+ * Composition from the file.
+ */
+class BinaryComposition {
+public:
+
+    /**
+     * Maps the binary composition file at the given path. Throws a string if the
+     * file cannot be read or is not a binary composition file of this version.
+     *
+     * @param path The path of the file.
+     */
+    BinaryComposition(const std::string &path) : data(NULL), size(0), header(NULL) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::string("Could not open binary composition " + path + ".");
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(BinaryHeader)) {
+            close(fd);
+            throw std::string("Not a binary composition file: " + path + ".");
+        }
+        size = st.st_size;
+        void *mapped = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (mapped == MAP_FAILED) {
+            throw std::string("Could not map binary composition " + path + ".");
+        }
+        data = static_cast<const char*>(mapped);
+        header = reinterpret_cast<const BinaryHeader*>(data);
+        if (!valid()) {
+            munmap((void*)data, size);
+            throw std::string("Not a binary composition file of version 1: " + path + ".");
+        }
+    }
+
+    ~BinaryComposition() { munmap((void*)data, size); }
+
+    int get_num_parts() const { return header->num_composition_parts; }
+    int get_num_events() const { return header->events.count; }
+    int get_num_pattern_segments() const { return header->segments.count; }
+    int get_num_composition_metrics() const { return header->metrics.count; }
+
+    /**
+     * Returns a view of the Composition Part at the given index.
+     *
+     * @param i The index of the Part, in the order of Composition::get_parts.
+     * @return A view of the Part.
+     */
+    BinaryPartView get_part(int i) const { return part_view(i); }
+
+    /**
+     * Returns the string at the given index of the string table.
+     *
+     * @param i The index of the string.
+     * @return The NUL terminated string, which lives in the mapped file.
+     */
+    const char* get_string(uint32_t i) const {
+        return section<char>(header->string_bytes) + section<BinaryString>(header->strings)[i].offset;
+    }
+
+    /**
+     * Fills the given Composition with the contents of the file. Everything is
+     * made in the Composition's Arena.
+     *
+     * @param comp The Composition to fill.
+     */
+    void to_composition(Composition &comp) const {
+        ArenaScope scope(&comp.get_arena());
+        const BinaryMetrics *metrics = section<BinaryMetrics>(header->metrics);
+        const int32_t *intervals = section<int32_t>(header->intervals);
+        std::vector<CompositionMetrics*> all_metrics;
+        for (int i = 0; i < header->metrics.count; i++) {
+            CompositionMetrics *m = arena_make<CompositionMetrics>();
+            m->position = metrics[i].position;
+            m->tempo = metrics[i].tempo;
+            m->key = KeyHandle(metrics[i].tonic, std::vector<int>(
+                    intervals + metrics[i].first_interval,
+                    intervals + metrics[i].first_interval + metrics[i].num_intervals));
+            m->time_signature = TimeSignature(metrics[i].num, metrics[i].denom);
+            all_metrics.push_back(m);
+        }
+        comp.add_all_composition_metrics(all_metrics);
+        for (int i = 0; i < header->num_composition_parts; i++) {
+            Part *p = arena_make<Part>();
+            fill_part(i, *p);
+            comp.add_part(*p);
+        }
+        const BinarySegment *segments = section<BinarySegment>(header->segments);
+        for (int i = 0; i < header->segments.count; i++) {
+            PatternSegment *s = arena_make<PatternSegment>(get_string(segments[i].name),
+                    segments[i].duration);
+            Part chord_progression;
+            fill_part(segments[i].chord_progression, chord_progression);
+            s->set_chord_progression(&chord_progression);
+            comp.register_pattern_segment(s);
+        }
+        const uint32_t *pattern = section<uint32_t>(header->pattern);
+        for (int i = 0; i < header->pattern.count; i++) {
+            comp.add_to_pattern(get_string(pattern[i]));
+        }
+        PacketPart *root = NULL;
+        if (header->packet_root != binary_none) {
+            root = make_packet_tree();
+        }
+        comp.set_packet_tree_root(root);
+    }
+
+private:
+    BinaryComposition(const BinaryComposition&);
+    BinaryComposition& operator=(const BinaryComposition&);
+
+    template <typename T>
+    const T* section(const BinarySection &s) const {
+        return reinterpret_cast<const T*>(data + s.offset);
+    }
+
+    template <typename T>
+    bool fits(const BinarySection &s) const {
+        return s.offset % 8 == 0 && s.offset <= size && s.count <= (size - s.offset) / sizeof(T);
+    }
+
+    /**
+     * Checks the header and that every section and every index in the file is
+     * in bounds, so the views never read outside the mapping.
+     */
+    bool valid() const {
+        if (std::memcmp(header->magic, binary_magic, sizeof(binary_magic)) != 0 ||
+                header->version != binary_version) {
+            return false;
+        }
+        if (!fits<BinaryString>(header->strings) || !fits<char>(header->string_bytes) ||
+                !fits<BinaryMetrics>(header->metrics) || !fits<int32_t>(header->intervals) ||
+                !fits<BinaryPart>(header->parts) || !fits<BinaryEvent>(header->events) ||
+                !fits<uint8_t>(header->pitches) || !fits<BinarySegment>(header->segments) ||
+                !fits<uint32_t>(header->pattern) || !fits<BinaryPacket>(header->packets)) {
+            return false;
+        }
+        uint64_t num_strings = header->strings.count;
+        const BinaryString *strings = section<BinaryString>(header->strings);
+        const char *bytes = section<char>(header->string_bytes);
+        for (uint64_t i = 0; i < num_strings; i++) {
+            if ((uint64_t)strings[i].offset + strings[i].length >= header->string_bytes.count ||
+                    bytes[strings[i].offset + strings[i].length] != '\0') {
+                return false;
+            }
+        }
+        const BinaryMetrics *metrics = section<BinaryMetrics>(header->metrics);
+        for (uint64_t i = 0; i < header->metrics.count; i++) {
+            if ((uint64_t)metrics[i].first_interval + metrics[i].num_intervals >
+                    header->intervals.count) {
+                return false;
+            }
+        }
+        const BinaryPart *parts = section<BinaryPart>(header->parts);
+        for (uint64_t i = 0; i < header->parts.count; i++) {
+            if (parts[i].name >= num_strings ||
+                    (uint64_t)parts[i].first_event + parts[i].num_events > header->events.count) {
+                return false;
+            }
+        }
+        const BinaryEvent *events = section<BinaryEvent>(header->events);
+        for (uint64_t i = 0; i < header->events.count; i++) {
+            if (events[i].kind == EVENT_CHORD && (events[i].value < 0 ||
+                    (uint64_t)events[i].value + events[i].num_pitches > header->pitches.count)) {
+                return false;
+            }
+        }
+        const BinarySegment *segments = section<BinarySegment>(header->segments);
+        for (uint64_t i = 0; i < header->segments.count; i++) {
+            if (segments[i].name >= num_strings ||
+                    segments[i].chord_progression >= header->parts.count) {
+                return false;
+            }
+        }
+        const uint32_t *pattern = section<uint32_t>(header->pattern);
+        for (uint64_t i = 0; i < header->pattern.count; i++) {
+            if (pattern[i] >= num_strings) {
+                return false;
+            }
+        }
+        const BinaryPacket *packets = section<BinaryPacket>(header->packets);
+        for (uint64_t i = 0; i < header->packets.count; i++) {
+            if (packets[i].packet_path >= num_strings || packets[i].mode >= num_strings ||
+                    packets[i].part >= header->parts.count || packets[i].first_child <= i ||
+                    (uint64_t)packets[i].first_child + packets[i].num_children >
+                    header->packets.count) {
+                return false;
+            }
+        }
+        return header->num_composition_parts <= header->parts.count &&
+                (header->packet_root == binary_none ||
+                (header->packet_root == 0 && header->packets.count > 0));
+    }
+
+    BinaryPartView part_view(uint32_t i) const {
+        const BinaryPart *part = section<BinaryPart>(header->parts) + i;
+        return BinaryPartView(get_string(part->name), part,
+                section<BinaryEvent>(header->events), section<uint8_t>(header->pitches));
+    }
+
+    void fill_part(uint32_t i, Part &p) const {
+        BinaryPartView view = part_view(i);
+        p.set_name(view.get_name());
+        for (const BinaryEvent *e = view.begin(); e != view.end(); e++) {
+            if (e->kind == EVENT_NOTE) {
+                Note *n = arena_make<Note>(e->value, e->duration);
+                n->flags = e->flags;
+                p.append_note(n);
+            }
+            else if (e->kind == EVENT_CHORD) {
+                const uint8_t *pitches = view.get_pitches(*e);
+                PitchSet chord_pitches;
+                for (int k = 0; k < e->num_pitches; k++) {
+                    chord_pitches.push_back(pitches[k]);
+                }
+                Chord *c = arena_make<Chord>(chord_pitches, e->duration);
+                c->flags = e->flags;
+                p.append_chord(c);
+            }
+            else if (e->kind == EVENT_DYNAMIC) {
+                p.append_dynamic(arena_make<Dynamic>(e->value,
+                        (e->flags & ARTICULATION_CRESC) != 0,
+                        (e->flags & ARTICULATION_DECRESC) != 0));
+            }
+        }
+    }
+
+    /**
+     * Makes the PacketParts of the packet tree. Nodes are stored in breadth first
+     * order, so every child comes after its parent.
+     */
+    PacketPart* make_packet_tree() const {
+        const BinaryPacket *packets = section<BinaryPacket>(header->packets);
+        std::vector<PacketPart*> nodes(header->packets.count);
+        for (int i = 0; i < nodes.size(); i++) {
+            nodes[i] = arena_make<PacketPart>();
+            Part part;
+            fill_part(packets[i].part, part);
+            nodes[i]->set_part(part);
+            nodes[i]->set_packet_path(get_string(packets[i].packet_path));
+            nodes[i]->set_mode(get_string(packets[i].mode));
+            nodes[i]->set_executed(packets[i].executed != 0);
+            nodes[i]->set_inactive();
+        }
+        for (int i = 0; i < nodes.size(); i++) {
+            for (int k = 0; k < packets[i].num_children; k++) {
+                nodes[i]->append_child(nodes[packets[i].first_child + k]);
+            }
+        }
+        return nodes[0];
+    }
+
+    const char *data;
+    size_t size;
+    const BinaryHeader *header;
+};
+
+/**
+ * Reads the binary composition file at the given path into the given
+ * Composition. Throws a string if the file cannot be read.
+ *
+ * @param path The path of the file.
+ * @param comp The Composition to fill.
+ */
+inline void read_binary(const std::string &path, Composition &comp) {
+    BinaryComposition(path).to_composition(comp);
+}
+
+#endif /* BINARY_FORMAT_H */
@@ -0,0 +1,137 @@
+/*
+ * File:    change_stamp.h
+ * Author:  Sam Rappl
+ *
+ */
+
+#ifndef CHANGE_STAMP_H
+#define CHANGE_STAMP_H
+
+#include <atomic>
+#include <vector>
+
+/**
+ * A ChangeStamp counts changes to a group of objects, so that whatever indexes
+ * them can tell when its index is out of date. A Part uses one for the
+ * durations of its events, and a Composition uses one for the names of its
+ * Parts and PatternSegments. It is shared by the objects and the index, and
+ * freed when the last of them lets it go.
+ */
+class ChangeStamp {
+public:
+
+    /**
+     * Returns a new ChangeStamp, held once by the caller.
+     */
+    static ChangeStamp* make() { return new ChangeStamp(); }
+
+    /**
+     * Holds this ChangeStamp once more.
+     *
+     * @return This ChangeStamp.
+     */
+    ChangeStamp* retain() {
+        refs.fetch_add(1, std::memory_order_relaxed);
+        return this;
+    }
+
+    /**
+     * Lets go of this ChangeStamp once, freeing it if nothing holds it.
+     */
+    void release() {
+        if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            delete this;
+        }
+    }
+
+    /**
+     * Records a change.
+     */
+    void changed() { count.fetch_add(1, std::memory_order_relaxed); }
+
+    /**
+     * Returns the number of changes so far.
+     *
+     * @return The number of changes.
+     */
+    unsigned long changes() const { return count.load(std::memory_order_relaxed); }
+
+    /**
+     * Records that the index reading this ChangeStamp is gone, so the objects
+     * holding it may let it go.
+     */
+    void close() { closed.store(true, std::memory_order_relaxed); }
+
+    /**
+     * Returns true if the index reading this ChangeStamp is gone.
+     */
+    bool is_closed() const { return closed.load(std::memory_order_relaxed); }
+
+private:
+    ChangeStamp() : refs(1), count(0), closed(false) {}
+    ChangeStamp(const ChangeStamp&) = delete;
+    ChangeStamp& operator=(const ChangeStamp&) = delete;
+
+    std::atomic<int> refs;
+    std::atomic<unsigned long> count;
+    std::atomic<bool> closed;
+};
+
+/**
+ * The ChangeStamps an object reports its changes to, such as those of the
+ * Compositions a Part has been added to. A copy of the object is not in those
+ * Compositions, so it starts with none. Assigning to the object counts as a
+ * change.
+ */
+class ChangeWatchers {
+public:
+    ChangeWatchers() : stamps() {}
+    ChangeWatchers(const ChangeWatchers&) : stamps() {}
+
+    ChangeWatchers& operator=(const ChangeWatchers&) {
+        changed();
+        return *this;
+    }
+
+    ~ChangeWatchers() {
+        for (int i = 0; i < stamps.size(); i++) {
+            stamps[i]->release();
+        }
+    }
+
+    /**
+     * Reports later changes to the given ChangeStamp as well, and lets go of
+     * the ChangeStamps which are closed.
+     *
+     * @param stamp The ChangeStamp to report to.
+     */
+    void add(ChangeStamp *stamp) {
+        bool found = false;
+        for (int i = stamps.size() - 1; i >= 0; i--) {
+            if (stamps[i] == stamp) {
+                found = true;
+            }
+            else if (stamps[i]->is_closed()) {
+                stamps[i]->release();
+                stamps.erase(stamps.begin() + i);
+            }
+        }
+        if (!found) {
+            stamps.push_back(stamp->retain());
+        }
+    }
+
+    /**
+     * Records a change in every ChangeStamp.
+     */
+    void changed() {
+        for (int i = 0; i < stamps.size(); i++) {
+            stamps[i]->changed();
+        }
+    }
+
+private:
+    std::vector<ChangeStamp*> stamps;
+};
+
+#endif /* CHANGE_STAMP_H */
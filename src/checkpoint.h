@@ -0,0 +1,230 @@
+/*
+ * File:    checkpoint.h
+ * Author:  Sam Rappl
+ *
+ */
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <cerrno>
+#include <condition_variable>
+#include <cstdio>
+#include <fcntl.h>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include "composition.h"
+#include "json_writer.h"
+#include "sax_reader.h"
+
+/**
+ * A CheckpointWriter keeps the latest state of a run of the packet shell in a
+ * file: the composition, with the packet tree and which packets have been
+ * executed and the Parts they produced, in the JSON form of to_json. save
+ * writes the composition to a string and returns; a thread of the writer's own
+ * puts it on disk, so the shell does not wait for the disk. If the shell saves
+ * again before the last save is on disk, only the newest is written.
+ *
+ * Each file is written to a temporary file, flushed to disk and renamed over
+ * the checkpoint, so the checkpoint is always a whole composition, the old one
+ * or the new one, even if the process or machine stops part way. The temporary
+ * file has a name of its own, so writers to the same checkpoint do not write
+ * over each other's, and the directory is flushed after the rename so that
+ * the rename itself is on disk.
+ */
+class CheckpointWriter {
+public:
+
+    /**
+     * @param path The path of the checkpoint. Its directory must exist.
+     */
+    CheckpointWriter(const std::string &path)
+            : path(path), mutex(), changed(), pending(), has_pending(false), writing(false),
+            stopping(false), saved(0), written(0), error(), writer() {
+        writer = std::thread(&CheckpointWriter::write_loop, this);
+    }
+
+    /** Writes the last composition saved, if it has not been, and stops. */
+    ~CheckpointWriter() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        changed.notify_all();
+        writer.join();
+    }
+
+    CheckpointWriter(const CheckpointWriter&) = delete;
+    CheckpointWriter& operator=(const CheckpointWriter&) = delete;
+
+    /**
+     * Saves the composition as it is now. It is written to disk in the
+     * background.
+     *
+     * @param comp The composition, which should have the packet tree.
+     */
+    void save(const Composition &comp) {
+        std::string text = to_json_string(comp);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pending.swap(text);
+            has_pending = true;
+            saved++;
+        }
+        changed.notify_all();
+    }
+
+    /**
+     * Waits until the last composition saved is on disk.
+     *
+     * @throws std::string If a checkpoint could not be written since the last
+     *         flush.
+     */
+    void flush() {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [this]() { return !has_pending && !writing; });
+        if (!error.empty()) {
+            std::string e;
+            e.swap(error);
+            throw e;
+        }
+    }
+
+    /**
+     * Returns the number of compositions saved.
+     *
+     * @return The number of calls to save.
+     */
+    int get_saved() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return saved;
+    }
+
+    /**
+     * Returns the number of checkpoints written to disk, which is fewer than
+     * the number saved when saves came faster than the disk.
+     *
+     * @return The number of checkpoints written.
+     */
+    int get_written() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return written;
+    }
+
+private:
+
+    void write_loop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            changed.wait(lock, [this]() { return has_pending || stopping; });
+            if (!has_pending) {
+                return;
+            }
+            std::string text;
+            text.swap(pending);
+            has_pending = false;
+            writing = true;
+            lock.unlock();
+            bool ok = write_file(text);
+            lock.lock();
+            writing = false;
+            if (ok) {
+                written++;
+            }
+            else {
+                error = "Could not write checkpoint " + path + ".";
+            }
+            changed.notify_all();
+        }
+    }
+
+    /**
+     * Writes text to a new temporary file next to the checkpoint, renames it
+     * over the checkpoint and flushes the directory.
+     */
+    bool write_file(const std::string &text) {
+        std::string temp = path + ".XXXXXX";
+        int fd = mkostemp(&temp[0], O_CLOEXEC);
+        if (fd < 0) {
+            return false;
+        }
+        if (fchmod(fd, 0644) != 0) {
+            close(fd);
+            std::remove(temp.c_str());
+            return false;
+        }
+        const char *p = text.data();
+        size_t size = text.size();
+        bool ok = true;
+        while (size > 0) {
+            ssize_t n = write(fd, p, size);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                ok = false;
+                break;
+            }
+            p += n;
+            size -= n;
+        }
+        ok = ok && fsync(fd) == 0;
+        ok = close(fd) == 0 && ok;
+        if (!ok || std::rename(temp.c_str(), path.c_str()) != 0) {
+            std::remove(temp.c_str());
+            return false;
+        }
+        return sync_directory();
+    }
+
+    /** Flushes the directory of the checkpoint, so that a rename in it is on disk. */
+    bool sync_directory() {
+        size_t slash = path.rfind('/');
+        std::string directory = slash == std::string::npos ? "." :
+                slash == 0 ? "/" : path.substr(0, slash);
+        int fd = open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (fd < 0) {
+            return false;
+        }
+        bool ok = fsync(fd) == 0;
+        return close(fd) == 0 && ok;
+    }
+
+    std::string path;
+    std::mutex mutex;
+    std::condition_variable changed;
+
+    /** The latest composition saved which the writer has not started on. */
+    std::string pending;
+    bool has_pending;
+    bool writing;
+    bool stopping;
+    int saved;
+    int written;
+
+    /** Why the last checkpoint could not be written, or "". */
+    std::string error;
+    std::thread writer;
+};
+
+/**
+ * Reads a checkpoint written by a CheckpointWriter. The JSON is read as it
+ * streams from the file, without building a document.
+ *
+ * @param path The path of the checkpoint.
+ * @param comp An empty Composition to read it into. It owns the packet tree.
+ * @throws std::string If the checkpoint could not be opened.
+ */
+inline void load_checkpoint(const std::string &path, Composition &comp) {
+    std::ifstream in(path.c_str(), std::ios::binary);
+    if (!in) {
+        throw std::string("Could not open checkpoint " + path + ".");
+    }
+    sax_from_json(in, comp);
+}
+
+#endif /* CHECKPOINT_H */
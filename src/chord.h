@@ -10,18 +10,18 @@
 #include <vector>
 #include "constants.h"
 #include "event.h"
+#include "articulation.h"
+#include "pitch_set.h"
 
 /**
  * A Chord is an object that represents several music notes with the same duration.
  */
-struct Chord: public Event {
+struct Chord: public Event, public Articulated {
 
     /**
      * Constructs a Chord object with a c major chord and the duration of a quarter note.
      */
-    Chord(): pitches(c_major_chord), duration(quarter_note), triplet(0),
-            dotted(0), double_dotted(0), staccato(0), tenuto(0),
-            accent(0), fermata(0), tied(0), slurred(0){}
+    Chord(): Event(EVENT_CHORD), pitches(c_major_chord), duration(quarter_note) {}
 
     /**
      * Constructs a Chord object with specified pitches and duration. Pitch and Duration
@@ -39,14 +39,13 @@ struct Chord: public Event {
      * @param tied Whether the chord is tied to the next chord.
      * @param slurred Whether the chord is slurred to the next chord.
      */
-    Chord(std::vector<int> pitches, int duration, int triplet = 0,
+    Chord(PitchSet pitches, int duration, int triplet = 0,
             int dotted = 0, int double_dotted = 0, int staccato = 0,
             int tenuto = 0, int accent = 0, int fermata = 0,
-            int tied = 0, int slurred = 0) : pitches(pitches),
-            duration(duration), triplet(triplet), dotted(dotted),
-            double_dotted(double_dotted), staccato(staccato),
-            tenuto(tenuto), accent(accent), fermata(fermata),
-            tied(tied), slurred(slurred){}
+            int tied = 0, int slurred = 0) : Event(EVENT_CHORD),
+            Articulated(pack(triplet, dotted, double_dotted, staccato, tenuto,
+            accent, fermata, tied, slurred)),
+            pitches(pitches), duration(duration) {}
 
     /**
      * Adds a dot to the chord (which turns on the dotted flag and increases the duration
@@ -56,21 +55,23 @@ struct Chord: public Event {
      * @return Whether the chord was dotted.
      */
     bool dot() {
-        if (!dotted) {
+        if (!is_dotted()) {
             if (duration == one_twenty_eighth_note) {
                 return false;
             } else {
-                dotted = true;
+                set_dotted();
                 duration *= 1.5;
+                duration_changed();
             }
             return true;
-        } else if (dotted && !double_dotted) {
+        } else if (!is_double_dotted()) {
             if (duration == dotted_sixty_fourth_note) {
                 return false;
             } else {
-                double_dotted = true;
+                set_double_dotted();
                 duration /= 6;
                 duration *= 7;
+                duration_changed();
             }
             return true;
         }
@@ -83,15 +84,16 @@ struct Chord: public Event {
      * @return Whether the chord was double dotted.
      */
     bool double_dot() {
-        if (dotted) {
+        if (is_dotted()) {
             return false;
         } else if (duration == one_twenty_eighth_note || duration == sixty_fourth_note) {
             return false;
         } else {
-            dotted = true;
-            double_dotted = true;
+            set_dotted();
+            set_double_dotted();
             duration /= 4;
             duration *= 7;
+            duration_changed();
         }
         return true;
     }
@@ -103,12 +105,13 @@ struct Chord: public Event {
      * @return Whether the chord was added to a triplet.
      */
     bool put_in_triplet() {
-        if (triplet) {
+        if (is_triplet()) {
             return false;
         } else {
-            triplet = true;
+            set_triplet();
             duration /= 3;
             duration *= 2;
+            duration_changed();
         }
         return true;
     }
@@ -119,12 +122,10 @@ struct Chord: public Event {
      * @return Whether the chord was moved up an octave.
      */
     bool add_octave() {
-        if (pitches.size() == 0 || pitches[pitches.size()-1] + 12 > 126) {
+        if (pitches.size() == 0 || pitches.back() + 12 > 126) {
             return false;
         }
-        for (int i = 0; i < pitches.size(); i++) {
-            pitches[i] += 12;
-        }
+        pitches.transpose(12);
         return true;
     }
 
@@ -134,12 +135,10 @@ struct Chord: public Event {
      * @return Whether the chord was moved down an octave.
      */
     bool drop_octave() {
-        if (pitches.size() == 0 || pitches[0] - 12 < 0) {
+        if (pitches.size() == 0 || pitches.front() - 12 < 0) {
             return false;
         }
-        for (int i = 0; i < pitches.size(); i++) {
-            pitches[i] -= 12;
-        }
+        pitches.transpose(-12);
         return true;
     }
 
@@ -152,8 +151,7 @@ struct Chord: public Event {
         if (pitches.size() < 2 || pitches[0] + 12 > 126) {
             return false;
         }
-        pitches.push_back(pitches[0] + 12);
-        pitches.erase(pitches.begin());
+        pitches.rotate_up_octave();
         return true;
     }
     
@@ -164,60 +162,41 @@ struct Chord: public Event {
      * @return true if this chord is the same as the chord passed in.
      */
     bool equals(Chord *chord) {
-        if (pitches.size() != chord->pitches.size()) {
+        if (pitches != chord->pitches) {
             return false;
         }
-        else {
-            for (int i = 0; i < pitches.size(); i++) {
-                if (pitches[i] != chord->pitches[i]) {
-                    return false;
-                }
-            }
-        }
         if (duration != chord->duration) {
             return false;
         }
-        if (triplet != chord->triplet) {
-            return false;
-        }
-        if (dotted != chord->dotted) {
-            return false;
-        }
-        if (double_dotted != chord->double_dotted) {
-            return false;
-        }
-        if (staccato != chord->staccato) {
-            return false;
-        }
-        if (tenuto != chord->tenuto) {
-            return false;
-        }
-        if (accent != chord->accent) {
-            return false;
-        }
-        if (fermata != chord->fermata) {
-            return false;
-        }
-        if (tied != chord->tied) {
-            return false;
-        }
-        if (slurred != chord->slurred) {
+        if (flags != chord->flags) {
             return false;
         }
         return true;
     }
     
-    std::vector<int> pitches;
+    /**
+     * Returns the duration of the chord.
+     *
+     * @return The duration of the chord.
+     */
+    int get_duration() const { return duration; }
+
+    /**
+     * Sets the duration of the chord. Its articulation flags are not changed.
+     *
+     * @param d The new duration of the chord.
+     */
+    void set_duration(int d) {
+        duration = d;
+        duration_changed();
+    }
+
+    PitchSet pitches;
+
+private:
+
+    /** The duration of the chord (see Note::duration). */
     int duration;
-    bool triplet;
-    bool dotted;
-    bool double_dotted;
-    bool staccato;
-    bool tenuto;
-    bool accent;
-    bool fermata;
-    bool tied;
-    bool slurred;
 };
 
 #endif /* CHORD_H */
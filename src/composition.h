@@ -7,9 +7,15 @@
 #ifndef COMPOSITION_H
 #define COMPOSITION_H
 
+#include <algorithm>
+#include <memory>
 #include <vector>
 #include <string>
+#include <unordered_map>
+#include "arena.h"
+#include "change_stamp.h"
 #include "composition_metrics.h"
+#include "tempo_map.h"
 #include "part.h"
 #include "packet_part.h"
 
@@ -23,7 +29,7 @@ public:
     /**
      * Constructs a PatternSegment object with no name and no chord progression
      */
-    PatternSegment(): name(), duration(), chord_progression(){}
+    PatternSegment(): name(), duration(), chord_progression(), watchers(){}
 
     /**
      * Constructs a PatternSegment with a name and a duration
@@ -32,14 +38,14 @@ public:
      * @param duration The length of the PatternSegment in FuseMuse duration units.
      */
     PatternSegment(std::string name, int duration) : name(name), duration(duration),
-            chord_progression(){}
+            chord_progression(), watchers(){}
 
     /**
      * Returns the chord progression of this PatternSegment.
      *
      * @return The chord progression of this PatternSegment.
      */
-    Part get_chord_progression() const { return chord_progression; }
+    const Part& get_chord_progression() const { return chord_progression; }
 
     /**
      * Sets the chord progression of this PatternSegment.
@@ -53,14 +59,17 @@ public:
      *
      * @return The name of this PatternSegment.
      */
-    std::string get_name() const { return name; }
+    const std::string& get_name() const { return name; }
 
     /**
      * Sets the name of this PatternSegment.
      *
      * @param n The new name for this PatternSegment.
      */
-    void set_name(std::string n) { name = n; }
+    void set_name(std::string n) {
+        name = n;
+        watchers.changed();
+    }
 
     /**
      * Returns the duration of this PatternSegment.
@@ -97,15 +106,42 @@ public:
     }
     
 private:
+    friend class Composition;
+
     std::string name;
     int duration;
     Part chord_progression;
+
+    /** Counts renames in the Compositions this PatternSegment is registered with. */
+    ChangeWatchers watchers;
 };
 
 class Composition {
 public:
-    Composition(): metrics(), parts(), pattern(), pattern_segments(), chord_progression(),
-        root(NULL){};
+    Composition(): metrics(), metric_positions(), parts(), part_indices(), pattern(), pattern_segments(),
+        pattern_segment_indices(), names(ChangeStamp::make(), close_names), indexed_names(0),
+        chord_progression(), root(NULL), arena(new Arena()), kept_arenas(){};
+
+    /**
+     * Returns the Arena that owns the events, Parts, PatternSegments, composition
+     * metrics and PacketParts read into this composition. Everything in it is
+     * freed at once when the last copy of this composition is destroyed.
+     *
+     * @return The Arena of this composition.
+     */
+    Arena& get_arena() const { return *arena; }
+
+    /**
+     * Keeps another Arena alive for as long as this composition, as when one
+     * of its Parts shares the events of a Part kept by a PacketPart.
+     *
+     * @param other The Arena to keep, or null.
+     */
+    void keep_arena(std::shared_ptr<Arena> other) {
+        if (other && std::find(kept_arenas.begin(), kept_arenas.end(), other) == kept_arenas.end()) {
+            kept_arenas.push_back(other);
+        }
+    }
 
     /**
      * Returns the composition metrics being used at the given position in the composition.
@@ -114,12 +150,12 @@ public:
      * @return The composition metrics used at the position.
      */
     CompositionMetrics* get_composition_metrics_at_position(int pos) const {
-        for (int i = metrics.size() - 1; i >= 0; i--) {
-            if (pos >= metrics[i]->position) {
-                return metrics[i];
-            }
+        std::vector<int>::const_iterator next = std::upper_bound(metric_positions.begin(),
+                metric_positions.end(), pos);
+        if (next == metric_positions.begin()) {
+            return NULL;
         }
-        return NULL;
+        return metrics[(next - metric_positions.begin()) - 1];
     }
 
     /**
@@ -133,6 +169,7 @@ public:
         }
         if (metrics.size() == 0) {
             metrics.push_back(mets);
+            metric_positions.push_back(0);
         }
         else {
             metrics[0] = mets;
@@ -144,12 +181,13 @@ public:
      *
      * @param initKey The initial key of the composition.
      */
-    void set_initial_key(Key init_key) {
+    void set_initial_key(KeyHandle init_key) {
         if (metrics.size() == 0) {
-            CompositionMetrics *m = new CompositionMetrics();
+            CompositionMetrics *m = arena->make<CompositionMetrics>();
             m->key = init_key;
             m->position = 0;
             metrics.push_back(m);
+            metric_positions.push_back(0);
         }
         else {
             metrics[0]->key = init_key;
@@ -163,10 +201,11 @@ public:
      */
     void set_initial_tempo(int init_tempo) {
         if (metrics.size() == 0) {
-            CompositionMetrics *m = new CompositionMetrics();
+            CompositionMetrics *m = arena->make<CompositionMetrics>();
             m->tempo = init_tempo;
             m->position = 0;
             metrics.push_back(m);
+            metric_positions.push_back(0);
         }
         else {
             metrics[0]->tempo = init_tempo;
@@ -181,10 +220,11 @@ public:
      */
     void set_initial_time_signature(TimeSignature init_time_sig) {
         if (metrics.size() == 0) {
-            CompositionMetrics *m = new CompositionMetrics();
+            CompositionMetrics *m = arena->make<CompositionMetrics>();
             m->time_signature = init_time_sig;
             m->position = 0;
             metrics.push_back(m);
+            metric_positions.push_back(0);
         }
         else {
             metrics[0]->time_signature = init_time_sig;
@@ -198,7 +238,7 @@ public:
      * @param pos The position the key change should occur.
      * @return Whether the key was changed.
      */
-    bool add_key_change(Key new_key, int pos) {
+    bool add_key_change(KeyHandle new_key, int pos) {
         if (metrics.size() == 0) {
             return false;
         }
@@ -209,23 +249,16 @@ public:
         }
         else {
             CompositionMetrics *mets = get_composition_metrics_at_position(pos);
-            if (mets->key.equals(&new_key)) {
+            if (mets->key == new_key) {
                 return false;
             }
             else {
-                CompositionMetrics *key_change = new CompositionMetrics();
+                CompositionMetrics *key_change = arena->make<CompositionMetrics>();
                 key_change->position = pos;
                 key_change->key = new_key;
                 key_change->tempo = mets->tempo;
                 key_change->time_signature = mets->time_signature;
-                for (std::vector<CompositionMetrics*>::iterator it = metrics.begin();
-                        it != metrics.end(); ++it) {
-                    if ((*it)->position > pos) {
-                        metrics.insert(it, key_change);
-                        return true;
-                    }
-                }
-                metrics.push_back(key_change);
+                insert_composition_metrics(key_change);
                 return true;
             }
         }
@@ -245,6 +278,7 @@ public:
         int index = composition_metrics_at_position(pos);
         if (index > -1) {
             metrics[index]->tempo = new_tempo;
+            return true;
         }
         else {
             CompositionMetrics *mets = get_composition_metrics_at_position(pos);
@@ -252,19 +286,12 @@ public:
                 return false;
             }
             else {
-                CompositionMetrics *tempo_change = new CompositionMetrics();
+                CompositionMetrics *tempo_change = arena->make<CompositionMetrics>();
                 tempo_change->position = pos;
                 tempo_change->tempo = new_tempo;
                 tempo_change->key = mets->key;
                 tempo_change->time_signature = mets->time_signature;
-                for (std::vector<CompositionMetrics*>::iterator it = metrics.begin();
-                        it != metrics.end(); ++it) {
-                    if ((*it)->position > pos) {
-                        metrics.insert(it, tempo_change);
-                        return true;
-                    }
-                }
-                metrics.push_back(tempo_change);
+                insert_composition_metrics(tempo_change);
                 return true;
             }
         }
@@ -284,6 +311,7 @@ public:
         int index = composition_metrics_at_position(pos);
         if (index > -1) {
             metrics[index]->time_signature = new_time_sig;
+            return true;
         }
         else {
             CompositionMetrics *mets = get_composition_metrics_at_position(pos);
@@ -292,19 +320,12 @@ public:
                 return false;
             }
             else {
-                CompositionMetrics *time_sig_change = new CompositionMetrics();
+                CompositionMetrics *time_sig_change = arena->make<CompositionMetrics>();
                 time_sig_change->position = pos;
                 time_sig_change->key = mets->key;
                 time_sig_change->tempo = mets->tempo;
                 time_sig_change->time_signature = new_time_sig;
-                for (std::vector<CompositionMetrics*>::iterator it = metrics.begin();
-                        it != metrics.end(); ++it) {
-                    if ((*it)->position > pos) {
-                        metrics.insert(it, time_sig_change);
-                        return true;
-                    }
-                }
-                metrics.push_back(time_sig_change);
+                insert_composition_metrics(time_sig_change);
                 return true;
             }
         }
@@ -322,40 +343,53 @@ public:
         if (metrics.size() == 0) {
             mets->position = 0;
             metrics.push_back(mets);
+            metric_positions.push_back(0);
             return true;
         }
-        else {
-            std::vector<CompositionMetrics*>::iterator it = metrics.begin();
-            while (it != metrics.end()) {
-                if ((*it)->position == mets->position) {
-                    (*it)->key = mets->key;
-                    (*it)->time_signature = mets->time_signature;
-                    (*it)->tempo = mets->tempo;
-                    return true;
-                }
-                else if ((*it)->position > mets->position) {
-                    it--;
-                    if ((*it)->key.equals(&mets->key) &&
-                            (*it)->time_signature.num == mets->time_signature.num &&
-                            (*it)->time_signature.denom == mets->time_signature.denom &&
-                            (*it)->tempo == mets->tempo) {
-                        return false;
-                    }
-                    it++;
-                    metrics.insert(it, mets);
-                    return true;
-                }
-                it++;
+        int index = composition_metrics_at_position(mets->position);
+        if (index > -1) {
+            metrics[index]->key = mets->key;
+            metrics[index]->time_signature = mets->time_signature;
+            metrics[index]->tempo = mets->tempo;
+            return true;
+        }
+        CompositionMetrics *previous = get_composition_metrics_at_position(mets->position);
+        if (previous != NULL && same_settings(previous, mets)) {
+            return false;
+        }
+        insert_composition_metrics(mets);
+        return true;
+    }
+
+    /**
+     * Adds a batch of composition metrics, given in any order, to the composition.
+     * The batch is sorted once instead of inserting each set of composition
+     * metrics on its own, so this takes O(n log n) time for n sets of composition
+     * metrics. As with add_new_composition_metrics, a later set of composition
+     * metrics at the same position as another replaces it, a set of composition
+     * metrics which changes nothing is left out, and the first set of composition
+     * metrics is moved to position 0.
+     *
+     * @param batch The composition metrics to be added.
+     */
+    void add_all_composition_metrics(const std::vector<CompositionMetrics*> &batch) {
+        std::vector<CompositionMetrics*> all(metrics);
+        all.insert(all.end(), batch.begin(), batch.end());
+        std::stable_sort(all.begin(), all.end(), position_less);
+        metrics.clear();
+        metric_positions.clear();
+        for (int i = 0; i < all.size(); i++) {
+            if (i + 1 < all.size() && all[i + 1]->position == all[i]->position) {
+                continue;
             }
-            it--;
-            if ((*it)->key.equals(&mets->key) &&
-                    (*it)->time_signature.num == mets->time_signature.num &&
-                    (*it)->time_signature.denom == mets->time_signature.denom &&
-                    (*it)->tempo == mets->tempo) {
-                return false;
+            if (metrics.size() == 0) {
+                all[i]->position = 0;
             }
-            metrics.push_back(mets);
-            return true;
+            else if (same_settings(metrics.back(), all[i])) {
+                continue;
+            }
+            metrics.push_back(all[i]);
+            metric_positions.push_back(all[i]->position);
         }
     }
 
@@ -387,10 +421,19 @@ public:
      *
      * @return a list of composition metrics in this composition.
      */
-    std::vector<CompositionMetrics*> get_all_composition_metrics() const {
+    const std::vector<CompositionMetrics*>& get_all_composition_metrics() const {
         return metrics;
     }
 
+    /**
+     * Returns a TempoMap of the tempo changes in this composition, for converting
+     * positions to seconds and back. The map is a snapshot: build a new one after
+     * changing the tempo.
+     *
+     * @return The TempoMap of this composition.
+     */
+    TempoMap get_tempo_map() const { return TempoMap(metrics); }
+
     /**
      * Returns the Part with the given name, or null if there is no such Part.
      *
@@ -398,12 +441,19 @@ public:
      * @return The part with the given name.
      */
     Part* get_part(std::string name) const {
-        for (int i = 0; i < parts.size(); i++) {
-            if (parts[i]->get_name() == name) {
-                return parts[i];
+        if (!names_indexed()) {
+            for (int i = 0; i < parts.size(); i++) {
+                if (parts[i]->get_name() == name) {
+                    return parts[i];
+                }
             }
+            return NULL;
+        }
+        std::unordered_map<std::string, int>::const_iterator it = part_indices.find(name);
+        if (it == part_indices.end()) {
+            return NULL;
         }
-        return NULL;
+        return parts[it->second];
     }
 
     /**
@@ -411,7 +461,7 @@ public:
      *
      * @return all Parts in this composition.
      */
-    std::vector<Part*> get_parts() const {
+    const std::vector<Part*>& get_parts() const {
         return parts;
     }
 
@@ -423,12 +473,12 @@ public:
      * @return Whether the Part was added.
      */
     bool add_part(Part& p) {
-        for (int i = 0; i < parts.size(); i++) {
-            if (parts[i]->get_name() == p.get_name()) {
-                return false;
-            }
+        index_names();
+        if (!part_indices.emplace(p.get_name(), parts.size()).second) {
+            return false;
         }
         parts.push_back(&p);
+        p.watchers.add(names.get());
         return true;
     }
 
@@ -440,12 +490,12 @@ public:
      * @return Whether the PatternSegment was registered.
      */
     bool register_pattern_segment(PatternSegment *p) {
-        for (int i = 0; i < pattern_segments.size(); i++) {
-            if (pattern_segments[i]->get_name() == p->get_name()) {
-                return false;
-            }
+        index_names();
+        if (!pattern_segment_indices.emplace(p->get_name(), pattern_segments.size()).second) {
+            return false;
         }
         pattern_segments.push_back(p);
+        p->watchers.add(names.get());
         return true;
     }
 
@@ -458,13 +508,15 @@ public:
      *      was updated to be the PatternSegment passed in.
      */
     bool edit_pattern_segment(PatternSegment *p) {
-        for (int i = 0; i < pattern_segments.size(); i++) {
-            if (pattern_segments[i]->get_name() == p->get_name()) {
-                pattern_segments[i] = p;
-                return true;
-            }
+        index_names();
+        std::unordered_map<std::string, int>::iterator it =
+                pattern_segment_indices.find(p->get_name());
+        if (it == pattern_segment_indices.end()) {
+            return false;
         }
-        return false;
+        pattern_segments[it->second] = p;
+        p->watchers.add(names.get());
+        return true;
     }
 
     /**
@@ -474,12 +526,20 @@ public:
      * @return The PatternSegment with the given name.
      */
     PatternSegment* get_pattern_segment(std::string name) const {
-        for (int i = 0; i < pattern_segments.size(); i++) {
-            if (pattern_segments[i]->get_name() == name) {
-                return pattern_segments[i];
+        if (!names_indexed()) {
+            for (int i = 0; i < pattern_segments.size(); i++) {
+                if (pattern_segments[i]->get_name() == name) {
+                    return pattern_segments[i];
+                }
             }
+            return NULL;
+        }
+        std::unordered_map<std::string, int>::const_iterator it =
+                pattern_segment_indices.find(name);
+        if (it == pattern_segment_indices.end()) {
+            return NULL;
         }
-        return NULL;
+        return pattern_segments[it->second];
     }
 
     /**
@@ -490,7 +550,8 @@ public:
      * @return Whether there is a PatternSegment with the given name.
      */
     bool add_to_pattern(std::string name) {
-        if (get_pattern_segment(name) != NULL) {
+        index_names();
+        if (pattern_segment_indices.count(name) != 0) {
             pattern.push_back(name);
             return true;
         }
@@ -502,7 +563,7 @@ public:
      *
      * @return the pattern of this composition.
      */
-    std::vector<std::string> get_pattern() const { return pattern; }
+    const std::vector<std::string>& get_pattern() const { return pattern; }
 
     
     /**
@@ -510,7 +571,7 @@ public:
      *
      * @return all of the PatternSegments in this composition.
      */
-    std::vector<PatternSegment*> get_pattern_segments() const { return pattern_segments; }
+    const std::vector<PatternSegment*>& get_pattern_segments() const { return pattern_segments; }
 
     /**
      * Resets the pattern of this composition.
@@ -524,7 +585,7 @@ public:
      *
      * @return the chord progression of this composition.
      */
-    Part get_chord_progression() const { return chord_progression; }
+    const Part& get_chord_progression() const { return chord_progression; }
 
     /**
      * Returns the root of the Packet tree.
@@ -597,7 +658,13 @@ public:
         if (!chord_progression.equals(&temp_chord_progression)) {
             return false;
         }
-        if (!root->equals(composition->get_packet_tree_root())) {
+        PacketPart *other_root = composition->get_packet_tree_root();
+        if (root == NULL || other_root == NULL) {
+            if (root != other_root) {
+                return false;
+            }
+        }
+        else if (!root->equals(other_root)) {
             return false;
         }
         return true;
@@ -605,25 +672,123 @@ public:
 
 private:
     /**
+     * Closes and lets go of the ChangeStamp counting renames once the last copy
+     * of a composition is destroyed.
+     *
+     * @param stamp The ChangeStamp to close.
+     */
+    static void close_names(ChangeStamp *stamp) {
+        stamp->close();
+        stamp->release();
+    }
+
+    /**
+     * Returns true if no Part or PatternSegment has been renamed since the
+     * indices were built.
+     *
+     * @return Whether the indices are up to date.
+     */
+    bool names_indexed() const { return names->changes() == indexed_names; }
+
+    /**
+     * Builds the indices again from the current names if a Part or PatternSegment
+     * has been renamed. Where two share a name, the first is found, as a search
+     * through the list would.
+     */
+    void index_names() {
+        unsigned long changes = names->changes();
+        if (changes == indexed_names) {
+            return;
+        }
+        part_indices.clear();
+        for (int i = 0; i < parts.size(); i++) {
+            part_indices.emplace(parts[i]->get_name(), i);
+        }
+        pattern_segment_indices.clear();
+        for (int i = 0; i < pattern_segments.size(); i++) {
+            pattern_segment_indices.emplace(pattern_segments[i]->get_name(), i);
+        }
+        indexed_names = changes;
+    }
+
+    /**
      * Returns the index of the composition metrics at a given position.
      *
      * @param pos The position at which to retrieve composition metrics.
      * @return The index of the composition metrics in the list.
      */
     int composition_metrics_at_position(int pos) {
-        for (int i = 0; i < metrics.size(); i++) {
-            if (metrics[i]->position == pos) {
-                return i;
-            }
+        std::vector<int>::iterator it = std::lower_bound(metric_positions.begin(),
+                metric_positions.end(), pos);
+        if (it == metric_positions.end() || *it != pos) {
+            return -1;
         }
-        return -1;
+        return it - metric_positions.begin();
+    }
+
+    /**
+     * Inserts the given composition metrics into the timeline after every set of
+     * composition metrics at or before its position.
+     *
+     * @param mets The composition metrics to insert.
+     */
+    void insert_composition_metrics(CompositionMetrics *mets) {
+        std::vector<int>::iterator it = std::upper_bound(metric_positions.begin(),
+                metric_positions.end(), mets->position);
+        int index = it - metric_positions.begin();
+        metric_positions.insert(it, mets->position);
+        metrics.insert(metrics.begin() + index, mets);
+    }
+
+    /**
+     * Returns true if the given composition metrics have the same key, time
+     * signature and tempo.
+     */
+    static bool same_settings(CompositionMetrics *a, CompositionMetrics *b) {
+        return a->key == b->key &&
+                a->time_signature.num == b->time_signature.num &&
+                a->time_signature.denom == b->time_signature.denom &&
+                a->tempo == b->tempo;
+    }
+
+    static bool position_less(const CompositionMetrics *a, const CompositionMetrics *b) {
+        return a->position < b->position;
     }
+
+    /** The composition metrics of the composition, sorted by position. */
     std::vector<CompositionMetrics*> metrics;
+
+    /**
+     * The position of each set of composition metrics, kept parallel to metrics
+     * in one contiguous array so that lookups are a binary search.
+     */
+    std::vector<int> metric_positions;
     std::vector<Part*> parts;
+
+    /** The index in parts of the Part with each name. */
+    std::unordered_map<std::string, int> part_indices;
+
     std::vector<PatternSegment*> pattern_segments;
+
+    /** The index in pattern_segments of the PatternSegment with each name. */
+    std::unordered_map<std::string, int> pattern_segment_indices;
+
+    /**
+     * Counts the renames of the Parts and PatternSegments in this composition,
+     * which are shared by its copies.
+     */
+    std::shared_ptr<ChangeStamp> names;
+
+    /** The number of renames names had counted when the indices were built. */
+    unsigned long indexed_names;
+
     std::vector<std::string> pattern;
     Part chord_progression;
     PacketPart *root;
+    std::shared_ptr<Arena> arena;
+
+    /** The Arenas which own events shared by Parts of this composition. */
+    std::vector<std::shared_ptr<Arena>> kept_arenas;
 };
 
 
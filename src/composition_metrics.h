@@ -7,7 +7,12 @@
 #ifndef COMPOSITIONMETRICS_H
 #define COMPOSITIONMETRICS_H
 
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
 #include <string>
+#include <utility>
 #include <vector>
 #include "constants.h"
 
@@ -78,8 +83,7 @@ public:
      * @param intervals A vector filled with numbers of half steps between steps in
      *         the scale.
      */
-    Key(int tonic = c3, std::vector<int> intervals = major_intervals) :
-            tonic(tonic), intervals(intervals) {
+    Key(int tonic, std::vector<int> intervals) : tonic(tonic), intervals(intervals) {
         if (tonic >= 102) {
             tonic = tonic % 12 + 36;
         }
@@ -89,6 +93,25 @@ public:
         calculate_scale();
     }
 
+    /**
+     * Constructs a Key from one of the scales in constants.h, which defaults to
+     * C major. The intervals are read straight from the constant.
+     *
+     * @param tonic The tonic note of the scale.
+     * @param intervals A list of the numbers of half steps between steps in the
+     *         scale.
+     */
+    Key(int tonic = c3, ConstantList intervals = major_intervals) :
+            tonic(tonic), intervals(intervals.begin(), intervals.end()) {
+        if (tonic >= 102) {
+            tonic = tonic % 12 + 36;
+        }
+        if (!valid_intervals(this->intervals)) {
+            throw std::string("Intervals do not add up to an octave.");
+        }
+        calculate_scale();
+    }
+
     /**
      * Returns a list of notes in the scale in this Key.
      *
@@ -101,7 +124,7 @@ public:
      *
      * @return A vector containing the intervals in this scale.
      */
-    std::vector<int> get_intervals() const { return intervals; }
+    const std::vector<int>& get_intervals() const { return intervals; }
 
     /**
      * Sets the intervals of this key if they equal 12 half steps, and recalculates
@@ -114,6 +137,7 @@ public:
         if (valid_intervals(new_intervals)) {
             intervals = new_intervals;
             calculate_scale();
+            return true;
         }
         else {
             return false;
@@ -188,15 +212,21 @@ public:
      * @return Whether the pitch is in the scale.
      */
     bool is_in_scale(int pitch) const {
-        int pmod = pitch % 12;
-        for (int i = 0; i < scale.size(); i++) {
-            if (pmod == scale[i] % 12) {
-                return true;
-            }
+        if (pitch >= 0 && pitch < num_pitches) {
+            return degrees[pitch] > 0;
         }
-        return false;
+        int pmod = pitch % 12;
+        return pmod >= 0 && (scale_mask >> pmod) & 1;
     }
 
+    /**
+     * Returns the pitch classes in the scale as a 12 bit mask. Bit i is set if
+     * pitches with pitch % 12 == i are in the scale.
+     *
+     * @return The pitch class mask of the scale.
+     */
+    uint16_t get_scale_mask() const { return scale_mask; }
+
     /**
      * Returns whether the pitch given is the tonic, 2nd, 3rd, etc... in the
      * scale.
@@ -205,13 +235,11 @@ public:
      * @return The position of the pitch in the scale. (1 if tonic, 2nd, 3rd, etc.)
      */
     int position_in_scale(int pitch) const {
-        int pmod = pitch % 12;
-        for (int i = 0; i < scale.size(); i++) {
-            if (pmod == scale[i] % 12) {
-                return i + 1;
-            }
+        if (pitch >= 0 && pitch < num_pitches) {
+            return degrees[pitch];
         }
-        return -1;
+        int pmod = pitch % 12;
+        return pmod >= 0 ? degrees[pmod] : -1;
     }
 
     /**
@@ -221,22 +249,23 @@ public:
      * @return The next pitch up in the scale.
      */
     int next_pitch_in_scale(int pitch) const {
-        int num_octaves = pitch / 12;
-        int pmod = pitch % 12;
-        int index_of_next = -1;
-        for (int i = 0; i < scale.size(); i++) {
-            if (pmod == scale[i] % 12) {
-                index_of_next = i+1;
-            }
+        if (pitch >= 0 && pitch < num_pitches) {
+            return pitch + next_steps[pitch];
         }
-        if (index_of_next == -1) {
-            for (int i = 0; i < scale.size() - 1; i++) {
-                if (pmod > scale[i] % 12 && pmod < scale[i+1] % 12) {
-                    index_of_next = i + 1;
-                }
-            }
+        return pitch + step_to_scale(pitch, 1);
+    }
+
+    /**
+     * Returns the next pitch down in the scale below the given pitch.
+     *
+     * @param pitch The pitch to get the pitch below on the scale.
+     * @return The next pitch down in the scale.
+     */
+    int previous_pitch_in_scale(int pitch) const {
+        if (pitch >= 0 && pitch < num_pitches) {
+            return pitch - previous_steps[pitch];
         }
-        return scale[index_of_next] % 12 + num_octaves * 12;
+        return pitch - step_to_scale(pitch, -1);
     }
 
     /**
@@ -274,6 +303,7 @@ public:
             calculate_scale();
             return true;
         }
+        return false;
     }
 
     /**
@@ -285,7 +315,7 @@ public:
      * @param start_position The starting position in the scale (i.e. the 4th)
      * @return A list of integers comprised of the pitches of the chord
      */
-    std::vector<int> get_chord(int start_position) {
+    std::vector<int> get_chord(int start_position) const {
         std::vector<int> pitches;
         int start_index = start_position % scale.size();
         pitches.push_back(scale[start_index]);
@@ -312,22 +342,8 @@ public:
      * @param key The key to be tested against this key
      * @return Whether the key is the same as the given key
      */
-    bool equals(Key *key) const {
-        if (tonic != key->get_tonic()) {
-            return false;
-        }
-        if (intervals.size() != key->get_intervals().size()) {
-            return false;
-        }
-        else {
-            std::vector<int> other_intervals = key->get_intervals();
-            for (int i = 0; i < intervals.size(); i++) {
-                if (intervals[i] != other_intervals[i]) {
-                    return false;
-                }
-            }
-        }
-        return true;
+    bool equals(const Key *key) const {
+        return tonic == key->tonic && intervals == key->intervals;
     }
 
 private:
@@ -342,12 +358,56 @@ private:
             pitch += intervals[i];
             scale.push_back(pitch);
         }
+        calculate_tables();
+    }
+
+    /**
+     * Helper method to recalculate the pitch class mask and the lookup tables
+     * from the scale, so that the scale queries are single loads.
+     */
+    void calculate_tables() {
+        scale_mask = 0;
+        int class_degrees[12];
+        for (int c = 0; c < 12; c++) {
+            class_degrees[c] = -1;
+        }
+        for (int i = scale.size() - 1; i >= 0; i--) {
+            int pmod = (scale[i] % 12 + 12) % 12;
+            scale_mask |= 1 << pmod;
+            class_degrees[pmod] = i + 1;
+        }
+        for (int pitch = 0; pitch < num_pitches; pitch++) {
+            degrees[pitch] = class_degrees[pitch % 12];
+            next_steps[pitch] = step_to_scale(pitch, 1);
+            previous_steps[pitch] = step_to_scale(pitch, -1);
+        }
+    }
+
+    /**
+     * Helper method to find how many half steps away the nearest pitch in the scale
+     * is in the given direction, not counting the given pitch itself.
+     *
+     * @param pitch The pitch to start from.
+     * @param direction 1 to search up, -1 to search down.
+     * @return The number of half steps to the nearest pitch in the scale.
+     */
+    int step_to_scale(int pitch, int direction) const {
+        for (int step = 1; step < 12; step++) {
+            int pmod = ((pitch + direction * step) % 12 + 12) % 12;
+            if ((scale_mask >> pmod) & 1) {
+                return step;
+            }
+        }
+        return 12;
     }
 
+    /** The number of pitches covered by the lookup tables. */
+    static const int num_pitches = 128;
+
     /**
      * Helper method to determine whether a set of intervals is valid.
      */
-    bool valid_intervals(std::vector<int> test_intervals) {
+    bool valid_intervals(const std::vector<int> &test_intervals) {
         int sum = 0;
         for (int i = 0; i < test_intervals.size(); i++) {
             sum += test_intervals[i];
@@ -361,6 +421,138 @@ private:
     int tonic;
     std::vector<int> intervals;
     std::vector<int> scale;
+
+    /** Bit i is set if pitch class i is in the scale. */
+    uint16_t scale_mask;
+
+    /** The position in the scale of each pitch, or -1 if it is not in the scale. */
+    int8_t degrees[num_pitches];
+
+    /** The number of half steps from each pitch up to the next pitch in the scale. */
+    uint8_t next_steps[num_pitches];
+
+    /** The number of half steps from each pitch down to the next pitch in the scale. */
+    uint8_t previous_steps[num_pitches];
+};
+
+/**
+ * A KeyHandle refers to an immutable Key shared by every KeyHandle made from an
+ * equal Key. Keys are interned the first time a KeyHandle is made from them and
+ * are never freed, so a KeyHandle is as cheap to copy as a pointer and two
+ * KeyHandles are equal exactly when they point to the same Key. A KeyHandle
+ * offers the same queries as the Key it refers to.
+ */
+class KeyHandle {
+public:
+
+    /**
+     * Constructs a KeyHandle referring to the default Key, C major.
+     */
+    KeyHandle() : key(default_key()) {}
+
+    /**
+     * Constructs a KeyHandle referring to a Key equal to the given Key.
+     *
+     * @param k The Key to refer to.
+     */
+    KeyHandle(const Key &k) : key(intern(k)) {}
+
+    /**
+     * Constructs a KeyHandle referring to the Key with the given tonic and
+     * intervals.
+     *
+     * @param tonic The tonic note of the scale.
+     * @param intervals The numbers of half steps between steps in the scale.
+     */
+    KeyHandle(int tonic, std::vector<int> intervals) : key(intern(Key(tonic, intervals))) {}
+
+    /**
+     * Returns the Key this KeyHandle refers to.
+     *
+     * @return The Key this KeyHandle refers to.
+     */
+    const Key& get() const { return *key; }
+    operator const Key&() const { return *key; }
+    const Key* operator->() const { return key; }
+
+    std::vector<int> get_scale() const { return key->get_scale(); }
+    const std::vector<int>& get_intervals() const { return key->get_intervals(); }
+    int get_key_signature() const { return key->get_key_signature(); }
+    int get_key_quality() const { return key->get_key_quality(); }
+    bool is_in_scale(int pitch) const { return key->is_in_scale(pitch); }
+    uint16_t get_scale_mask() const { return key->get_scale_mask(); }
+    int position_in_scale(int pitch) const { return key->position_in_scale(pitch); }
+    int next_pitch_in_scale(int pitch) const { return key->next_pitch_in_scale(pitch); }
+    int previous_pitch_in_scale(int pitch) const { return key->previous_pitch_in_scale(pitch); }
+    int get_nth_pitch(int n) const { return key->get_nth_pitch(n); }
+    int get_tonic() const { return key->get_tonic(); }
+    std::vector<int> get_chord(int start_position) const { return key->get_chord(start_position); }
+
+    /**
+     * Returns whether this KeyHandle refers to the same Key as the one passed in.
+     *
+     * @param other The KeyHandle to compare to.
+     * @return Whether the KeyHandles refer to the same Key.
+     */
+    bool equals(const KeyHandle *other) const { return key == other->key; }
+
+    bool operator==(const KeyHandle &other) const { return key == other.key; }
+    bool operator!=(const KeyHandle &other) const { return key != other.key; }
+
+    /**
+     * Returns the number of distinct Keys interned so far.
+     *
+     * @return The number of interned Keys.
+     */
+    static int num_interned() {
+        std::lock_guard<std::mutex> lock(table().mutex);
+        return table().keys.size();
+    }
+
+private:
+
+    /**
+     * The interned Keys, and an index from the tonic and intervals of each Key to
+     * the interned copy. Keys are kept in a deque so they never move.
+     */
+    struct Table {
+        std::mutex mutex;
+        std::deque<Key> keys;
+        std::map<std::pair<int, std::vector<int> >, const Key*> index;
+    };
+
+    static Table& table() {
+        static Table t;
+        return t;
+    }
+
+    /**
+     * Returns the interned default Key. It is interned once, so that default
+     * constructing a KeyHandle takes no lock.
+     */
+    static const Key* default_key() {
+        static const Key *k = intern(Key());
+        return k;
+    }
+
+    /**
+     * Returns the interned Key equal to the given Key, interning it if needed.
+     */
+    static const Key* intern(const Key &k) {
+        Table &t = table();
+        std::pair<int, std::vector<int> > id(k.get_tonic(), k.get_intervals());
+        std::lock_guard<std::mutex> lock(t.mutex);
+        std::map<std::pair<int, std::vector<int> >, const Key*>::iterator it =
+                t.index.find(id);
+        if (it != t.index.end()) {
+            return it->second;
+        }
+        t.keys.push_back(k);
+        t.index[id] = &t.keys.back();
+        return &t.keys.back();
+    }
+
+    const Key *key;
 };
 
 /**
@@ -383,7 +575,7 @@ struct CompositionMetrics {
      * @return true if the composition metrics are the same.
      */
     bool equals(CompositionMetrics *composition_metrics) {
-        if (!key.equals(&composition_metrics->key)) {
+        if (key != composition_metrics->key) {
             return false;
         }
         if (!time_signature.equals(&composition_metrics->time_signature)) {
@@ -398,7 +590,7 @@ struct CompositionMetrics {
         return true;
     }
     
-    Key key;
+    KeyHandle key;
     TimeSignature time_signature;
     unsigned int tempo;
     int position;
@@ -0,0 +1,103 @@
+/*
+ * File:    constant_list.h
+ * Author:  Sam Rappl
+ *
+ */
+
+#ifndef CONSTANT_LIST_H
+#define CONSTANT_LIST_H
+
+#include <cstddef>
+#include <ostream>
+#include <vector>
+
+/**
+ * A ConstantList is a read-only view of a constant array of ints, such as the
+ * chords and scale intervals in constants.h. It does not own or copy the array,
+ * so ConstantLists cost nothing to construct and can be used in constant
+ * expressions. It converts to a std::vector<int> where one is needed.
+ */
+class ConstantList {
+public:
+    typedef int value_type;
+    typedef const int* iterator;
+    typedef const int* const_iterator;
+
+    /**
+     * Constructs a ConstantList viewing the given array.
+     *
+     * @param values The array to view.
+     */
+    template <std::size_t N>
+    constexpr ConstantList(const int (&values)[N]) : values(values), count(N) {}
+
+    /**
+     * Constructs a ConstantList viewing count ints starting at values.
+     *
+     * @param values A pointer to the first int.
+     * @param count The number of ints.
+     */
+    constexpr ConstantList(const int *values, int count) : values(values), count(count) {}
+
+    /**
+     * Returns the number of ints in the list.
+     *
+     * @return The number of ints in the list.
+     */
+    constexpr int size() const { return count; }
+
+    /**
+     * Returns the int at the given index.
+     *
+     * @param i The index of the int.
+     * @return The int at the given index.
+     */
+    constexpr int operator[](int i) const { return values[i]; }
+
+    constexpr const int* begin() const { return values; }
+    constexpr const int* end() const { return values + count; }
+
+    /**
+     * Returns a copy of the list as a vector.
+     *
+     * @return A vector containing the ints in the list.
+     */
+    std::vector<int> to_vector() const { return std::vector<int>(begin(), end()); }
+
+    operator std::vector<int>() const { return to_vector(); }
+
+private:
+    const int *values;
+    int count;
+};
+
+inline bool operator==(ConstantList a, ConstantList b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (int i = 0; i < a.size(); i++) {
+        if (a[i] != b[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+inline bool operator==(ConstantList a, const std::vector<int> &b) {
+    return a == ConstantList(b.data(), b.size());
+}
+
+inline bool operator==(const std::vector<int> &a, ConstantList b) { return b == a; }
+inline bool operator!=(ConstantList a, ConstantList b) { return !(a == b); }
+inline bool operator!=(ConstantList a, const std::vector<int> &b) { return !(a == b); }
+inline bool operator!=(const std::vector<int> &a, ConstantList b) { return !(b == a); }
+
+inline std::ostream& operator<<(std::ostream &os, ConstantList list) {
+    os << "{";
+    for (int i = 0; i < list.size(); i++) {
+        os << (i > 0 ? ", " : " ") << list[i];
+    }
+    return os << " }";
+}
+
+#endif /* CONSTANT_LIST_H */
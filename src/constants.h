@@ -7,7 +7,7 @@
 #ifndef CONSTANTS_H
 #define CONSTANTS_H
 
-#include <vector>
+#include "constant_list.h"
 
 /** FuseMuse Pitches */
 // Octave 0
@@ -300,20 +300,36 @@ const int double_dotted_whole_note = 672;
 
 /** Common Scales */
 // Common Scale Intervals
-const std::vector<int> ionian_intervals = {2, 2, 1, 2, 2, 2, 1};
-const std::vector<int> dorian_intervals = {2, 1, 2, 2, 2, 1, 2};
-const std::vector<int> phrygian_intervals = {1, 2, 2, 2, 1, 2, 2};
-const std::vector<int> lydian_intervals = {2, 2, 2, 1, 2, 2, 1};
-const std::vector<int> mixolydian_intervals = {2, 2, 1, 2, 2, 1, 2};
-const std::vector<int> aeolian_intervals = {2, 1, 2, 2, 1, 2, 2};
-const std::vector<int> locrian_intervals = {1, 2, 2, 1, 2, 2, 2};
-const std::vector<int> major_intervals = ionian_intervals;
-const std::vector<int> minor_intervals = aeolian_intervals;
-const std::vector<int> minor_pentatonic_intervals = {3, 2, 2, 3, 2};
-const std::vector<int> major_pentatonic_intervals = {2, 2, 3, 2, 3};
-const std::vector<int> egyptian_pentatonic_intervals = {2, 3, 2, 3, 2};
-const std::vector<int> man_gong_pentatonic_intervals = {3, 2, 3, 2, 2};
-const std::vector<int> ritsusen_pentatonic_intervals = {2, 3, 2, 2, 3};
+// The arrays behind the ConstantLists (see constant_list.h) below.
+namespace constant_data {
+constexpr int ionian_intervals[] = {2, 2, 1, 2, 2, 2, 1};
+constexpr int dorian_intervals[] = {2, 1, 2, 2, 2, 1, 2};
+constexpr int phrygian_intervals[] = {1, 2, 2, 2, 1, 2, 2};
+constexpr int lydian_intervals[] = {2, 2, 2, 1, 2, 2, 1};
+constexpr int mixolydian_intervals[] = {2, 2, 1, 2, 2, 1, 2};
+constexpr int aeolian_intervals[] = {2, 1, 2, 2, 1, 2, 2};
+constexpr int locrian_intervals[] = {1, 2, 2, 1, 2, 2, 2};
+constexpr int minor_pentatonic_intervals[] = {3, 2, 2, 3, 2};
+constexpr int major_pentatonic_intervals[] = {2, 2, 3, 2, 3};
+constexpr int egyptian_pentatonic_intervals[] = {2, 3, 2, 3, 2};
+constexpr int man_gong_pentatonic_intervals[] = {3, 2, 3, 2, 2};
+constexpr int ritsusen_pentatonic_intervals[] = {2, 3, 2, 2, 3};
+}
+
+constexpr ConstantList ionian_intervals = constant_data::ionian_intervals;
+constexpr ConstantList dorian_intervals = constant_data::dorian_intervals;
+constexpr ConstantList phrygian_intervals = constant_data::phrygian_intervals;
+constexpr ConstantList lydian_intervals = constant_data::lydian_intervals;
+constexpr ConstantList mixolydian_intervals = constant_data::mixolydian_intervals;
+constexpr ConstantList aeolian_intervals = constant_data::aeolian_intervals;
+constexpr ConstantList locrian_intervals = constant_data::locrian_intervals;
+constexpr ConstantList major_intervals = ionian_intervals;
+constexpr ConstantList minor_intervals = aeolian_intervals;
+constexpr ConstantList minor_pentatonic_intervals = constant_data::minor_pentatonic_intervals;
+constexpr ConstantList major_pentatonic_intervals = constant_data::major_pentatonic_intervals;
+constexpr ConstantList egyptian_pentatonic_intervals = constant_data::egyptian_pentatonic_intervals;
+constexpr ConstantList man_gong_pentatonic_intervals = constant_data::man_gong_pentatonic_intervals;
+constexpr ConstantList ritsusen_pentatonic_intervals = constant_data::ritsusen_pentatonic_intervals;
 
 /** Dynamics */
 // Dynamics
@@ -328,107 +344,212 @@ const int fff = 7;
 
 /** Common Chords */
 // Chords
-const std::vector<int> c_major_chord = {c3, e3, g3};
-const std::vector<int> c_minor_chord = {c3, ef3, g3};
-const std::vector<int> c_sus2_chord = {c3, d3, g3};
-const std::vector<int> c_sus4_chord = {c3, f3, g3};
-const std::vector<int> c_major_7_chord = {c3, e3, g3, b3};
-const std::vector<int> c_minor_7_chord = {c3, ef3, g3, bf3};
-const std::vector<int> cs_major_chord = {cs3, f3, gs3};
-const std::vector<int> cs_minor_chord = {cs3, e3, gs3};
-const std::vector<int> cs_sus2_chord = {cs3, ds3, gs3};
-const std::vector<int> cs_sus4_chord = {cs3, fs3, gs3};
-const std::vector<int> cs_major_7_chord = {cs3, f3, gs3, c3};
-const std::vector<int> cs_minor_7_chord = {cs3, e3, gs3, b3};
-const std::vector<int> df_major_chord = {df3, f3, af3};
-const std::vector<int> df_minor_chord = {df3, e3, af3};
-const std::vector<int> df_sus2_chord = {df3, ef3, af3};
-const std::vector<int> df_sus4_chord = {df3, gf3, af3};
-const std::vector<int> df_major_7_chord = {df3, f3, af3, c4};
-const std::vector<int> df_minor_7_chord = {df3, e3, af3, b3};
-const std::vector<int> d_major_chord = {d3, fs3, a3};
-const std::vector<int> d_minor_chord = {d3, f3, a3};
-const std::vector<int> d_sus2_chord = {d3, e3, a3};
-const std::vector<int> d_sus4_chord = {d3, g3, a3};
-const std::vector<int> d_major_7_chord = {d3, fs3, a3, cs4};
-const std::vector<int> d_minor_7_chord = {d3, f3, a3, c4};
-const std::vector<int> ds_major_chord = {ds3, g3, as3};
-const std::vector<int> ds_minor_chord = {ds3, fs3, as3};
-const std::vector<int> ds_sus2_chord = {ds3, f3, as3};
-const std::vector<int> ds_sus4_chord = {ds3, gs3, as3};
-const std::vector<int> ds_major_7_chord = {ds3, g3, as3, d4};
-const std::vector<int> ds_minor_7_chord = {ds3, fs3, as3, cs4};
-const std::vector<int> ef_major_chord = {ef3, g3, bf3};
-const std::vector<int> ef_minor_chord = {ef3, gf3, bf3};
-const std::vector<int> ef_sus2_chord = {ef3, f3, bf3};
-const std::vector<int> ef_sus4_chord = {ef3, af3, bf3};
-const std::vector<int> ef_major_7_chord = {ef3, g3, bf3, d4};
-const std::vector<int> ef_minor_7_chord = {ef3, gf3, bf3, df4};
-const std::vector<int> e_major_chord = {e3, gs3, b3};
-const std::vector<int> e_minor_chord = {e3, g3, b3};
-const std::vector<int> e_sus2_chord = {e3, fs3, b3};
-const std::vector<int> e_sus4_chord = {e3, a3, b3};
-const std::vector<int> e_major_7_chord = {e3, gs3, b3, ds4};
-const std::vector<int> e_minor_7_chord = {e3, g3, b3, d4};
-const std::vector<int> f_major_chord = {f3, a3, c4};
-const std::vector<int> f_minor_chord = {f3, af3, c4};
-const std::vector<int> f_sus2_chord = {f3, g3, c4};
-const std::vector<int> f_sus4_chord = {f3, bf3, c4};
-const std::vector<int> f_major_7_chord = {f3, a3, c4, e4};
-const std::vector<int> f_minor_7_chord = {f3, af3, c4, ef4};
-const std::vector<int> fs_major_chord = {fs3, as3, cs4};
-const std::vector<int> fs_minor_chord = {fs3, a3, cs4};
-const std::vector<int> fs_sus2_chord = {fs3, gs3, cs4};
-const std::vector<int> fs_sus4_chord = {fs3, b3, cs4};
-const std::vector<int> fs_major_7_chord = {fs3, as3, cs4, f4};
-const std::vector<int> fs_minor_7_chord = {fs3, a3, cs4, f4};
-const std::vector<int> gf_major_chord = {gf3, bf3, df4};
-const std::vector<int> gf_minor_chord = {gf3, a3, df4};
-const std::vector<int> gf_sus2_chord = {gf3, af3, df4};
-const std::vector<int> gf_sus4_chord = {gf3, b3, df4};
-const std::vector<int> gf_major_7_chord = {gf3, bf3, df4, f4};
-const std::vector<int> gf_minor_7_chord = {gf3, a3, df4, e4};
-const std::vector<int> g_major_chord = {g3, b3, d4};
-const std::vector<int> g_minor_chord = {g3, bf3, d4};
-const std::vector<int> g_sus2_chord = {g3, a3, d4};
-const std::vector<int> g_sus4_chord = {g3, c4, d4};
-const std::vector<int> g_major_7_chord = {g3, b3, d4, fs4};
-const std::vector<int> g_minor_7_chord = {g3, bf3, d4, f4};
-const std::vector<int> gs_major_chord = {gs3, c4, ds4};
-const std::vector<int> gs_minor_chord = {gs3, b3, ds4};
-const std::vector<int> gs_sus2_chord = {gs3, as3, ds4};
-const std::vector<int> gs_sus4_chord = {gs3, cs4, ds4};
-const std::vector<int> gs_major_7_chord = {gs3, c4, ds4, g4};
-const std::vector<int> gs_minor_7_chord = {gs3, b3, ds4, fs4};
-const std::vector<int> af_major_chord = {af3, c4, ef4};
-const std::vector<int> af_minor_chord = {af3, b3, ef4};
-const std::vector<int> af_sus2_chord = {af3, bf3, ef4};
-const std::vector<int> af_sus4_chord = {af3, df4, ef4};
-const std::vector<int> af_major_7_chord = {af3, c4, ef4, g4};
-const std::vector<int> af_minor_7_chord = {af3, b3, ef4, gf4};
-const std::vector<int> a_major_chord = {a3, cs4, e4};
-const std::vector<int> a_minor_chord = {a3, c4, e4};
-const std::vector<int> a_sus2_chord = {a3, b3, e4};
-const std::vector<int> a_sus4_chord = {a3, d4, e4};
-const std::vector<int> a_major_7_chord = {a3, cs4, e4, gs4};
-const std::vector<int> a_minor_7_chord = {a3, c4, e4, g4};
-const std::vector<int> as_major_chord = {as3, d4, f4};
-const std::vector<int> as_minor_chord = {as3, cs4, f4};
-const std::vector<int> as_sus2_chord = {as3, c4, f4};
-const std::vector<int> as_sus4_chord = {as3, ds4, f4};
-const std::vector<int> as_major_7_chord = {as3, d4, f4, a4};
-const std::vector<int> as_minor_7_chord = {as3, cs4, f4, gs4};
-const std::vector<int> bf_major_chord = {bf3, d4, f4};
-const std::vector<int> bf_minor_chord = {bf3, df4, f4};
-const std::vector<int> bf_sus2_chord = {bf3, c4, f4};
-const std::vector<int> bf_sus4_chord = {bf3, ef4, f4};
-const std::vector<int> bf_major_7_chord = {bf3, d4, f4, a4};
-const std::vector<int> bf_minor_7_chord = {bf3, df4, f4, af4};
-const std::vector<int> b_major_chord = {b3, ds4, fs4};
-const std::vector<int> b_minor_chord = {b3, d4, fs4};
-const std::vector<int> b_sus2_chord = {b3, cs4, fs4};
-const std::vector<int> b_sus4_chord = {b3, e4, fs4};
-const std::vector<int> b_major_7_chord = {b3, ds4, fs4, as4};
-const std::vector<int> b_minor_7_chord = {b3, d4, fs4, a4};
+namespace constant_data {
+constexpr int c_major_chord[] = {c3, e3, g3};
+constexpr int c_minor_chord[] = {c3, ef3, g3};
+constexpr int c_sus2_chord[] = {c3, d3, g3};
+constexpr int c_sus4_chord[] = {c3, f3, g3};
+constexpr int c_major_7_chord[] = {c3, e3, g3, b3};
+constexpr int c_minor_7_chord[] = {c3, ef3, g3, bf3};
+constexpr int cs_major_chord[] = {cs3, f3, gs3};
+constexpr int cs_minor_chord[] = {cs3, e3, gs3};
+constexpr int cs_sus2_chord[] = {cs3, ds3, gs3};
+constexpr int cs_sus4_chord[] = {cs3, fs3, gs3};
+constexpr int cs_major_7_chord[] = {cs3, f3, gs3, c3};
+constexpr int cs_minor_7_chord[] = {cs3, e3, gs3, b3};
+constexpr int df_major_chord[] = {df3, f3, af3};
+constexpr int df_minor_chord[] = {df3, e3, af3};
+constexpr int df_sus2_chord[] = {df3, ef3, af3};
+constexpr int df_sus4_chord[] = {df3, gf3, af3};
+constexpr int df_major_7_chord[] = {df3, f3, af3, c4};
+constexpr int df_minor_7_chord[] = {df3, e3, af3, b3};
+constexpr int d_major_chord[] = {d3, fs3, a3};
+constexpr int d_minor_chord[] = {d3, f3, a3};
+constexpr int d_sus2_chord[] = {d3, e3, a3};
+constexpr int d_sus4_chord[] = {d3, g3, a3};
+constexpr int d_major_7_chord[] = {d3, fs3, a3, cs4};
+constexpr int d_minor_7_chord[] = {d3, f3, a3, c4};
+constexpr int ds_major_chord[] = {ds3, g3, as3};
+constexpr int ds_minor_chord[] = {ds3, fs3, as3};
+constexpr int ds_sus2_chord[] = {ds3, f3, as3};
+constexpr int ds_sus4_chord[] = {ds3, gs3, as3};
+constexpr int ds_major_7_chord[] = {ds3, g3, as3, d4};
+constexpr int ds_minor_7_chord[] = {ds3, fs3, as3, cs4};
+constexpr int ef_major_chord[] = {ef3, g3, bf3};
+constexpr int ef_minor_chord[] = {ef3, gf3, bf3};
+constexpr int ef_sus2_chord[] = {ef3, f3, bf3};
+constexpr int ef_sus4_chord[] = {ef3, af3, bf3};
+constexpr int ef_major_7_chord[] = {ef3, g3, bf3, d4};
+constexpr int ef_minor_7_chord[] = {ef3, gf3, bf3, df4};
+constexpr int e_major_chord[] = {e3, gs3, b3};
+constexpr int e_minor_chord[] = {e3, g3, b3};
+constexpr int e_sus2_chord[] = {e3, fs3, b3};
+constexpr int e_sus4_chord[] = {e3, a3, b3};
+constexpr int e_major_7_chord[] = {e3, gs3, b3, ds4};
+constexpr int e_minor_7_chord[] = {e3, g3, b3, d4};
+constexpr int f_major_chord[] = {f3, a3, c4};
+constexpr int f_minor_chord[] = {f3, af3, c4};
+constexpr int f_sus2_chord[] = {f3, g3, c4};
+constexpr int f_sus4_chord[] = {f3, bf3, c4};
+constexpr int f_major_7_chord[] = {f3, a3, c4, e4};
+constexpr int f_minor_7_chord[] = {f3, af3, c4, ef4};
+constexpr int fs_major_chord[] = {fs3, as3, cs4};
+constexpr int fs_minor_chord[] = {fs3, a3, cs4};
+constexpr int fs_sus2_chord[] = {fs3, gs3, cs4};
+constexpr int fs_sus4_chord[] = {fs3, b3, cs4};
+constexpr int fs_major_7_chord[] = {fs3, as3, cs4, f4};
+constexpr int fs_minor_7_chord[] = {fs3, a3, cs4, f4};
+constexpr int gf_major_chord[] = {gf3, bf3, df4};
+constexpr int gf_minor_chord[] = {gf3, a3, df4};
+constexpr int gf_sus2_chord[] = {gf3, af3, df4};
+constexpr int gf_sus4_chord[] = {gf3, b3, df4};
+constexpr int gf_major_7_chord[] = {gf3, bf3, df4, f4};
+constexpr int gf_minor_7_chord[] = {gf3, a3, df4, e4};
+constexpr int g_major_chord[] = {g3, b3, d4};
+constexpr int g_minor_chord[] = {g3, bf3, d4};
+constexpr int g_sus2_chord[] = {g3, a3, d4};
+constexpr int g_sus4_chord[] = {g3, c4, d4};
+constexpr int g_major_7_chord[] = {g3, b3, d4, fs4};
+constexpr int g_minor_7_chord[] = {g3, bf3, d4, f4};
+constexpr int gs_major_chord[] = {gs3, c4, ds4};
+constexpr int gs_minor_chord[] = {gs3, b3, ds4};
+constexpr int gs_sus2_chord[] = {gs3, as3, ds4};
+constexpr int gs_sus4_chord[] = {gs3, cs4, ds4};
+constexpr int gs_major_7_chord[] = {gs3, c4, ds4, g4};
+constexpr int gs_minor_7_chord[] = {gs3, b3, ds4, fs4};
+constexpr int af_major_chord[] = {af3, c4, ef4};
+constexpr int af_minor_chord[] = {af3, b3, ef4};
+constexpr int af_sus2_chord[] = {af3, bf3, ef4};
+constexpr int af_sus4_chord[] = {af3, df4, ef4};
+constexpr int af_major_7_chord[] = {af3, c4, ef4, g4};
+constexpr int af_minor_7_chord[] = {af3, b3, ef4, gf4};
+constexpr int a_major_chord[] = {a3, cs4, e4};
+constexpr int a_minor_chord[] = {a3, c4, e4};
+constexpr int a_sus2_chord[] = {a3, b3, e4};
+constexpr int a_sus4_chord[] = {a3, d4, e4};
+constexpr int a_major_7_chord[] = {a3, cs4, e4, gs4};
+constexpr int a_minor_7_chord[] = {a3, c4, e4, g4};
+constexpr int as_major_chord[] = {as3, d4, f4};
+constexpr int as_minor_chord[] = {as3, cs4, f4};
+constexpr int as_sus2_chord[] = {as3, c4, f4};
+constexpr int as_sus4_chord[] = {as3, ds4, f4};
+constexpr int as_major_7_chord[] = {as3, d4, f4, a4};
+constexpr int as_minor_7_chord[] = {as3, cs4, f4, gs4};
+constexpr int bf_major_chord[] = {bf3, d4, f4};
+constexpr int bf_minor_chord[] = {bf3, df4, f4};
+constexpr int bf_sus2_chord[] = {bf3, c4, f4};
+constexpr int bf_sus4_chord[] = {bf3, ef4, f4};
+constexpr int bf_major_7_chord[] = {bf3, d4, f4, a4};
+constexpr int bf_minor_7_chord[] = {bf3, df4, f4, af4};
+constexpr int b_major_chord[] = {b3, ds4, fs4};
+constexpr int b_minor_chord[] = {b3, d4, fs4};
+constexpr int b_sus2_chord[] = {b3, cs4, fs4};
+constexpr int b_sus4_chord[] = {b3, e4, fs4};
+constexpr int b_major_7_chord[] = {b3, ds4, fs4, as4};
+constexpr int b_minor_7_chord[] = {b3, d4, fs4, a4};
+}
+
+constexpr ConstantList c_major_chord = constant_data::c_major_chord;
+constexpr ConstantList c_minor_chord = constant_data::c_minor_chord;
+constexpr ConstantList c_sus2_chord = constant_data::c_sus2_chord;
+constexpr ConstantList c_sus4_chord = constant_data::c_sus4_chord;
+constexpr ConstantList c_major_7_chord = constant_data::c_major_7_chord;
+constexpr ConstantList c_minor_7_chord = constant_data::c_minor_7_chord;
+constexpr ConstantList cs_major_chord = constant_data::cs_major_chord;
+constexpr ConstantList cs_minor_chord = constant_data::cs_minor_chord;
+constexpr ConstantList cs_sus2_chord = constant_data::cs_sus2_chord;
+constexpr ConstantList cs_sus4_chord = constant_data::cs_sus4_chord;
+constexpr ConstantList cs_major_7_chord = constant_data::cs_major_7_chord;
+constexpr ConstantList cs_minor_7_chord = constant_data::cs_minor_7_chord;
+constexpr ConstantList df_major_chord = constant_data::df_major_chord;
+constexpr ConstantList df_minor_chord = constant_data::df_minor_chord;
+constexpr ConstantList df_sus2_chord = constant_data::df_sus2_chord;
+constexpr ConstantList df_sus4_chord = constant_data::df_sus4_chord;
+constexpr ConstantList df_major_7_chord = constant_data::df_major_7_chord;
+constexpr ConstantList df_minor_7_chord = constant_data::df_minor_7_chord;
+constexpr ConstantList d_major_chord = constant_data::d_major_chord;
+constexpr ConstantList d_minor_chord = constant_data::d_minor_chord;
+constexpr ConstantList d_sus2_chord = constant_data::d_sus2_chord;
+constexpr ConstantList d_sus4_chord = constant_data::d_sus4_chord;
+constexpr ConstantList d_major_7_chord = constant_data::d_major_7_chord;
+constexpr ConstantList d_minor_7_chord = constant_data::d_minor_7_chord;
+constexpr ConstantList ds_major_chord = constant_data::ds_major_chord;
+constexpr ConstantList ds_minor_chord = constant_data::ds_minor_chord;
+constexpr ConstantList ds_sus2_chord = constant_data::ds_sus2_chord;
+constexpr ConstantList ds_sus4_chord = constant_data::ds_sus4_chord;
+constexpr ConstantList ds_major_7_chord = constant_data::ds_major_7_chord;
+constexpr ConstantList ds_minor_7_chord = constant_data::ds_minor_7_chord;
+constexpr ConstantList ef_major_chord = constant_data::ef_major_chord;
+constexpr ConstantList ef_minor_chord = constant_data::ef_minor_chord;
+constexpr ConstantList ef_sus2_chord = constant_data::ef_sus2_chord;
+constexpr ConstantList ef_sus4_chord = constant_data::ef_sus4_chord;
+constexpr ConstantList ef_major_7_chord = constant_data::ef_major_7_chord;
+constexpr ConstantList ef_minor_7_chord = constant_data::ef_minor_7_chord;
+constexpr ConstantList e_major_chord = constant_data::e_major_chord;
+constexpr ConstantList e_minor_chord = constant_data::e_minor_chord;
+constexpr ConstantList e_sus2_chord = constant_data::e_sus2_chord;
+constexpr ConstantList e_sus4_chord = constant_data::e_sus4_chord;
+constexpr ConstantList e_major_7_chord = constant_data::e_major_7_chord;
+constexpr ConstantList e_minor_7_chord = constant_data::e_minor_7_chord;
+constexpr ConstantList f_major_chord = constant_data::f_major_chord;
+constexpr ConstantList f_minor_chord = constant_data::f_minor_chord;
+constexpr ConstantList f_sus2_chord = constant_data::f_sus2_chord;
+constexpr ConstantList f_sus4_chord = constant_data::f_sus4_chord;
+constexpr ConstantList f_major_7_chord = constant_data::f_major_7_chord;
+constexpr ConstantList f_minor_7_chord = constant_data::f_minor_7_chord;
+constexpr ConstantList fs_major_chord = constant_data::fs_major_chord;
+constexpr ConstantList fs_minor_chord = constant_data::fs_minor_chord;
+constexpr ConstantList fs_sus2_chord = constant_data::fs_sus2_chord;
+constexpr ConstantList fs_sus4_chord = constant_data::fs_sus4_chord;
+constexpr ConstantList fs_major_7_chord = constant_data::fs_major_7_chord;
+constexpr ConstantList fs_minor_7_chord = constant_data::fs_minor_7_chord;
+constexpr ConstantList gf_major_chord = constant_data::gf_major_chord;
+constexpr ConstantList gf_minor_chord = constant_data::gf_minor_chord;
+constexpr ConstantList gf_sus2_chord = constant_data::gf_sus2_chord;
+constexpr ConstantList gf_sus4_chord = constant_data::gf_sus4_chord;
+constexpr ConstantList gf_major_7_chord = constant_data::gf_major_7_chord;
+constexpr ConstantList gf_minor_7_chord = constant_data::gf_minor_7_chord;
+constexpr ConstantList g_major_chord = constant_data::g_major_chord;
+constexpr ConstantList g_minor_chord = constant_data::g_minor_chord;
+constexpr ConstantList g_sus2_chord = constant_data::g_sus2_chord;
+constexpr ConstantList g_sus4_chord = constant_data::g_sus4_chord;
+constexpr ConstantList g_major_7_chord = constant_data::g_major_7_chord;
+constexpr ConstantList g_minor_7_chord = constant_data::g_minor_7_chord;
+constexpr ConstantList gs_major_chord = constant_data::gs_major_chord;
+constexpr ConstantList gs_minor_chord = constant_data::gs_minor_chord;
+constexpr ConstantList gs_sus2_chord = constant_data::gs_sus2_chord;
+constexpr ConstantList gs_sus4_chord = constant_data::gs_sus4_chord;
+constexpr ConstantList gs_major_7_chord = constant_data::gs_major_7_chord;
+constexpr ConstantList gs_minor_7_chord = constant_data::gs_minor_7_chord;
+constexpr ConstantList af_major_chord = constant_data::af_major_chord;
+constexpr ConstantList af_minor_chord = constant_data::af_minor_chord;
+constexpr ConstantList af_sus2_chord = constant_data::af_sus2_chord;
+constexpr ConstantList af_sus4_chord = constant_data::af_sus4_chord;
+constexpr ConstantList af_major_7_chord = constant_data::af_major_7_chord;
+constexpr ConstantList af_minor_7_chord = constant_data::af_minor_7_chord;
+constexpr ConstantList a_major_chord = constant_data::a_major_chord;
+constexpr ConstantList a_minor_chord = constant_data::a_minor_chord;
+constexpr ConstantList a_sus2_chord = constant_data::a_sus2_chord;
+constexpr ConstantList a_sus4_chord = constant_data::a_sus4_chord;
+constexpr ConstantList a_major_7_chord = constant_data::a_major_7_chord;
+constexpr ConstantList a_minor_7_chord = constant_data::a_minor_7_chord;
+constexpr ConstantList as_major_chord = constant_data::as_major_chord;
+constexpr ConstantList as_minor_chord = constant_data::as_minor_chord;
+constexpr ConstantList as_sus2_chord = constant_data::as_sus2_chord;
+constexpr ConstantList as_sus4_chord = constant_data::as_sus4_chord;
+constexpr ConstantList as_major_7_chord = constant_data::as_major_7_chord;
+constexpr ConstantList as_minor_7_chord = constant_data::as_minor_7_chord;
+constexpr ConstantList bf_major_chord = constant_data::bf_major_chord;
+constexpr ConstantList bf_minor_chord = constant_data::bf_minor_chord;
+constexpr ConstantList bf_sus2_chord = constant_data::bf_sus2_chord;
+constexpr ConstantList bf_sus4_chord = constant_data::bf_sus4_chord;
+constexpr ConstantList bf_major_7_chord = constant_data::bf_major_7_chord;
+constexpr ConstantList bf_minor_7_chord = constant_data::bf_minor_7_chord;
+constexpr ConstantList b_major_chord = constant_data::b_major_chord;
+constexpr ConstantList b_minor_chord = constant_data::b_minor_chord;
+constexpr ConstantList b_sus2_chord = constant_data::b_sus2_chord;
+constexpr ConstantList b_sus4_chord = constant_data::b_sus4_chord;
+constexpr ConstantList b_major_7_chord = constant_data::b_major_7_chord;
+constexpr ConstantList b_minor_7_chord = constant_data::b_minor_7_chord;
 
 #endif /* CONSTANTS_H */
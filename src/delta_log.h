@@ -0,0 +1,106 @@
+/*
+ * File:    delta_log.h
+ * Author:  Sam Rappl
+ *
+ */
+
+#ifndef DELTA_LOG_H
+#define DELTA_LOG_H
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+/**
+ * A DeltaLog records changes to a JSON document as RFC 6902 JSON Patch
+ * operations, and remembers how many of them each receiver of the document has
+ * been sent. A receiver which already holds the document can then be sent just
+ * the operations it has not seen, which it applies with nlohmann::json::patch,
+ * instead of the whole document again.
+ */
+class DeltaLog {
+public:
+    DeltaLog() : ops(), sent() {}
+
+    /**
+     * Records an "add" operation.
+     *
+     * @param path The JSON Pointer of the new value, such as "/parts/-".
+     * @param value The new value.
+     */
+    void add(const std::string &path, const nlohmann::json &value) {
+        ops.push_back(nlohmann::json{{"op", "add"}, {"path", path}, {"value", value}});
+    }
+
+    /**
+     * Records a "replace" operation.
+     *
+     * @param path The JSON Pointer of the value to replace.
+     * @param value The new value.
+     */
+    void replace(const std::string &path, const nlohmann::json &value) {
+        ops.push_back(nlohmann::json{{"op", "replace"}, {"path", path}, {"value", value}});
+    }
+
+    /**
+     * Records a "remove" operation.
+     *
+     * @param path The JSON Pointer of the value to remove.
+     */
+    void remove(const std::string &path) {
+        ops.push_back(nlohmann::json{{"op", "remove"}, {"path", path}});
+    }
+
+    /**
+     * Returns whether the given receiver has been sent the document.
+     *
+     * @param receiver The name of the receiver.
+     * @return true if snapshot_sent has been called for the receiver.
+     */
+    bool has_snapshot(const std::string &receiver) const {
+        return sent.find(receiver) != sent.end();
+    }
+
+    /**
+     * Records that the given receiver has been sent the whole document as it is
+     * after every operation recorded so far.
+     *
+     * @param receiver The name of the receiver.
+     */
+    void snapshot_sent(const std::string &receiver) { sent[receiver] = ops.size(); }
+
+    /**
+     * Returns the operations the given receiver has not been sent as a JSON
+     * Patch document, and records that it has now been sent them. The receiver
+     * must have been sent a snapshot.
+     *
+     * @param receiver The name of the receiver.
+     * @return A JSON array of patch operations, which may be empty.
+     */
+    nlohmann::json take_patch(const std::string &receiver) {
+        std::size_t &first = sent[receiver];
+        nlohmann::json patch = nlohmann::json::array();
+        for (std::size_t i = first; i < ops.size(); i++) {
+            patch.push_back(ops[i]);
+        }
+        first = ops.size();
+        return patch;
+    }
+
+    /**
+     * Returns the number of operations recorded.
+     *
+     * @return The number of operations recorded.
+     */
+    int size() const { return ops.size(); }
+
+private:
+    std::vector<nlohmann::json> ops;
+
+    /** The number of operations each receiver has been sent. */
+    std::unordered_map<std::string, std::size_t> sent;
+};
+
+#endif /* DELTA_LOG_H */
@@ -20,7 +20,7 @@ struct Dynamic: public Event {
     /**
      * Constructs a Dynamic object with volume mezzo piano.
      */
-    Dynamic(): volume(mp), cresc(0), decresc(0), duration(0) {}
+    Dynamic(): Event(EVENT_DYNAMIC), volume(mp), cresc(0), decresc(0), duration(0) {}
     
     /**
      * Constructs a Dynamic object with specified volume. Volume parameter is mandatory,
@@ -31,7 +31,7 @@ struct Dynamic: public Event {
      * @param decresc Whether the notes following this Dynamics object are in a decrescendo.
      */
     Dynamic(int volume, int cresc = 0, int decresc = 0) :
-            volume(volume), cresc(cresc), decresc(decresc), duration(0) {}
+            Event(EVENT_DYNAMIC), volume(volume), cresc(cresc), decresc(decresc), duration(0) {}
 
     /**
      * Compares this dynamic with the dynamic passed in and returns true if they are the same.
@@ -7,11 +7,89 @@
 #ifndef EVENT_H
 #define EVENT_H
 
+#include "change_stamp.h"
+
+/**
+ * The kind of a music event. Every Event is tagged with its kind when it is
+ * constructed so that its concrete type can be found without RTTI.
+ */
+enum EventKind {
+    EVENT_NONE = 0,
+    EVENT_NOTE = 1,
+    EVENT_CHORD = 2,
+    EVENT_DYNAMIC = 3
+};
+
 /**
  * An Event or music event is the parent object of Notes, Chords, and Dynamics.
  */
 struct Event {
-    virtual ~Event(){};
+
+    /**
+     * Constructs an Event of the given kind.
+     *
+     * @param kind The kind of the concrete event.
+     */
+    Event(EventKind kind = EVENT_NONE) : stamp(NULL), kind(kind) {}
+
+    /**
+     * Constructs a copy of an Event. The copy is not in a Part yet, so it has
+     * no ChangeStamp.
+     */
+    Event(const Event &other) : stamp(NULL), kind(other.kind) {}
+
+    /**
+     * Copies another Event into this one, which keeps its ChangeStamp and
+     * records that its duration may have changed.
+     */
+    Event& operator=(const Event &other) {
+        kind = other.kind;
+        duration_changed();
+        return *this;
+    }
+
+    virtual ~Event() {
+        if (stamp != NULL) {
+            stamp->release();
+        }
+    }
+
+    /**
+     * Returns the kind of this event.
+     *
+     * @return EVENT_NOTE, EVENT_CHORD or EVENT_DYNAMIC.
+     */
+    EventKind get_kind() const { return kind; }
+
+    bool is_note() const { return kind == EVENT_NOTE; }
+    bool is_chord() const { return kind == EVENT_CHORD; }
+    bool is_dynamic() const { return kind == EVENT_DYNAMIC; }
+
+protected:
+
+    /**
+     * Records that the duration of this event changed, in the ChangeStamp
+     * of the Part it was added to.
+     */
+    void duration_changed() {
+        if (stamp != NULL) {
+            stamp->changed();
+        }
+    }
+
+private:
+    friend class Part;
+
+    /**
+     * The ChangeStamp counting the duration changes of the Part this event
+     * was added to, or NULL if it
+     * has not been added to one. It comes before kind so the members of Notes
+     * and Chords can fill the padding after kind.
+     */
+    ChangeStamp *stamp;
+
+protected:
+    EventKind kind;
 };
 
 #endif /* EVENT_H */
@@ -0,0 +1,63 @@
+/*
+ * File:    event_loop.h
+ * Author:  Sam Rappl
+ *
+ */
+
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+
+/**
+ * An EventLoop runs events on the thread which owns it. Any thread may post an
+ * event, such as the completion of some work started on another thread, and
+ * the owning thread runs them one at a time in the order they were posted, so
+ * the events need no locking of their own.
+ */
+class EventLoop {
+public:
+    EventLoop() : events(), mutex(), posted() {}
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    /**
+     * Queues an event to be run by the owning thread. May be called from any
+     * thread, including from inside an event.
+     *
+     * @param event The event.
+     */
+    void post(std::function<void()> event) {
+        // Notify with the lock held: once the event can be seen, the owning
+        // thread may run it and destroy the loop.
+        std::lock_guard<std::mutex> lock(mutex);
+        events.push_back(std::move(event));
+        posted.notify_one();
+    }
+
+    /**
+     * Waits until an event has been posted and runs it. Exceptions thrown by
+     * the event are passed on to the caller.
+     */
+    void run_one() {
+        std::function<void()> event;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            posted.wait(lock, [this]() { return !events.empty(); });
+            event = std::move(events.front());
+            events.pop_front();
+        }
+        event();
+    }
+
+private:
+    std::deque<std::function<void()> > events;
+    std::mutex mutex;
+    std::condition_variable posted;
+};
+
+#endif /* EVENT_LOOP_H */
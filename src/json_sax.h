@@ -0,0 +1,430 @@
+/*
+ * File:    json_sax.h
+ * Author:  Sam Rappl
+ *
+ */
+
+#ifndef JSON_SAX_H
+#define JSON_SAX_H
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <istream>
+#include <streambuf>
+#include <string>
+#include <nlohmann/json.hpp>
+
+/**
+ * A JSON source reading characters from a string in memory.
+ */
+class JsonStringSource {
+public:
+    JsonStringSource(const char *first, const char *last) : next(first), last(last),
+            first(first) {}
+
+    int peek() const { return next < last ? (unsigned char)*next : EOF; }
+    int get() { return next < last ? (unsigned char)*next++ : EOF; }
+    std::size_t position() const { return next - first; }
+
+private:
+    const char *next;
+    const char *last;
+    const char *first;
+};
+
+/**
+ * A JSON source reading characters from a stream through its buffer, so only
+ * the stream's buffer is held in memory.
+ */
+class JsonStreamSource {
+public:
+    JsonStreamSource(std::istream &in) : buf(in.rdbuf()), count(0) {}
+
+    int peek() const { return buf->sgetc(); }
+    int get() {
+        int c = buf->sbumpc();
+        if (c != EOF) {
+            count++;
+        }
+        return c;
+    }
+    std::size_t position() const { return count; }
+
+private:
+    std::streambuf *buf;
+    std::size_t count;
+};
+
+/**
+ * A JsonSaxParser reads JSON text and reports each value to a handler as it is
+ * read, without building a document in memory. The handler has the same member
+ * functions as nlohmann::json_sax in nlohmann/json 3.2 and later:
+ *
+ *     bool null();
+ *     bool boolean(bool val);
+ *     bool number_integer(int64_t val);
+ *     bool number_unsigned(uint64_t val);
+ *     bool number_float(double val, const std::string &text);
+ *     bool string(std::string &val);
+ *     bool start_object(std::size_t elements);
+ *     bool key(std::string &val);
+ *     bool end_object();
+ *     bool start_array(std::size_t elements);
+ *     bool end_array();
+ *
+ * Returning false from any of them stops the parse. Malformed JSON throws
+ * nlohmann::json::parse_error, as nlohmann::json::parse does, and so do
+ * objects and arrays nested more than max_depth deep, which would otherwise
+ * exhaust the stack.
+ */
+template <typename Source, typename Handler>
+class JsonSaxParser {
+public:
+
+    /** The deepest objects and arrays may be nested. */
+    static const int max_depth = 512;
+
+    /**
+     * Constructs a parser reading from the given source and reporting to the
+     * given handler.
+     */
+    JsonSaxParser(Source &source, Handler &handler) : source(source), handler(handler),
+            text(), depth(0) {}
+
+    /**
+     * Parses one JSON value, which must be followed only by whitespace.
+     *
+     * @return false if the handler stopped the parse.
+     */
+    bool parse() {
+        if (!parse_value()) {
+            return false;
+        }
+        skip_whitespace();
+        if (source.peek() != EOF) {
+            error("expected end of input");
+        }
+        return true;
+    }
+
+private:
+    bool parse_value() {
+        skip_whitespace();
+        int c = source.peek();
+        switch (c) {
+        case '{':
+        case '[': {
+            if (++depth > max_depth) {
+                error("nested too deeply");
+            }
+            bool ok = c == '{' ? parse_object() : parse_array();
+            depth--;
+            return ok;
+        }
+        case '"':
+            source.get();
+            read_string();
+            return handler.string(text);
+        case 't':
+            expect_literal("true");
+            return handler.boolean(true);
+        case 'f':
+            expect_literal("false");
+            return handler.boolean(false);
+        case 'n':
+            expect_literal("null");
+            return handler.null();
+        default:
+            if (c == '-' || (c >= '0' && c <= '9')) {
+                return parse_number();
+            }
+            error("unexpected character");
+            return false;
+        }
+    }
+
+    bool parse_object() {
+        source.get();
+        if (!handler.start_object(std::size_t(-1))) {
+            return false;
+        }
+        skip_whitespace();
+        if (source.peek() == '}') {
+            source.get();
+            return handler.end_object();
+        }
+        while (true) {
+            skip_whitespace();
+            if (source.get() != '"') {
+                error("expected object key");
+            }
+            read_string();
+            if (!handler.key(text)) {
+                return false;
+            }
+            skip_whitespace();
+            if (source.get() != ':') {
+                error("expected ':'");
+            }
+            if (!parse_value()) {
+                return false;
+            }
+            skip_whitespace();
+            int c = source.get();
+            if (c == '}') {
+                return handler.end_object();
+            }
+            if (c != ',') {
+                error("expected ',' or '}'");
+            }
+        }
+    }
+
+    bool parse_array() {
+        source.get();
+        if (!handler.start_array(std::size_t(-1))) {
+            return false;
+        }
+        skip_whitespace();
+        if (source.peek() == ']') {
+            source.get();
+            return handler.end_array();
+        }
+        while (true) {
+            if (!parse_value()) {
+                return false;
+            }
+            skip_whitespace();
+            int c = source.get();
+            if (c == ']') {
+                return handler.end_array();
+            }
+            if (c != ',') {
+                error("expected ',' or ']'");
+            }
+        }
+    }
+
+    /**
+     * Reads a number, which must follow the JSON grammar: an optional minus, an
+     * integer part without leading zeros, an optional fraction with at least
+     * one digit and an optional exponent with at least one digit.
+     */
+    bool parse_number() {
+        text.clear();
+        bool is_float = false;
+        if (source.peek() == '-') {
+            text += (char)source.get();
+        }
+        if (source.peek() == '0') {
+            text += (char)source.get();
+        }
+        else if (!read_digits()) {
+            error("invalid number");
+        }
+        if (source.peek() == '.') {
+            is_float = true;
+            text += (char)source.get();
+            if (!read_digits()) {
+                error("invalid number");
+            }
+        }
+        if (source.peek() == 'e' || source.peek() == 'E') {
+            is_float = true;
+            text += (char)source.get();
+            if (source.peek() == '+' || source.peek() == '-') {
+                text += (char)source.get();
+            }
+            if (!read_digits()) {
+                error("invalid number");
+            }
+        }
+        int c = source.peek();
+        if (c >= '0' && c <= '9') {
+            error("invalid number");
+        }
+        char *end = NULL;
+        if (!is_float) {
+            errno = 0;
+            if (text[0] == '-') {
+                long long value = std::strtoll(text.c_str(), &end, 10);
+                if (errno == 0 && *end == '\0') {
+                    return handler.number_integer(value);
+                }
+            }
+            else {
+                unsigned long long value = std::strtoull(text.c_str(), &end, 10);
+                if (errno == 0 && *end == '\0') {
+                    return handler.number_unsigned(value);
+                }
+            }
+        }
+        double value = std::strtod(text.c_str(), &end);
+        if (*end != '\0') {
+            error("invalid number");
+        }
+        return handler.number_float(value, text);
+    }
+
+    /**
+     * Appends the digits at the front of the source to text.
+     *
+     * @return false if there were none.
+     */
+    bool read_digits() {
+        int c = source.peek();
+        if (c < '0' || c > '9') {
+            return false;
+        }
+        while (c >= '0' && c <= '9') {
+            text += (char)source.get();
+            c = source.peek();
+        }
+        return true;
+    }
+
+    /**
+     * Reads the rest of a string, after its opening quote, into text.
+     */
+    void read_string() {
+        text.clear();
+        while (true) {
+            int c = source.get();
+            if (c == '"') {
+                return;
+            }
+            if (c == EOF || c < 0x20) {
+                error("unterminated string");
+            }
+            if (c != '\\') {
+                text += (char)c;
+                continue;
+            }
+            c = source.get();
+            switch (c) {
+            case '"': text += '"'; break;
+            case '\\': text += '\\'; break;
+            case '/': text += '/'; break;
+            case 'b': text += '\b'; break;
+            case 'f': text += '\f'; break;
+            case 'n': text += '\n'; break;
+            case 'r': text += '\r'; break;
+            case 't': text += '\t'; break;
+            case 'u': append_code_point(); break;
+            default: error("invalid escape");
+            }
+        }
+    }
+
+    /**
+     * Reads the hex digits of a \u escape (and of the low half of a surrogate
+     * pair) and appends the code point to text as UTF-8.
+     */
+    void append_code_point() {
+        unsigned long cp = read_hex4();
+        if (cp >= 0xdc00 && cp <= 0xdfff) {
+            error("low surrogate without a high surrogate");
+        }
+        if (cp >= 0xd800 && cp <= 0xdbff) {
+            if (source.get() != '\\' || source.get() != 'u') {
+                error("expected low surrogate");
+            }
+            unsigned long low = read_hex4();
+            if (low < 0xdc00 || low > 0xdfff) {
+                error("expected low surrogate");
+            }
+            cp = 0x10000 + ((cp - 0xd800) << 10) + (low - 0xdc00);
+        }
+        if (cp < 0x80) {
+            text += (char)cp;
+        }
+        else if (cp < 0x800) {
+            text += (char)(0xc0 | (cp >> 6));
+            text += (char)(0x80 | (cp & 0x3f));
+        }
+        else if (cp < 0x10000) {
+            text += (char)(0xe0 | (cp >> 12));
+            text += (char)(0x80 | ((cp >> 6) & 0x3f));
+            text += (char)(0x80 | (cp & 0x3f));
+        }
+        else {
+            text += (char)(0xf0 | (cp >> 18));
+            text += (char)(0x80 | ((cp >> 12) & 0x3f));
+            text += (char)(0x80 | ((cp >> 6) & 0x3f));
+            text += (char)(0x80 | (cp & 0x3f));
+        }
+    }
+
+    unsigned long read_hex4() {
+        unsigned long value = 0;
+        for (int i = 0; i < 4; i++) {
+            int c = source.get();
+            value <<= 4;
+            if (c >= '0' && c <= '9') { value |= c - '0'; }
+            else if (c >= 'a' && c <= 'f') { value |= c - 'a' + 10; }
+            else if (c >= 'A' && c <= 'F') { value |= c - 'A' + 10; }
+            else { error("invalid \\u escape"); }
+        }
+        return value;
+    }
+
+    void expect_literal(const char *literal) {
+        for (const char *p = literal; *p != '\0'; p++) {
+            if (source.get() != *p) {
+                error(std::string("expected ") + literal);
+            }
+        }
+    }
+
+    void skip_whitespace() {
+        int c = source.peek();
+        while (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+            source.get();
+            c = source.peek();
+        }
+    }
+
+    void error(const std::string &message) {
+        throw nlohmann::json::parse_error::create(101, source.position(), message);
+    }
+
+    Source &source;
+    Handler &handler;
+
+    /** The text of the string, key or number being read. */
+    std::string text;
+
+    /** The number of objects and arrays open around the value being read. */
+    int depth;
+};
+
+/**
+ * Parses the given JSON text, reporting each value to the given handler (see
+ * JsonSaxParser).
+ *
+ * @param json The JSON text.
+ * @param handler The handler to report values to.
+ * @return false if the handler stopped the parse.
+ */
+template <typename Handler>
+bool json_sax_parse(const std::string &json, Handler &handler) {
+    JsonStringSource source(json.data(), json.data() + json.size());
+    return JsonSaxParser<JsonStringSource, Handler>(source, handler).parse();
+}
+
+/**
+ * Parses the JSON text read from the given stream, reporting each value to the
+ * given handler (see JsonSaxParser).
+ *
+ * @param in The stream to read from.
+ * @param handler The handler to report values to.
+ * @return false if the handler stopped the parse.
+ */
+template <typename Handler>
+bool json_sax_parse(std::istream &in, Handler &handler) {
+    JsonStreamSource source(in);
+    return JsonSaxParser<JsonStreamSource, Handler>(source, handler).parse();
+}
+
+#endif /* JSON_SAX_H */
@@ -0,0 +1,682 @@
+/*
+ * File:    json_writer.h
+ * Author:  Sam Rappl
+ *
+ */
+
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "composition.h"
+#include "visit.h"
+
+/**
+ * A WriterOutput collects the bytes written by a JsonWriter, CborWriter or
+ * MsgpackWriter in a string, or in a buffer which it writes to a stream
+ * whenever the buffer fills.
+ */
+class WriterOutput {
+public:
+
+    /**
+     * Constructs a WriterOutput which appends to the given string.
+     *
+     * @param out The string to append to.
+     */
+    WriterOutput(std::string &out) : buf(out), own_buf(), stream(NULL) {}
+
+    /**
+     * Constructs a WriterOutput which writes to the given stream through a
+     * buffer of flush_size bytes.
+     *
+     * @param out The stream to write to.
+     */
+    WriterOutput(std::ostream &out) : buf(own_buf), own_buf(), stream(&out) {
+        own_buf.reserve(flush_size + 256);
+    }
+
+    ~WriterOutput() { flush(); }
+
+    /**
+     * Writes any buffered bytes to the stream. Does nothing when writing to a
+     * string.
+     */
+    void flush() {
+        if (stream != NULL && !buf.empty()) {
+            stream->write(buf.data(), buf.size());
+            buf.clear();
+        }
+    }
+
+protected:
+
+    /** The size at which the buffer is written to the stream. */
+    static const std::string::size_type flush_size = 1 << 16;
+
+    void put(unsigned char c) { buf += (char)c; }
+
+    /**
+     * Appends the low bytes bytes of v, most significant first, as CBOR and
+     * MessagePack store numbers.
+     */
+    void put_big_endian(uint64_t v, int bytes) {
+        for (int shift = 8 * (bytes - 1); shift >= 0; shift -= 8) {
+            buf += (char)(v >> shift);
+        }
+    }
+
+    /**
+     * Writes the buffer to the stream if it has filled. Called after each value.
+     */
+    void end_value() {
+        if (stream != NULL && buf.size() >= flush_size) {
+            flush();
+        }
+    }
+
+    std::string &buf;
+
+private:
+    std::string own_buf;
+    std::ostream *stream;
+};
+
+/**
+ * A JsonWriter writes JSON text. Keys and values are written in the order they
+ * are given, and commas are added between them. Numbers are formatted without
+ * allocating, so after the buffer has grown to its working size writing does
+ * not allocate at all. The sizes given to begin_object and begin_array are only
+ * needed by the binary writers and are ignored.
+ */
+class JsonWriter : public WriterOutput {
+public:
+    JsonWriter(std::string &out) : WriterOutput(out), need_comma(false) {}
+    JsonWriter(std::ostream &out) : WriterOutput(out), need_comma(false) {}
+
+    void begin_object(int) { separate(); buf += '{'; need_comma = false; }
+    void end_object() { buf += '}'; end_json_value(); }
+    void begin_array(int) { separate(); buf += '['; need_comma = false; }
+    void end_array() { buf += ']'; end_json_value(); }
+
+    /**
+     * Writes an object key, which must not need escaping.
+     *
+     * @param k The key.
+     */
+    void key(const char *k) {
+        separate();
+        buf += '"';
+        buf += k;
+        buf += "\":";
+        need_comma = false;
+    }
+
+    void value(int v) {
+        separate();
+        if (v < 0) {
+            buf += '-';
+        }
+        append_digits(v < 0 ? 0u - (unsigned int)v : (unsigned int)v);
+        end_json_value();
+    }
+
+    void value(unsigned int v) {
+        separate();
+        append_digits(v);
+        end_json_value();
+    }
+
+    void value(bool v) {
+        separate();
+        buf += v ? "true" : "false";
+        end_json_value();
+    }
+
+    /**
+     * Writes a string value, escaped the way nlohmann::json::dump escapes it.
+     *
+     * @param s The string.
+     */
+    void value(const std::string &s) { string_value(s.data(), s.size()); }
+    void value(const char *s) { string_value(s, std::strlen(s)); }
+
+private:
+    void separate() {
+        if (need_comma) {
+            buf += ',';
+        }
+    }
+
+    void end_json_value() {
+        need_comma = true;
+        end_value();
+    }
+
+    void append_digits(unsigned int u) {
+        char digits[10];
+        char *p = digits + sizeof(digits);
+        do {
+            *--p = '0' + u % 10;
+            u /= 10;
+        } while (u != 0);
+        buf.append(p, digits + sizeof(digits) - p);
+    }
+
+    void string_value(const char *s, std::string::size_type n) {
+        separate();
+        buf += '"';
+        for (std::string::size_type i = 0; i < n; i++) {
+            unsigned char c = s[i];
+            switch (c) {
+            case '"': buf += "\\\""; break;
+            case '\\': buf += "\\\\"; break;
+            case '\b': buf += "\\b"; break;
+            case '\f': buf += "\\f"; break;
+            case '\n': buf += "\\n"; break;
+            case '\r': buf += "\\r"; break;
+            case '\t': buf += "\\t"; break;
+            default:
+                if (c < 0x20) {
+                    const char *hex = "0123456789abcdef";
+                    buf += "\\u00";
+                    buf += hex[c >> 4];
+                    buf += hex[c & 0xf];
+                }
+                else {
+                    buf += (char)c;
+                }
+            }
+        }
+        buf += '"';
+        end_json_value();
+    }
+
+    bool need_comma;
+};
+
+/**
+ * A CborWriter writes the same document as a JsonWriter encoded as CBOR, byte
+ * for byte as nlohmann::json::to_cbor encodes it.
+ */
+class CborWriter : public WriterOutput {
+public:
+    CborWriter(std::string &out) : WriterOutput(out) {}
+    CborWriter(std::ostream &out) : WriterOutput(out) {}
+
+    void begin_object(int size) { head(0xa0, size); }
+    void end_object() { end_value(); }
+    void begin_array(int size) { head(0x80, size); }
+    void end_array() { end_value(); }
+    void key(const char *k) { string_value(k, std::strlen(k)); }
+
+    void value(int v) {
+        if (v >= 0) {
+            head(0x00, v);
+        }
+        else {
+            head(0x20, (uint64_t)(-1 - (int64_t)v));
+        }
+        end_value();
+    }
+
+    void value(unsigned int v) { head(0x00, v); end_value(); }
+    void value(bool v) { put(v ? 0xf5 : 0xf4); end_value(); }
+    void value(const std::string &s) { string_value(s.data(), s.size()); }
+    void value(const char *s) { string_value(s, std::strlen(s)); }
+
+private:
+
+    /**
+     * Writes the initial byte of a CBOR item of the given major type, and the
+     * argument n in the fewest bytes that hold it.
+     */
+    void head(unsigned char major, uint64_t n) {
+        if (n <= 0x17) {
+            put(major | n);
+        }
+        else if (n <= 0xff) {
+            put(major | 0x18);
+            put(n);
+        }
+        else if (n <= 0xffff) {
+            put(major | 0x19);
+            put_big_endian(n, 2);
+        }
+        else if (n <= 0xffffffff) {
+            put(major | 0x1a);
+            put_big_endian(n, 4);
+        }
+        else {
+            put(major | 0x1b);
+            put_big_endian(n, 8);
+        }
+    }
+
+    void string_value(const char *s, std::string::size_type n) {
+        head(0x60, n);
+        buf.append(s, n);
+        end_value();
+    }
+};
+
+/**
+ * A MsgpackWriter writes the same document as a JsonWriter encoded as
+ * MessagePack, byte for byte as nlohmann::json::to_msgpack encodes it.
+ */
+class MsgpackWriter : public WriterOutput {
+public:
+    MsgpackWriter(std::string &out) : WriterOutput(out) {}
+    MsgpackWriter(std::ostream &out) : WriterOutput(out) {}
+
+    void begin_object(int size) { container(0x80, 0xde, size); }
+    void end_object() { end_value(); }
+    void begin_array(int size) { container(0x90, 0xdc, size); }
+    void end_array() { end_value(); }
+    void key(const char *k) { string_value(k, std::strlen(k)); }
+
+    void value(int v) {
+        if (v >= 0) {
+            value((unsigned int)v);
+            return;
+        }
+        if (v >= -32) {
+            put(v);
+        }
+        else if (v >= -128) {
+            put(0xd0);
+            put(v);
+        }
+        else if (v >= -32768) {
+            put(0xd1);
+            put_big_endian(v, 2);
+        }
+        else {
+            put(0xd2);
+            put_big_endian(v, 4);
+        }
+        end_value();
+    }
+
+    void value(unsigned int v) {
+        if (v < 128) {
+            put(v);
+        }
+        else if (v <= 0xff) {
+            put(0xcc);
+            put(v);
+        }
+        else if (v <= 0xffff) {
+            put(0xcd);
+            put_big_endian(v, 2);
+        }
+        else {
+            put(0xce);
+            put_big_endian(v, 4);
+        }
+        end_value();
+    }
+
+    void value(bool v) { put(v ? 0xc3 : 0xc2); end_value(); }
+    void value(const std::string &s) { string_value(s.data(), s.size()); }
+    void value(const char *s) { string_value(s, std::strlen(s)); }
+
+private:
+
+    /**
+     * Writes the header of a map or array of the given size, using the fix form
+     * for up to 15 elements, else the 16 bit form (wide) or the 32 bit form
+     * after it.
+     */
+    void container(unsigned char fix, unsigned char wide, uint32_t size) {
+        if (size <= 15) {
+            put(fix | size);
+        }
+        else if (size <= 0xffff) {
+            put(wide);
+            put_big_endian(size, 2);
+        }
+        else {
+            put(wide + 1);
+            put_big_endian(size, 4);
+        }
+    }
+
+    void string_value(const char *s, std::string::size_type n) {
+        if (n <= 31) {
+            put(0xa0 | n);
+        }
+        else if (n <= 0xff) {
+            put(0xd9);
+            put(n);
+        }
+        else if (n <= 0xffff) {
+            put(0xda);
+            put_big_endian(n, 2);
+        }
+        else {
+            put(0xdb);
+            put_big_endian(n, 4);
+        }
+        buf.append(s, n);
+        end_value();
+    }
+};
+
+// *********************ARTICULATIONS**********************
+/**
+ * The articulation bit numbers in the alphabetical order of their keys, which
+ * is the order nlohmann::json writes object keys in: accent, dotted,
+ * double_dotted, fermata, slurred, staccato, tenuto, tied, triplet.
+ */
+const int sorted_articulations[num_note_articulations] = { 5, 1, 2, 6, 8, 3, 4, 7, 0 };
+
+/**
+ * Writes the articulations set in flags whose keys sort before the given key,
+ * starting from sorted_articulations[next], and advances next past them.
+ *
+ * @param w The writer.
+ * @param flags The articulation flags of a Note or Chord.
+ * @param before The next key of the event, or NULL to write the rest.
+ * @param next The index in sorted_articulations of the next articulation.
+ */
+template <typename Writer>
+void write_articulations(Writer &w, uint16_t flags, const char *before, int &next) {
+    for (; next < num_note_articulations; next++) {
+        int bit = sorted_articulations[next];
+        const char *k = articulation_keys[bit];
+        if (before != NULL && std::strcmp(k, before) > 0) {
+            return;
+        }
+        if (flags & (1 << bit)) {
+            w.key(k);
+            w.value(1);
+        }
+    }
+}
+
+/**
+ * Returns the number of articulations set in the flags of a Note or Chord.
+ */
+inline int count_articulations(uint16_t flags) {
+    int count = 0;
+    for (int bit = 0; bit < num_note_articulations; bit++) {
+        count += (flags >> bit) & 1;
+    }
+    return count;
+}
+
+// *************************EVENTS*************************
+template <typename Writer>
+void write_value(Writer &w, const Note &note) {
+    int next = 0;
+    w.begin_object(3 + count_articulations(note.flags));
+    write_articulations(w, note.flags, "duration", next);
+    w.key("duration");
+    w.value(note.get_duration());
+    write_articulations(w, note.flags, "pitch", next);
+    w.key("pitch");
+    w.value(note.pitch);
+    write_articulations(w, note.flags, "type", next);
+    w.key("type");
+    w.value("note");
+    write_articulations(w, note.flags, NULL, next);
+    w.end_object();
+}
+
+template <typename Writer>
+void write_value(Writer &w, const Chord &chord) {
+    int next = 0;
+    w.begin_object(3 + count_articulations(chord.flags));
+    write_articulations(w, chord.flags, "duration", next);
+    w.key("duration");
+    w.value(chord.get_duration());
+    write_articulations(w, chord.flags, "pitches", next);
+    w.key("pitches");
+    w.begin_array(chord.pitches.size());
+    for (int i = 0; i < chord.pitches.size(); i++) {
+        w.value(chord.pitches[i]);
+    }
+    w.end_array();
+    write_articulations(w, chord.flags, "type", next);
+    w.key("type");
+    w.value("chord");
+    write_articulations(w, chord.flags, NULL, next);
+    w.end_object();
+}
+
+template <typename Writer>
+void write_value(Writer &w, const Dynamic &dynamic) {
+    w.begin_object(2 + (dynamic.cresc == 1) + (dynamic.decresc == 1));
+    if (dynamic.cresc == 1) {
+        w.key("cresc");
+        w.value(1);
+    }
+    if (dynamic.decresc == 1) {
+        w.key("decresc");
+        w.value(1);
+    }
+    w.key("type");
+    w.value("dynamic");
+    w.key("volume");
+    w.value(dynamic.volume);
+    w.end_object();
+}
+
+/**
+ * A visitor which writes the document of a music event.
+ */
+template <typename Writer>
+struct EventWriter {
+    EventWriter(Writer &w) : w(w) {}
+    void operator()(const Note &n) { write_value(w, n); }
+    void operator()(const Chord &c) { write_value(w, c); }
+    void operator()(const Dynamic &d) { write_value(w, d); }
+    Writer &w;
+};
+
+// ************************PART****************************
+template <typename Writer>
+void write_value(Writer &w, const Part &part) {
+    w.begin_object(3);
+    w.key("events");
+    w.begin_array(part.const_end() - part.const_begin());
+    std::vector<Event*>::const_iterator it;
+    for (it = part.const_begin(); it != part.const_end(); it++) {
+        visit(**it, EventWriter<Writer>(w));
+    }
+    w.end_array();
+    w.key("length");
+    w.value(part.get_length());
+    w.key("name");
+    w.value(part.get_name());
+    w.end_object();
+}
+
+// ******************PATTERN SEGMENT***********************
+template <typename Writer>
+void write_value(Writer &w, const PatternSegment &pattern_segment) {
+    w.begin_object(3);
+    w.key("chord_progression");
+    write_value(w, pattern_segment.get_chord_progression());
+    w.key("duration");
+    w.value(pattern_segment.get_duration());
+    w.key("name");
+    w.value(pattern_segment.get_name());
+    w.end_object();
+}
+
+// *****************COMPOSITION METRICS********************
+template <typename Writer>
+void write_value(Writer &w, const Key &key) {
+    const std::vector<int> &intervals = key.get_intervals();
+    w.begin_object(2);
+    w.key("intervals");
+    w.begin_array(intervals.size());
+    for (int i = 0; i < intervals.size(); i++) {
+        w.value(intervals[i]);
+    }
+    w.end_array();
+    w.key("tonic");
+    w.value(key.get_tonic());
+    w.end_object();
+}
+
+template <typename Writer>
+void write_value(Writer &w, const TimeSignature &time_signature) {
+    w.begin_object(2);
+    w.key("denom");
+    w.value((int)time_signature.denom);
+    w.key("num");
+    w.value((int)time_signature.num);
+    w.end_object();
+}
+
+template <typename Writer>
+void write_value(Writer &w, const CompositionMetrics &composition_metrics) {
+    w.begin_object(4);
+    w.key("key");
+    write_value(w, composition_metrics.key.get());
+    w.key("position");
+    w.value(composition_metrics.position);
+    w.key("tempo");
+    w.value(composition_metrics.tempo);
+    w.key("time_signature");
+    write_value(w, composition_metrics.time_signature);
+    w.end_object();
+}
+
+// ********************PACKET PART*************************
+template <typename Writer>
+void write_value(Writer &w, const PacketPart &packet_part) {
+    const std::vector<PacketPart*> &children = packet_part.get_children();
+    w.begin_object(6);
+    w.key("children");
+    w.begin_array(children.size());
+    for (int i = 0; i < children.size(); i++) {
+        write_value(w, *children[i]);
+    }
+    w.end_array();
+    w.key("executed");
+    w.value(packet_part.has_been_executed());
+    w.key("is_active");
+    w.value(packet_part.is_active());
+    w.key("mode");
+    w.value(packet_part.get_mode());
+    w.key("packet_path");
+    w.value(packet_part.get_packet_path());
+    w.key("part");
+    write_value(w, packet_part.get_part());
+    w.end_object();
+}
+
+// ********************COMPOSITION*************************
+template <typename Writer>
+void write_value(Writer &w, const Composition &comp) {
+    const std::vector<CompositionMetrics*> &metrics = comp.get_all_composition_metrics();
+    const std::vector<Part*> &parts = comp.get_parts();
+    const std::vector<std::string> &pattern = comp.get_pattern();
+    const std::vector<PatternSegment*> &segments = comp.get_pattern_segments();
+    w.begin_object(comp.get_packet_tree_root() ? 5 : 4);
+    w.key("metrics");
+    w.begin_array(metrics.size());
+    for (int i = 0; i < metrics.size(); i++) {
+        write_value(w, *metrics[i]);
+    }
+    w.end_array();
+    if (comp.get_packet_tree_root()) {
+        w.key("packet_tree_root");
+        write_value(w, *comp.get_packet_tree_root());
+    }
+    w.key("parts");
+    w.begin_array(parts.size());
+    for (int i = 0; i < parts.size(); i++) {
+        write_value(w, *parts[i]);
+    }
+    w.end_array();
+    w.key("pattern");
+    w.begin_array(pattern.size());
+    for (int i = 0; i < pattern.size(); i++) {
+        w.value(pattern[i]);
+    }
+    w.end_array();
+    w.key("pattern_segments");
+    w.begin_array(segments.size());
+    for (int i = 0; i < segments.size(); i++) {
+        write_value(w, *segments[i]);
+    }
+    w.end_array();
+    w.end_object();
+}
+
+/**
+ * Writes the JSON form of a Part, PatternSegment, CompositionMetrics,
+ * PacketPart or Composition to the given stream without building a JSON
+ * document. The text is the same as nlohmann::json::dump of the JSON built by
+ * to_json in utilities.h.
+ *
+ * @param out The stream to write to.
+ * @param value The object to write.
+ */
+template <typename T>
+void write_json(std::ostream &out, const T &value) {
+    JsonWriter w(out);
+    write_value(w, value);
+}
+
+/**
+ * Returns the JSON form of a Part, PatternSegment, CompositionMetrics,
+ * PacketPart or Composition as a string, without building a JSON document.
+ * The text is the same as nlohmann::json::dump of the JSON built by to_json in
+ * utilities.h.
+ *
+ * @param value The object to write.
+ * @return The JSON text.
+ */
+template <typename T>
+std::string to_json_string(const T &value) {
+    std::string out;
+    JsonWriter w(out);
+    write_value(w, value);
+    return out;
+}
+
+/**
+ * Returns the JSON form of a Part, PatternSegment, CompositionMetrics,
+ * PacketPart or Composition encoded as CBOR, without building a JSON document.
+ * The bytes are the same as nlohmann::json::to_cbor of the JSON built by
+ * to_json in utilities.h.
+ *
+ * @param value The object to write.
+ * @return The CBOR bytes.
+ */
+template <typename T>
+std::string to_cbor_string(const T &value) {
+    std::string out;
+    CborWriter w(out);
+    write_value(w, value);
+    return out;
+}
+
+/**
+ * Returns the JSON form of a Part, PatternSegment, CompositionMetrics,
+ * PacketPart or Composition encoded as MessagePack, without building a JSON
+ * document. The bytes are the same as nlohmann::json::to_msgpack of the JSON
+ * built by to_json in utilities.h.
+ *
+ * @param value The object to write.
+ * @return The MessagePack bytes.
+ */
+template <typename T>
+std::string to_msgpack_string(const T &value) {
+    std::string out;
+    MsgpackWriter w(out);
+    write_value(w, value);
+    return out;
+}
+
+#endif /* JSON_WRITER_H */
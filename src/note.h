@@ -9,18 +9,17 @@
 
 #include "constants.h"
 #include "event.h"
+#include "articulation.h"
 
 /**
  * A Note is an object that represents a music note with pitch and duration.
  */
-struct Note: public Event {
+struct Note: public Event, public Articulated {
 
     /**
      * Constructs a Note object with the pitch c4 and the duration of a quarter note.
      */
-    Note(): pitch(c4), duration(quarter_note), triplet(0),
-            dotted(0), double_dotted(0), staccato(0), tenuto(0),
-            accent(0), fermata(0), tied(0), slurred(0){}
+    Note(): Event(EVENT_NOTE), pitch(c4), duration(quarter_note) {}
 
     /**
      * Constructs a Note object with specified pitch and duration. Pitch and duration
@@ -41,11 +40,10 @@ struct Note: public Event {
     Note(int pitch, int duration, bool triplet = false, bool dotted = false,
             bool double_dotted = false, bool staccato = false, bool tenuto = false,
             bool accent = false, bool fermata = false, bool tied = false,
-            bool slurred = false) : pitch(pitch), duration(duration),
-            triplet(triplet), dotted(dotted),
-            double_dotted(double_dotted), staccato(staccato),
-            tenuto(tenuto), accent(accent), fermata(fermata),
-            tied(tied), slurred(slurred){}
+            bool slurred = false) : Event(EVENT_NOTE),
+            Articulated(pack(triplet, dotted, double_dotted, staccato, tenuto,
+            accent, fermata, tied, slurred)),
+            pitch(pitch), duration(duration) {}
 
     /**
      * Adds a dot to the note (which turns on the dotted flag and increases the duration
@@ -55,21 +53,23 @@ struct Note: public Event {
      * @return Whether the note was dotted.
      */
     bool dot() {
-        if (!dotted) {
+        if (!is_dotted()) {
             if (duration == one_twenty_eighth_note) {
                 return false;
             } else {
-                dotted = true;
+                set_dotted();
                 duration *= 1.5;
+                duration_changed();
             }
 			return true;
-        } else if (dotted && !double_dotted) {
+        } else if (!is_double_dotted()) {
             if (duration == dotted_sixty_fourth_note) {
                 return false;
             } else {
-                double_dotted = true;
+                set_double_dotted();
                 duration /= 6;
                 duration *= 7;
+                duration_changed();
             }
 			return true;
         }
@@ -82,15 +82,16 @@ struct Note: public Event {
      * @return Whether the note was double dotted.
      */
     bool double_dot() {
-        if (dotted) {
+        if (is_dotted()) {
             return false;
         } else if (duration == one_twenty_eighth_note || duration == sixty_fourth_note) {
             return false;
         } else {
-            dotted = true;
-            double_dotted = true;
+            set_dotted();
+            set_double_dotted();
             duration /= 4;
             duration *= 7;
+            duration_changed();
         }
 		return true;
     }
@@ -102,12 +103,13 @@ struct Note: public Event {
      * @return Whether the note was added to a triplet.
      */
     bool put_in_triplet() {
-        if (triplet) {
+        if (is_triplet()) {
             return false;
         } else {
-            triplet = true;
+            set_triplet();
             duration /= 3;
             duration *= 2;
+            duration_changed();
         }
 		return true;
     }
@@ -125,47 +127,38 @@ struct Note: public Event {
         if (duration != note->duration) {
             return false;
         }
-        if (triplet != note->triplet) {
-            return false;
-        }
-        if (dotted != note->dotted) {
-            return false;
-        }
-        if (double_dotted != note->double_dotted) {
-            return false;
-        }
-        if (staccato != note->staccato) {
-            return false;
-        }
-        if (tenuto != note->tenuto) {
-            return false;
-        }
-        if (accent != note->accent) {
-            return false;
-        }
-        if (fermata != note->fermata) {
-            return false;
-        }
-        if (tied != note->tied) {
-            return false;
-        }
-        if (slurred != note->slurred) {
+        if (flags != note->flags) {
             return false;
         }
         return true;
     }
 
+    /**
+     * Returns the duration of the note.
+     *
+     * @return The duration of the note.
+     */
+    int get_duration() const { return duration; }
+
+    /**
+     * Sets the duration of the note. Its articulation flags are not changed.
+     *
+     * @param d The new duration of the note.
+     */
+    void set_duration(int d) {
+        duration = d;
+        duration_changed();
+    }
+
     int pitch;
+
+private:
+
+    /**
+     * The duration of the note. It is private so that every change is
+     * recorded for the Part the note is in (see Event::duration_changed).
+     */
     int duration;
-    bool triplet;
-    bool dotted;
-    bool double_dotted;
-    bool staccato;
-    bool tenuto;
-    bool accent;
-    bool fermata;
-    bool tied;
-    bool slurred;
 };
 
 
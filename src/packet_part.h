@@ -7,14 +7,22 @@
 #ifndef PACKETPART_H
 #define PACKETPART_H
 
+#include <memory>
 #include <vector>
 #include <string>
+#include "arena.h"
 #include "part.h"
+#include "visit.h"
 
 /**
  * A PacketPart is a wrapper for a Packet that contains the path of the Packet,
  * the part it generated, and whether it has executed yet or is currently being
  * executed. It is also a tree node.
+ *
+ * A PacketPart is dirty if it has not been executed. Changing its packet or
+ * mode once it has been executed, or changing the Part it produced, marks the
+ * PacketParts which depend on the change dirty, so that the next run executes
+ * only them and reuses the Parts of the rest.
  */
 class PacketPart {
 public:
@@ -22,7 +30,7 @@ public:
     /**
      * Constructs an empty PacketPart.
      */
-    PacketPart() : parent(NULL), children(), part(), packet_path(), mode(),
+    PacketPart() : parent(NULL), children(), part(), part_arena(), packet_path(), mode(),
             executed(false), active(false){}
     
     /**
@@ -93,9 +101,57 @@ public:
      * Sets the Part produced by this PacketPart.
      *
      * @param p The Part produced by this PacketPart.
+     * @param events The Arena which owns the Part's events, kept alive for as
+     *         long as this PacketPart has the Part, or null if they are owned
+     *         elsewhere.
      */
-    void set_part(Part p) {
+    void set_part(Part p, std::shared_ptr<Arena> events = std::shared_ptr<Arena>()) {
         part = p;
+        part_arena = events;
+    }
+
+    /**
+     * Returns the Arena which owns the events of this PacketPart's Part, or
+     * null if they are owned elsewhere. A Composition the Part is added to
+     * keeps it (see Composition::keep_arena).
+     *
+     * @return The Arena of this PacketPart's Part.
+     */
+    std::shared_ptr<Arena> get_part_arena() const { return part_arena; }
+
+    /**
+     * Replaces the Part produced by this PacketPart, as when it is edited by
+     * hand. Its descendants were run on the old Part, so they are marked
+     * dirty. This PacketPart keeps the new Part and is not.
+     *
+     * The new Part is usually a copy of the old one, sharing its events, so
+     * they are copied into an Arena of this PacketPart's own. The Arena of the
+     * old Part is then let go, and is freed once no Composition keeps it.
+     *
+     * @param p The new Part of this PacketPart.
+     */
+    void edit_part(Part p) {
+        std::shared_ptr<Arena> events(new Arena());
+        Part copy(p.get_name());
+        for (std::vector<Event*>::const_iterator it = p.const_begin(); it != p.const_end(); it++) {
+            visit(**it, CopyEvent(*events, copy));
+        }
+        edit_part(copy, events);
+    }
+
+    /**
+     * Replaces the Part produced by this PacketPart, as edit_part(Part) does,
+     * with a Part whose events are owned by the given Arena.
+     *
+     * @param p The new Part of this PacketPart.
+     * @param events The Arena which owns the new Part's events, or null if
+     *         they are owned elsewhere.
+     */
+    void edit_part(Part p, std::shared_ptr<Arena> events) {
+        set_part(p, events);
+        for (int i = 0; i < children.size(); i++) {
+            children[i]->mark_dirty();
+        }
     }
     
     /**
@@ -103,16 +159,20 @@ public:
      *
      * @return the Part produced by this PacketPart.
      */
-    Part get_part() const { return part; }
+    const Part& get_part() const { return part; }
     
     /**
-     * Sets the mode of this PacketPart.
+     * Sets the mode of this PacketPart. If it has been executed and the mode
+     * changes, it and its descendants are marked dirty.
      *
      * @param m The mode of this PacketPart.
      * @return Whether the new mode was valid.
      */
     bool set_mode(std::string m) {
         if (m == "melody" || m == "harmony" || m == "support" || m == "melodic" || m == "harmonic" || m == "supporting") {
+            if (executed && m != mode) {
+                mark_dirty();
+            }
             mode = m;
             return true;
         }
@@ -124,21 +184,27 @@ public:
      *
      * @return The mode of this PacketPart.
      */
-    std::string get_mode() const { return mode; }
+    const std::string& get_mode() const { return mode; }
     
     /**
-     * Sets the file path of this PacketPart.
+     * Sets the file path of this PacketPart. If it has been executed and the
+     * path changes, it and its descendants are marked dirty.
      *
      * @param path The file path of this PacketPart.
      */
-    void set_packet_path(std::string path) { packet_path = path; }
+    void set_packet_path(std::string path) {
+        if (executed && path != packet_path) {
+            mark_dirty();
+        }
+        packet_path = path;
+    }
     
     /**
      * Returns the file path of this PacketPart.
      *
      * @return the file path of this PacketPart.
      */
-    std::string get_packet_path() const { return packet_path; }
+    const std::string& get_packet_path() const { return packet_path; }
     
     /**
      * Returns true if this PacketPart has been executed.
@@ -164,13 +230,37 @@ public:
      * this PacketPart. That is done separately.
      */
     void execute() { executed = true; }
+
+    /**
+     * Marks this PacketPart and its descendants dirty, so that the next run
+     * executes them again. Their Parts are kept until then.
+     */
+    void mark_dirty() {
+        executed = false;
+        for (int i = 0; i < children.size(); i++) {
+            children[i]->mark_dirty();
+        }
+    }
+
+    /**
+     * Returns the PacketParts of this subtree which are dirty, in the leftmost
+     * depth first order they are run in. These are the only packets the next
+     * run executes; the rest have their Parts reused.
+     *
+     * @return The dirty PacketParts of this subtree.
+     */
+    std::vector<PacketPart*> get_dirty() {
+        std::vector<PacketPart*> dirty;
+        append_dirty(dirty);
+        return dirty;
+    }
     
     /**
      * Returns the children of this PacketPart.
      *
      * @return the children of this PacketPart.
      */
-    std::vector<PacketPart*> get_children() const { return children; }
+    const std::vector<PacketPart*>& get_children() const { return children; }
     
     /**
      * Sets this PacketPart as the active PacketPart.
@@ -230,9 +320,32 @@ public:
     }
     
 private:
+
+    /** Appends a copy of each event it visits to a Part, made in an Arena. */
+    struct CopyEvent {
+        CopyEvent(Arena &arena, Part &part) : arena(arena), part(part) {}
+        void operator()(const Note &n) { part.append_note(arena.make<Note>(n)); }
+        void operator()(const Chord &c) { part.append_chord(arena.make<Chord>(c)); }
+        void operator()(const Dynamic &d) { part.append_dynamic(arena.make<Dynamic>(d)); }
+        Arena &arena;
+        Part &part;
+    };
+
+    void append_dirty(std::vector<PacketPart*> &dirty) {
+        if (!executed) {
+            dirty.push_back(this);
+        }
+        for (int i = 0; i < children.size(); i++) {
+            children[i]->append_dirty(dirty);
+        }
+    }
+
     PacketPart *parent;
     std::vector<PacketPart*> children;
     Part part;
+
+    /** The Arena which owns the events of part, if this PacketPart keeps it. */
+    std::shared_ptr<Arena> part_arena;
     std::string packet_path;
     std::string mode;
     bool executed;
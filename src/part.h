@@ -7,13 +7,16 @@
 #ifndef PART_H
 #define PART_H
 
+#include <algorithm>
 #include <vector>
 #include <string>
 #include <iostream>
+#include "change_stamp.h"
 #include "constants.h"
 #include "note.h"
 #include "chord.h"
 #include "dynamics.h"
+#include "visit.h"
 
 /**
  * A Part is an object that represents a single line of music played by a single
@@ -25,28 +28,61 @@ public:
     /**
      * Constructs a Part object with no name and no music.
      */
-    Part(): name(), events(0), length(0) {}
+    Part(): name(), watchers(), length(0), stamp(ChangeStamp::make()), indexed_changes(0),
+            untracked(false), events(0), starts(0), dynamic_indices() {}
 
     /**
      * Constructs a Part object with a name and no music.
      *
      * @param name The name of the Part.
      */
-    Part(std::string name): name(name), events(0), length(0) {}
+    Part(std::string name): name(name), watchers(), length(0), stamp(ChangeStamp::make()),
+            indexed_changes(0), untracked(false), events(0), starts(0), dynamic_indices() {}
+
+    /**
+     * Constructs a copy of a Part. The copy shares the music events of the
+     * original, and sees changes to their durations as the original does.
+     *
+     * @param other The Part to copy.
+     */
+    Part(const Part &other): name(other.name), watchers(other.watchers), length(other.length),
+            stamp(other.stamp->retain()), indexed_changes(other.indexed_changes),
+            untracked(other.untracked), events(other.events), starts(other.starts),
+            dynamic_indices(other.dynamic_indices) {}
+
+    Part& operator=(const Part &other) {
+        ChangeStamp *shared = other.stamp->retain();
+        stamp->release();
+        stamp = shared;
+        name = other.name;
+        watchers = other.watchers;
+        length = other.length;
+        indexed_changes = other.indexed_changes;
+        untracked = other.untracked;
+        events = other.events;
+        starts = other.starts;
+        dynamic_indices = other.dynamic_indices;
+        return *this;
+    }
+
+    ~Part() { stamp->release(); }
 
     /**
      * Sets the name of the Part to the given name.
      *
      * @param n The new name of the Part.
      */
-    void set_name(std::string n) { name = n; }
+    void set_name(std::string n) {
+        name = n;
+        watchers.changed();
+    }
 
     /**
      * Returns the name of the Part.
      *
      * @return The name of the Part.
      */
-    std::string get_name() const { return name; }
+    const std::string& get_name() const { return name; }
 
     /**
      * Returns an iterator indexed to the beginning of the list of music notes,
@@ -86,15 +122,7 @@ public:
      *         last event.
      */
     std::vector<Event*>::iterator erase(std::vector<Event*>::const_iterator it) {
-        Event *e = *it;
-        Note *n = nullptr;
-        Chord *c = nullptr;
-        if (n = dynamic_cast<Note*>(e)) {
-            length -= n->duration;
-        }
-        else if (c = dynamic_cast<Chord*>(e)) {
-            length -= c->duration;
-        }
+        unindex_event(it - events.cbegin());
         return events.erase(it);
     }
 
@@ -106,8 +134,8 @@ public:
      * @param n A pointer to the Note to be inserted at the position before the iterator.
      */
     void insert_note(std::vector<Event*>::const_iterator it, Note *n) {
+        index_event(it - events.cbegin(), n);
         events.insert(it, n);
-        length += n->duration;
     }
 
     /**
@@ -118,8 +146,8 @@ public:
      * @param n A pointer to the Chord to be inserted at the position before the iterator.
      */
     void insert_chord(std::vector<Event*>::const_iterator it, Chord *c) {
+        index_event(it - events.cbegin(), c);
         events.insert(it, c);
-        length += c->duration;
     }
 
     /**
@@ -130,6 +158,7 @@ public:
      * @param n A pointer to the Note to be inserted at the position before the iterator.
      */
     void insert_dynamic(std::vector<Event*>::const_iterator it, Dynamic *d) {
+        index_event(it - events.cbegin(), d);
         events.insert(it, d);
     }
 
@@ -139,17 +168,18 @@ public:
      * @param e A pointer to the Note, Chord, or Dynamic to be appended to the Part.
      */
     void append(Event *e) {
-        Note *n = nullptr;
-        Chord *c = nullptr;
-        Dynamic *d = nullptr;
-        if (n = dynamic_cast<Note*>(e)) {
-            append_note(n);
-        }
-        else if (c = dynamic_cast<Chord*>(e)) {
-            append_chord(c);
-        }
-        else if (d = dynamic_cast<Dynamic*>(e)) {
-            append_dynamic(d);
+        switch (e->get_kind()) {
+        case EVENT_NOTE:
+            append_note(static_cast<Note*>(e));
+            break;
+        case EVENT_CHORD:
+            append_chord(static_cast<Chord*>(e));
+            break;
+        case EVENT_DYNAMIC:
+            append_dynamic(static_cast<Dynamic*>(e));
+            break;
+        default:
+            break;
         }
     }
 
@@ -158,21 +188,39 @@ public:
      *
      * @param n A pointer to the Note to be appended to the Part.
      */
-    void append_note(Note *n) { events.push_back(n); length += n->duration; }
+    void append_note(Note *n) {
+        refresh_starts();
+        track(n);
+        events.push_back(n);
+        starts.push_back(length);
+        length += n->get_duration();
+    }
 
     /**
      * Appends a Chord to the end of the Part.
      *
      * @param c A pointer to the Chord to be appended to the Part.
      */
-    void append_chord(Chord *c) { events.push_back(c); length += c->duration; }
+    void append_chord(Chord *c) {
+        refresh_starts();
+        track(c);
+        events.push_back(c);
+        starts.push_back(length);
+        length += c->get_duration();
+    }
 
     /**
      * Appends a Dynamic object to the end of the Part.
      *
      * @param d A pointer to the Dynamic to be appended to the Part.
      */
-    void append_dynamic(Dynamic *d) { events.push_back(d); }
+    void append_dynamic(Dynamic *d) {
+        refresh_starts();
+        track(d);
+        dynamic_indices.push_back(events.size());
+        events.push_back(d);
+        starts.push_back(length);
+    }
 
     /**
      * Returns the length of the Part in FuseMuse duration units.
@@ -180,7 +228,12 @@ public:
      *
      * @return The length of the Part in FuseMuse duration units.
      */
-    int get_length() const { return length; }
+    int get_length() const {
+        if (!indexed()) {
+            return total_duration();
+        }
+        return length;
+    }
 
     /**
      * Returns the number of music events in the Part.
@@ -189,6 +242,25 @@ public:
      */
     int get_num_events() const { return events.size(); }
 
+    /**
+     * Returns the FuseMuse position at which each music event in the Part begins,
+     * in the same order as the events.
+     *
+     * @return The starting position of every music event in the Part.
+     */
+    std::vector<int> positions() const {
+        if (indexed()) {
+            return starts;
+        }
+        std::vector<int> found(events.size());
+        int position = 0;
+        for (int i = 0; i < events.size(); i++) {
+            found[i] = position;
+            position += event_duration(events[i]);
+        }
+        return found;
+    }
+
     /**
      * Returns the Dynamic that is applied to the music event pointed to
      * by the iterator passed in.
@@ -199,23 +271,34 @@ public:
      *         pointed to by the iterator.
      */
     Dynamic get_current_dynamics(std::vector<Event*>::const_iterator it) {
-        if (events.size() == 0) {
+        // Find the last Dynamic at or before the event.
+        std::vector<int>::iterator next = std::upper_bound(dynamic_indices.begin(),
+                dynamic_indices.end(), (int)(it - events.cbegin()));
+        if (next == dynamic_indices.begin()) {
             Dynamic dynamics;
             return dynamics;
         }
-        std::vector<Event*>::iterator start = begin();
-        while (true) {
-            Event *e = *it;
-            Dynamic *d = nullptr;
-            if (d = dynamic_cast<Dynamic*>(e)) {
-                return *d;
-            }
-            if (it == start) {
-                Dynamic dynamics;
-                return dynamics;
+        return *static_cast<Dynamic*>(events[*(next - 1)]);
+    }
+
+    /**
+     * Returns the Dynamic that is applied to each music event in the Part, in
+     * the same order as the events. This finds the Dynamics of every event in
+     * one pass, instead of one search per event.
+     *
+     * @return The Dynamics used at the position of every music event.
+     */
+    std::vector<Dynamic> get_all_current_dynamics() const {
+        std::vector<Dynamic> all;
+        all.reserve(events.size());
+        Dynamic current;
+        for (int i = 0; i < events.size(); i++) {
+            if (events[i]->is_dynamic()) {
+                current = *static_cast<Dynamic*>(events[i]);
             }
-            it--;
+            all.push_back(current);
         }
+        return all;
     }
 
     /**
@@ -244,38 +327,27 @@ public:
             std::vector<int> drop;
             return drop;
         }
+        int index = it - begin();
         bool up = false;
-        while (true) {
-            Event *e = *it;
-            Dynamic *d = nullptr;
-            if (d = dynamic_cast<Dynamic*>(e)) {
-                if (it == begin() && !list_contains_pitches()) {
-                    std::vector<int> drop;
-                    return drop;
-                }
-                else if (it == begin()) {
-                    up = true;
-                }
-                if (up) {
-                    it++;
-                }
-                else {
-                    it--;
-                }
+        while (events[index]->is_dynamic()) {
+            if (index == 0 && !list_contains_pitches()) {
+                std::vector<int> drop;
+                return drop;
+            }
+            else if (index == 0) {
+                up = true;
+            }
+            if (up) {
+                index++;
             }
             else {
-                Note *n = nullptr;
-                Chord *c = nullptr;
-                if (n = dynamic_cast<Note*>(e)) {
-                    std::vector<int> ret;
-                    ret.push_back(n->pitch);
-                    return ret;
-                }
-                else if (c = dynamic_cast<Chord*>(e)) {
-                    return c->pitches;
-                }
+                index--;
             }
         }
+        if (events[index]->is_note()) {
+            return std::vector<int>(1, static_cast<Note*>(events[index])->pitch);
+        }
+        return static_cast<Chord*>(events[index])->pitches;
     }
 
     /**
@@ -299,20 +371,11 @@ public:
      *         iterator begins.
      */
     int get_position_of(std::vector<Event*>::iterator it) {
-        int pos = 0;
-        while (it != begin()) {
-            it--;
-            Event *e = *it;
-            Note *n = nullptr;
-            Chord *c = nullptr;
-            if (n = dynamic_cast<Note*>(e)) {
-                pos += n->duration;
-            }
-            else if (c = dynamic_cast<Chord*>(e)) {
-                pos += c->duration;
-            }
+        refresh_starts();
+        if (it == end()) {
+            return length;
         }
-        return pos;
+        return starts[it - begin()];
     }
 
     /**
@@ -326,29 +389,8 @@ public:
      *         iterator ends.
      */
     int get_position_after(std::vector<Event*>::iterator it) {
-        int pos = 0;
-        Event *e = *it;
-        Note *n = nullptr;
-        Chord *c = nullptr;
-        if (n = dynamic_cast<Note*>(e)) {
-            pos += n->duration;
-        }
-        else if (c = dynamic_cast<Chord*>(e)) {
-            pos += c->duration;
-        }
-        while (it != begin()) {
-            it--;
-            Event *e = *it;
-            Note *n = nullptr;
-            Chord *c = nullptr;
-            if (n = dynamic_cast<Note*>(e)) {
-                pos += n->duration;
-            }
-            else if (c = dynamic_cast<Chord*>(e)) {
-                pos += c->duration;
-            }
-        }
-        return pos;
+        refresh_starts();
+        return starts[it - begin()] + event_duration(*it);
     }
     
     /**
@@ -361,79 +403,67 @@ public:
         if (name != part->get_name()) {
             return false;
         }
-        if (length != part->get_length()) {
+        if (get_length() != part->get_length()) {
             return false;
         }
         if (events.size() != part->get_num_events()) {
             return false;
         }
-        else {
-            auto itthis = begin();
-            auto itthat = part->begin();
-            for (int i = 0; i < events.size(); i++) {
-                Event *ethis = *itthis;
-                Note *nthis = nullptr;
-                Chord *cthis = nullptr;
-                Dynamic *dthis = nullptr;
-                if (nthis = dynamic_cast<Note*>(ethis)) {
-                    Event *ethat = *itthat;
-                    Note *nthat = nullptr;
-                    if (nthat = dynamic_cast<Note*>(ethat)) {
-                        if (!nthis->equals(nthat)) {
-                            return false;
-                        }
-                    }
-                    else {
-                        return false;
-                    }
-                }
-                else if (cthis = dynamic_cast<Chord*>(ethis)) {
-                    Event *ethat = *itthat;
-                    Chord *cthat = nullptr;
-                    if (cthat = dynamic_cast<Chord*>(ethat)) {
-                        if (!cthis->equals(cthat)) {
-                            return false;
-                        }
-                    }
-                    else {
-                        return false;
-                    }
-                }
-                else if (dthis = dynamic_cast<Dynamic*>(ethis)) {
-                    Event *ethat = *itthat;
-                    Dynamic *dthat = nullptr;
-                    if (dthat = dynamic_cast<Dynamic*>(ethat)) {
-                        if (!dthis->equals(dthat)) {
-                            return false;
-                        }
-                    }
-                    else {
-                        return false;
-                    }
-                }
-                itthis++;
-                itthat++;
+        for (int i = 0; i < events.size(); i++) {
+            if (!same_event(events[i], part->events[i])) {
+                return false;
             }
         }
         return true;
     }
     
 private:
+    friend class Composition;
 
     /** The name of the Part. */
     std::string name;
 
+    /** Counts renames in the Compositions this Part has been added to. */
+    ChangeWatchers watchers;
+
     /**
      * The FuseMuse duration of the entire Part. (see libfm/utilities.h for help
      * understanding FuseMuse duration units)
      */
     int length;
 
+    /**
+     * Counts the changes to the durations of the events in this Part. It is
+     * shared with the events, and with the Parts copied from this one.
+     */
+    ChangeStamp *stamp;
+
+    /** The number of changes stamp had counted when starts were last found. */
+    unsigned long indexed_changes;
+
+    /**
+     * Whether some event in this Part reports its duration changes to another
+     * Part's stamp, so starts must be found again before each use.
+     */
+    bool untracked;
+
     /**
      * An ordered list of the music events (Notes, Chords, and Dynamics) in the Part.
      */
     std::vector<Event*> events;
 
+    /**
+     * The FuseMuse position at which each music event begins, kept parallel to
+     * events so that positions can be found with a binary search.
+     */
+    std::vector<int> starts;
+
+    /**
+     * The index in events of every Dynamic, in increasing order, so that the
+     * Dynamic in effect at an event can be found with a binary search.
+     */
+    std::vector<int> dynamic_indices;
+
     /**
      * A private helper method to get an iterator for a music event at a specific
      * FuseMuse position. see libfm/utilities.h for help understanding FuseMuse
@@ -444,36 +474,161 @@ private:
      * @return An iterator to the music event at the given position.
      */
     std::vector<Event*>::iterator get_iterator_at_position(int pos) {
-        if (pos <= 0) {
+        refresh_starts();
+        if (pos <= 0 || events.size() == 0) {
             return begin();
         }
         else if (pos >= length) {
-            std::vector<Event*>::iterator it = begin();
-            while (it != end()) { it++; }
-            it --;
-            return it;
+            return end() - 1;
         }
         else {
-            std::vector<Event*>::iterator it = begin();
-            int temp_pos = 0;
-            while (temp_pos < pos) {
-                Event *e = *it;
-                Note *n = nullptr;
-                Chord *c = nullptr;
-                if (n = dynamic_cast<Note*>(e)) {
-                    temp_pos += n->duration;
-                }
-                else if (c = dynamic_cast<Chord*>(e)) {
-                    temp_pos += c->duration;
-                }
-                if (temp_pos >= pos) {
-                    return it;
-                }
-                it++;
+            // The event at index i ends where event i + 1 starts, so the first
+            // event ending at or after pos is found by searching the starts of
+            // the events that follow it.
+            std::vector<int>::iterator next = std::lower_bound(starts.begin() + 1,
+                    starts.end(), pos);
+            return begin() + ((next - starts.begin()) - 1);
+        }
+    }
+
+    /**
+     * A private helper method which records a music event about to be inserted
+     * at the given index in the position index and the Dynamic index.
+     *
+     * @param index The index at which the music event will be inserted.
+     * @param e The music event being inserted.
+     */
+    void index_event(int index, Event *e) {
+        refresh_starts();
+        track(e);
+        int duration = event_duration(e);
+        std::vector<int>::iterator d = std::lower_bound(dynamic_indices.begin(),
+                dynamic_indices.end(), index);
+        for (std::vector<int>::iterator k = d; k != dynamic_indices.end(); k++) {
+            (*k)++;
+        }
+        if (e->is_dynamic()) {
+            dynamic_indices.insert(d, index);
+        }
+        int start = index < starts.size() ? starts[index] : length;
+        starts.insert(starts.begin() + index, start);
+        for (int i = index + 1; i < starts.size(); i++) {
+            starts[i] += duration;
+        }
+        length += duration;
+    }
+
+    /**
+     * A private helper method which removes the music event at the given index
+     * from the position index and the Dynamic index.
+     *
+     * @param index The index of the music event being removed.
+     */
+    void unindex_event(int index) {
+        refresh_starts();
+        int duration = event_duration(events[index]);
+        std::vector<int>::iterator d = std::lower_bound(dynamic_indices.begin(),
+                dynamic_indices.end(), index);
+        if (events[index]->is_dynamic()) {
+            d = dynamic_indices.erase(d);
+        }
+        for (std::vector<int>::iterator k = d; k != dynamic_indices.end(); k++) {
+            (*k)--;
+        }
+        starts.erase(starts.begin() + index);
+        for (int i = index; i < starts.size(); i++) {
+            starts[i] -= duration;
+        }
+        length -= duration;
+    }
+
+    /**
+     * A private helper method which returns true if starts and length are up
+     * to date with the durations of the events.
+     */
+    bool indexed() const {
+        return !untracked && indexed_changes == stamp->changes();
+    }
+
+    /**
+     * A private helper method which finds where every music event starts again
+     * if the duration of any event has changed since it was last found.
+     */
+    void refresh_starts() {
+        if (indexed()) {
+            return;
+        }
+        indexed_changes = stamp->changes();
+        untracked = false;
+        length = 0;
+        for (int i = 0; i < events.size(); i++) {
+            starts[i] = length;
+            length += event_duration(events[i]);
+            if (events[i]->stamp != stamp) {
+                untracked = true;
             }
         }
     }
 
+    /**
+     * A private helper method which returns the sum of the durations of the
+     * music events, without using starts.
+     */
+    int total_duration() const {
+        int total = 0;
+        for (int i = 0; i < events.size(); i++) {
+            total += event_duration(events[i]);
+        }
+        return total;
+    }
+
+    /**
+     * A private helper method which makes a music event being added to this
+     * Part report changes to its duration to this Part's stamp. An event taken
+     * from another Part keeps reporting to that Part, so this Part shares its
+     * stamp if it is empty, and otherwise finds its starts again before each
+     * use.
+     *
+     * @param e The music event being added.
+     */
+    void track(Event *e) {
+        if (e->stamp == stamp) {
+            return;
+        }
+        if (e->stamp == NULL) {
+            e->stamp = stamp->retain();
+        }
+        else if (events.empty()) {
+            ChangeStamp *shared = e->stamp->retain();
+            stamp->release();
+            stamp = shared;
+            indexed_changes = stamp->changes();
+        }
+        else {
+            untracked = true;
+        }
+    }
+
+    /**
+     * A private helper method which returns true if two music events are of the
+     * same kind and equal.
+     */
+    static bool same_event(Event *a, Event *b) {
+        if (a->get_kind() != b->get_kind()) {
+            return false;
+        }
+        switch (a->get_kind()) {
+        case EVENT_NOTE:
+            return static_cast<Note*>(a)->equals(static_cast<Note*>(b));
+        case EVENT_CHORD:
+            return static_cast<Chord*>(a)->equals(static_cast<Chord*>(b));
+        case EVENT_DYNAMIC:
+            return static_cast<Dynamic*>(a)->equals(static_cast<Dynamic*>(b));
+        default:
+            return true;
+        }
+    }
+
     /**
      * A private helper method to see if there are any pitches (Notes or Chords) in
      * the Part.
@@ -481,7 +636,7 @@ private:
      * @return Whether the Part contains any pitches.
      */
     bool list_contains_pitches() {
-        if (length > 0) {
+        if (get_length() > 0) {
             return true;
         }
         return false;
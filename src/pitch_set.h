@@ -0,0 +1,245 @@
+/*
+ * File:    pitch_set.h
+ * Author:  Sam Rappl
+ *
+ */
+
+#ifndef PITCH_SET_H
+#define PITCH_SET_H
+
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "constant_list.h"
+
+/**
+ * A PitchSet is an ordered list of pitches, as played by a Chord. Pitches fit
+ * in a byte (see constants.h), so adding one outside 0 to 255 throws a
+ * std::string. Up to inline_capacity of them are stored inside the PitchSet
+ * itself, so common chords need no heap allocation. Larger chords spill into a
+ * vector.
+ */
+class PitchSet {
+public:
+
+    /** The number of pitches that are stored without a heap allocation. */
+    static const int inline_capacity = 8;
+
+    /**
+     * Constructs an empty PitchSet.
+     */
+    PitchSet() : count(0), spill() { std::memset(slots, 0, sizeof(slots)); }
+
+    /**
+     * Constructs a PitchSet holding the given pitches.
+     *
+     * @param pitches The pitches, lowest first.
+     */
+    PitchSet(const std::vector<int> &pitches) : count(0), spill() {
+        std::memset(slots, 0, sizeof(slots));
+        assign(pitches.begin(), pitches.end());
+    }
+
+    /**
+     * Constructs a PitchSet holding the given pitches.
+     *
+     * @param pitches The pitches, lowest first.
+     */
+    PitchSet(std::initializer_list<int> pitches) : count(0), spill() {
+        std::memset(slots, 0, sizeof(slots));
+        assign(pitches.begin(), pitches.end());
+    }
+
+    /**
+     * Constructs a PitchSet holding the given pitches, such as one of the chords
+     * in constants.h.
+     *
+     * @param pitches The pitches, lowest first.
+     */
+    PitchSet(ConstantList pitches) : count(0), spill() {
+        std::memset(slots, 0, sizeof(slots));
+        assign(pitches.begin(), pitches.end());
+    }
+
+    /**
+     * Constructs a PitchSet holding the pitches in the given range.
+     *
+     * @param first A pointer to the first pitch.
+     * @param last A pointer past the last pitch.
+     */
+    PitchSet(const int *first, const int *last) : count(0), spill() {
+        std::memset(slots, 0, sizeof(slots));
+        assign(first, last);
+    }
+
+    /**
+     * Returns the number of pitches.
+     *
+     * @return The number of pitches.
+     */
+    int size() const { return count; }
+
+    /**
+     * Returns true if there are no pitches.
+     *
+     * @return true if there are no pitches.
+     */
+    bool empty() const { return count == 0; }
+
+    /**
+     * Returns the pitch at the given index.
+     *
+     * @param i The index of the pitch.
+     * @return The pitch at the given index.
+     */
+    int operator[](int i) const { return data()[i]; }
+
+    /**
+     * Sets the pitch at the given index.
+     *
+     * @param i The index of the pitch.
+     * @param pitch The new pitch.
+     */
+    void set(int i, int pitch) { mutable_data()[i] = checked(pitch); }
+
+    /**
+     * Returns the lowest (first) pitch.
+     */
+    int front() const { return data()[0]; }
+
+    /**
+     * Returns the highest (last) pitch.
+     */
+    int back() const { return data()[count - 1]; }
+
+    /**
+     * Returns a pointer to the pitches, which are stored contiguously.
+     *
+     * @return A pointer to the first pitch.
+     */
+    const uint8_t* data() const { return count > inline_capacity ? spill.data() : slots; }
+
+    /**
+     * Appends a pitch to the end of the PitchSet.
+     *
+     * @param pitch The pitch to append.
+     */
+    void push_back(int pitch) {
+        uint8_t p = checked(pitch);
+        if (count < inline_capacity) {
+            slots[count] = p;
+        }
+        else {
+            if (count == inline_capacity) {
+                spill.assign(slots, slots + inline_capacity);
+            }
+            spill.push_back(p);
+        }
+        count++;
+    }
+
+    /**
+     * Adds the given number of half steps to every pitch. The caller must make
+     * sure the results stay between 0 and 127.
+     *
+     * @param delta The number of half steps to move each pitch by.
+     */
+    void transpose(int delta) {
+        if (count > inline_capacity) {
+            for (int i = 0; i < count; i++) {
+                spill[i] += delta;
+            }
+            return;
+        }
+        // Move all of the inline slots with one 64 bit add or subtract. The
+        // step is zero in the unused slots, and the results stay between 0 and
+        // 127, so no pitch carries or borrows into its neighbor.
+        uint8_t step_bytes[inline_capacity] = {};
+        std::memset(step_bytes, delta < 0 ? -delta : delta, count);
+        uint64_t word;
+        uint64_t step;
+        std::memcpy(&word, slots, sizeof(word));
+        std::memcpy(&step, step_bytes, sizeof(step));
+        word = delta < 0 ? word - step : word + step;
+        std::memcpy(slots, &word, sizeof(word));
+    }
+
+    /**
+     * Removes the lowest pitch and appends it again an octave higher.
+     */
+    void rotate_up_octave() {
+        uint8_t *d = mutable_data();
+        uint8_t low = d[0];
+        std::memmove(d, d + 1, count - 1);
+        d[count - 1] = low + 12;
+    }
+
+    /**
+     * Returns the pitches as a vector.
+     *
+     * @return A vector containing the pitches, lowest first.
+     */
+    std::vector<int> to_vector() const {
+        return std::vector<int>(data(), data() + count);
+    }
+
+    operator std::vector<int>() const { return to_vector(); }
+
+    bool operator==(const PitchSet &other) const {
+        return count == other.count && std::memcmp(data(), other.data(), count) == 0;
+    }
+
+    bool operator!=(const PitchSet &other) const { return !(*this == other); }
+
+private:
+    template <typename It>
+    void assign(It first, It last) {
+        for (; first != last; ++first) {
+            push_back(*first);
+        }
+    }
+
+    uint8_t* mutable_data() { return count > inline_capacity ? spill.data() : slots; }
+
+    /** Returns the pitch as a byte, or throws if it does not fit in one. */
+    static uint8_t checked(int pitch) {
+        if (pitch < 0 || pitch > 255) {
+            throw std::string("A pitch must be between 0 and 255, not " +
+                    std::to_string(pitch) + ".");
+        }
+        return pitch;
+    }
+
+    int count;
+    uint8_t slots[inline_capacity];
+    std::vector<uint8_t> spill;
+};
+
+inline bool operator==(const std::vector<int> &a, const PitchSet &b) {
+    return PitchSet(a) == b;
+}
+
+inline bool operator==(const PitchSet &a, const std::vector<int> &b) {
+    return a == PitchSet(b);
+}
+
+inline bool operator==(ConstantList a, const PitchSet &b) {
+    return PitchSet(a) == b;
+}
+
+inline bool operator==(const PitchSet &a, ConstantList b) {
+    return a == PitchSet(b);
+}
+
+inline std::ostream& operator<<(std::ostream &os, const PitchSet &pitches) {
+    os << "{";
+    for (int i = 0; i < pitches.size(); i++) {
+        os << (i > 0 ? ", " : " ") << pitches[i];
+    }
+    return os << " }";
+}
+
+#endif /* PITCH_SET_H */
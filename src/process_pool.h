@@ -0,0 +1,457 @@
+/*
+ * File:    process_pool.h
+ * Author:  Sam Rappl
+ *
+ */
+
+#ifndef PROCESS_POOL_H
+#define PROCESS_POOL_H
+
+#include <cerrno>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <fcntl.h>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <set>
+#include <signal.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+// ****************************FRAMES*********************************
+// Packets run by a ProcessPool are sent requests and send responses over
+// pipes as frames: a 4 byte big endian length followed by that many bytes. A
+// request is two frames, the mode and the input. A response is two frames,
+// "ok" and the output, or "error" and a message.
+
+/**
+ * Writes exactly size bytes. A socket is written with MSG_NOSIGNAL, so that if
+ * the reader has exited the write fails instead of raising SIGPIPE.
+ *
+ * @return false if they could not all be written.
+ */
+inline bool write_fully(int fd, const char *p, size_t size) {
+    bool socket = true;
+    while (size > 0) {
+        ssize_t n = socket ? send(fd, p, size, MSG_NOSIGNAL) : write(fd, p, size);
+        if (n < 0 && errno == ENOTSOCK && socket) {
+            socket = false;
+            continue;
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        size -= n;
+    }
+    return true;
+}
+
+/**
+ * Writes a frame.
+ *
+ * @param fd The file descriptor to write to.
+ * @param data The bytes of the frame.
+ * @return false if the frame could not be written, as when the reader exited.
+ */
+inline bool write_frame(int fd, const std::string &data) {
+    uint32_t size = data.size();
+    unsigned char head[4] = { (unsigned char) (size >> 24), (unsigned char) (size >> 16),
+            (unsigned char) (size >> 8), (unsigned char) size };
+    return write_fully(fd, (const char*) head, 4) && write_fully(fd, data.data(), size);
+}
+
+/**
+ * Reads exactly size bytes.
+ *
+ * @return false if the end of the file or an error came first.
+ */
+inline bool read_fully(int fd, char *p, size_t size) {
+    while (size > 0) {
+        ssize_t n = read(fd, p, size);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        size -= n;
+    }
+    return true;
+}
+
+/**
+ * Reads a frame.
+ *
+ * @param fd The file descriptor to read from.
+ * @param data Set to the bytes of the frame.
+ * @return false if no whole frame could be read, as when the writer exited.
+ */
+inline bool read_frame(int fd, std::string &data) {
+    unsigned char head[4];
+    if (!read_fully(fd, (char*) head, 4)) {
+        return false;
+    }
+    uint32_t size = (uint32_t) head[0] << 24 | (uint32_t) head[1] << 16 |
+            (uint32_t) head[2] << 8 | head[3];
+    data.resize(size);
+    return size == 0 || read_fully(fd, &data[0], size);
+}
+
+/**
+ * Serves requests from a ProcessPool on standard input and output until the
+ * pool closes the pipe. Packet programs call this from main. A std::string or
+ * std::exception thrown by handle is sent back as an error, which the pool
+ * throws from execute.
+ *
+ * @param handle Returns the output of the packet for a mode and input.
+ */
+inline void serve_packet(std::function<std::string(const std::string&,
+        const std::string&)> handle) {
+    std::string mode;
+    std::string input;
+    while (read_frame(0, mode) && read_frame(0, input)) {
+        std::string status = "ok";
+        std::string output;
+        try {
+            output = handle(mode, input);
+        }
+        catch (const std::string &e) {
+            status = "error";
+            output = e;
+        }
+        catch (const std::exception &e) {
+            status = "error";
+            output = e.what();
+        }
+        if (!write_frame(1, status) || !write_frame(1, output)) {
+            return;
+        }
+    }
+}
+
+// ****************************PROCESS POOL*********************************
+
+/**
+ * A ProcessPool runs packets as long lived worker processes, so that a packet
+ * which takes a long time to start, such as one which loads an interpreter or
+ * a model, pays for it once rather than on every call. Each packet path gets
+ * its own workers, which are started the first time the path is executed and
+ * kept until the pool is destroyed. A worker which exits or breaks the frame
+ * protocol is replaced and the request retried once.
+ *
+ * Each worker's standard input and output are one end of a socket pair, which
+ * the pool writes with MSG_NOSIGNAL (see write_fully), so a worker exiting is
+ * seen as a failed write instead of killing the shell with SIGPIPE.
+ */
+class ProcessPool {
+public:
+
+    /** Returns the command line which starts a worker for a packet path. */
+    typedef std::function<std::vector<std::string>(const std::string&)> launcher;
+
+    /**
+     * @param launch Returns the command line, the program and its arguments,
+     *         which starts a worker for a packet path.
+     * @param workers_per_packet The number of workers each packet path may
+     *         have, which is how many calls to it may run at once.
+     */
+    ProcessPool(launcher launch, int workers_per_packet = 1)
+            : launch(launch), workers_per_packet(workers_per_packet), mutex(), released(),
+            finished(), packets(), busy(), calls(0), closing(false), started(0),
+            restarted(0) {}
+
+    /**
+     * Closes every idle worker's socket and waits for it to exit. Busy workers
+     * are killed, so the calls running on them fail, and calls waiting for a
+     * worker fail at once; the pool waits for those calls to return before
+     * it is destroyed.
+     */
+    ~ProcessPool() {
+        std::vector<Worker> idle;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            closing = true;
+            for (std::set<pid_t>::iterator it = busy.begin(); it != busy.end(); ++it) {
+                kill(*it, SIGKILL);
+            }
+            for (std::map<std::string, Workers>::iterator it = packets.begin();
+                    it != packets.end(); ++it) {
+                idle.insert(idle.end(), it->second.idle.begin(), it->second.idle.end());
+                it->second.idle.clear();
+            }
+        }
+        released.notify_all();
+        for (int i = 0; i < idle.size(); i++) {
+            stop(idle[i], false);
+        }
+        std::unique_lock<std::mutex> lock(mutex);
+        finished.wait(lock, [this]() { return calls == 0; });
+    }
+
+    ProcessPool(const ProcessPool&) = delete;
+    ProcessPool& operator=(const ProcessPool&) = delete;
+
+    /**
+     * Runs a packet on one of its workers, starting one if it has none free
+     * and fewer than workers_per_packet, and otherwise waiting for one to be
+     * free. Safe to call from several threads at once. Has the same arguments
+     * and result as the shell's callback.
+     *
+     * @return The output of the packet.
+     * @throws std::string If the packet reported an error, a worker could not
+     *         be started or failed twice, or the pool is being destroyed.
+     */
+    std::string execute(const std::string &path, const std::string &mode,
+            const std::string &input) {
+        Worker worker = acquire(path);
+        Call call(this);
+        std::string output;
+        for (int attempt = 0; ; attempt++) {
+            std::string status;
+            if (worker.pid > 0 && write_frame(worker.fd, mode) &&
+                    write_frame(worker.fd, input) &&
+                    read_frame(worker.fd, status) &&
+                    read_frame(worker.fd, output) &&
+                    (status == "ok" || status == "error")) {
+                release(path, worker);
+                if (status == "error") {
+                    throw output;
+                }
+                return output;
+            }
+            bool closed = stop_busy(worker);
+            if (closed) {
+                discard(path);
+                throw std::string("Packet " + path + " was stopped with its ProcessPool.");
+            }
+            if (attempt == 1) {
+                discard(path);
+                throw std::string("Packet " + path + " failed twice.");
+            }
+            worker = spawn(path);
+            std::lock_guard<std::mutex> lock(mutex);
+            restarted++;
+        }
+    }
+
+    /**
+     * Returns the number of workers started, including restarts.
+     *
+     * @return The number of workers started.
+     */
+    int get_started() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return started;
+    }
+
+    /**
+     * Returns the number of workers started to replace one which failed.
+     *
+     * @return The number of restarts.
+     */
+    int get_restarted() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return restarted;
+    }
+
+private:
+    struct Worker {
+        pid_t pid;
+
+        /** The pool's end of the socket pair which is the worker's standard
+         * input and output. */
+        int fd;
+    };
+
+    /** The workers of one packet path. */
+    struct Workers {
+        Workers() : idle(), count(0) {}
+
+        std::vector<Worker> idle;
+
+        /** The number of workers, idle or busy. */
+        int count;
+    };
+
+    /**
+     * Counts a call to execute as finished when it returns or throws. It is the
+     * last thing a call does with the pool, which the destructor waits for.
+     */
+    struct Call {
+        Call(ProcessPool *pool) : pool(pool) {}
+
+        ~Call() {
+            std::lock_guard<std::mutex> lock(pool->mutex);
+            if (--pool->calls == 0) {
+                pool->finished.notify_all();
+            }
+        }
+
+        ProcessPool *pool;
+    };
+
+    /** Takes a free worker for path, starting one if there is room. */
+    Worker acquire(const std::string &path) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            Workers &workers = packets[path];
+            released.wait(lock, [&]() {
+                return closing || !workers.idle.empty() || workers.count < workers_per_packet;
+            });
+            if (closing) {
+                throw std::string("Packet " + path + " was not run as its ProcessPool is "
+                        "being destroyed.");
+            }
+            calls++;
+            if (!workers.idle.empty()) {
+                Worker worker = workers.idle.back();
+                workers.idle.pop_back();
+                busy.insert(worker.pid);
+                return worker;
+            }
+            workers.count++;
+        }
+        return spawn(path);
+    }
+
+    /**
+     * Returns a worker which has finished a call to the idle workers of path,
+     * or stops it if the pool is being destroyed.
+     */
+    void release(const std::string &path, const Worker &worker) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            busy.erase(worker.pid);
+            if (!closing) {
+                packets[path].idle.push_back(worker);
+                released.notify_one();
+                return;
+            }
+        }
+        stop(worker, false);
+        discard(path);
+    }
+
+    /** Gives up the place of a worker which has been stopped. */
+    void discard(const std::string &path) {
+        std::lock_guard<std::mutex> lock(mutex);
+        packets[path].count--;
+        released.notify_one();
+    }
+
+    /**
+     * Starts a worker for path. Its pid is -1 if it could not be started. It is
+     * killed at once if the pool is being destroyed.
+     */
+    Worker spawn(const std::string &path) {
+        Worker worker = { -1, -1 };
+        std::vector<std::string> args = launch(path);
+        if (args.empty()) {
+            return worker;
+        }
+        std::vector<char*> argv;
+        for (int i = 0; i < args.size(); i++) {
+            argv.push_back(&args[i][0]);
+        }
+        argv.push_back(NULL);
+        int fds[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) != 0) {
+            return worker;
+        }
+        pid_t pid = fork();
+        if (pid == 0) {
+            dup2(fds[1], 0);
+            dup2(fds[1], 1);
+            execvp(argv[0], &argv[0]);
+            _exit(127);
+        }
+        close(fds[1]);
+        if (pid < 0) {
+            close(fds[0]);
+            return worker;
+        }
+        worker.pid = pid;
+        worker.fd = fds[0];
+        std::lock_guard<std::mutex> lock(mutex);
+        started++;
+        busy.insert(pid);
+        if (closing) {
+            kill(pid, SIGKILL);
+        }
+        return worker;
+    }
+
+    /**
+     * Kills and stops a busy worker which has failed or was killed by the
+     * destructor.
+     *
+     * @return Whether the pool is being destroyed.
+     */
+    bool stop_busy(const Worker &worker) {
+        bool closed;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            busy.erase(worker.pid);
+            closed = closing;
+        }
+        stop(worker, true);
+        return closed;
+    }
+
+    /**
+     * Closes a worker's socket and waits for it to exit.
+     *
+     * @param kill_first Whether to kill the worker first, as when it has failed and
+     *         may not exit when its input is closed.
+     */
+    static void stop(const Worker &worker, bool kill_first) {
+        if (worker.pid <= 0) {
+            return;
+        }
+        if (kill_first) {
+            kill(worker.pid, SIGKILL);
+        }
+        close(worker.fd);
+        int status;
+        while (waitpid(worker.pid, &status, 0) < 0 && errno == EINTR) {
+        }
+    }
+
+    launcher launch;
+    int workers_per_packet;
+    std::mutex mutex;
+    std::condition_variable released;
+
+    /** Notified when the last call to execute has finished. */
+    std::condition_variable finished;
+
+    std::map<std::string, Workers> packets;
+
+    /**
+     * The pids of the workers running a call, which the destructor kills. A
+     * pid is removed before its worker is waited for, so it is never reused.
+     */
+    std::set<pid_t> busy;
+
+    /** The number of calls to execute which have taken a worker. */
+    int calls;
+
+    /** Whether the destructor has started. */
+    bool closing;
+
+    int started;
+    int restarted;
+};
+
+#endif /* PROCESS_POOL_H */
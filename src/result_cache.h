@@ -0,0 +1,276 @@
+/*
+ * File:    result_cache.h
+ * Author:  Sam Rappl
+ *
+ */
+
+#ifndef RESULT_CACHE_H
+#define RESULT_CACHE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <list>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <utility>
+
+inline uint64_t rotl64(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+inline uint64_t fmix64(uint64_t k) {
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ULL;
+    k ^= k >> 33;
+    return k;
+}
+
+/**
+ * Returns the 128 bit MurmurHash3 (x64, seed 0) of some bytes as 32 hex
+ * digits. It is quick and well mixed, but not cryptographic: it keys a cache
+ * whose contents are trusted.
+ *
+ * @param data The bytes to hash.
+ * @return The hash.
+ */
+inline std::string content_hash(const std::string &data) {
+    const uint64_t c1 = 0x87c37b91114253d5ULL;
+    const uint64_t c2 = 0x4cf5ad432745937fULL;
+    uint64_t h1 = 0;
+    uint64_t h2 = 0;
+    size_t i = 0;
+    for (; i + 16 <= data.size(); i += 16) {
+        uint64_t k1;
+        uint64_t k2;
+        std::memcpy(&k1, data.data() + i, 8);
+        std::memcpy(&k2, data.data() + i + 8, 8);
+        h1 ^= rotl64(k1 * c1, 31) * c2;
+        h1 = (rotl64(h1, 27) + h2) * 5 + 0x52dce729;
+        h2 ^= rotl64(k2 * c2, 33) * c1;
+        h2 = (rotl64(h2, 31) + h1) * 5 + 0x38495ab5;
+    }
+    uint64_t tail[2] = { 0, 0 };
+    std::memcpy(tail, data.data() + i, data.size() - i);
+    if (data.size() - i > 8) {
+        h2 ^= rotl64(tail[1] * c2, 33) * c1;
+    }
+    if (data.size() - i > 0) {
+        h1 ^= rotl64(tail[0] * c1, 31) * c2;
+    }
+    h1 ^= data.size();
+    h2 ^= data.size();
+    h1 += h2;
+    h2 += h1;
+    h1 = fmix64(h1);
+    h2 = fmix64(h2);
+    h1 += h2;
+    h2 += h1;
+    char hex[33];
+    std::snprintf(hex, sizeof(hex), "%016llx%016llx", (unsigned long long) h1,
+            (unsigned long long) h2);
+    return std::string(hex, 32);
+}
+
+/**
+ * Returns the size and modification time of a packet's file, so that a cache
+ * key which includes it changes when the packet is edited.
+ *
+ * @param path The path of the packet.
+ * @return The size and modification time, or "" if there is no such file.
+ */
+inline std::string packet_stamp(const std::string &path) {
+    struct stat st;
+    if (path.empty() || stat(path.c_str(), &st) != 0) {
+        return "";
+    }
+    std::ostringstream out;
+    out << st.st_size << ':' << st.st_mtim.tv_sec << '.' << st.st_mtim.tv_nsec;
+    return out.str();
+}
+
+/**
+ * A ResultCache remembers the outputs of packets and modules by a hash of what
+ * they were passed, so that running a packet again on the same input can
+ * reuse its last output instead. The most recently used outputs are kept in
+ * memory, and every output is also kept as a file in a directory if one is
+ * given, so the cache outlives the process. Safe to use from several threads.
+ */
+class ResultCache {
+public:
+
+    /**
+     * @param max_entries The most outputs kept in memory.
+     * @param directory A directory which outputs are also kept in, or "" to
+     *         keep them only in memory. It must exist.
+     */
+    ResultCache(int max_entries = 1024, const std::string &directory = "")
+            : max_entries(max_entries), directory(directory), mutex(), recent(), entries(),
+            hits(0), misses(0), writes(0) {}
+
+    ResultCache(const ResultCache&) = delete;
+    ResultCache& operator=(const ResultCache&) = delete;
+
+    /**
+     * Returns the key of a call to a packet or module.
+     *
+     * @param path The path of the packet or module.
+     * @param mode The mode it is run in.
+     * @param input Its input, exactly as it is passed to it.
+     * @param stamp Anything else the output depends on, such as the
+     *         packet_stamp of the packet and the wire format.
+     * @return The key.
+     */
+    static std::string key(const std::string &path, const std::string &mode,
+            const std::string &input, const std::string &stamp) {
+        std::string data;
+        data.reserve(path.size() + mode.size() + stamp.size() + input.size() + 32);
+        append_field(data, path);
+        append_field(data, mode);
+        append_field(data, stamp);
+        data += input;
+        return content_hash(data);
+    }
+
+    /**
+     * Looks up the output stored for a key, in memory and then on disk.
+     *
+     * @param key The key.
+     * @param output Set to the output if it is found.
+     * @return Whether it was found.
+     */
+    bool get(const std::string &key, std::string &output) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            std::unordered_map<std::string, Entries::iterator>::iterator it = entries.find(key);
+            if (it != entries.end()) {
+                recent.splice(recent.begin(), recent, it->second);
+                output = it->second->second;
+                hits++;
+                return true;
+            }
+        }
+        if (!directory.empty()) {
+            std::ifstream in((directory + "/" + key).c_str(), std::ios::binary);
+            if (in) {
+                output.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+                std::lock_guard<std::mutex> lock(mutex);
+                remember(key, output);
+                hits++;
+                return true;
+            }
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        misses++;
+        return false;
+    }
+
+    /**
+     * Stores the output for a key. On disk it is written to a temporary file
+     * which is renamed into place, so a reader never sees part of it.
+     *
+     * @param key The key.
+     * @param output The output.
+     */
+    void put(const std::string &key, const std::string &output) {
+        int n;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            remember(key, output);
+            n = writes++;
+        }
+        if (directory.empty()) {
+            return;
+        }
+        std::string path = directory + "/" + key;
+        std::string temp = path + ".tmp" + std::to_string(getpid()) + "." + std::to_string(n);
+        std::ofstream out(temp.c_str(), std::ios::binary);
+        out.write(output.data(), output.size());
+        out.close();
+        if (!out || std::rename(temp.c_str(), path.c_str()) != 0) {
+            std::remove(temp.c_str());
+        }
+    }
+
+    /** Forgets every output kept in memory. Files on disk are kept. */
+    void clear_memory() {
+        std::lock_guard<std::mutex> lock(mutex);
+        recent.clear();
+        entries.clear();
+    }
+
+    /**
+     * Returns the number of outputs kept in memory.
+     *
+     * @return The number of outputs kept in memory.
+     */
+    int size() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return entries.size();
+    }
+
+    /**
+     * Returns the number of lookups which found an output.
+     *
+     * @return The number of hits.
+     */
+    int get_hits() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return hits;
+    }
+
+    /**
+     * Returns the number of lookups which found nothing.
+     *
+     * @return The number of misses.
+     */
+    int get_misses() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return misses;
+    }
+
+private:
+    typedef std::list<std::pair<std::string, std::string> > Entries;
+
+    /** Appends a field and its length, so that fields cannot run together. */
+    static void append_field(std::string &data, const std::string &field) {
+        data += std::to_string(field.size());
+        data += ':';
+        data += field;
+    }
+
+    /** Puts an output at the front of memory, evicting the oldest if full. */
+    void remember(const std::string &key, const std::string &output) {
+        std::unordered_map<std::string, Entries::iterator>::iterator it = entries.find(key);
+        if (it != entries.end()) {
+            it->second->second = output;
+            recent.splice(recent.begin(), recent, it->second);
+            return;
+        }
+        recent.push_front(std::make_pair(key, output));
+        entries[key] = recent.begin();
+        while (entries.size() > max_entries) {
+            entries.erase(recent.back().first);
+            recent.pop_back();
+        }
+    }
+
+    int max_entries;
+    std::string directory;
+    std::mutex mutex;
+
+    /** The outputs kept in memory, most recently used first. */
+    Entries recent;
+    std::unordered_map<std::string, Entries::iterator> entries;
+    int hits;
+    int misses;
+    int writes;
+};
+
+#endif /* RESULT_CACHE_H */
@@ -0,0 +1,459 @@
+/*
+ * File:    sax_reader.h
+ * Author:  Sam Rappl
+ *
+ */
+
+#ifndef SAX_READER_H
+#define SAX_READER_H
+
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <string>
+#include <vector>
+#include "composition.h"
+#include "json_sax.h"
+
+/**
+ * A ModelSaxHandler fills a Part, PatternSegment, CompositionMetrics, PacketPart
+ * or Composition straight from the values reported by a JsonSaxParser, reading
+ * the same JSON as the from_json functions in utilities.h without building a
+ * JSON document first. Events, Parts, PatternSegments, CompositionMetrics and
+ * PacketParts are made with arena_make (see arena.h). Unknown keys are skipped
+ * and missing values keep their defaults.
+ */
+class ModelSaxHandler {
+public:
+    ModelSaxHandler(Part &part) : root(PART), root_part(&part) { init(); }
+    ModelSaxHandler(PatternSegment &segment) : root(SEGMENT), root_part(NULL) {
+        init();
+        this->segment = &segment;
+    }
+    ModelSaxHandler(CompositionMetrics &metrics) : root(METRICS), root_part(NULL) {
+        init();
+        this->metrics = &metrics;
+    }
+    ModelSaxHandler(PacketPart &packet_part) : root(PACKET_PART), root_part(NULL) {
+        init();
+        packet_parts.push_back(&packet_part);
+    }
+    ModelSaxHandler(Composition &comp) : root(COMPOSITION), root_part(NULL) {
+        init();
+        this->comp = &comp;
+    }
+
+    bool null() { return true; }
+    bool boolean(bool val) {
+        if (top() == PACKET_PART && frames.back().key == "executed") {
+            frames.back().executed = val;
+        }
+        else if (top() == EVENT) {
+            mark_present();
+        }
+        return true;
+    }
+    bool number_integer(int64_t val) { return number(val); }
+    bool number_unsigned(uint64_t val) { return number(val); }
+    bool number_float(double val, const std::string &) { return number((int64_t)val); }
+
+    bool string(std::string &val) {
+        const std::string &key = frames.back().key;
+        switch (top()) {
+        case PART:
+            if (key == "name") { part->set_name(val); }
+            break;
+        case EVENT:
+            if (key == "type") { event.type = val; }
+            else { mark_present(); }
+            break;
+        case SEGMENT:
+            if (key == "name") { segment->set_name(val); }
+            break;
+        case PACKET_PART:
+            if (key == "packet_path") { packet_parts.back()->set_packet_path(val); }
+            else if (key == "mode") { packet_parts.back()->set_mode(val); }
+            break;
+        case PATTERN_ARRAY:
+            pattern.push_back(val);
+            break;
+        default:
+            break;
+        }
+        return true;
+    }
+
+    bool start_object(std::size_t) {
+        if (frames.empty()) {
+            push(root);
+            if (root == PART) {
+                part = root_part;
+            }
+            else if (root == PACKET_PART) {
+                packet_parts.back()->set_inactive();
+            }
+            return true;
+        }
+        const std::string &key = frames.back().key;
+        switch (top()) {
+        case COMPOSITION:
+            if (key == "packet_tree_root") {
+                packet_parts.push_back(arena_make<PacketPart>());
+                packet_parts.back()->set_inactive();
+                push(PACKET_PART);
+                return true;
+            }
+            break;
+        case METRICS_ARRAY:
+            metrics = arena_make<CompositionMetrics>();
+            push(METRICS);
+            return true;
+        case METRICS:
+            if (key == "key") {
+                key_tonic = c3;
+                key_intervals = major_intervals;
+                key_intervals_read = false;
+                push(KEY);
+                return true;
+            }
+            if (key == "time_signature") {
+                push(TIME_SIGNATURE);
+                return true;
+            }
+            break;
+        case PARTS_ARRAY:
+            part = arena_make<Part>();
+            push(PART);
+            return true;
+        case EVENTS_ARRAY:
+            event = EventFields();
+            push(EVENT);
+            return true;
+        case SEGMENTS_ARRAY:
+            segment = arena_make<PatternSegment>();
+            push(SEGMENT);
+            return true;
+        case SEGMENT:
+        case PACKET_PART:
+            if (key == "chord_progression" || key == "part") {
+                scratch = Part();
+                part = &scratch;
+                push(PART);
+                return true;
+            }
+            break;
+        case CHILDREN_ARRAY:
+            packet_parts.push_back(arena_make<PacketPart>());
+            packet_parts.back()->set_inactive();
+            push(PACKET_PART);
+            return true;
+        default:
+            break;
+        }
+        push(SKIP);
+        return true;
+    }
+
+    bool key(std::string &val) {
+        frames.back().key = val;
+        return true;
+    }
+
+    bool end_object() {
+        Frame kind = top();
+        bool executed = frames.back().executed;
+        frames.pop_back();
+        Frame parent = frames.empty() ? SKIP : top();
+        switch (kind) {
+        case EVENT:
+            append_event();
+            break;
+        case PART:
+            if (parent == PARTS_ARRAY) {
+                comp->add_part(*part);
+            }
+            else if (parent == SEGMENT) {
+                segment->set_chord_progression(part);
+            }
+            else if (parent == PACKET_PART) {
+                packet_parts.back()->set_part(*part);
+            }
+            break;
+        case SEGMENT:
+            if (parent == SEGMENTS_ARRAY) {
+                comp->register_pattern_segment(segment);
+            }
+            break;
+        case KEY:
+            metrics->key = KeyHandle(key_tonic, key_intervals);
+            break;
+        case METRICS:
+            if (parent == METRICS_ARRAY) {
+                metrics_batch.push_back(metrics);
+            }
+            break;
+        case PACKET_PART:
+            packet_parts.back()->set_executed(executed);
+            if (parent == CHILDREN_ARRAY) {
+                PacketPart *child = packet_parts.back();
+                packet_parts.pop_back();
+                packet_parts.back()->append_child(child);
+            }
+            else if (parent == COMPOSITION) {
+                packet_tree_root = packet_parts.back();
+                packet_parts.pop_back();
+            }
+            break;
+        case COMPOSITION:
+            comp->add_all_composition_metrics(metrics_batch);
+            for (int i = 0; i < pattern.size(); i++) {
+                comp->add_to_pattern(pattern[i]);
+            }
+            comp->set_packet_tree_root(packet_tree_root);
+            break;
+        default:
+            break;
+        }
+        return true;
+    }
+
+    bool start_array(std::size_t) {
+        if (frames.empty()) {
+            push(SKIP);
+            return true;
+        }
+        const std::string &key = frames.back().key;
+        Frame array = SKIP;
+        switch (top()) {
+        case COMPOSITION:
+            if (key == "metrics") { array = METRICS_ARRAY; }
+            else if (key == "parts") { array = PARTS_ARRAY; }
+            else if (key == "pattern_segments") { array = SEGMENTS_ARRAY; }
+            else if (key == "pattern") { array = PATTERN_ARRAY; }
+            break;
+        case PART:
+            if (key == "events") { array = EVENTS_ARRAY; }
+            break;
+        case EVENT:
+            if (key == "pitches") { array = PITCHES_ARRAY; }
+            break;
+        case KEY:
+            if (key == "intervals") { array = INTERVALS_ARRAY; }
+            break;
+        case PACKET_PART:
+            if (key == "children") { array = CHILDREN_ARRAY; }
+            break;
+        default:
+            break;
+        }
+        push(array);
+        return true;
+    }
+
+    bool end_array() {
+        frames.pop_back();
+        return true;
+    }
+
+private:
+
+    /**
+     * The kinds of JSON objects and arrays the handler can be inside of.
+     */
+    enum Frame {
+        SKIP, COMPOSITION, METRICS_ARRAY, METRICS, KEY, INTERVALS_ARRAY, TIME_SIGNATURE,
+        PARTS_ARRAY, PART, EVENTS_ARRAY, EVENT, PITCHES_ARRAY, SEGMENTS_ARRAY, SEGMENT,
+        PATTERN_ARRAY, PACKET_PART, CHILDREN_ARRAY
+    };
+
+    /**
+     * An open JSON object or array, and the last key read in it.
+     */
+    struct OpenFrame {
+        OpenFrame(Frame kind) : kind(kind), key(), executed(false) {}
+        Frame kind;
+        std::string key;
+
+        /**
+         * The "executed" value of a PacketPart. It is set once the object
+         * ends, so that setting the packet path and mode, which come after it,
+         * does not mark the PacketPart dirty.
+         */
+        bool executed;
+    };
+
+    /**
+     * The fields of the event being read. They are kept until the end of the
+     * event's object, because its "type" key comes after the others.
+     */
+    struct EventFields {
+        EventFields() : type(), pitch(c4), duration(quarter_note), volume(mp),
+                flags(0), cresc(false), decresc(false), pitches() {}
+        std::string type;
+        int pitch;
+        int duration;
+        int volume;
+        uint16_t flags;
+        bool cresc;
+        bool decresc;
+        PitchSet pitches;
+    };
+
+    void init() {
+        part = NULL;
+        segment = NULL;
+        metrics = NULL;
+        comp = NULL;
+        packet_tree_root = NULL;
+        key_tonic = c3;
+        key_intervals_read = false;
+    }
+
+    Frame top() const { return frames.back().kind; }
+
+    void push(Frame kind) { frames.push_back(OpenFrame(kind)); }
+
+    bool number(int64_t val) {
+        const std::string &key = frames.back().key;
+        switch (top()) {
+        case EVENT:
+            if (key == "pitch") { event.pitch = val; }
+            else if (key == "duration") { event.duration = val; }
+            else if (key == "volume") { event.volume = val; }
+            else { mark_present(); }
+            break;
+        case PITCHES_ARRAY:
+            event.pitches.push_back(val);
+            break;
+        case SEGMENT:
+            if (key == "duration") { segment->set_duration(val); }
+            break;
+        case METRICS:
+            if (key == "tempo") { metrics->tempo = val; }
+            else if (key == "position") { metrics->position = val; }
+            break;
+        case KEY:
+            if (key == "tonic") { key_tonic = val; }
+            break;
+        case INTERVALS_ARRAY:
+            if (!key_intervals_read) {
+                key_intervals.clear();
+                key_intervals_read = true;
+            }
+            key_intervals.push_back(val);
+            break;
+        case TIME_SIGNATURE:
+            if (key == "num") { metrics->time_signature.num = (char)val; }
+            else if (key == "denom") { metrics->time_signature.denom = (char)val; }
+            break;
+        default:
+            break;
+        }
+        return true;
+    }
+
+    /**
+     * Records that the current key of the event being read is present, which is
+     * all that matters for articulations and crescendo markings.
+     */
+    void mark_present() {
+        const std::string &key = frames.back().key;
+        for (int bit = 0; bit < num_note_articulations; bit++) {
+            if (key == articulation_keys[bit]) {
+                event.flags |= 1 << bit;
+                return;
+            }
+        }
+        if (key == "cresc") { event.cresc = true; }
+        else if (key == "decresc") { event.decresc = true; }
+    }
+
+    void append_event() {
+        if (event.type == "note") {
+            Note *n = arena_make<Note>(event.pitch, event.duration);
+            n->flags = event.flags;
+            part->append_note(n);
+        }
+        else if (event.type == "chord") {
+            Chord *c = arena_make<Chord>(event.pitches, event.duration);
+            c->flags = event.flags;
+            part->append_chord(c);
+        }
+        else if (event.type == "dynamic") {
+            part->append_dynamic(arena_make<Dynamic>(event.volume, event.cresc, event.decresc));
+        }
+    }
+
+    Frame root;
+    Part *root_part;
+    std::vector<OpenFrame> frames;
+
+    Part *part;
+    Part scratch;
+    EventFields event;
+    PatternSegment *segment;
+    CompositionMetrics *metrics;
+    std::vector<CompositionMetrics*> metrics_batch;
+    int key_tonic;
+    std::vector<int> key_intervals;
+    bool key_intervals_read;
+    std::vector<PacketPart*> packet_parts;
+    PacketPart *packet_tree_root;
+    std::vector<std::string> pattern;
+    Composition *comp;
+};
+
+/**
+ * Reads a Part, PatternSegment, CompositionMetrics, PacketPart or Composition
+ * from the given JSON text without building a JSON document.
+ *
+ * @param json The JSON text, in the form written by to_json in utilities.h.
+ * @param target The object to fill.
+ */
+template <typename T>
+void sax_from_json(const std::string &json, T &target) {
+    ModelSaxHandler handler(target);
+    json_sax_parse(json, handler);
+}
+
+/**
+ * Reads a Part, PatternSegment, CompositionMetrics, PacketPart or Composition
+ * from the JSON text in the given stream without building a JSON document or
+ * holding the whole text in memory.
+ *
+ * @param in The stream to read the JSON text from.
+ * @param target The object to fill.
+ */
+template <typename T>
+void sax_from_json(std::istream &in, T &target) {
+    ModelSaxHandler handler(target);
+    json_sax_parse(in, handler);
+}
+
+/**
+ * Reads a Composition from the given JSON text without building a JSON
+ * document. Everything read is owned by the Composition's Arena.
+ *
+ * @param json The JSON text, in the form written by to_json in utilities.h.
+ * @param comp The Composition to fill.
+ */
+inline void sax_from_json(const std::string &json, Composition &comp) {
+    ArenaScope scope(&comp.get_arena());
+    ModelSaxHandler handler(comp);
+    json_sax_parse(json, handler);
+}
+
+/**
+ * Reads a Composition from the JSON text in the given stream without building
+ * a JSON document. Everything read is owned by the Composition's Arena.
+ *
+ * @param in The stream to read the JSON text from.
+ * @param comp The Composition to fill.
+ */
+inline void sax_from_json(std::istream &in, Composition &comp) {
+    ArenaScope scope(&comp.get_arena());
+    ModelSaxHandler handler(comp);
+    json_sax_parse(in, handler);
+}
+
+#endif /* SAX_READER_H */
@@ -0,0 +1,427 @@
+/*
+ * File:    shell_trace.h
+ * Author:  Sam Rappl
+ *
+ */
+
+#ifndef SHELL_TRACE_H
+#define SHELL_TRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// ****************************TRACING*********************************
+// The packet shell records how long each call to a packet or module takes when
+// it is compiled with SHELL_TRACING defined and ShellOptions::trace is set.
+// Without SHELL_TRACING the hooks in the shell and in the JSON readers and
+// writers compile to nothing, and a ShellTrace stays empty.
+
+#ifdef SHELL_TRACING
+#define SHELL_TRACE_SERIALIZE TraceTimer shell_trace_timer(TraceTimer::SERIALIZE)
+#define SHELL_TRACE_PARSE TraceTimer shell_trace_timer(TraceTimer::PARSE)
+#else
+#define SHELL_TRACE_SERIALIZE
+#define SHELL_TRACE_PARSE
+#endif
+
+/**
+ * Returns the time on a steady clock in nanoseconds.
+ */
+inline int64_t trace_now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * Returns a small number which identifies the calling thread in a trace.
+ */
+inline int trace_thread_id() {
+    static std::atomic<int> next(1);
+    static thread_local int id = next++;
+    return id;
+}
+
+/**
+ * A TraceTimer adds the time from its construction to its destruction to the
+ * calling thread's total for serializing or parsing, unless another
+ * TraceTimer is already running on the thread, so that readers and writers
+ * which call one another are counted once. The shell takes the totals around
+ * each call (see TraceSpan).
+ */
+class TraceTimer {
+public:
+    enum Phase { SERIALIZE, PARSE };
+
+    TraceTimer(Phase phase) : phase(phase), outer(depth()++ == 0),
+            start(outer ? trace_now_ns() : 0) {}
+
+    ~TraceTimer() {
+        depth()--;
+        if (outer) {
+            totals()[phase] += trace_now_ns() - start;
+        }
+    }
+
+    /**
+     * Returns the calling thread's total for a phase in nanoseconds and resets
+     * it.
+     */
+    static int64_t take(Phase phase) {
+        int64_t total = totals()[phase];
+        totals()[phase] = 0;
+        return total;
+    }
+
+private:
+    TraceTimer(const TraceTimer&) = delete;
+    TraceTimer& operator=(const TraceTimer&) = delete;
+
+    static int& depth() {
+        static thread_local int depth = 0;
+        return depth;
+    }
+
+    static int64_t* totals() {
+        static thread_local int64_t totals[2] = { 0, 0 };
+        return totals;
+    }
+
+    Phase phase;
+    bool outer;
+    int64_t start;
+};
+
+/**
+ * One call to a packet or module. Times are in nanoseconds on trace_now_ns's
+ * clock.
+ */
+struct TraceRecord {
+    TraceRecord() : path(), mode(), start(0), call_start(0), call_end(0), end(0), serialize(0),
+            parse(0), bytes_in(0), bytes_out(0), thread(0), call_thread(0), cached(false) {}
+
+    std::string path;
+    std::string mode;
+
+    /** When the shell started encoding the input. */
+    int64_t start;
+
+    /** When the callback was started and when it finished. */
+    int64_t call_start;
+    int64_t call_end;
+
+    /** When the shell had decoded the output and merged it. */
+    int64_t end;
+
+    /** The time spent writing the input and reading the output. */
+    int64_t serialize;
+    int64_t parse;
+
+    size_t bytes_in;
+    size_t bytes_out;
+
+    /** The thread the shell ran on, and the thread the call finished on. */
+    int thread;
+    int call_thread;
+
+    /** Whether the output was found in ShellOptions::cache. */
+    bool cached;
+};
+
+/**
+ * A ShellTrace collects a TraceRecord for each call the shell makes, and writes
+ * them as Chrome trace event JSON, which chrome://tracing and Perfetto open,
+ * or as a table summed over each packet and module. Safe to use from several
+ * threads.
+ */
+class ShellTrace {
+public:
+
+    /**
+     * Returns whether the shell was compiled with SHELL_TRACING, without
+     * which nothing is recorded.
+     *
+     * @return Whether tracing is compiled in.
+     */
+    static bool compiled_in() {
+#ifdef SHELL_TRACING
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    ShellTrace() : mutex(), records() {}
+
+    ShellTrace(const ShellTrace&) = delete;
+    ShellTrace& operator=(const ShellTrace&) = delete;
+
+    void add(const TraceRecord &record) {
+        std::lock_guard<std::mutex> lock(mutex);
+        records.push_back(record);
+    }
+
+    /**
+     * Returns the records in the order their calls were merged.
+     *
+     * @return The records.
+     */
+    std::vector<TraceRecord> get_records() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return records;
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex);
+        records.clear();
+    }
+
+    /**
+     * Writes the records as a Chrome trace. Each call is a complete event on
+     * the thread it finished on, and the serializing and parsing around it
+     * are events on the shell's thread. Times start at the first record.
+     *
+     * @param out Where the JSON is written.
+     */
+    void write_chrome_trace(std::ostream &out) {
+        std::lock_guard<std::mutex> lock(mutex);
+        int64_t origin = 0;
+        for (int i = 0; i < records.size(); i++) {
+            if (i == 0 || records[i].start < origin) {
+                origin = records[i].start;
+            }
+        }
+        out << "{\"traceEvents\":[";
+        bool first = true;
+        for (int i = 0; i < records.size(); i++) {
+            const TraceRecord &r = records[i];
+            std::string name = display_name(r);
+            write_event(out, first, name, r.mode, r.call_start - origin,
+                    r.call_end - r.call_start, r.call_thread, &r);
+            if (r.serialize > 0) {
+                write_event(out, first, "serialize " + name, "serialize", r.start - origin,
+                        r.serialize, r.thread, NULL);
+            }
+            if (r.parse > 0) {
+                write_event(out, first, "parse " + name, "parse", r.end - r.parse - origin,
+                        r.parse, r.thread, NULL);
+            }
+        }
+        out << "],\"displayTimeUnit\":\"ms\"}";
+    }
+
+    /**
+     * Writes a table of the calls to each packet and module, in the order they
+     * were first called, with their total times in milliseconds and bytes.
+     *
+     * @param out Where the table is written.
+     */
+    void write_summary(std::ostream &out) {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<std::string> order;
+        std::map<std::string, Totals> totals;
+        Totals all;
+        for (int i = 0; i < records.size(); i++) {
+            std::string name = display_name(records[i]) + " (" + records[i].mode + ")";
+            if (totals.count(name) == 0) {
+                order.push_back(name);
+            }
+            totals[name].add(records[i]);
+            all.add(records[i]);
+        }
+        char line[256];
+        std::snprintf(line, sizeof(line), "%-32s %6s %6s %10s %10s %10s %10s %10s %10s\n",
+                "packet", "calls", "cached", "wall ms", "call ms", "write ms", "read ms",
+                "bytes in", "bytes out");
+        out << line;
+        for (int i = 0; i < order.size(); i++) {
+            write_totals(out, order[i], totals[order[i]]);
+        }
+        write_totals(out, "total", all);
+    }
+
+private:
+
+    /** The sums over the calls to one packet or module. */
+    struct Totals {
+        Totals() : calls(0), cached(0), wall(0), call(0), serialize(0), parse(0),
+                bytes_in(0), bytes_out(0) {}
+
+        void add(const TraceRecord &r) {
+            calls++;
+            cached += r.cached;
+            wall += r.end - r.start;
+            call += r.call_end - r.call_start;
+            serialize += r.serialize;
+            parse += r.parse;
+            bytes_in += r.bytes_in;
+            bytes_out += r.bytes_out;
+        }
+
+        int calls;
+        int cached;
+        int64_t wall;
+        int64_t call;
+        int64_t serialize;
+        int64_t parse;
+        size_t bytes_in;
+        size_t bytes_out;
+    };
+
+    static std::string display_name(const TraceRecord &r) {
+        return r.path.empty() ? r.mode : r.path;
+    }
+
+    static void write_totals(std::ostream &out, const std::string &name, const Totals &t) {
+        char line[256];
+        std::snprintf(line, sizeof(line),
+                "%-32s %6d %6d %10.3f %10.3f %10.3f %10.3f %10zu %10zu\n", name.c_str(),
+                t.calls, t.cached, t.wall / 1e6, t.call / 1e6, t.serialize / 1e6,
+                t.parse / 1e6, t.bytes_in, t.bytes_out);
+        out << line;
+    }
+
+    /** Writes a JSON string with the characters JSON requires escaped. */
+    static void write_string(std::ostream &out, const std::string &s) {
+        out << '"';
+        for (int i = 0; i < s.size(); i++) {
+            unsigned char c = s[i];
+            if (c == '"' || c == '\\') {
+                out << '\\' << c;
+            }
+            else if (c < 0x20) {
+                char escape[8];
+                std::snprintf(escape, sizeof(escape), "\\u%04x", c);
+                out << escape;
+            }
+            else {
+                out << c;
+            }
+        }
+        out << '"';
+    }
+
+    /**
+     * Writes a complete event. Chrome traces are in microseconds.
+     *
+     * @param call The record of a call, whose sizes are written as arguments,
+     *         or NULL.
+     */
+    static void write_event(std::ostream &out, bool &first, const std::string &name,
+            const std::string &category, int64_t ts, int64_t dur, int tid,
+            const TraceRecord *call) {
+        char numbers[128];
+        out << (first ? "" : ",") << "{\"name\":";
+        first = false;
+        write_string(out, name);
+        out << ",\"cat\":";
+        write_string(out, category);
+        std::snprintf(numbers, sizeof(numbers),
+                ",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d", ts / 1e3,
+                dur / 1e3, tid);
+        out << numbers;
+        if (call != NULL) {
+            std::snprintf(numbers, sizeof(numbers),
+                    ",\"args\":{\"bytes_in\":%zu,\"bytes_out\":%zu,\"cached\":%s}",
+                    call->bytes_in, call->bytes_out, call->cached ? "true" : "false");
+            out << numbers;
+        }
+        out << '}';
+    }
+
+    std::mutex mutex;
+    std::vector<TraceRecord> records;
+};
+
+/**
+ * A TraceSpan follows one call through the shell, which marks each step of it
+ * in order: begin, then serialized once the input is encoded, call_started and
+ * call_finished around the callback, and parsing and end around decoding and
+ * merging the output. Serializing and parsing are the time the readers and
+ * writers spent between those marks on the shell's thread (see TraceTimer).
+ * Without SHELL_TRACING every method is empty.
+ */
+class TraceSpan {
+public:
+#ifdef SHELL_TRACING
+    TraceSpan() : trace(NULL), record() {}
+
+    /**
+     * @param trace Where the record is added at the end, or NULL to record
+     *         nothing.
+     */
+    void begin(ShellTrace *trace, const std::string &path, const std::string &mode) {
+        this->trace = trace;
+        if (trace == NULL) {
+            return;
+        }
+        record = TraceRecord();
+        record.path = path;
+        record.mode = mode;
+        record.thread = trace_thread_id();
+        TraceTimer::take(TraceTimer::SERIALIZE);
+        record.start = trace_now_ns();
+        record.end = -1;
+    }
+
+    void serialized(size_t bytes_in) {
+        if (trace != NULL) {
+            record.serialize = TraceTimer::take(TraceTimer::SERIALIZE);
+            record.bytes_in = bytes_in;
+        }
+    }
+
+    void call_started() {
+        if (trace != NULL) {
+            record.call_start = trace_now_ns();
+        }
+    }
+
+    /** May be called on the thread the call ran on. */
+    void call_finished(size_t bytes_out, bool cached) {
+        if (trace != NULL) {
+            record.call_end = trace_now_ns();
+            record.call_thread = trace_thread_id();
+            record.bytes_out = bytes_out;
+            record.cached = cached;
+        }
+    }
+
+    void parsing() {
+        if (trace != NULL) {
+            TraceTimer::take(TraceTimer::PARSE);
+            record.end = trace_now_ns();
+        }
+    }
+
+    void end() {
+        if (trace == NULL) {
+            return;
+        }
+        int64_t now = trace_now_ns();
+        record.parse = record.end < 0 ? 0 : TraceTimer::take(TraceTimer::PARSE);
+        record.end = now;
+        trace->add(record);
+        trace = NULL;
+    }
+
+private:
+    ShellTrace *trace;
+    TraceRecord record;
+#else
+    void begin(ShellTrace*, const std::string&, const std::string&) {}
+    void serialized(size_t) {}
+    void call_started() {}
+    void call_finished(size_t, bool) {}
+    void parsing() {}
+    void end() {}
+#endif
+};
+
+#endif /* SHELL_TRACE_H */
@@ -0,0 +1,148 @@
+/*
+ * File:    tempo_map.h
+ * Author:  Sam Rappl
+ *
+ */
+
+#ifndef TEMPO_MAP_H
+#define TEMPO_MAP_H
+
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "constants.h"
+#include "composition_metrics.h"
+
+/**
+ * A TempoMap converts between FuseMuse positions and wall clock time in seconds
+ * across the tempo changes of a composition. Tempos are in quarter notes per
+ * minute. The time elapsed at each tempo change is computed once when the map is
+ * built, so each conversion is a binary search over the tempo changes.
+ */
+class TempoMap {
+public:
+
+    /**
+     * Constructs a TempoMap for a composition with the given composition metrics.
+     * Before the first composition metrics, the tempo of the first composition
+     * metrics is used. With no composition metrics, the default tempo of
+     * CompositionMetrics is used throughout. Throws an error message if a tempo
+     * is not positive.
+     *
+     * @param metrics The composition metrics of the composition, sorted by
+     *         position (see Composition::get_all_composition_metrics).
+     */
+    TempoMap(const std::vector<CompositionMetrics*> &metrics) : positions(),
+            elapsed(), seconds_per_tick() {
+        if (metrics.size() == 0) {
+            add_change(0, CompositionMetrics().tempo);
+            return;
+        }
+        if (metrics[0]->position > 0) {
+            add_change(0, metrics[0]->tempo);
+        }
+        for (int i = 0; i < metrics.size(); i++) {
+            add_change(metrics[i]->position, metrics[i]->tempo);
+        }
+    }
+
+    /**
+     * Returns the number of seconds from the start of the composition to the
+     * given position.
+     *
+     * @param ticks The position in FuseMuse duration units.
+     * @return The time of the position in seconds.
+     */
+    double ticks_to_seconds(int ticks) const {
+        int i = std::upper_bound(positions.begin() + 1, positions.end(), ticks) -
+                positions.begin() - 1;
+        return elapsed[i] + (ticks - positions[i]) * seconds_per_tick[i];
+    }
+
+    /**
+     * Returns the position reached the given number of seconds after the start of
+     * the composition. The result is not rounded to a whole tick.
+     *
+     * @param seconds The time in seconds.
+     * @return The position at that time in FuseMuse duration units.
+     */
+    double seconds_to_ticks(double seconds) const {
+        int i = std::upper_bound(elapsed.begin() + 1, elapsed.end(), seconds) -
+                elapsed.begin() - 1;
+        return positions[i] + (seconds - elapsed[i]) / seconds_per_tick[i];
+    }
+
+    /**
+     * Returns the time in seconds of each of the given positions. Because the
+     * positions are sorted, this walks the tempo changes once alongside them
+     * instead of searching for each position.
+     *
+     * @param ticks The positions in FuseMuse duration units, in increasing order.
+     * @return The time of each position in seconds.
+     */
+    std::vector<double> ticks_to_seconds(const std::vector<int> &ticks) const {
+        std::vector<double> seconds;
+        seconds.reserve(ticks.size());
+        int i = 0;
+        for (int k = 0; k < ticks.size(); k++) {
+            while (i + 1 < positions.size() && positions[i + 1] <= ticks[k]) {
+                i++;
+            }
+            seconds.push_back(elapsed[i] + (ticks[k] - positions[i]) * seconds_per_tick[i]);
+        }
+        return seconds;
+    }
+
+    /**
+     * Returns the number of tempo changes in the map, counting the starting tempo.
+     *
+     * @return The number of tempo changes.
+     */
+    int get_num_changes() const { return positions.size(); }
+
+private:
+
+    /**
+     * Appends a tempo change at the given position, which must not come before
+     * the last tempo change. A change to the same tempo is skipped. Throws an
+     * error message if the tempo is not positive.
+     *
+     * @param position The position of the change.
+     * @param tempo The new tempo in quarter notes per minute.
+     */
+    void add_change(int position, int tempo) {
+        if (tempo <= 0) {
+            throw std::string("The tempo at position " + std::to_string(position) +
+                    " is " + std::to_string(tempo) + ", but a tempo must be positive.");
+        }
+        double step = 60.0 / ((double)tempo * quarter_note);
+        if (positions.size() == 0) {
+            positions.push_back(position);
+            elapsed.push_back(0);
+            seconds_per_tick.push_back(step);
+            return;
+        }
+        if (step == seconds_per_tick.back()) {
+            return;
+        }
+        if (position == positions.back()) {
+            seconds_per_tick.back() = step;
+            return;
+        }
+        elapsed.push_back(elapsed.back() + (position - positions.back()) *
+                seconds_per_tick.back());
+        positions.push_back(position);
+        seconds_per_tick.push_back(step);
+    }
+
+    /** The position of each tempo change, in increasing order. */
+    std::vector<int> positions;
+
+    /** The number of seconds elapsed at each tempo change. */
+    std::vector<double> elapsed;
+
+    /** The length of one tick in seconds after each tempo change. */
+    std::vector<double> seconds_per_tick;
+};
+
+#endif /* TEMPO_MAP_H */
@@ -7,74 +7,79 @@
 #ifndef UTILITIES_H
 #define UTILITIES_H
 
+#include <deque>
 #include <exception>
+#include <functional>
+#include <memory>
+#include <set>
 #include <string>
 #include <vector>
 #include <nlohmann/json.hpp>
 #include "composition.h"
+#include "delta_log.h"
+#include "json_writer.h"
+#include "shell_trace.h"
+
+// The packet shell runs packets one at a time on the calling thread. Running
+// them on threads and worker processes (see executeShellAsync), caching their
+// outputs and saving checkpoints need POSIX and threads, so they are only
+// compiled when SHELL_EXTRAS is defined; a program which uses them must also
+// link the threads library.
+#ifdef SHELL_EXTRAS
+#include "checkpoint.h"
+#include "event_loop.h"
+#include "process_pool.h"
+#include "result_cache.h"
+#include "worker_pool.h"
+#else
+class CheckpointWriter;
+#endif
+
+// *********************ARTICULATIONS**********************
+void articulations_to_json(nlohmann::json &j, uint16_t flags) {
+    for (int bit = 0; flags != 0; bit++, flags >>= 1) {
+        if (flags & 1) { j[articulation_keys[bit]] = 1; }
+    }
+}
+
+uint16_t articulations_from_json(const nlohmann::json &j) {
+    uint16_t flags = 0;
+    for (int bit = 0; bit < num_note_articulations; bit++) {
+        if (j.find(articulation_keys[bit]) != j.end()) { flags |= 1 << bit; }
+    }
+    return flags;
+}
 
 // *************************NOTE***************************
 void to_json(nlohmann::json &j, const Note &note) {
     j = nlohmann::json{
         {"pitch", note.pitch},
-        {"duration", note.duration},
+        {"duration", note.get_duration()},
         {"type", "note"}
     };
-    if (note.triplet == 1) { j["triplet"] = 1; }
-    if (note.dotted == 1) { j["dotted"] = 1; }
-    if (note.double_dotted == 1) { j["double_dotted"] = 1; }
-    if (note.staccato == 1) { j["staccato"] = 1; }
-    if (note.tenuto == 1) { j["tenuto"] = 1; }
-    if (note.accent == 1) { j["accent"] = 1; }
-    if (note.fermata == 1) { j["fermata"] = 1; }
-    if (note.tied == 1) { j["tied"] = 1; }
-    if (note.slurred == 1) { j["slurred"] = 1; }
+    articulations_to_json(j, note.flags);
 }
 
 void from_json(const nlohmann::json &j, Note &note) {
     note.pitch = j.at("pitch").get<int>();
-    note.duration = j.at("duration").get<int>();
-    if (j.find("triplet") != j.end()) { note.triplet = 1; }
-    if (j.find("dotted") != j.end()) { note.dotted = 1; }
-    if (j.find("double_dotted") != j.end()) { note.double_dotted = 1; }
-    if (j.find("staccato") != j.end()) { note.staccato = 1; }
-    if (j.find("tenuto") != j.end()) { note.tenuto = 1; }
-    if (j.find("accent") != j.end()) { note.accent = 1; }
-    if (j.find("fermata") != j.end()) { note.fermata = 1; }
-    if (j.find("tied") != j.end()) { note.tied = 1; }
-    if (j.find("slurred") != j.end()) { note.slurred = 1; }
+    note.set_duration(j.at("duration").get<int>());
+    note.flags = articulations_from_json(j);
 }
 
 // *************************CHORD**************************
 void to_json(nlohmann::json &j, const Chord &chord) {
     j = nlohmann::json{
-        {"pitches", chord.pitches},
-        {"duration", chord.duration},
+        {"pitches", chord.pitches.to_vector()},
+        {"duration", chord.get_duration()},
         {"type", "chord"}
     };
-    if (chord.triplet == 1) { j["triplet"] = 1; }
-    if (chord.dotted == 1) { j["dotted"] = 1; }
-    if (chord.double_dotted == 1) { j["double_dotted"] = 1; }
-    if (chord.staccato == 1) { j["staccato"] = 1; }
-    if (chord.tenuto == 1) { j["tenuto"] = 1; }
-    if (chord.accent == 1) { j["accent"] = 1; }
-    if (chord.fermata == 1) { j["fermata"] = 1; }
-    if (chord.tied == 1) { j["tied"] = 1; }
-    if (chord.slurred == 1) { j["slurred"] = 1; }
+    articulations_to_json(j, chord.flags);
 }
 
 void from_json(const nlohmann::json &j, Chord &chord) {
     chord.pitches = j.at("pitches").get<std::vector<int>>();
-    chord.duration = j.at("duration").get<int>();
-    if (j.find("triplet") != j.end()) { chord.triplet = 1; }
-    if (j.find("dotted") != j.end()) { chord.dotted = 1; }
-    if (j.find("double_dotted") != j.end()) { chord.double_dotted = 1; }
-    if (j.find("staccato") != j.end()) { chord.staccato = 1; }
-    if (j.find("tenuto") != j.end()) { chord.tenuto = 1; }
-    if (j.find("accent") != j.end()) { chord.accent = 1; }
-    if (j.find("fermata") != j.end()) { chord.fermata = 1; }
-    if (j.find("tied") != j.end()) { chord.tied = 1; }
-    if (j.find("slurred") != j.end()) { chord.slurred = 1; }
+    chord.set_duration(j.at("duration").get<int>());
+    chord.flags = articulations_from_json(j);
 }
 
 // ***********************DYNAMIC*************************
@@ -94,46 +99,48 @@ void from_json(const nlohmann::json &j, Dynamic &dynamic) {
 }
 
 // ************************PART****************************
+/**
+ * A visitor which appends the JSON form of a music event to a JSON array.
+ */
+struct EventToJson {
+    EventToJson(nlohmann::json &events) : events(events) {}
+    void operator()(const Note &n) { events.push_back(n); }
+    void operator()(const Chord &c) { events.push_back(c); }
+    void operator()(const Dynamic &d) { events.push_back(d); }
+    nlohmann::json &events;
+};
+
 void to_json(nlohmann::json &j, const Part &part) {
+    SHELL_TRACE_SERIALIZE;
     j = nlohmann::json{
         {"name", part.get_name()},
         {"events", nlohmann::json::array()},
         {"length", part.get_length()}
     };
+    nlohmann::json &events = j["events"];
     std::vector<Event*>::const_iterator it;
     for (it = part.const_begin(); it != part.const_end(); it++) {
-        Event *e = *it;
-        Note *n = nullptr;
-        Chord *c = nullptr;
-        Dynamic *d = nullptr;
-        if (n = dynamic_cast<Note*>(e)) {
-            j["events"].push_back(*n);
-        }
-        else if (c = dynamic_cast<Chord*>(e)) {
-            j["events"].push_back(*c);
-        }
-        else if (d = dynamic_cast<Dynamic*>(e)) {
-            j["events"].push_back(*d);
-        }
+        visit(**it, EventToJson(events));
     }
 }
 
 void from_json(const nlohmann::json &j, Part &part) {
+    SHELL_TRACE_PARSE;
     part.set_name(j.at("name").get<std::string>());
     for (int i = 0; i < j["events"].size(); i++) {
         if (j.at("events").at(i).at("type") == "note") {
-            Note *n = new Note();
-            *n = j.at("events").at(i);
+            Note *n = arena_make<Note>();
+            from_json(j.at("events").at(i), *n);
             part.append_note(n);
         }
         else if (j.at("events").at(i).at("type") == "chord") {
-            Chord *c = new Chord();
-            *c = j.at("events").at(i);
+            Chord *c = arena_make<Chord>();
+            from_json(j.at("events").at(i), *c);
             part.append_chord(c);
         }
         else if (j.at("events").at(i).at("type") == "dynamic") {
-            Dynamic *d = new Dynamic();
-            *d = j.at("events").at(i);
+            Dynamic *d = arena_make<Dynamic>();
+            from_json(j.at("events").at(i), *d);
             part.append_dynamic(d);
         }
     }
@@ -151,9 +158,9 @@ void to_json(nlohmann::json &j, const PatternSegment &pattern_segment) {
 void from_json(const nlohmann::json &j, PatternSegment &pattern_segment) {
     pattern_segment.set_name(j.at("name").get<std::string>());
     pattern_segment.set_duration(j.at("duration").get<int>());
-    Part *p = new Part();
-    *p = j.at("chord_progression").get<Part>();
-    pattern_segment.set_chord_progression(p);
+    Part p;
+    from_json(j.at("chord_progression"), p);
+    pattern_segment.set_chord_progression(&p);
 }
 
 // **************************KEY***************************
@@ -185,7 +192,7 @@ void from_json(const nlohmann::json &j, TimeSignature &time_signature) {
 // *****************COMPOSITION METRICS********************
 void to_json(nlohmann::json &j, const CompositionMetrics &composition_metrics) {
     j = nlohmann::json{
-        {"key", composition_metrics.key},
+        {"key", composition_metrics.key.get()},
         {"time_signature", composition_metrics.time_signature},
         {"tempo", composition_metrics.tempo},
         {"position", composition_metrics.position}
@@ -222,14 +229,15 @@ void from_json(const nlohmann::json &j, PacketPart &packet_part) {
     packet_part.set_executed(j.at("executed").get<bool>());
     packet_part.set_inactive();
     for (int i = 0; i < j.at("children").size(); i++) {
-        PacketPart *p = new PacketPart();
-        *p = j.at("children").at(i).get<PacketPart>();
+        PacketPart *p = arena_make<PacketPart>();
+        from_json(j.at("children").at(i), *p);
         packet_part.append_child(p);
     }
 }
 
 // ********************COMPOSITION*************************
 void to_json(nlohmann::json &j, const Composition &comp) {
+    SHELL_TRACE_SERIALIZE;
     j["metrics"] = std::vector<CompositionMetrics>();
     j["parts"] = std::vector<Part>();
     j["pattern_segments"] = std::vector<PatternSegment>();
@@ -254,76 +262,1347 @@ void to_json(nlohmann::json &j, const Composition &comp) {
 }
 
 void from_json(const nlohmann::json &j, Composition &comp) {
+    SHELL_TRACE_PARSE;
+    // Everything read into the composition is owned by its arena
+    ArenaScope scope(&comp.get_arena());
+    std::vector<CompositionMetrics*> metrics;
     for (int i = 0; i < j["metrics"].size(); i++) {
-        CompositionMetrics *mets = new CompositionMetrics();
-        *mets = j.at("metrics").at(i).get<CompositionMetrics>();
-        comp.add_new_composition_metrics(mets);
+        CompositionMetrics *mets = arena_make<CompositionMetrics>();
+        from_json(j.at("metrics").at(i), *mets);
+        metrics.push_back(mets);
     }
+    comp.add_all_composition_metrics(metrics);
     for (int i = 0; i < j["parts"].size(); i++) {
-        Part *p = new Part();
-        *p = j.at("part").at(i).get<Part>();
+        Part *p = arena_make<Part>();
+        from_json(j.at("parts").at(i), *p);
         comp.add_part(*p);
     }
     for (int i = 0; i < j["pattern_segments"].size(); i++) {
-        PatternSegment *seg = new PatternSegment();
-        *seg = j.at("pattern_segments").at(i).get<PatternSegment>();
+        PatternSegment *seg = arena_make<PatternSegment>();
+        from_json(j.at("pattern_segments").at(i), *seg);
         comp.register_pattern_segment(seg);
     }
     for (int i = 0; i < j["pattern"].size(); i++) {
         comp.add_to_pattern(j.at("pattern").at(i).get<std::string>());
     }
-    PacketPart *pt = new PacketPart();
-    try {
-        *pt = j.at("packet_tree_root").get<PacketPart>();
-    } catch(const std::exception& ex) {
-        pt = NULL;
+    PacketPart *pt = NULL;
+    if (j.find("packet_tree_root") != j.end()) {
+        pt = arena_make<PacketPart>();
+        from_json(j.at("packet_tree_root"), *pt);
     }
     comp.set_packet_tree_root(pt);
 }
 
+// *********************WIRE FORMAT************************
+/**
+ * The encodings a composition can be exchanged in with packets and the control
+ * module. CBOR and MessagePack carry the same document as JSON in a smaller
+ * binary form which is cheaper to parse.
+ */
+enum WireFormat {
+    WIRE_JSON,
+    WIRE_CBOR,
+    WIRE_MSGPACK
+};
+
+/**
+ * Encodes a JSON document in the given wire format.
+ *
+ * @param j The document.
+ * @param format The wire format.
+ * @return The encoded document. CBOR and MessagePack are binary.
+ */
+std::string encode_wire(const nlohmann::json &j, WireFormat format) {
+    SHELL_TRACE_SERIALIZE;
+    std::string out;
+    if (format == WIRE_CBOR) {
+        nlohmann::json::to_cbor(j, out);
+    }
+    else if (format == WIRE_MSGPACK) {
+        nlohmann::json::to_msgpack(j, out);
+    }
+    else {
+        out = j.dump();
+    }
+    return out;
+}
+
+/**
+ * Decodes a document received in the given wire format.
+ *
+ * @param data The encoded document.
+ * @param format The wire format.
+ * @return The document.
+ */
+nlohmann::json decode_wire(const std::string &data, WireFormat format) {
+    SHELL_TRACE_PARSE;
+    if (format == WIRE_CBOR) {
+        return nlohmann::json::from_cbor(data);
+    }
+    if (format == WIRE_MSGPACK) {
+        return nlohmann::json::from_msgpack(data);
+    }
+    return nlohmann::json::parse(data);
+}
+
+/**
+ * Encodes a Composition in the given wire format. It is written directly (see
+ * json_writer.h), without building a document.
+ *
+ * @param comp The Composition.
+ * @param format The wire format.
+ * @return The encoded Composition.
+ */
+std::string encode_wire(const Composition &comp, WireFormat format) {
+    SHELL_TRACE_SERIALIZE;
+    if (format == WIRE_CBOR) {
+        return to_cbor_string(comp);
+    }
+    if (format == WIRE_MSGPACK) {
+        return to_msgpack_string(comp);
+    }
+    return to_json_string(comp);
+}
+
 // **********************SHELL**************************
 typedef std::string (*callback)(std::string zip_path, std::string mode, std::string input);
 
-void run(callback execute, PacketPart *node, nlohmann::json *composition_json,
-                std::string cm_path, Composition &comp) {
-    if(node) {
-        if (node->has_been_executed() == false) {
-            nlohmann::json packet_out;
-            node->set_active();
-            to_json(*composition_json, comp);
-            packet_out = nlohmann::json::parse(execute(node->get_packet_path(), node->get_mode(), composition_json->dump()));
-            node->set_inactive();
-            Part* new_part = new Part();
-            from_json(packet_out, *new_part);
-            comp.add_part(*new_part);
-            node->set_part(*new_part);
-            to_json(*composition_json, comp);
-            *composition_json = nlohmann::json::parse(execute(cm_path, "control", composition_json->dump()));
-            node->execute();
-        }
-        if (!node->is_leaf()) {
-            std::vector<PacketPart*> children = node->get_children();
-            for (int i = 0; i < children.size(); i++) {
-                run(execute, children[i], composition_json, cm_path, comp);
+#ifdef SHELL_EXTRAS
+/**
+ * Called with the output of a packet or module when it has finished, or with
+ * the exception it failed with. May be called from any thread.
+ */
+typedef std::function<void(std::string output, std::exception_ptr error)> completion_handler;
+
+/**
+ * Starts a packet or module and returns without waiting for it to finish. done
+ * must be called exactly once, from any thread, when it has finished.
+ */
+typedef std::function<void(std::string zip_path, std::string mode, std::string input,
+        completion_handler done)> async_callback;
+
+/**
+ * Runs a callback and passes its output, or the exception it threw, to done.
+ */
+void complete(callback execute, const std::string &path, const std::string &mode,
+        const std::string &input, const completion_handler &done) {
+    std::string output;
+    std::exception_ptr error;
+    try {
+        output = execute(path, mode, input);
+    }
+    catch (...) {
+        error = std::current_exception();
+    }
+    done(output, error);
+}
+
+/**
+ * Wraps a callback as an async_callback which runs it before returning.
+ *
+ * @param execute The callback.
+ * @return The async_callback.
+ */
+async_callback make_async_callback(callback execute) {
+    return [execute](std::string path, std::string mode, std::string input,
+            completion_handler done) {
+        complete(execute, path, mode, input, done);
+    };
+}
+
+/**
+ * Wraps a callback as an async_callback which runs it on one of the threads of
+ * a WorkerPool. The callback must be safe to call from several threads at once
+ * if the pool has more than one.
+ *
+ * @param execute The callback.
+ * @param pool The WorkerPool, which must outlive the async_callback.
+ * @return The async_callback.
+ */
+async_callback make_async_callback(callback execute, WorkerPool &pool) {
+    WorkerPool *workers = &pool;
+    return [execute, workers](std::string path, std::string mode, std::string input,
+            completion_handler done) {
+        workers->submit([=]() { complete(execute, path, mode, input, done); });
+    };
+}
+
+/**
+ * Wraps a ProcessPool as an async_callback which runs packets and modules on
+ * its worker processes from the threads of a WorkerPool.
+ *
+ * @param processes The ProcessPool, which must outlive the async_callback.
+ * @param pool The WorkerPool, which must outlive the async_callback.
+ * @return The async_callback.
+ */
+async_callback make_async_callback(ProcessPool &processes, WorkerPool &pool) {
+    ProcessPool *packets = &processes;
+    WorkerPool *workers = &pool;
+    return [packets, workers](std::string path, std::string mode, std::string input,
+            completion_handler done) {
+        workers->submit([=]() {
+            std::string output;
+            std::exception_ptr error;
+            try {
+                output = packets->execute(path, mode, input);
+            }
+            catch (...) {
+                error = std::current_exception();
+            }
+            done(output, error);
+        });
+    };
+}
+
+/**
+ * Runs an async_callback and waits for it to finish.
+ *
+ * @return The output of the packet or module.
+ */
+std::string wait_for(async_callback execute, const std::string &path, const std::string &mode,
+        const std::string &input) {
+    EventLoop loop;
+    std::string output;
+    std::exception_ptr error;
+    bool finished = false;
+    EventLoop *events = &loop;
+    execute(path, mode, input, [events, &output, &error, &finished](std::string out,
+            std::exception_ptr err) {
+        events->post([&output, &error, &finished, out, err]() {
+            output = out;
+            error = err;
+            finished = true;
+        });
+    });
+    while (!finished) {
+        loop.run_one();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    return output;
+}
+#endif
+
+/**
+ * Settings for running the packet shell. A WireFormat converts to ShellOptions
+ * with every other setting left at its default.
+ */
+struct ShellOptions {
+    ShellOptions(WireFormat format = WIRE_JSON)
+            : format(format), delta_receivers(), trace(NULL)
+#ifdef SHELL_EXTRAS
+            , num_workers(1), independent_packets(), cache(NULL), checkpoint_path()
+#endif
+            {}
+
+    /** The wire format inputs and outputs of the callback are encoded in. */
+    WireFormat format;
+
+    /**
+     * The paths of the packets and control modules which accept deltas. The
+     * first time one of them is passed the composition it is sent the whole
+     * composition, a JSON object. After that it is sent an RFC 6902 JSON Patch,
+     * a JSON array, of the changes since it was last sent the composition,
+     * which it applies to the composition it was last sent.
+     */
+    std::set<std::string> delta_receivers;
+
+    /**
+     * Where a TraceRecord of each call to a packet or module is added, or
+     * NULL. Nothing is recorded unless the shell is compiled with
+     * SHELL_TRACING (see shell_trace.h).
+     */
+    ShellTrace *trace;
+
+#ifdef SHELL_EXTRAS
+    /**
+     * The number of packets which may run at once. With more than one, the
+     * packets are run by an AsyncPacketRun, and a callback (though not an
+     * async_callback) must be safe to call from several threads at once. Only
+     * independent packets (see independent_packets) run alongside each other.
+     */
+    int num_workers;
+
+    /**
+     * The paths of the packets which read neither the Parts of the packets
+     * before them in depth first order, other than their ancestors', nor the
+     * output of the control module after their parent. An AsyncPacketRun starts
+     * one of them as soon as its parent's Part has been added, so sibling
+     * subtrees run concurrently, and passes it the composition as it was then.
+     * Every other packet is passed what run_packets would pass it. Packets
+     * which accept deltas are never started early.
+     */
+    std::set<std::string> independent_packets;
+
+    /**
+     * Where the outputs of packets and the control module are remembered, or
+     * NULL. A call whose path, mode, input, wire format and packet file (see
+     * packet_stamp) match an earlier one is not made again; its output is
+     * reused. Packets and modules which accept deltas are always called, as
+     * what they return depends on what they were sent before.
+     */
+    ResultCache *cache;
+
+    /**
+     * Where the composition, with the packet tree, is saved each time a packet
+     * has been executed, or "" to save nothing. It is written in the
+     * background by a CheckpointWriter, so that if a packet fails, the Parts of
+     * the packets before it are kept, and resume_shell carries on from there.
+     */
+    std::string checkpoint_path;
+#endif
+};
+
+/**
+ * Returns true if the given key is one of the keys of the JSON form of a
+ * Composition.
+ */
+bool is_composition_key(const std::string &key) {
+    return key == "metrics" || key == "packet_tree_root" || key == "parts" ||
+            key == "pattern" || key == "pattern_segments";
+}
+
+/**
+ * Returns true if the output of the driver or control module has keys which are
+ * not part of the composition. They are passed on to every packet and module
+ * after it, with the composition laid over them.
+ *
+ * @param module_output The decoded output of the module.
+ */
+bool has_extra_keys(const nlohmann::json &module_output) {
+    if (!module_output.is_object()) {
+        return false;
+    }
+    for (nlohmann::json::const_iterator it = module_output.begin();
+            it != module_output.end(); ++it) {
+        if (!is_composition_key(it.key())) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Returns the keys of the output of the driver or control module which are not
+ * part of the composition (see has_extra_keys).
+ *
+ * @param module_output The decoded output of the module.
+ * @return A JSON object of those keys and their values.
+ */
+nlohmann::json extra_keys(const nlohmann::json &module_output) {
+    nlohmann::json extra = nlohmann::json::object();
+    if (module_output.is_object()) {
+        for (nlohmann::json::const_iterator it = module_output.begin();
+                it != module_output.end(); ++it) {
+            if (!is_composition_key(it.key())) {
+                extra[it.key()] = it.value();
+            }
+        }
+    }
+    return extra;
+}
+
+/**
+ * Returns the given key escaped as a token of a JSON Pointer.
+ */
+std::string pointer_token(const std::string &key) {
+    std::string token;
+    for (int i = 0; i < key.size(); i++) {
+        if (key[i] == '~') {
+            token += "~0";
+        }
+        else if (key[i] == '/') {
+            token += "~1";
+        }
+        else {
+            token += key[i];
+        }
+    }
+    return token;
+}
+
+/**
+ * Replaces the latest output of the control module with a new one, recording
+ * in deltas the changes to the keys which are not part of the composition.
+ *
+ * @param composition_json The latest output of the control module, or of the
+ *         driver module before the control module has run.
+ * @param output The new output of the control module.
+ * @param deltas Where the changes are recorded, or NULL.
+ */
+void set_module_output(nlohmann::json *composition_json, nlohmann::json output,
+        DeltaLog *deltas) {
+    if (deltas != NULL) {
+        nlohmann::json none = nlohmann::json::object();
+        const nlohmann::json &before = composition_json->is_object() ? *composition_json : none;
+        const nlohmann::json &after = output.is_object() ? output : none;
+        for (nlohmann::json::const_iterator it = before.begin(); it != before.end(); ++it) {
+            if (!is_composition_key(it.key()) && after.find(it.key()) == after.end()) {
+                deltas->remove("/" + pointer_token(it.key()));
+            }
+        }
+        for (nlohmann::json::const_iterator it = after.begin(); it != after.end(); ++it) {
+            if (is_composition_key(it.key())) {
+                continue;
+            }
+            nlohmann::json::const_iterator old = before.find(it.key());
+            if (old == before.end()) {
+                deltas->add("/" + pointer_token(it.key()), it.value());
+            }
+            else if (old.value() != it.value()) {
+                deltas->replace("/" + pointer_token(it.key()), it.value());
             }
         }
     }
+    *composition_json = std::move(output);
 }
 
+/**
+ * Encodes the composition to pass to a packet or module, as a delta if it
+ * accepts deltas and has been sent the composition before (see ShellOptions).
+ * The keys of the latest module output which are not part of the composition
+ * are passed with it.
+ *
+ * @param path The path of the packet or module.
+ * @param module_output The latest output of the control module, or of the
+ *         driver module before the control module has run.
+ * @param deltas The changes made to the composition, or NULL if they are not
+ *         being tracked and the whole composition must be sent.
+ * @return The input of the packet or module.
+ */
+std::string composition_input(const std::string &path, const Composition &comp,
+        const nlohmann::json &module_output, const ShellOptions &options, DeltaLog *deltas) {
+    if (deltas != NULL && options.delta_receivers.count(path) != 0) {
+        if (deltas->has_snapshot(path)) {
+            return encode_wire(deltas->take_patch(path), options.format);
+        }
+        deltas->snapshot_sent(path);
+    }
+    if (!has_extra_keys(module_output)) {
+        return encode_wire(comp, options.format);
+    }
+    nlohmann::json j = extra_keys(module_output);
+    to_json(j, comp);
+    return encode_wire(j, options.format);
+}
+
+#ifdef SHELL_EXTRAS
+/**
+ * Returns the key of a call to a packet or module in options.cache, or "" if
+ * it must not be cached (see ShellOptions::cache).
+ */
+std::string cache_key(const std::string &path, const std::string &mode,
+        const std::string &input, const ShellOptions &options) {
+    if (options.cache == NULL || options.delta_receivers.count(path) != 0) {
+        return "";
+    }
+    return ResultCache::key(path, mode, input,
+            packet_stamp(path) + "/" + std::to_string(options.format));
+}
+#endif
+
+/**
+ * Runs a packet or module, or reuses its output from options.cache. A new
+ * output is not stored in the cache here: the caller stores it under key once
+ * it has decoded it, so output which cannot be decoded is never cached.
+ *
+ * @param span Marks when the call starts and finishes.
+ * @param key Set to the key to store the output under, or "" if it came from
+ *         the cache or must not be cached.
+ * @return The output of the packet or module.
+ */
+std::string cached_execute(callback execute, const std::string &path, const std::string &mode,
+        const std::string &input, const ShellOptions &options, TraceSpan &span,
+        std::string &key) {
+    span.call_started();
+    std::string output;
+#ifdef SHELL_EXTRAS
+    key = cache_key(path, mode, input, options);
+    if (!key.empty() && options.cache->get(key, output)) {
+        span.call_finished(output.size(), true);
+        key.clear();
+        return output;
+    }
+#else
+    key.clear();
+#endif
+    output = execute(path, mode, input);
+    span.call_finished(output.size(), false);
+    return output;
+}
+
+/**
+ * Passes the composition to a packet or module (see composition_input) and
+ * decodes its output.
+ *
+ * @param span Begun for the call. The caller ends it once it has merged the
+ *         output, so that merging counts as parsing.
+ * @return The decoded output of the packet or module.
+ */
+nlohmann::json send_composition(callback execute, const std::string &path,
+        const std::string &mode, const Composition &comp, const nlohmann::json &module_output,
+        const ShellOptions &options, DeltaLog *deltas, TraceSpan &span) {
+    span.begin(options.trace, path, mode);
+    std::string input = composition_input(path, comp, module_output, options, deltas);
+    span.serialized(input.size());
+    std::string key;
+    std::string output = cached_execute(execute, path, mode, input, options, span, key);
+    span.parsing();
+    nlohmann::json decoded = decode_wire(output, options.format);
+#ifdef SHELL_EXTRAS
+    if (!key.empty()) {
+        options.cache->put(key, output);
+    }
+#endif
+    return decoded;
+}
+
+/**
+ * Finds the JSON Pointer of a PacketPart in the JSON form of a Composition.
+ *
+ * @param tree The PacketPart at pointer.
+ * @param node The PacketPart to find.
+ * @param pointer The JSON Pointer of tree.
+ * @param found Set to the JSON Pointer of node if it is found.
+ * @return Whether node is tree or one of its descendants.
+ */
+bool find_packet_pointer(PacketPart *tree, PacketPart *node, const std::string &pointer,
+        std::string &found) {
+    if (tree == NULL) {
+        return false;
+    }
+    if (tree == node) {
+        found = pointer;
+        return true;
+    }
+    const std::vector<PacketPart*> &children = tree->get_children();
+    for (int i = 0; i < children.size(); i++) {
+        if (find_packet_pointer(children[i], node, pointer + "/children/" + std::to_string(i),
+                found)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Adds the Part a packet returned to the composition and sets it as the Part of
+ * the packet's node. The Part is read into an Arena of its own, which the node
+ * keeps so that a later run can reuse the Part, and which is freed once the
+ * node's Part is replaced and no composition keeps it.
+ *
+ * @param pointer The JSON Pointer of node in the JSON form of comp.
+ * @param packet_out The decoded output of the packet.
+ * @param deltas Where the changes are recorded, or NULL.
+ */
+void add_packet_part(PacketPart *node, const std::string &pointer,
+        const nlohmann::json &packet_out, Composition &comp, DeltaLog *deltas) {
+    std::shared_ptr<Arena> events(new Arena());
+    Part* new_part;
+    {
+        ArenaScope scope(events.get());
+        new_part = arena_make<Part>();
+        from_json(packet_out, *new_part);
+    }
+    comp.keep_arena(events);
+    bool added = comp.add_part(*new_part);
+    node->set_part(*new_part, events);
+    if (deltas != NULL) {
+        nlohmann::json part_json;
+        to_json(part_json, *new_part);
+        if (added) {
+            deltas->add("/parts/-", part_json);
+        }
+        deltas->replace(pointer + "/part", part_json);
+    }
+}
+
+/**
+ * Adds the Part a clean node produced on an earlier run to the composition
+ * without running its packet.
+ *
+ * @param deltas Where the change is recorded, or NULL.
+ */
+void reuse_packet_part(PacketPart *node, Composition &comp, DeltaLog *deltas) {
+    ArenaScope scope(&comp.get_arena());
+    Part *part = arena_make<Part>(node->get_part());
+    comp.keep_arena(node->get_part_arena());
+    if (comp.add_part(*part) && deltas != NULL) {
+        nlohmann::json part_json;
+        to_json(part_json, *part);
+        deltas->add("/parts/-", part_json);
+    }
+}
+
+/**
+ * Runs the packets below node for run, recording each change to the
+ * composition in deltas if it is not NULL.
+ *
+ * @param pointer The JSON Pointer of node in the JSON form of comp.
+ * @param reused Set to true when a clean node's Part is added, and to false
+ *         when the control module is called, so that run knows whether the
+ *         control module has seen the whole composition.
+ * @param checkpoint Where comp is saved after each packet is executed, or NULL.
+ */
+void run_packets(callback execute, PacketPart *node, const std::string &pointer,
+        nlohmann::json *composition_json, const std::string &cm_path, Composition &comp,
+        const ShellOptions &options, DeltaLog *deltas, bool *reused,
+        CheckpointWriter *checkpoint) {
+    if (node->has_been_executed()) {
+        reuse_packet_part(node, comp, deltas);
+        *reused = true;
+    }
+    else {
+        nlohmann::json packet_out;
+        TraceSpan span;
+        node->set_active();
+        if (deltas != NULL) {
+            deltas->replace(pointer + "/is_active", true);
+        }
+        packet_out = send_composition(execute, node->get_packet_path(), node->get_mode(), comp,
+                *composition_json, options, deltas, span);
+        node->set_inactive();
+        if (deltas != NULL) {
+            deltas->replace(pointer + "/is_active", false);
+        }
+        add_packet_part(node, pointer, packet_out, comp, deltas);
+        span.end();
+        set_module_output(composition_json, send_composition(execute, cm_path, "control", comp,
+                *composition_json, options, deltas, span), deltas);
+        span.end();
+        *reused = false;
+        node->execute();
+        if (deltas != NULL) {
+            deltas->replace(pointer + "/executed", true);
+        }
+#ifdef SHELL_EXTRAS
+        if (checkpoint != NULL) {
+            checkpoint->save(comp);
+        }
+#endif
+    }
+    const std::vector<PacketPart*> &children = node->get_children();
+    for (int i = 0; i < children.size(); i++) {
+        run_packets(execute, children[i], pointer + "/children/" + std::to_string(i),
+                composition_json, cm_path, comp, options, deltas, reused, checkpoint);
+    }
+}
+
+#ifdef SHELL_EXTRAS
+/** A node of the packet subtree an AsyncPacketRun schedules. */
+struct ScheduledPacket {
+    PacketPart *node;
+
+    /** The JSON Pointer of node in the JSON form of the composition. */
+    std::string pointer;
+
+    /** The indexes of the node's children in depth first order. */
+    std::vector<int> children;
+};
+
+/**
+ * Lists node and its descendants in depth first order.
+ */
+void schedule_packets(PacketPart *node, const std::string &pointer,
+        std::vector<ScheduledPacket> &packets) {
+    int index = packets.size();
+    packets.push_back(ScheduledPacket());
+    packets[index].node = node;
+    packets[index].pointer = pointer;
+    const std::vector<PacketPart*> &children = node->get_children();
+    for (int i = 0; i < children.size(); i++) {
+        packets[index].children.push_back(packets.size());
+        schedule_packets(children[i], pointer + "/children/" + std::to_string(i), packets);
+    }
+}
+
+/**
+ * Runs the packets below a node for run_async. Packets and the control module
+ * are started through an async_callback and their completions are handled on
+ * an EventLoop, so the thread running the packets encodes the next input and
+ * decodes the last output while packets and the control module are running.
+ * Only that thread touches the composition and the packet tree.
+ *
+ * Parts are merged into the composition in depth first order, whatever order
+ * the packets finish in, and the control module is passed the composition
+ * after each merge, one call at a time. A packet is started once the packet
+ * before it has been merged, and is passed what run_packets would pass it. It
+ * runs alongside the control module called after that packet, on the
+ * assumption that the control module does not change the keys of its output
+ * which are not part of the composition (see composition_input). If it does,
+ * the packet is run again. Packets which accept deltas wait for the control
+ * module instead. An independent packet (see ShellOptions::independent_packets)
+ * is started as soon as its parent has been merged, so sibling subtrees run
+ * concurrently, up to ShellOptions::num_workers packets at a time. It is passed
+ * the composition as it was when its parent was merged, with the keys its
+ * parent was passed. Since the Parts are merged in the same order, the
+ * composition and every composition the control module is passed are the same
+ * as run_packets produces, so long as the independent packets are.
+ *
+ * Packets which have been executed are not run. Their stored Parts are merged
+ * in their place, and if any are merged after the last packet which runs, the
+ * control module is passed the whole composition once more at the end.
+ *
+ * If a CheckpointWriter is given, the composition is saved each time a packet's
+ * Part is merged.
+ */
+class AsyncPacketRun {
+public:
+
+    /**
+     * @param pointer The JSON Pointer of node in the JSON form of comp.
+     * @param deltas Where changes to comp are recorded, or NULL.
+     * @param checkpoint Where comp is saved after each merge, or NULL.
+     */
+    AsyncPacketRun(async_callback execute, PacketPart *node, const std::string &pointer,
+            nlohmann::json *composition_json, const std::string &cm_path, Composition &comp,
+            const ShellOptions &options, DeltaLog *deltas, CheckpointWriter *checkpoint = NULL)
+            : execute(execute), composition_json(composition_json), cm_path(cm_path),
+            comp(comp), options(options), deltas(deltas), checkpoint(checkpoint), loop(), packets(), skipped(),
+            inputs(), outputs(), done(), keys(), spans(), started(), stale(), passed(),
+            next_merge(0), speculating(-1), reused(false), waiting(),
+            running(0), pending(0), control_inputs(), control_spans(), control_span(),
+            control_key(), control_running(false), error() {
+        schedule_packets(node, pointer, packets);
+        for (int i = 0; i < packets.size(); i++) {
+            skipped.push_back(packets[i].node->has_been_executed());
+        }
+        inputs.resize(packets.size());
+        outputs.resize(packets.size());
+        keys.resize(packets.size());
+        done.resize(packets.size(), false);
+        spans.resize(packets.size());
+        started.resize(packets.size(), false);
+        stale.resize(packets.size(), false);
+        passed.resize(packets.size());
+    }
+
+    AsyncPacketRun(const AsyncPacketRun&) = delete;
+    AsyncPacketRun& operator=(const AsyncPacketRun&) = delete;
+
+    /**
+     * Runs the packets and returns once every packet and call to the control
+     * module has finished. If one failed, nothing more is started, and its
+     * exception is rethrown once everything already started has finished.
+     */
+    void run() {
+        try {
+            merge();
+        }
+        catch (...) {
+            fail(std::current_exception());
+        }
+        while (pending > 0 || (!error && !finished())) {
+            try {
+                loop.run_one();
+            }
+            catch (...) {
+                fail(std::current_exception());
+            }
+        }
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+private:
+
+    /** The output of a call and what to do with it, posted to the loop. */
+    struct Completion {
+        std::function<void(std::string&, std::exception_ptr)> handler;
+        std::string output;
+        std::exception_ptr error;
+
+        void operator()() { handler(output, error); }
+    };
+
+    bool finished() const {
+        return next_merge == packets.size() && control_inputs.empty() && !control_running;
+    }
+
+    void fail(std::exception_ptr e) {
+        if (!error) {
+            error = e;
+        }
+    }
+
+    /**
+     * Starts a packet or module, with handler run on the loop when it has
+     * finished. If its output is in options.cache, it is not started and
+     * handler is passed the output.
+     *
+     * @param span Marks when the call starts and finishes. It must not move
+     *         until the call has finished.
+     * @param key Set to the key to store the output under once it has been
+     *         decoded (see remember), or "" if it came from the cache or must
+     *         not be cached.
+     */
+    void call(const std::string &path, const std::string &mode, const std::string &input,
+            TraceSpan *span, std::string &key,
+            std::function<void(std::string&, std::exception_ptr)> handler) {
+        pending++;
+        span->call_started();
+        key = cache_key(path, mode, input, options);
+        if (!key.empty()) {
+            Completion completion;
+            if (options.cache->get(key, completion.output)) {
+                span->call_finished(completion.output.size(), true);
+                key.clear();
+                completion.handler = handler;
+                loop.post(std::move(completion));
+                return;
+            }
+        }
+        EventLoop *events = &loop;
+        completion_handler finish = [events, span, handler](std::string output,
+                std::exception_ptr error) {
+            span->call_finished(output.size(), false);
+            Completion completion;
+            completion.handler = handler;
+            completion.output.swap(output);
+            completion.error = error;
+            events->post(std::move(completion));
+        };
+        try {
+            execute(path, mode, input, finish);
+        }
+        catch (...) {
+            finish("", std::current_exception());
+        }
+    }
+
+    /**
+     * Returns true if packet i is started as soon as its parent has been merged
+     * (see ShellOptions::independent_packets).
+     */
+    bool independent(int i) const {
+        const std::string &path = packets[i].node->get_packet_path();
+        return options.independent_packets.count(path) != 0 &&
+                options.delta_receivers.count(path) == 0;
+    }
+
+    /**
+     * Encodes the input of packet i, which is passed the composition as it is
+     * now with the keys of the given module output which are not part of the
+     * composition, and queues it to be started.
+     */
+    void ready(int i, const nlohmann::json &module_output) {
+        const ScheduledPacket &packet = packets[i];
+        started[i] = true;
+        passed[i] = extra_keys(module_output);
+        spans[i].begin(options.trace, packet.node->get_packet_path(), packet.node->get_mode());
+        packet.node->set_active();
+        if (deltas != NULL) {
+            deltas->replace(packet.pointer + "/is_active", true);
+        }
+        inputs[i] = composition_input(packet.node->get_packet_path(), comp, passed[i], options,
+                deltas);
+        spans[i].serialized(inputs[i].size());
+        packet.node->set_inactive();
+        if (deltas != NULL) {
+            deltas->replace(packet.pointer + "/is_active", false);
+        }
+        waiting.push_back(i);
+        start_packets();
+    }
+
+    void start_packets() {
+        while (!error && running < options.num_workers && !waiting.empty()) {
+            int i = waiting.front();
+            waiting.pop_front();
+            std::string input;
+            input.swap(inputs[i]);
+            running++;
+            call(packets[i].node->get_packet_path(), packets[i].node->get_mode(), input,
+                    &spans[i], keys[i], [this, i](std::string &output, std::exception_ptr e) {
+                        packet_done(i, output, e);
+                    });
+        }
+    }
+
+    void packet_done(int i, std::string &output, std::exception_ptr e) {
+        pending--;
+        running--;
+        if (stale[i]) {
+            stale[i] = false;
+            keys[i].clear();
+            if (!error) {
+                ready(i, *composition_json);
+            }
+            return;
+        }
+        if (e) {
+            fail(e);
+            return;
+        }
+        outputs[i].swap(output);
+        done[i] = true;
+        merge();
+        start_packets();
+    }
+
+    /**
+     * Starts the next packet in depth first order if it has not been started,
+     * passing it the composition and the latest output of the control module.
+     * If the control module is running, the packet is passed its last output
+     * (see control_done), unless it accepts deltas, when it waits.
+     */
+    void ready_next() {
+        int i = next_merge;
+        if (i == packets.size() || skipped[i] || started[i]) {
+            return;
+        }
+        if (control_running) {
+            if (options.delta_receivers.count(packets[i].node->get_packet_path()) != 0) {
+                return;
+            }
+            speculating = i;
+        }
+        ready(i, *composition_json);
+    }
+
+    /**
+     * Merges the Parts of finished packets and of packets which were already
+     * executed once every packet before them in depth first order has been
+     * merged and the control module has been passed the composition with them,
+     * and starts the packets this allows.
+     */
+    void merge() {
+        while (!error && !control_running && next_merge < packets.size()) {
+            ready_next();
+            int i = next_merge;
+            const ScheduledPacket &packet = packets[i];
+            if (skipped[i]) {
+                reuse_packet_part(packet.node, comp, deltas);
+                passed[i] = extra_keys(*composition_json);
+                reused = true;
+            }
+            else {
+                if (!done[i]) {
+                    return;
+                }
+                spans[i].parsing();
+                nlohmann::json packet_out = decode_wire(outputs[i], options.format);
+                remember(keys[i], outputs[i]);
+                std::string().swap(outputs[i]);
+                add_packet_part(packet.node, packet.pointer, packet_out, comp, deltas);
+                spans[i].end();
+                queue_control();
+                packet.node->execute();
+                if (deltas != NULL) {
+                    deltas->replace(packet.pointer + "/executed", true);
+                }
+                if (checkpoint != NULL) {
+                    checkpoint->save(comp);
+                }
+                start_control();
+            }
+            next_merge++;
+            for (int c = 0; c < packet.children.size(); c++) {
+                int child = packet.children[c];
+                if (!skipped[child] && independent(child)) {
+                    ready(child, passed[i]);
+                }
+            }
+            ready_next();
+        }
+        if (!error && !control_running && next_merge == packets.size() && reused) {
+            queue_control();
+            start_control();
+        }
+    }
+
+    /**
+     * Runs packet i again if the output of the control module which has just
+     * arrived changed the keys it was passed (see ready_next).
+     */
+    void check_speculation() {
+        int i = speculating;
+        speculating = -1;
+        if (i < 0 || passed[i] == extra_keys(*composition_json)) {
+            return;
+        }
+        if (done[i]) {
+            done[i] = false;
+            std::string().swap(outputs[i]);
+            keys[i].clear();
+            ready(i, *composition_json);
+        }
+        else {
+            stale[i] = true;
+        }
+    }
+
+    /** Encodes the composition as it is now for the control module. */
+    void queue_control() {
+        control_spans.push_back(TraceSpan());
+        control_spans.back().begin(options.trace, cm_path, "control");
+        control_inputs.push_back(composition_input(cm_path, comp, *composition_json, options,
+                deltas));
+        control_spans.back().serialized(control_inputs.back().size());
+        reused = false;
+    }
+
+    void start_control() {
+        if (error || control_running || control_inputs.empty()) {
+            return;
+        }
+        control_running = true;
+        std::string input;
+        input.swap(control_inputs.front());
+        control_inputs.pop_front();
+        control_span = control_spans.front();
+        control_spans.pop_front();
+        call(cm_path, "control", input, &control_span, control_key, [this](std::string &output, std::exception_ptr e) {
+            control_done(output, e);
+        });
+    }
+
+    void control_done(std::string &output, std::exception_ptr e) {
+        pending--;
+        control_running = false;
+        if (e) {
+            fail(e);
+            return;
+        }
+        control_span.parsing();
+        set_module_output(composition_json, decode_wire(output, options.format), deltas);
+        remember(control_key, output);
+        control_span.end();
+        check_speculation();
+        merge();
+    }
+
+    /**
+     * Stores a decoded output in options.cache under the key its call set, if
+     * it set one.
+     */
+    void remember(std::string &key, const std::string &output) {
+        if (!key.empty()) {
+            options.cache->put(key, output);
+            key.clear();
+        }
+    }
+
+    async_callback execute;
+    nlohmann::json *composition_json;
+    std::string cm_path;
+    Composition &comp;
+    const ShellOptions &options;
+    DeltaLog *deltas;
+    CheckpointWriter *checkpoint;
+    EventLoop loop;
+
+    /** The packets below the node in depth first order. */
+    std::vector<ScheduledPacket> packets;
+
+    /** Whether each packet had been executed before the run. */
+    std::vector<bool> skipped;
+
+    /** The inputs of the packets waiting to be started. */
+    std::vector<std::string> inputs;
+
+    /** The outputs of the packets which have finished but not been merged. */
+    std::vector<std::string> outputs;
+    std::vector<bool> done;
+
+    /** The keys the outputs of the packets are cached under (see call). */
+    std::vector<std::string> keys;
+
+    /** The trace of each packet's call, from its input to its merge. */
+    std::vector<TraceSpan> spans;
+
+    /** Whether each packet's input has been encoded. */
+    std::vector<bool> started;
+
+    /**
+     * Whether each running packet was passed keys the control module has since
+     * changed, so its output is dropped and it is run again.
+     */
+    std::vector<bool> stale;
+
+    /**
+     * The keys which are not part of the composition each packet was passed, or
+     * which were current when a packet which was not run was merged.
+     */
+    std::vector<nlohmann::json> passed;
+
+    /** The first packet which has not been merged. */
+    int next_merge;
+
+    /**
+     * The packet started while the control module was running, which is
+     * checked when it finishes (see check_speculation), or -1.
+     */
+    int speculating;
+
+    /**
+     * Whether a stored Part has been merged since the composition was last
+     * queued for the control module.
+     */
+    bool reused;
+
+    /** The packets ready to be started, in the order they became ready. */
+    std::deque<int> waiting;
+
+    /** The number of packets running. */
+    int running;
+
+    /** The number of calls which have been started but not handled. */
+    int pending;
+
+    /** The inputs of the calls to the control module not yet started. */
+    std::deque<std::string> control_inputs;
+    std::deque<TraceSpan> control_spans;
+
+    /** The trace of the running call to the control module. */
+    TraceSpan control_span;
+    std::string control_key;
+    bool control_running;
+
+    /** The first exception a call or event failed with. */
+    std::exception_ptr error;
+};
+
+/**
+ * Runs the packets of the packet tree below node which are dirty, as run does, through an async_callback (see AsyncPacketRun).
+ *
+ * @param execute The async_callback which starts a packet or module.
+ * @param node The root of the packet subtree to run.
+ * @param composition_json The output of the driver module, set to the latest
+ *         output of the control module. Its keys which are not part of the
+ *         composition are passed on with the composition (see
+ *         composition_input).
+ * @param cm_path The path of the control module.
+ * @param comp The composition the packets add their Parts to.
+ * @param options The wire format, which packets and modules accept deltas, and
+ *         how many packets may run at once. Deltas are only sent when node is
+ *         in comp's packet tree.
+ */
+void run_async(async_callback execute, PacketPart *node, nlohmann::json *composition_json,
+        const std::string &cm_path, Composition &comp,
+        const ShellOptions &options = ShellOptions()) {
+    if (node == NULL) {
+        return;
+    }
+    DeltaLog deltas;
+    std::string pointer;
+    bool track = !options.delta_receivers.empty() &&
+            find_packet_pointer(comp.get_packet_tree_root(), node, "/packet_tree_root", pointer);
+    std::unique_ptr<CheckpointWriter> checkpoint;
+    if (!options.checkpoint_path.empty()) {
+        checkpoint.reset(new CheckpointWriter(options.checkpoint_path));
+    }
+    AsyncPacketRun(execute, node, pointer, composition_json, cm_path, comp, options,
+            track ? &deltas : NULL, checkpoint.get()).run();
+    if (checkpoint) {
+        checkpoint->flush();
+    }
+}
+#endif
+
+/**
+ * Runs the packets of the packet tree below node which are dirty (see
+ * PacketPart::get_dirty), in leftmost depth first order. Each packet is passed
+ * the composition and returns a Part, and the control module is then passed the
+ * composition with that Part added. The Parts of clean packets are added in
+ * their place without running them, and if any come after the last dirty
+ * packet the control module is passed the whole composition once more.
+ *
+ * @param execute The callback which runs a packet or module.
+ * @param node The root of the packet subtree to run.
+ * @param composition_json The output of the driver module, set to the latest
+ *         output of the control module. Its keys which are not part of the
+ *         composition are passed on with the composition (see
+ *         composition_input).
+ * @param cm_path The path of the control module.
+ * @param comp The composition the packets add their Parts to.
+ * @param options The wire format, which packets and modules accept deltas, and
+ *         how many packets may run at once. Deltas are only sent when node is
+ *         in comp's packet tree. With more than one worker, the packets are
+ *         run on a WorkerPool by run_async.
+ */
+void run(callback execute, PacketPart *node, nlohmann::json *composition_json,
+                std::string cm_path, Composition &comp,
+                const ShellOptions &options = ShellOptions()) {
+    if (node == NULL) {
+        return;
+    }
+#ifdef SHELL_EXTRAS
+    if (options.num_workers > 1) {
+        WorkerPool pool(options.num_workers);
+        run_async(make_async_callback(execute, pool), node, composition_json, cm_path, comp,
+                options);
+        return;
+    }
+#endif
+    DeltaLog deltas;
+    std::string pointer;
+    bool track = !options.delta_receivers.empty() &&
+            find_packet_pointer(comp.get_packet_tree_root(), node, "/packet_tree_root", pointer);
+    CheckpointWriter *checkpoint = NULL;
+#ifdef SHELL_EXTRAS
+    std::unique_ptr<CheckpointWriter> writer;
+    if (!options.checkpoint_path.empty()) {
+        writer.reset(new CheckpointWriter(options.checkpoint_path));
+        checkpoint = writer.get();
+    }
+#endif
+    bool reused = false;
+    run_packets(execute, node, pointer, composition_json, cm_path, comp, options,
+            track ? &deltas : NULL, &reused, checkpoint);
+    if (reused) {
+        TraceSpan span;
+        set_module_output(composition_json, send_composition(execute, cm_path, "control", comp,
+                *composition_json, options, track ? &deltas : NULL, span), track ? &deltas : NULL);
+        span.end();
+    }
+#ifdef SHELL_EXTRAS
+    if (writer) {
+        writer->flush();
+    }
+#endif
+}
+
+/**
+ * Runs a module which is not passed the composition, marking span around it.
+ *
+ * @param execute Called with the path, mode and input, and returns the output.
+ * @param span Begun for the call and ended by the caller.
+ * @return The output of the module.
+ */
+template <typename F>
+std::string traced_execute(F execute, const std::string &path, const std::string &mode,
+        const std::string &input, TraceSpan &span) {
+    span.serialized(input.size());
+    span.call_started();
+    std::string output = execute(path, mode, input);
+    span.call_finished(output.size(), false);
+    return output;
+}
+
+/**
+ * Runs the final control module on the last output of the control module, then
+ * plays what it returns.
+ *
+ * @param execute Called with the path, mode and input, and returns the output.
+ * @param composition_json The last output of the control module.
+ * @return The output of the final control module, in the wire format.
+ */
+template <typename F>
+std::string finish_shell(F execute, const nlohmann::json &composition_json,
+        const std::string &cm_path, const ShellOptions &options) {
+    TraceSpan span;
+    span.begin(options.trace, cm_path, "finalcontrol");
+    std::string final_output = traced_execute(execute, cm_path, "finalcontrol",
+            encode_wire(composition_json, options.format), span);
+    span.end();
+    span.begin(options.trace, "", "play");
+    traced_execute(execute, "", "play", final_output, span);
+    span.end();
+    return final_output;
+}
+
+/**
+ * Runs a whole composition: the driver module, every packet of the packet tree
+ * with the control module after each, then the final control module, whose
+ * output is played and returned.
+ *
+ * @param execute The callback which runs a packet or module.
+ * @param root_node The root of the packet tree.
+ * @param dm_path The path of the driver module.
+ * @param cm_path The path of the control module.
+ * @param options The wire format, which packets and modules must all read and
+ *         write, which of them accept deltas, how many packets may run at
+ *         once, and where outputs are cached and calls traced. The final
+ *         control module is always sent the whole output of the last control
+ *         module.
+ * @return The output of the final control module, in the wire format.
+ */
 std::string executeShell(callback execute, PacketPart *root_node,
-               std::string dm_path, std::string cm_path) {
-       // Call the Driver Module and store the JSON it passes back as a composition
-       nlohmann::json dm_output = nlohmann::json::parse(execute(dm_path, "driver", ""));
+               std::string dm_path, std::string cm_path,
+               const ShellOptions &options = ShellOptions()) {
+       // Call the Driver Module and store the composition it passes back
+       TraceSpan span;
+       span.begin(options.trace, dm_path, "driver");
+       std::string driver_output = traced_execute(execute, dm_path, "driver", "", span);
+       span.parsing();
+       nlohmann::json dm_output = decode_wire(driver_output, options.format);
        // Populate the composition with the Packet Hierarchy
        Composition comp;
        from_json(dm_output, comp);
        comp.set_packet_tree_root(root_node);
+       span.end();
        // Execute Packets in a Leftmost Depth-First-Search order, passing them the
-       // most recent composition JSON
-       run(execute, root_node, &dm_output, cm_path, comp);
-       std::string final_json = execute(cm_path, "finalcontrol", dm_output.dump());
-       execute("", "play", final_json);
-       return final_json;
+       // most recent composition
+       run(execute, root_node, &dm_output, cm_path, comp, options);
+       return finish_shell(execute, dm_output, cm_path, options);
+}
+
+#ifdef SHELL_EXTRAS
+/**
+ * Carries on a run of executeShell from the checkpoint it saved (see
+ * ShellOptions::checkpoint_path), after a packet failed or the process
+ * stopped. The composition and packet tree are read from the checkpoint, and
+ * the packets which had not been executed are run, from the first of them in
+ * depth first order, with the Parts of the rest added in their place; then the
+ * final control module is run and its output played, as executeShell does. The
+ * driver module is not run again.
+ *
+ * @param execute The callback which runs a packet or module.
+ * @param cm_path The path of the control module.
+ * @param options As for executeShell. The checkpoint is read from
+ *         checkpoint_path and saved there again as packets are executed.
+ * @return The output of the final control module, in the wire format.
+ * @throws std::string If the checkpoint could not be read.
+ */
+std::string resume_shell(callback execute, const std::string &cm_path,
+        const ShellOptions &options) {
+    if (options.checkpoint_path.empty()) {
+        throw std::string("No checkpoint to resume from.");
+    }
+    Composition comp;
+    load_checkpoint(options.checkpoint_path, comp);
+    nlohmann::json composition_json;
+    to_json(composition_json, comp);
+    run(execute, comp.get_packet_tree_root(), &composition_json, cm_path, comp, options);
+    return finish_shell(execute, composition_json, cm_path, options);
+}
+
+/**
+ * Runs a whole composition as executeShell does, through an async_callback.
+ * The calling thread runs the event loop which encodes each input and decodes
+ * each output while packets and the control module run (see AsyncPacketRun).
+ *
+ * @param execute The async_callback which starts a packet or module. A
+ *         callback can be wrapped with make_async_callback.
+ * @param root_node The root of the packet tree.
+ * @param dm_path The path of the driver module.
+ * @param cm_path The path of the control module.
+ * @param options As for executeShell.
+ * @return The output of the final control module, in the wire format.
+ */
+std::string executeShellAsync(async_callback execute, PacketPart *root_node,
+        const std::string &dm_path, const std::string &cm_path,
+        const ShellOptions &options = ShellOptions()) {
+    std::function<std::string(const std::string&, const std::string&, const std::string&)>
+            call = [&execute](const std::string &path, const std::string &mode,
+            const std::string &input) {
+        return wait_for(execute, path, mode, input);
+    };
+    TraceSpan span;
+    span.begin(options.trace, dm_path, "driver");
+    std::string driver_output = traced_execute(call, dm_path, "driver", "", span);
+    span.parsing();
+    nlohmann::json dm_output = decode_wire(driver_output, options.format);
+    Composition comp;
+    from_json(dm_output, comp);
+    comp.set_packet_tree_root(root_node);
+    span.end();
+    run_async(execute, root_node, &dm_output, cm_path, comp, options);
+    return finish_shell(call, dm_output, cm_path, options);
 }
+#endif
 
 #endif /* UTILITIES_H */
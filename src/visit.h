@@ -0,0 +1,83 @@
+/*
+ * File:    visit.h
+ * Author:  Sam Rappl
+ *
+ */
+
+#ifndef VISIT_H
+#define VISIT_H
+
+#include <utility>
+#include "event.h"
+#include "note.h"
+#include "chord.h"
+#include "dynamics.h"
+
+/**
+ * Calls the visitor with the event passed in, downcast to its concrete type
+ * using the event's kind tag. The visitor must be callable with a Note&, a
+ * Chord& and a Dynamic&, and all three calls must return the same type.
+ * Untagged events are not passed to the visitor; a default constructed result
+ * is returned instead.
+ *
+ * @param e The event to visit.
+ * @param f The visitor to call with the concrete event.
+ * @return Whatever the visitor returns.
+ */
+template <typename F>
+auto visit(Event &e, F &&f) -> decltype(f(std::declval<Note&>())) {
+    typedef decltype(f(std::declval<Note&>())) result_type;
+    switch (e.get_kind()) {
+    case EVENT_NOTE:
+        return f(static_cast<Note&>(e));
+    case EVENT_CHORD:
+        return f(static_cast<Chord&>(e));
+    case EVENT_DYNAMIC:
+        return f(static_cast<Dynamic&>(e));
+    default:
+        return result_type();
+    }
+}
+
+/**
+ * Calls the visitor with the const event passed in, downcast to its concrete
+ * type using the event's kind tag.
+ *
+ * @param e The event to visit.
+ * @param f The visitor to call with the concrete event.
+ * @return Whatever the visitor returns.
+ */
+template <typename F>
+auto visit(const Event &e, F &&f) -> decltype(f(std::declval<const Note&>())) {
+    typedef decltype(f(std::declval<const Note&>())) result_type;
+    switch (e.get_kind()) {
+    case EVENT_NOTE:
+        return f(static_cast<const Note&>(e));
+    case EVENT_CHORD:
+        return f(static_cast<const Chord&>(e));
+    case EVENT_DYNAMIC:
+        return f(static_cast<const Dynamic&>(e));
+    default:
+        return result_type();
+    }
+}
+
+/**
+ * Returns the FuseMuse duration of a music event. Dynamics take up no time,
+ * so their duration is 0.
+ *
+ * @param e The event to get the duration of.
+ * @return The duration of the event in FuseMuse duration units.
+ */
+inline int event_duration(const Event *e) {
+    switch (e->get_kind()) {
+    case EVENT_NOTE:
+        return static_cast<const Note*>(e)->get_duration();
+    case EVENT_CHORD:
+        return static_cast<const Chord*>(e)->get_duration();
+    default:
+        return 0;
+    }
+}
+
+#endif /* VISIT_H */
@@ -0,0 +1,99 @@
+/*
+ * File:    worker_pool.h
+ * Author:  Sam Rappl
+ *
+ */
+
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * A WorkerPool runs tasks on a fixed number of threads, in the order they are
+ * submitted. Tasks must not throw; a task which can fail should catch its
+ * exception and hand it back to whoever is waiting on its result.
+ */
+class WorkerPool {
+public:
+
+    /**
+     * Starts the worker threads.
+     *
+     * @param num_threads The number of tasks which may run at once.
+     */
+    explicit WorkerPool(int num_threads) : tasks(), mutex(), wake(), threads(), stopping(false) {
+        for (int i = 0; i < num_threads; i++) {
+            threads.push_back(std::thread(&WorkerPool::work, this));
+        }
+    }
+
+    /**
+     * Waits for the running tasks to finish and stops the worker threads. Tasks
+     * which have not started are discarded.
+     */
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+            tasks.clear();
+        }
+        wake.notify_all();
+        for (int i = 0; i < threads.size(); i++) {
+            threads[i].join();
+        }
+    }
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    /**
+     * Queues a task to be run on one of the worker threads.
+     *
+     * @param task The task.
+     */
+    void submit(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tasks.push_back(std::move(task));
+        }
+        wake.notify_one();
+    }
+
+    /**
+     * Returns the number of worker threads.
+     *
+     * @return The number of worker threads.
+     */
+    int size() const { return threads.size(); }
+
+private:
+    void work() {
+        for (;;) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this]() { return stopping || !tasks.empty(); });
+                if (stopping) {
+                    return;
+                }
+                task = std::move(tasks.front());
+                tasks.pop_front();
+            }
+            task();
+        }
+    }
+
+    std::deque<std::function<void()> > tasks;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::vector<std::thread> threads;
+    bool stopping;
+};
+
+#endif /* WORKER_POOL_H */
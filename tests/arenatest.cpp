@@ -0,0 +1,122 @@
+/* 
+ * File:   arenatest.cpp
+ * Author: Sam Rappl
+ *
+ */
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include "arena.h"
+#include "note.h"
+#include "gtest/gtest.h"
+
+struct Counted {
+	Counted(int *count) : count(count) { (*count)++; }
+	~Counted() { (*count)--; }
+	int *count;
+};
+
+TEST(arenaTest, makeAndReleaseTest) {
+	int live = 0;
+	Arena arena;
+	for (int i = 0; i < 200; i++) {
+		arena.make<Counted>(&live);
+	}
+	ASSERT_EQ(200, live);
+	Note *n = arena.make<Note>(c4, eighth_note);
+	ASSERT_EQ(c4, n->pitch);
+	ASSERT_TRUE(n->is_note());
+	ASSERT_GT(arena.bytes_allocated(), 200 * sizeof(Counted));
+	arena.release();
+	ASSERT_EQ(0, live);
+	ASSERT_EQ(0, arena.bytes_allocated());
+	arena.make<Counted>(&live);
+	ASSERT_EQ(1, live);
+}
+
+TEST(arenaTest, destructorReleaseTest) {
+	int live = 0;
+	{
+		Arena arena;
+		arena.make<Counted>(&live);
+		arena.make<Counted>(&live);
+		ASSERT_EQ(2, live);
+	}
+	ASSERT_EQ(0, live);
+}
+
+TEST(arenaTest, allocateTest) {
+	Arena arena;
+	void *p = arena.allocate(3, 1);
+	void *q = arena.allocate(8, 8);
+	ASSERT_NE(p, q);
+	ASSERT_EQ(0, (uintptr_t)q % 8);
+	// Larger than a block
+	char *big = static_cast<char*>(arena.allocate(Arena::block_size * 2));
+	big[Arena::block_size * 2 - 1] = 1;
+	ASSERT_GE(arena.bytes_reserved(), Arena::block_size * 3);
+}
+
+TEST(arenaTest, scopeTest) {
+	Arena arena;
+	ASSERT_EQ(NULL, ArenaScope::current());
+	{
+		ArenaScope scope(&arena);
+		ASSERT_EQ(&arena, ArenaScope::current());
+		Note *n = arena_make<Note>();
+		ASSERT_GT(arena.bytes_allocated(), 0);
+		ASSERT_EQ(c4, n->pitch);
+	}
+	ASSERT_EQ(NULL, ArenaScope::current());
+}
+
+TEST(arenaTest, containsTest) {
+	Arena arena;
+	Note outside(c4, quarter_note);
+	ASSERT_FALSE(arena.contains(&outside));
+	Note *inside = arena.make<Note>(c4, quarter_note);
+	ASSERT_TRUE(arena.contains(inside));
+	ASSERT_FALSE(arena.contains(&outside));
+	void *big = arena.allocate(Arena::block_size * 2);
+	ASSERT_TRUE(arena.contains(static_cast<char*>(big) + Arena::block_size));
+	arena.release();
+	ASSERT_FALSE(arena.contains(inside));
+}
+
+template <int N>
+struct PoolTag {
+	PoolTag() : value(N) {}
+	~PoolTag() { value = -1; }
+	int value;
+	char padding[N * 8];
+};
+
+/** Makes a PoolTag<N> in a new Arena, so that its type gets a pool. */
+template <int N>
+void make_tag() {
+	Arena arena;
+	arena.make<PoolTag<N> >();
+}
+
+TEST(arenaTest, poolIdThreadsTest) {
+	// Each type is first used on its own thread at the same time, and must
+	// still get its own pool.
+	std::vector<std::thread> threads;
+	threads.push_back(std::thread(make_tag<1>));
+	threads.push_back(std::thread(make_tag<2>));
+	threads.push_back(std::thread(make_tag<3>));
+	threads.push_back(std::thread(make_tag<4>));
+	for (int i = 0; i < threads.size(); i++) {
+		threads[i].join();
+	}
+	Arena arena;
+	PoolTag<1> *one = arena.make<PoolTag<1> >();
+	PoolTag<2> *two = arena.make<PoolTag<2> >();
+	PoolTag<3> *three = arena.make<PoolTag<3> >();
+	PoolTag<4> *four = arena.make<PoolTag<4> >();
+	ASSERT_EQ(1, one->value);
+	ASSERT_EQ(2, two->value);
+	ASSERT_EQ(3, three->value);
+	ASSERT_EQ(4, four->value);
+}
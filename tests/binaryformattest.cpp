@@ -0,0 +1,153 @@
+/* 
+ * File:   binaryformattest.cpp
+ * Author: Sam Rappl
+ *
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+#include "binary_format.h"
+#include "json_writer.h"
+#include "sax_reader.h"
+#include "gtest/gtest.h"
+
+/**
+ * Returns a path for a temporary file, which the caller removes.
+ */
+std::string temp_path() {
+	char path[] = "/tmp/binaryformattestXXXXXX";
+	close(mkstemp(path));
+	return path;
+}
+
+/**
+ * Fills the given Composition with Parts, PatternSegments, composition metrics
+ * and a packet tree, everything the binary format stores.
+ */
+void fill_composition(Composition &comp) {
+	ArenaScope scope(&comp.get_arena());
+	Part *p = arena_make<Part>("melody");
+	p->append_dynamic(arena_make<Dynamic>(mf, 1, 0));
+	Note *n = arena_make<Note>(e3, quarter_note, true);
+	n->set_staccato();
+	p->append_note(n);
+	p->append_chord(arena_make<Chord>(c_major_chord, half_note));
+	p->append_note(arena_make<Note>(g3, eighth_note));
+	comp.add_part(*p);
+	Part *bass = arena_make<Part>("bass");
+	bass->append_note(arena_make<Note>(c2, whole_note));
+	comp.add_part(*bass);
+	PatternSegment *verse = arena_make<PatternSegment>("verse", whole_note);
+	verse->set_chord_progression(bass);
+	comp.register_pattern_segment(verse);
+	comp.add_to_pattern("verse");
+	comp.add_to_pattern("verse");
+	PacketPart *root = arena_make<PacketPart>();
+	root->set_packet_path("/");
+	root->set_mode("melody");
+	PacketPart *left = arena_make<PacketPart>();
+	left->set_packet_path("/left");
+	left->set_mode("harmony");
+	left->set_part(*p);
+	left->execute();
+	PacketPart *right = arena_make<PacketPart>();
+	right->set_packet_path("/right");
+	right->set_mode("harmony");
+	PacketPart *grandchild = arena_make<PacketPart>();
+	grandchild->set_packet_path("/right/center");
+	grandchild->set_mode("support");
+	root->append_child(left);
+	root->append_child(right);
+	right->append_child(grandchild);
+	root->set_inactive();
+	left->set_inactive();
+	right->set_inactive();
+	grandchild->set_inactive();
+	comp.set_packet_tree_root(root);
+	CompositionMetrics *m0 = arena_make<CompositionMetrics>();
+	m0->key = Key(f3, lydian_intervals);
+	m0->tempo = 77;
+	CompositionMetrics *m1 = arena_make<CompositionMetrics>();
+	m1->key = Key(e3, minor_intervals);
+	m1->time_signature = TimeSignature(6, 8);
+	m1->tempo = 90;
+	m1->position = whole_note;
+	comp.add_new_composition_metrics(m0);
+	comp.add_new_composition_metrics(m1);
+}
+
+TEST(binaryFormatTest, roundTripTest) {
+	Composition comp;
+	fill_composition(comp);
+	std::string path = temp_path();
+	ASSERT_TRUE(write_binary(path, comp));
+	Composition comp2;
+	read_binary(path, comp2);
+	std::remove(path.c_str());
+	ASSERT_TRUE(comp.equals(&comp2));
+	ASSERT_EQ(to_json_string(comp), to_json_string(comp2));
+	Composition from_json;
+	sax_from_json(to_json_string(comp), from_json);
+	ASSERT_TRUE(from_json.equals(&comp2));
+}
+
+TEST(binaryFormatTest, viewTest) {
+	Composition comp;
+	fill_composition(comp);
+	std::string path = temp_path();
+	ASSERT_TRUE(write_binary(path, comp));
+	BinaryComposition bin(path);
+	std::remove(path.c_str());
+	ASSERT_EQ(2, bin.get_num_parts());
+	ASSERT_EQ(1, bin.get_num_pattern_segments());
+	ASSERT_EQ(2, bin.get_num_composition_metrics());
+	BinaryPartView melody = bin.get_part(0);
+	ASSERT_STREQ("melody", melody.get_name());
+	ASSERT_EQ(4, melody.size());
+	ASSERT_EQ(EVENT_DYNAMIC, melody[0].kind);
+	ASSERT_EQ(mf, melody[0].value);
+	ASSERT_EQ(ARTICULATION_CRESC, melody[0].flags);
+	ASSERT_EQ(EVENT_NOTE, melody[1].kind);
+	ASSERT_EQ(e3, melody[1].value);
+	ASSERT_EQ(ARTICULATION_TRIPLET | ARTICULATION_STACCATO, melody[1].flags);
+	ASSERT_EQ(EVENT_CHORD, melody[2].kind);
+	ASSERT_EQ(c_major_chord.size(), melody[2].num_pitches);
+	ASSERT_EQ(c_major_chord[0], melody.get_pitches(melody[2])[0]);
+	ASSERT_EQ(comp.get_part("melody")->get_length(), melody.get_length());
+	ASSERT_STREQ("bass", bin.get_part(1).get_name());
+}
+
+TEST(binaryFormatTest, emptyCompositionTest) {
+	Composition comp;
+	std::string path = temp_path();
+	ASSERT_TRUE(write_binary(path, comp));
+	Composition comp2;
+	read_binary(path, comp2);
+	std::remove(path.c_str());
+	ASSERT_TRUE(comp2.get_packet_tree_root() == NULL);
+	ASSERT_EQ(to_json_string(comp), to_json_string(comp2));
+}
+
+TEST(binaryFormatTest, invalidFileTest) {
+	std::string path = temp_path();
+	std::ofstream out(path.c_str());
+	out << "{\"metrics\": [], \"parts\": []}";
+	out.close();
+	Composition comp;
+	ASSERT_THROW(read_binary(path, comp), std::string);
+	std::remove(path.c_str());
+	ASSERT_THROW(read_binary(path, comp), std::string);
+}
+
+TEST(binaryFormatTest, truncatedFileTest) {
+	Composition comp;
+	fill_composition(comp);
+	std::string path = temp_path();
+	ASSERT_TRUE(write_binary(path, comp));
+	ASSERT_EQ(0, truncate(path.c_str(), 200));
+	Composition comp2;
+	ASSERT_THROW(read_binary(path, comp2), std::string);
+	std::remove(path.c_str());
+}
@@ -0,0 +1,168 @@
+/*
+ * File:    checkpointtest.cpp
+ * Author:  Sam Rappl
+ *
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <dirent.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include "checkpoint.h"
+#include "gtest/gtest.h"
+
+/**
+ * Builds a composition with the packet tree "/" -> ("/left", "/right") in
+ * which "/" and "/left" have been executed.
+ */
+void build_checkpoint_composition(Composition &comp, std::vector<PacketPart> &nodes) {
+	const char *paths[] = { "/", "/left", "/right" };
+	for (int i = 0; i < 3; i++) {
+		nodes[i].set_packet_path(paths[i]);
+		nodes[i].set_mode("melody");
+	}
+	nodes[0].append_child(&nodes[1]);
+	nodes[0].append_child(&nodes[2]);
+	ArenaScope scope(&comp.get_arena());
+	for (int i = 0; i < 2; i++) {
+		Part *part = arena_make<Part>(paths[i]);
+		part->append_note(arena_make<Note>(c4 + i, quarter_note));
+		nodes[i].set_part(*part);
+		comp.add_part(*part);
+		nodes[i].execute();
+	}
+	comp.set_packet_tree_root(&nodes[0]);
+}
+
+/**
+ * Returns the names of the files in a directory.
+ */
+std::vector<std::string> list_directory(const std::string &dir) {
+	std::vector<std::string> names;
+	DIR *d = opendir(dir.c_str());
+	if (d == NULL) {
+		return names;
+	}
+	for (struct dirent *entry = readdir(d); entry != NULL; entry = readdir(d)) {
+		std::string name = entry->d_name;
+		if (name != "." && name != "..") {
+			names.push_back(name);
+		}
+	}
+	closedir(d);
+	return names;
+}
+
+TEST(checkpointTest, saveAndLoadTest) {
+	char dir[] = "/tmp/checkpointtestXXXXXX";
+	ASSERT_TRUE(mkdtemp(dir) != NULL);
+	std::string path = std::string(dir) + "/checkpoint.json";
+	Composition comp;
+	std::vector<PacketPart> nodes(3);
+	build_checkpoint_composition(comp, nodes);
+	{
+		CheckpointWriter writer(path);
+		writer.save(comp);
+		writer.flush();
+		ASSERT_EQ(1, writer.get_saved());
+		ASSERT_EQ(1, writer.get_written());
+	}
+	Composition loaded;
+	load_checkpoint(path, loaded);
+	ASSERT_EQ(to_json_string(comp), to_json_string(loaded));
+	PacketPart *root = loaded.get_packet_tree_root();
+	ASSERT_TRUE(root != NULL);
+	ASSERT_TRUE(root->has_been_executed());
+	ASSERT_TRUE(root->get_children()[0]->has_been_executed());
+	ASSERT_FALSE(root->get_children()[1]->has_been_executed());
+	ASSERT_EQ("/left", root->get_children()[0]->get_part().get_name());
+	std::vector<PacketPart*> dirty = root->get_dirty();
+	ASSERT_EQ(1, dirty.size());
+	ASSERT_EQ("/right", dirty[0]->get_packet_path());
+	// The temporary file was renamed over the checkpoint
+	ASSERT_EQ(std::vector<std::string>{ "checkpoint.json" }, list_directory(dir));
+	std::system((std::string("rm -rf ") + dir).c_str());
+}
+
+TEST(checkpointTest, latestSaveTest) {
+	char dir[] = "/tmp/checkpointtestXXXXXX";
+	ASSERT_TRUE(mkdtemp(dir) != NULL);
+	std::string path = std::string(dir) + "/checkpoint.json";
+	Composition comp;
+	std::vector<PacketPart> nodes(3);
+	build_checkpoint_composition(comp, nodes);
+	std::string last;
+	{
+		CheckpointWriter writer(path);
+		ArenaScope scope(&comp.get_arena());
+		for (int i = 0; i < 100; i++) {
+			comp.add_part(*arena_make<Part>("/part" + std::to_string(i)));
+			writer.save(comp);
+		}
+		last = to_json_string(comp);
+		ASSERT_EQ(100, writer.get_saved());
+		// The destructor writes the last save without a flush
+	}
+	Composition loaded;
+	load_checkpoint(path, loaded);
+	ASSERT_EQ(last, to_json_string(loaded));
+	ASSERT_EQ(102, loaded.get_parts().size());
+	std::system((std::string("rm -rf ") + dir).c_str());
+}
+
+TEST(checkpointTest, sharedPathTest) {
+	char dir[] = "/tmp/checkpointtestXXXXXX";
+	ASSERT_TRUE(mkdtemp(dir) != NULL);
+	std::string path = std::string(dir) + "/checkpoint.json";
+	Composition comps[2];
+	std::vector<PacketPart> nodes[2] = { std::vector<PacketPart>(3), std::vector<PacketPart>(3) };
+	build_checkpoint_composition(comps[0], nodes[0]);
+	build_checkpoint_composition(comps[1], nodes[1]);
+	{
+		// Two writers with the same checkpoint, such as two shells resumed from
+		// it, each write temporary files of their own
+		CheckpointWriter first(path);
+		CheckpointWriter second(path);
+		CheckpointWriter *writers[2] = { &first, &second };
+		std::string errors[2];
+		std::vector<std::thread> threads;
+		for (int w = 0; w < 2; w++) {
+			threads.push_back(std::thread([&comps, &writers, &errors, w]() {
+				try {
+					for (int i = 0; i < 50; i++) {
+						writers[w]->save(comps[w]);
+						writers[w]->flush();
+					}
+				}
+				catch (std::string &e) {
+					errors[w] = e;
+				}
+			}));
+		}
+		threads[0].join();
+		threads[1].join();
+		ASSERT_EQ("", errors[0]);
+		ASSERT_EQ("", errors[1]);
+		ASSERT_EQ(50, first.get_written());
+		ASSERT_EQ(50, second.get_written());
+	}
+	Composition loaded;
+	load_checkpoint(path, loaded);
+	ASSERT_EQ(to_json_string(comps[0]), to_json_string(loaded));
+	ASSERT_EQ(std::vector<std::string>{ "checkpoint.json" }, list_directory(dir));
+	std::system((std::string("rm -rf ") + dir).c_str());
+}
+
+TEST(checkpointTest, errorTest) {
+	Composition comp;
+	CheckpointWriter writer("/nonexistent/directory/checkpoint.json");
+	writer.save(comp);
+	ASSERT_THROW(writer.flush(), std::string);
+	// The error is reported once
+	writer.flush();
+	Composition loaded;
+	ASSERT_THROW(load_checkpoint("/nonexistent/directory/checkpoint.json", loaded),
+			std::string);
+}
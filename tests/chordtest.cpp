@@ -13,39 +13,39 @@ TEST(chordTest, chordDefaultConstructorTest) {
 	// Test Default constructor
 	Chord chord;
 	ASSERT_EQ(c_major_chord, chord.pitches);
-	ASSERT_EQ(quarter_note, chord.duration);
-	ASSERT_FALSE(chord.triplet);
-	ASSERT_FALSE(chord.dotted);
-	ASSERT_FALSE(chord.double_dotted);
-	ASSERT_FALSE(chord.staccato);
-	ASSERT_FALSE(chord.tenuto);
-	ASSERT_FALSE(chord.accent);
-	ASSERT_FALSE(chord.fermata);
-	ASSERT_FALSE(chord.tied);
-	ASSERT_FALSE(chord.slurred);
+	ASSERT_EQ(quarter_note, chord.get_duration());
+	ASSERT_FALSE(chord.is_triplet());
+	ASSERT_FALSE(chord.is_dotted());
+	ASSERT_FALSE(chord.is_double_dotted());
+	ASSERT_FALSE(chord.is_staccato());
+	ASSERT_FALSE(chord.is_tenuto());
+	ASSERT_FALSE(chord.is_accented());
+	ASSERT_FALSE(chord.has_fermata());
+	ASSERT_FALSE(chord.is_tied());
+	ASSERT_FALSE(chord.is_slurred());
 }
 
 TEST(chordTest, chordConstructorPitchDurationTest) {
 	// Test pitch and duration constructor
 	Chord chord(d_major_chord, quarter_note);
 	ASSERT_EQ(d_major_chord, chord.pitches);
-	ASSERT_EQ(quarter_note, chord.duration);
-	ASSERT_FALSE(chord.triplet);
-	ASSERT_FALSE(chord.dotted);
-	ASSERT_FALSE(chord.double_dotted);
-	ASSERT_FALSE(chord.staccato);
-	ASSERT_FALSE(chord.tenuto);
-	ASSERT_FALSE(chord.accent);
-	ASSERT_FALSE(chord.fermata);
-	ASSERT_FALSE(chord.tied);
-	ASSERT_FALSE(chord.slurred);
+	ASSERT_EQ(quarter_note, chord.get_duration());
+	ASSERT_FALSE(chord.is_triplet());
+	ASSERT_FALSE(chord.is_dotted());
+	ASSERT_FALSE(chord.is_double_dotted());
+	ASSERT_FALSE(chord.is_staccato());
+	ASSERT_FALSE(chord.is_tenuto());
+	ASSERT_FALSE(chord.is_accented());
+	ASSERT_FALSE(chord.has_fermata());
+	ASSERT_FALSE(chord.is_tied());
+	ASSERT_FALSE(chord.is_slurred());
 }
 
 TEST(chordTest, chordConstructorPitchDurationTripDotDoubleTest) {
 	Chord chord(d_major_chord, dotted_quarter_note, false, true, false);
-	ASSERT_FALSE(chord.triplet);
-	ASSERT_TRUE(chord.dotted);
-	ASSERT_FALSE(chord.double_dotted);
+	ASSERT_FALSE(chord.is_triplet());
+	ASSERT_TRUE(chord.is_dotted());
+	ASSERT_FALSE(chord.is_double_dotted());
 }
 
 TEST(chordTest, chordAllArgsConstructorTest) {
@@ -53,16 +53,16 @@ TEST(chordTest, chordAllArgsConstructorTest) {
 	Chord chord(d_major_chord, quarter_note, false, false, false, true,
 		false, false, false, false, true);
 	ASSERT_EQ(d_major_chord, chord.pitches);
-	ASSERT_EQ(quarter_note, chord.duration);
-	ASSERT_FALSE(chord.triplet);
-	ASSERT_FALSE(chord.dotted);
-	ASSERT_FALSE(chord.double_dotted);
-	ASSERT_TRUE(chord.staccato);
-	ASSERT_FALSE(chord.tenuto);
-	ASSERT_FALSE(chord.accent);
-	ASSERT_FALSE(chord.fermata);
-	ASSERT_FALSE(chord.tied);
-	ASSERT_TRUE(chord.slurred);
+	ASSERT_EQ(quarter_note, chord.get_duration());
+	ASSERT_FALSE(chord.is_triplet());
+	ASSERT_FALSE(chord.is_dotted());
+	ASSERT_FALSE(chord.is_double_dotted());
+	ASSERT_TRUE(chord.is_staccato());
+	ASSERT_FALSE(chord.is_tenuto());
+	ASSERT_FALSE(chord.is_accented());
+	ASSERT_FALSE(chord.has_fermata());
+	ASSERT_FALSE(chord.is_tied());
+	ASSERT_TRUE(chord.is_slurred());
 }
 
 TEST(chordTest, dotTest) {
@@ -70,11 +70,11 @@ TEST(chordTest, dotTest) {
 	
 	// Test dot function
 	chord.dot();
-	ASSERT_EQ(dotted_quarter_note, chord.duration);
+	ASSERT_EQ(dotted_quarter_note, chord.get_duration());
 	
 	// Test dotting a second time
 	chord.dot();
-	ASSERT_EQ(double_dotted_quarter_note, chord.duration);
+	ASSERT_EQ(double_dotted_quarter_note, chord.get_duration());
 	
 	// Test dotting a third time
 	ASSERT_FALSE(chord.dot());
@@ -82,7 +82,7 @@ TEST(chordTest, dotTest) {
 	// Test double dotting
 	Chord chord2(a_sus2_chord, quarter_note);
 	chord2.double_dot();
-	ASSERT_EQ(double_dotted_quarter_note, chord2.duration);
+	ASSERT_EQ(double_dotted_quarter_note, chord2.get_duration());
 	
 	// Test double dotting a dotted chord
 	Chord chord3(e_minor_7_chord, dotted_quarter_note, false, true, false);
@@ -96,10 +96,10 @@ TEST(chordTest, tripletTest) {
 	
 	// Test put_in_triplet function
 	chord.put_in_triplet();
-	ASSERT_EQ(triplet_quarter_note, chord.duration);
+	ASSERT_EQ(triplet_quarter_note, chord.get_duration());
 	ASSERT_FALSE(chord.put_in_triplet());
 	chord2.put_in_triplet();
-	ASSERT_EQ(triplet_dotted_eighth_note, chord2.duration);
+	ASSERT_EQ(triplet_dotted_eighth_note, chord2.get_duration());
 	ASSERT_FALSE(chord2.put_in_triplet());
 	ASSERT_FALSE(chord3.put_in_triplet());
 }
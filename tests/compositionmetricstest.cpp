@@ -7,6 +7,7 @@
 #include "composition_metrics.h"
 #include "constants.h"
 #include "gtest/gtest.h"
+#include <type_traits>
 #include <vector>
 
 TEST(timeSigTest, timeSigDefaultConstructorTest) {
@@ -170,6 +171,49 @@ TEST(keyTest, nextPitchInScaleTest) {
 	ASSERT_EQ(g4, key.next_pitch_in_scale(fs4));
 }
 
+TEST(keyTest, nextPitchAcrossOctaveTest) {
+	Key key(a3, major_intervals);
+	// From the tonic and across the octave boundary
+	ASSERT_EQ(b3, key.next_pitch_in_scale(a3));
+	ASSERT_EQ(cs4, key.next_pitch_in_scale(b3));
+	ASSERT_EQ(cs4, key.next_pitch_in_scale(c4));
+	ASSERT_EQ(gs3, key.previous_pitch_in_scale(a3));
+	ASSERT_EQ(b3, key.previous_pitch_in_scale(cs4));
+	ASSERT_EQ(b3, key.previous_pitch_in_scale(c4));
+}
+
+TEST(keyTest, scaleMaskTest) {
+	Key key(c3, major_intervals);
+	ASSERT_EQ(0xab5, key.get_scale_mask());
+	Key key2(fs3, minor_pentatonic_intervals);
+	for (int pitch = 0; pitch < 140; pitch++) {
+		bool in_scale = false;
+		int degree = -1;
+		std::vector<int> scale = key2.get_scale();
+		for (int i = scale.size() - 1; i >= 0; i--) {
+			if (pitch % 12 == scale[i] % 12) {
+				in_scale = true;
+				degree = i + 1;
+			}
+		}
+		ASSERT_EQ(in_scale, key2.is_in_scale(pitch));
+		ASSERT_EQ(degree, key2.position_in_scale(pitch));
+		int next = pitch + 1;
+		while (!key2.is_in_scale(next)) {
+			next++;
+		}
+		ASSERT_EQ(next, key2.next_pitch_in_scale(pitch));
+		int previous = pitch - 1;
+		while (!key2.is_in_scale(previous + 120)) {
+			previous--;
+		}
+		ASSERT_EQ(previous, key2.previous_pitch_in_scale(pitch));
+	}
+	key2.set_tonic(g3);
+	ASSERT_TRUE(key2.is_in_scale(g3));
+	ASSERT_FALSE(key2.is_in_scale(fs3));
+}
+
 TEST(keyTest, nthPitchTest) {
 	Key key(c3, lydian_intervals);
 	ASSERT_EQ(c3, key.get_tonic());
@@ -186,6 +230,37 @@ TEST(keyTest, keyEqualsTest) {
 	ASSERT_FALSE(key.equals(&key4));
 }
 
+TEST(keyTest, keyHandleTest) {
+	KeyHandle handle(Key(fs3, minor_intervals));
+	KeyHandle handle2(fs3, minor_intervals);
+	KeyHandle handle3(fs3, dorian_intervals);
+	int interned = KeyHandle::num_interned();
+	// Equal keys share one interned Key
+	ASSERT_TRUE(handle == handle2);
+	ASSERT_EQ(&handle.get(), &handle2.get());
+	ASSERT_TRUE(handle.equals(&handle2));
+	ASSERT_FALSE(handle == handle3);
+	KeyHandle handle4 = handle3;
+	ASSERT_TRUE(handle4 == handle3);
+	ASSERT_EQ(interned, KeyHandle::num_interned());
+	// Queries are answered by the interned Key
+	ASSERT_EQ(fs3, handle.get_tonic());
+	ASSERT_EQ(minor_intervals, handle.get_intervals());
+	ASSERT_TRUE(handle3.is_in_scale(ds3));
+	ASSERT_FALSE(handle.is_in_scale(ds3));
+	ASSERT_TRUE(KeyHandle() == KeyHandle(c3, major_intervals));
+}
+
+TEST(compositionMetricsTest, trivialCopyTest) {
+	ASSERT_TRUE(std::is_trivially_copyable<KeyHandle>::value);
+	ASSERT_TRUE(std::is_trivially_copyable<CompositionMetrics>::value);
+	CompositionMetrics mets;
+	mets.key = Key(b3, lydian_intervals);
+	CompositionMetrics copy = mets;
+	ASSERT_TRUE(copy.equals(&mets));
+	ASSERT_EQ(b3, copy.key.get_tonic());
+}
+
 TEST(compositionMetricsTest, compositionMetricsDefaultConstructorTest) {
 	CompositionMetrics comp;
 	std::vector<int> scale;
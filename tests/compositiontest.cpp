@@ -169,6 +169,37 @@ TEST(compositionTest, addNewCompositionMetricsTest) {
 	ASSERT_EQ(120, comp.get_composition_metrics_at_position(51)->tempo);
 }
 
+TEST(compositionTest, addAllCompositionMetricsTest) {
+	Composition comp;
+	std::vector<CompositionMetrics> mets(6);
+	int positions[6] = {960, 5, 480, 0, 480, 1440};
+	int tempos[6] = {100, 70, 90, 60, 95, 100};
+	std::vector<CompositionMetrics*> batch;
+	for (int i = 0; i < 6; i++) {
+		mets[i].position = positions[i];
+		mets[i].tempo = tempos[i];
+		batch.push_back(&mets[i]);
+	}
+	comp.add_all_composition_metrics(batch);
+	std::vector<CompositionMetrics*> timeline = comp.get_all_composition_metrics();
+	// The later change at 480 replaces the earlier one, and the change at 1440
+	// is dropped because the tempo does not change.
+	ASSERT_EQ(4, timeline.size());
+	ASSERT_EQ(&mets[3], timeline[0]);
+	ASSERT_EQ(&mets[1], timeline[1]);
+	ASSERT_EQ(&mets[4], timeline[2]);
+	ASSERT_EQ(&mets[0], timeline[3]);
+	ASSERT_EQ(60, comp.get_composition_metrics_at_position(4)->tempo);
+	ASSERT_EQ(70, comp.get_composition_metrics_at_position(479)->tempo);
+	ASSERT_EQ(95, comp.get_composition_metrics_at_position(480)->tempo);
+	ASSERT_EQ(100, comp.get_composition_metrics_at_position(5000)->tempo);
+	// Single changes still work on a timeline built in bulk
+	ASSERT_TRUE(comp.add_tempo_change(110, 700));
+	ASSERT_EQ(95, comp.get_composition_metrics_at_position(699)->tempo);
+	ASSERT_EQ(110, comp.get_composition_metrics_at_position(700)->tempo);
+	ASSERT_EQ(100, comp.get_composition_metrics_at_position(960)->tempo);
+}
+
 TEST(compositionTest, updateCompositionMetricsAtPositionTest) {
 	Composition comp;
 	Key key(a5, major_intervals);
@@ -303,3 +334,91 @@ TEST(compositionTest, resetPatternTest) {
 	comp.reset_pattern();
 	ASSERT_EQ(0, comp.get_pattern().size());
 }
+
+TEST(compositionTest, manyPartsTest) {
+	Composition comp;
+	std::vector<Part> parts;
+	std::vector<PatternSegment> segments;
+	for (int i = 0; i < 500; i++) {
+		parts.push_back(Part("part" + std::to_string(i)));
+		segments.push_back(PatternSegment("segment" + std::to_string(i), i));
+	}
+	for (int i = 0; i < 500; i++) {
+		ASSERT_TRUE(comp.add_part(parts[i]));
+		ASSERT_TRUE(comp.register_pattern_segment(&segments[i]));
+	}
+	Part duplicate("part250");
+	ASSERT_FALSE(comp.add_part(duplicate));
+	std::vector<Part*> added = comp.get_parts();
+	ASSERT_EQ(500, added.size());
+	for (int i = 0; i < 500; i++) {
+		ASSERT_EQ(&parts[i], added[i]);
+		ASSERT_EQ(&parts[i], comp.get_part("part" + std::to_string(i)));
+		ASSERT_EQ(&segments[i], comp.get_pattern_segment("segment" + std::to_string(i)));
+	}
+	ASSERT_EQ(NULL, comp.get_part("part500"));
+	ASSERT_TRUE(comp.add_to_pattern("segment499"));
+	ASSERT_FALSE(comp.add_to_pattern("segment500"));
+}
+
+TEST(compositionTest, renamePartTest) {
+	Composition comp;
+	Part p("drumline");
+	Part p2("bass");
+	comp.add_part(p);
+	comp.add_part(p2);
+	p.set_name("percussion");
+	// Test that const lookups see the new name
+	const Composition &view = comp;
+	ASSERT_EQ(&p, view.get_part("percussion"));
+	ASSERT_EQ(NULL, view.get_part("drumline"));
+	// Test that the old name is free once the Part is renamed
+	Part p3("drumline");
+	ASSERT_TRUE(comp.add_part(p3));
+	ASSERT_FALSE(comp.add_part(p));
+	ASSERT_EQ(&p, comp.get_part("percussion"));
+	ASSERT_EQ(&p3, comp.get_part("drumline"));
+	ASSERT_EQ(&p2, comp.get_part("bass"));
+	// Test that assigning to a Part renames it too
+	p2 = Part("tuba");
+	ASSERT_EQ(&p2, comp.get_part("tuba"));
+	ASSERT_EQ(NULL, comp.get_part("bass"));
+	// Test that renaming a copy leaves the composition alone
+	Part copy = p3;
+	copy.set_name("guitar");
+	ASSERT_EQ(&p3, comp.get_part("drumline"));
+	ASSERT_EQ(NULL, comp.get_part("guitar"));
+}
+
+TEST(compositionTest, renamePatternSegmentTest) {
+	PatternSegment p("verse", 3084);
+	Composition comp;
+	comp.register_pattern_segment(&p);
+	p.set_name("chorus");
+	ASSERT_EQ(&p, comp.get_pattern_segment("chorus"));
+	ASSERT_EQ(NULL, comp.get_pattern_segment("verse"));
+	ASSERT_FALSE(comp.add_to_pattern("verse"));
+	ASSERT_TRUE(comp.add_to_pattern("chorus"));
+	PatternSegment p2("chorus", 1024);
+	ASSERT_TRUE(comp.edit_pattern_segment(&p2));
+	ASSERT_EQ(1024, comp.get_pattern_segment("chorus")->get_duration());
+	PatternSegment p3("verse", 2048);
+	ASSERT_TRUE(comp.register_pattern_segment(&p3));
+	ASSERT_EQ(&p3, comp.get_pattern_segment("verse"));
+}
+
+TEST(compositionTest, renameInTwoCompositionsTest) {
+	Part p("drumline");
+	Composition copy;
+	{
+		Composition comp;
+		comp.add_part(p);
+		copy = comp;
+	}
+	Composition other;
+	other.add_part(p);
+	p.set_name("percussion");
+	ASSERT_EQ(&p, copy.get_part("percussion"));
+	ASSERT_EQ(&p, other.get_part("percussion"));
+	ASSERT_EQ(NULL, other.get_part("drumline"));
+}
@@ -0,0 +1,40 @@
+/* 
+ * File:   deltalogtest.cpp
+ * Author: Sam Rappl
+ *
+ */
+
+#include <nlohmann/json.hpp>
+#include "delta_log.h"
+#include "gtest/gtest.h"
+
+TEST(deltaLogTest, snapshotTest) {
+	DeltaLog log;
+	ASSERT_FALSE(log.has_snapshot("control"));
+	log.add("/parts/-", 1);
+	log.snapshot_sent("control");
+	ASSERT_TRUE(log.has_snapshot("control"));
+	ASSERT_TRUE(log.take_patch("control").empty());
+	ASSERT_EQ(1, log.size());
+}
+
+TEST(deltaLogTest, patchTest) {
+	nlohmann::json doc = {{"parts", nlohmann::json::array()}, {"active", false}};
+	DeltaLog log;
+	log.snapshot_sent("a");
+	nlohmann::json a = doc;
+	log.add("/parts/-", "melody");
+	log.replace("/active", true);
+	nlohmann::json patch = log.take_patch("a");
+	ASSERT_TRUE(patch.is_array());
+	ASSERT_EQ(2, patch.size());
+	a = a.patch(patch);
+	ASSERT_EQ("melody", a["parts"][0]);
+	ASSERT_EQ(true, a["active"]);
+	log.snapshot_sent("b");
+	log.add("/parts/-", "bass");
+	ASSERT_EQ(1, log.take_patch("b").size());
+	a = a.patch(log.take_patch("a"));
+	ASSERT_EQ(2, a["parts"].size());
+	ASSERT_TRUE(log.take_patch("a").empty());
+}
@@ -8,6 +8,7 @@
 #include "note.h"
 #include "chord.h"
 #include "event.h"
+#include "visit.h"
 #include "constants.h"
 #include "gtest/gtest.h"
 #include <vector>
@@ -89,11 +90,11 @@ TEST(eventInheritanceTest, mixedListInheritanceTest) {
 		Dynamic *d = nullptr;
 		if (n = dynamic_cast<Note*>(e)) {
 			ASSERT_EQ(gs7, n->pitch);
-			ASSERT_EQ(half_note, n->duration);
+			ASSERT_EQ(half_note, n->get_duration());
 		}
 		else if (c = dynamic_cast<Chord*>(e)) {
 			ASSERT_EQ(invec, c->pitches);
-			ASSERT_EQ(eighth_note, c->duration);
+			ASSERT_EQ(eighth_note, c->get_duration());
 		}
 		else if (d = dynamic_cast<Dynamic*>(e)) {
 			ASSERT_EQ(ff, d->volume);
@@ -102,3 +103,42 @@ TEST(eventInheritanceTest, mixedListInheritanceTest) {
 		}
 	}
 }
+
+TEST(eventInheritanceTest, kindTagTest) {
+	Note note;
+	Chord chord;
+	Dynamic dynamic;
+	Event *e = &note;
+	ASSERT_EQ(EVENT_NOTE, e->get_kind());
+	ASSERT_TRUE(e->is_note());
+	e = &chord;
+	ASSERT_EQ(EVENT_CHORD, e->get_kind());
+	ASSERT_TRUE(e->is_chord());
+	e = &dynamic;
+	ASSERT_EQ(EVENT_DYNAMIC, e->get_kind());
+	ASSERT_TRUE(e->is_dynamic());
+}
+
+struct KindVisitor {
+	int operator()(Note &n) { return EVENT_NOTE; }
+	int operator()(Chord &c) { return EVENT_CHORD; }
+	int operator()(Dynamic &d) { return EVENT_DYNAMIC; }
+};
+
+TEST(eventInheritanceTest, visitTest) {
+	Note note(gs7, half_note);
+	Chord chord(c_major_chord, eighth_note);
+	Dynamic dynamic(ff);
+	Event event;
+	std::vector<Event*> events;
+	events.push_back(&note);
+	events.push_back(&chord);
+	events.push_back(&dynamic);
+	for (int i = 0; i < events.size(); i++) {
+		ASSERT_EQ(events[i]->get_kind(), visit(*events[i], KindVisitor()));
+	}
+	ASSERT_EQ(0, visit(event, KindVisitor()));
+	ASSERT_EQ(half_note, event_duration(&note));
+	ASSERT_EQ(eighth_note, event_duration(&chord));
+	ASSERT_EQ(0, event_duration(&dynamic));
+}
@@ -0,0 +1,48 @@
+/* 
+ * File:   eventlooptest.cpp
+ * Author: Sam Rappl
+ *
+ */
+
+#include <string>
+#include <thread>
+#include <vector>
+#include "event_loop.h"
+#include "gtest/gtest.h"
+
+TEST(eventLoopTest, runsInOrderTest) {
+	EventLoop loop;
+	std::vector<int> order;
+	std::thread poster([&]() {
+		for (int i = 0; i < 10; i++) {
+			loop.post([&order, i]() { order.push_back(i); });
+		}
+	});
+	for (int i = 0; i < 10; i++) {
+		loop.run_one();
+	}
+	poster.join();
+	ASSERT_EQ(10, order.size());
+	for (int i = 0; i < 10; i++) {
+		ASSERT_EQ(i, order[i]);
+	}
+}
+
+TEST(eventLoopTest, postFromEventTest) {
+	EventLoop loop;
+	int count = 0;
+	loop.post([&]() {
+		count++;
+		loop.post([&]() { count++; });
+	});
+	loop.run_one();
+	ASSERT_EQ(1, count);
+	loop.run_one();
+	ASSERT_EQ(2, count);
+}
+
+TEST(eventLoopTest, exceptionTest) {
+	EventLoop loop;
+	loop.post([]() { throw std::string("event failed"); });
+	ASSERT_THROW(loop.run_one(), std::string);
+}
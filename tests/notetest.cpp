@@ -12,39 +12,39 @@ TEST(noteTest, noteDefaultConstructorTest) {
 	// Test Default constructor
 	Note note;
 	ASSERT_EQ(c4, note.pitch);
-	ASSERT_EQ(quarter_note, note.duration);
-	ASSERT_FALSE(note.triplet);
-	ASSERT_FALSE(note.dotted);
-	ASSERT_FALSE(note.double_dotted);
-	ASSERT_FALSE(note.staccato);
-	ASSERT_FALSE(note.tenuto);
-	ASSERT_FALSE(note.accent);
-	ASSERT_FALSE(note.fermata);
-	ASSERT_FALSE(note.tied);
-	ASSERT_FALSE(note.slurred);
+	ASSERT_EQ(quarter_note, note.get_duration());
+	ASSERT_FALSE(note.is_triplet());
+	ASSERT_FALSE(note.is_dotted());
+	ASSERT_FALSE(note.is_double_dotted());
+	ASSERT_FALSE(note.is_staccato());
+	ASSERT_FALSE(note.is_tenuto());
+	ASSERT_FALSE(note.is_accented());
+	ASSERT_FALSE(note.has_fermata());
+	ASSERT_FALSE(note.is_tied());
+	ASSERT_FALSE(note.is_slurred());
 }
 
 TEST(noteTest, noteConstructorPitchDurationTest) {
 	// Test pitch and duration constructor
 	Note note(c4, quarter_note);
 	ASSERT_EQ(c4, note.pitch);
-	ASSERT_EQ(quarter_note, note.duration);
-	ASSERT_FALSE(note.triplet);
-	ASSERT_FALSE(note.dotted);
-	ASSERT_FALSE(note.double_dotted);
-	ASSERT_FALSE(note.staccato);
-	ASSERT_FALSE(note.tenuto);
-	ASSERT_FALSE(note.accent);
-	ASSERT_FALSE(note.fermata);
-	ASSERT_FALSE(note.tied);
-	ASSERT_FALSE(note.slurred);
+	ASSERT_EQ(quarter_note, note.get_duration());
+	ASSERT_FALSE(note.is_triplet());
+	ASSERT_FALSE(note.is_dotted());
+	ASSERT_FALSE(note.is_double_dotted());
+	ASSERT_FALSE(note.is_staccato());
+	ASSERT_FALSE(note.is_tenuto());
+	ASSERT_FALSE(note.is_accented());
+	ASSERT_FALSE(note.has_fermata());
+	ASSERT_FALSE(note.is_tied());
+	ASSERT_FALSE(note.is_slurred());
 }
 
 TEST(noteTest, noteConstructorPitchDurationTripDotDoubleTest) {
 	Note note(c4, dotted_quarter_note, false, true, false);
-	ASSERT_FALSE(note.triplet);
-	ASSERT_TRUE(note.dotted);
-	ASSERT_FALSE(note.double_dotted);
+	ASSERT_FALSE(note.is_triplet());
+	ASSERT_TRUE(note.is_dotted());
+	ASSERT_FALSE(note.is_double_dotted());
 }
 
 TEST(noteTest, noteAllArgsConstructorTest) {
@@ -52,16 +52,16 @@ TEST(noteTest, noteAllArgsConstructorTest) {
 	Note note(c4, quarter_note, false, false, false, true,
 		false, false, false, false, true);
 	ASSERT_EQ(c4, note.pitch);
-	ASSERT_EQ(quarter_note, note.duration);
-	ASSERT_FALSE(note.triplet);
-	ASSERT_FALSE(note.dotted);
-	ASSERT_FALSE(note.double_dotted);
-	ASSERT_TRUE(note.staccato);
-	ASSERT_FALSE(note.tenuto);
-	ASSERT_FALSE(note.accent);
-	ASSERT_FALSE(note.fermata);
-	ASSERT_FALSE(note.tied);
-	ASSERT_TRUE(note.slurred);
+	ASSERT_EQ(quarter_note, note.get_duration());
+	ASSERT_FALSE(note.is_triplet());
+	ASSERT_FALSE(note.is_dotted());
+	ASSERT_FALSE(note.is_double_dotted());
+	ASSERT_TRUE(note.is_staccato());
+	ASSERT_FALSE(note.is_tenuto());
+	ASSERT_FALSE(note.is_accented());
+	ASSERT_FALSE(note.has_fermata());
+	ASSERT_FALSE(note.is_tied());
+	ASSERT_TRUE(note.is_slurred());
 }
 
 TEST(noteTest, dotTest) {
@@ -69,11 +69,11 @@ TEST(noteTest, dotTest) {
 	
 	// Test dot function
 	note.dot();
-	ASSERT_EQ(dotted_quarter_note, note.duration);
+	ASSERT_EQ(dotted_quarter_note, note.get_duration());
 	
 	// Test dotting a second time
 	note.dot();
-	ASSERT_EQ(double_dotted_quarter_note, note.duration);
+	ASSERT_EQ(double_dotted_quarter_note, note.get_duration());
 	
 	// Test dotting a third time
 	ASSERT_FALSE(note.dot());
@@ -81,7 +81,7 @@ TEST(noteTest, dotTest) {
 	// Test double dotting
 	Note note2(c4, quarter_note);
 	note2.double_dot();
-	ASSERT_EQ(double_dotted_quarter_note, note2.duration);
+	ASSERT_EQ(double_dotted_quarter_note, note2.get_duration());
 	
 	// Test double dotting a dotted note
 	Note note3(c4, dotted_quarter_note, false, true, false);
@@ -95,10 +95,10 @@ TEST(noteTest, tripletTest) {
 	
 	// Test put_in_triplet function
 	note.put_in_triplet();
-	ASSERT_EQ(triplet_quarter_note, note.duration);
+	ASSERT_EQ(triplet_quarter_note, note.get_duration());
 	ASSERT_FALSE(note.put_in_triplet());
 	note2.put_in_triplet();
-	ASSERT_EQ(triplet_dotted_eighth_note, note2.duration);
+	ASSERT_EQ(triplet_dotted_eighth_note, note2.get_duration());
 	ASSERT_FALSE(note2.put_in_triplet());
 	ASSERT_FALSE(note3.put_in_triplet());
 }
@@ -156,3 +156,17 @@ TEST(noteTest, durationBitFieldTest) {
 	EXPECT_NE(1024, note.duration) << "If this fails, the size of the bit"
 	<< "field for duration has been increased.";
 }*/
+
+TEST(noteTest, articulationFlagsTest) {
+	Note note(c4, quarter_note, false, false, false, true, false, false, true);
+	ASSERT_EQ(ARTICULATION_STACCATO | ARTICULATION_FERMATA, note.flags);
+	note.set_tied();
+	ASSERT_TRUE(note.is_tied());
+	note.set_staccato(false);
+	ASSERT_FALSE(note.is_staccato());
+	ASSERT_EQ(ARTICULATION_FERMATA | ARTICULATION_TIED, note.flags);
+	Note note2(c4, quarter_note, false, false, false, false, false, false, true, true);
+	ASSERT_TRUE(note.equals(&note2));
+	note2.set_accented();
+	ASSERT_FALSE(note.equals(&note2));
+}
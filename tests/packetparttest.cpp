@@ -0,0 +1,107 @@
+/*
+ * File:    packetparttest.cpp
+ * Author:  Sam Rappl
+ *
+ */
+
+#include <vector>
+#include "packet_part.h"
+#include "gtest/gtest.h"
+
+/**
+ * Builds the tree 0 -> (1, 2), 2 -> 3 and marks every node executed.
+ */
+void build_executed_tree(std::vector<PacketPart> &nodes) {
+	for (int i = 0; i < 4; i++) {
+		nodes[i].set_packet_path("/" + std::to_string(i));
+		nodes[i].set_mode("melody");
+	}
+	nodes[0].append_child(&nodes[1]);
+	nodes[0].append_child(&nodes[2]);
+	nodes[2].append_child(&nodes[3]);
+	for (int i = 0; i < 4; i++) {
+		nodes[i].execute();
+	}
+}
+
+TEST(packetPartTest, getDirtyTest) {
+	std::vector<PacketPart> nodes(4);
+	build_executed_tree(nodes);
+	ASSERT_TRUE(nodes[0].get_dirty().empty());
+	nodes[3].clear_execution();
+	nodes[1].clear_execution();
+	std::vector<PacketPart*> dirty = nodes[0].get_dirty();
+	ASSERT_EQ(2, dirty.size());
+	ASSERT_EQ(&nodes[1], dirty[0]);
+	ASSERT_EQ(&nodes[3], dirty[1]);
+	ASSERT_EQ(1, nodes[2].get_dirty().size());
+}
+
+TEST(packetPartTest, markDirtyTest) {
+	std::vector<PacketPart> nodes(4);
+	build_executed_tree(nodes);
+	nodes[2].mark_dirty();
+	ASSERT_TRUE(nodes[0].has_been_executed());
+	ASSERT_TRUE(nodes[1].has_been_executed());
+	ASSERT_FALSE(nodes[2].has_been_executed());
+	ASSERT_FALSE(nodes[3].has_been_executed());
+}
+
+TEST(packetPartTest, setterDirtyTest) {
+	std::vector<PacketPart> nodes(4);
+	build_executed_tree(nodes);
+	nodes[0].set_packet_path("/0");
+	ASSERT_FALSE(nodes[0].set_mode("descant"));
+	ASSERT_TRUE(nodes[0].get_dirty().empty());
+	nodes[2].set_packet_path("/two");
+	ASSERT_EQ(2, nodes[0].get_dirty().size());
+	std::vector<PacketPart> other(4);
+	build_executed_tree(other);
+	other[0].set_mode("harmony");
+	ASSERT_EQ(4, other[0].get_dirty().size());
+	// A node which has not been executed is run anyway, so changing it marks
+	// nothing else
+	std::vector<PacketPart> cleared(4);
+	build_executed_tree(cleared);
+	cleared[2].clear_execution();
+	cleared[2].set_mode("support");
+	ASSERT_EQ(1, cleared[0].get_dirty().size());
+}
+
+TEST(packetPartTest, editPartTest) {
+	std::vector<PacketPart> nodes(4);
+	build_executed_tree(nodes);
+	Part p("edited");
+	nodes[0].edit_part(p);
+	ASSERT_EQ("edited", nodes[0].get_part().get_name());
+	std::vector<PacketPart*> dirty = nodes[0].get_dirty();
+	ASSERT_EQ(3, dirty.size());
+	ASSERT_EQ(&nodes[1], dirty[0]);
+	nodes[0].set_part(p);
+	ASSERT_TRUE(nodes[0].has_been_executed());
+}
+
+TEST(packetPartTest, editCopiedPartTest) {
+	std::vector<PacketPart> nodes(4);
+	build_executed_tree(nodes);
+	std::shared_ptr<Arena> arena(new Arena());
+	Part *p = arena->make<Part>("run");
+	p->append_note(arena->make<Note>(c4, quarter_note));
+	nodes[2].set_part(*p, arena);
+	std::weak_ptr<Arena> owner = arena;
+	arena.reset();
+	// The copy shares the run's events, so editing it copies them and lets
+	// the run's Arena go
+	Part edited = nodes[2].get_part();
+	edited.set_name("edited");
+	nodes[2].edit_part(edited);
+	ASSERT_TRUE(owner.expired());
+	ASSERT_EQ("edited", nodes[2].get_part().get_name());
+	ASSERT_EQ(c4, static_cast<Note*>(*nodes[2].get_part().const_begin())->pitch);
+	ASSERT_TRUE(nodes[2].get_part_arena()->contains(*nodes[2].get_part().const_begin()));
+	ASSERT_EQ(1, nodes[0].get_dirty().size());
+	// A Part whose events are owned elsewhere lets the copies go
+	std::weak_ptr<Arena> copies = nodes[2].get_part_arena();
+	nodes[2].edit_part(Part("fresh"), std::shared_ptr<Arena>());
+	ASSERT_TRUE(copies.expired());
+}
@@ -110,12 +110,12 @@ TEST(partTest, appendAllEventsTest) {
 		if (n = dynamic_cast<Note*>(e)) {
 			ASSERT_EQ(2, i);
 			ASSERT_EQ(cs3, n->pitch);
-			ASSERT_EQ(half_note, n->duration);
+			ASSERT_EQ(half_note, n->get_duration());
 		}
 		else if (c = dynamic_cast<Chord*>(e)) {
 			ASSERT_EQ(0, i);
 			ASSERT_EQ(g_major_chord, c->pitches);
-			ASSERT_EQ(quarter_note, c->duration);
+			ASSERT_EQ(quarter_note, c->get_duration());
 		}
 		else if (d = dynamic_cast<Dynamic*>(e)) {
 			ASSERT_EQ(1, i);
@@ -154,7 +154,7 @@ TEST(partTest, appendMultiNoteDynamicTest) {
 		Dynamic *d = nullptr;
 		if (n = dynamic_cast<Note*>(e)) {
 			if (i == 1 || i == 2 || i == 3 || i == 5 || i == 6) {
-				ASSERT_EQ(quarter_note, n->duration);
+				ASSERT_EQ(quarter_note, n->get_duration());
 			}
 			else {
 				FAIL();
@@ -678,3 +678,188 @@ TEST(partGetPositionIteratorTest, getPositionIteratorTest) {
 	ASSERT_EQ(dotted_quarter_note, part.get_position_of(it));
 	ASSERT_EQ(double_dotted_quarter_note, part.get_position_after(it));
 }
+
+TEST(partGetPositionIteratorTest, positionsTest) {
+	Part part;
+	Dynamic dynamic;
+	Note note;
+	Chord chord(a_major_chord, eighth_note);
+	Note note2(c3, sixteenth_note);
+	part.append_dynamic(&dynamic);
+	part.append_note(&note);
+	part.append_chord(&chord);
+	part.append_note(&note2);
+	std::vector<int> expected = {0, 0, quarter_note, dotted_quarter_note};
+	ASSERT_EQ(expected, part.positions());
+	ASSERT_EQ(part.get_length(), part.get_position_of(part.end()));
+}
+
+TEST(partGetPositionIteratorTest, positionsAfterInsertEraseTest) {
+	Part part;
+	Note note;
+	Chord chord(a_major_chord, eighth_note);
+	Note note2(c3, sixteenth_note);
+	Dynamic dynamic(ff);
+	part.append_note(&note);
+	part.append_note(&note2);
+	part.insert_chord(part.begin() + 1, &chord);
+	part.insert_dynamic(part.begin() + 1, &dynamic);
+	std::vector<int> expected = {0, quarter_note, quarter_note, dotted_quarter_note};
+	ASSERT_EQ(expected, part.positions());
+	ASSERT_EQ(dotted_quarter_note, part.get_position_of(part.begin() + 3));
+	ASSERT_EQ(ff, part.get_dynamics_at_position(quarter_note + 1).volume);
+	part.erase(part.begin());
+	expected = {0, 0, eighth_note};
+	ASSERT_EQ(expected, part.positions());
+	ASSERT_EQ(eighth_note + sixteenth_note, part.get_length());
+	ASSERT_EQ(a_major_chord, part.get_pitches_at_position(eighth_note));
+	std::vector<int> pitches = {c3};
+	ASSERT_EQ(pitches, part.get_pitches_at_position(eighth_note + 1));
+}
+
+TEST(partGetPositionIteratorTest, positionsAfterDotTest) {
+	Part part;
+	Note note;
+	Chord chord(a_major_chord, eighth_note);
+	Note note2(c3, sixteenth_note);
+	part.append_note(&note);
+	part.append_chord(&chord);
+	part.append_note(&note2);
+	ASSERT_EQ(quarter_note, part.get_position_of(part.begin() + 1));
+	static_cast<Note*>(*part.begin())->dot();
+	ASSERT_EQ(dotted_quarter_note, part.get_position_of(part.begin() + 1));
+	ASSERT_EQ(dotted_quarter_note + eighth_note, part.get_position_of(part.begin() + 2));
+	ASSERT_EQ(dotted_quarter_note + eighth_note, part.get_position_after(part.begin() + 1));
+	chord.put_in_triplet();
+	int end_of_chord = dotted_quarter_note + chord.get_duration();
+	ASSERT_EQ(end_of_chord, part.get_position_of(part.begin() + 2));
+	ASSERT_EQ(end_of_chord + sixteenth_note, part.get_length());
+	std::vector<int> pitches = {c3};
+	ASSERT_EQ(pitches, part.get_pitches_at_position(end_of_chord + 1));
+	note2.set_duration(eighth_note);
+	ASSERT_EQ(end_of_chord + eighth_note, part.get_length());
+	std::vector<int> expected = {0, dotted_quarter_note, end_of_chord};
+	ASSERT_EQ(expected, part.positions());
+}
+
+TEST(partGetPositionIteratorTest, positionsOfSharedEventsTest) {
+	Note note(c4, quarter_note);
+	Note note2(d4, quarter_note);
+	Part part;
+	part.append_note(&note);
+	part.append_note(&note2);
+	// A copy shares the events, and sees their changes
+	Part copy = part;
+	note.dot();
+	ASSERT_EQ(dotted_quarter_note, part.get_position_of(part.begin() + 1));
+	ASSERT_EQ(dotted_quarter_note, copy.get_position_of(copy.begin() + 1));
+	// So does a Part built from the events of another
+	Part rebuilt;
+	rebuilt.append_note(&note);
+	rebuilt.append_note(&note2);
+	note2.dot();
+	ASSERT_EQ(2 * dotted_quarter_note, rebuilt.get_length());
+	// And a Part that mixes them with events of its own
+	Note note3(e4, eighth_note);
+	Part mixed;
+	mixed.append_note(&note3);
+	mixed.append_note(&note);
+	note.set_duration(half_note);
+	ASSERT_EQ(eighth_note + half_note, mixed.get_length());
+	ASSERT_EQ(eighth_note + half_note, mixed.get_position_after(mixed.begin() + 1));
+	ASSERT_EQ(half_note + dotted_quarter_note, part.get_length());
+	// A const Part answers without finding its starts again
+	const Part &reader = part;
+	note2.set_duration(quarter_note);
+	std::vector<int> expected = {0, half_note};
+	ASSERT_EQ(expected, reader.positions());
+	ASSERT_EQ(half_note + quarter_note, reader.get_length());
+}
+
+TEST(partEqualsTest, equalsAfterEventChangeTest) {
+	Part part("part");
+	Part other("part");
+	Note note(c4, quarter_note);
+	Note other_note(c4, quarter_note);
+	Chord chord(c_major_chord, half_note);
+	Chord other_chord(c_major_chord, half_note);
+	part.append_note(&note);
+	part.append_chord(&chord);
+	other.append_note(&other_note);
+	other.append_chord(&other_chord);
+	ASSERT_TRUE(part.equals(&other));
+	static_cast<Note*>(*part.begin())->pitch = d4;
+	ASSERT_FALSE(part.equals(&other));
+	other_note.pitch = d4;
+	ASSERT_TRUE(part.equals(&other));
+	static_cast<Chord*>(*(part.begin() + 1))->invert();
+	ASSERT_FALSE(part.equals(&other));
+	other_chord.invert();
+	ASSERT_TRUE(part.equals(&other));
+	static_cast<Note*>(*part.begin())->set_staccato();
+	ASSERT_FALSE(part.equals(&other));
+}
+
+TEST(partGetPitchesTest, pitchesAfterEventChangeTest) {
+	Part part;
+	Dynamic dynamic(mf);
+	Note note(c4, quarter_note);
+	Chord chord(c_major_chord, half_note);
+	part.append_dynamic(&dynamic);
+	part.append_note(&note);
+	part.append_chord(&chord);
+	static_cast<Note*>(*(part.begin() + 1))->pitch = e4;
+	std::vector<int> pitches = {e4};
+	ASSERT_EQ(pitches, part.get_current_pitches(part.begin()));
+	ASSERT_EQ(pitches, part.get_pitches_at_position(0));
+	Chord *c = static_cast<Chord*>(*(part.begin() + 2));
+	c->add_octave();
+	std::vector<int> chord_pitches = c->pitches;
+	ASSERT_EQ(chord_pitches, part.get_current_pitches(part.begin() + 2));
+	ASSERT_EQ(chord_pitches, part.get_pitches_at_position(quarter_note + 1));
+}
+
+TEST(partGetDynamicTest, dynamicsAfterInsertEraseTest) {
+	Part part;
+	Note note;
+	Dynamic dynamics(p);
+	Note note2;
+	Dynamic dynamics2(f);
+	Note note3;
+	part.append_note(&note);
+	part.append_note(&note2);
+	part.append_note(&note3);
+	part.insert_dynamic(part.begin() + 1, &dynamics);
+	part.insert_dynamic(part.begin() + 3, &dynamics2);
+	ASSERT_EQ(mp, part.get_current_dynamics(part.begin()).volume);
+	ASSERT_EQ(p, part.get_current_dynamics(part.begin() + 2).volume);
+	ASSERT_EQ(f, part.get_current_dynamics(part.begin() + 4).volume);
+	part.erase(part.begin() + 1);
+	ASSERT_EQ(mp, part.get_current_dynamics(part.begin() + 1).volume);
+	ASSERT_EQ(f, part.get_current_dynamics(part.begin() + 3).volume);
+	part.erase(part.begin());
+	ASSERT_EQ(f, part.get_current_dynamics(part.begin() + 1).volume);
+	ASSERT_EQ(f, part.get_current_dynamics(part.begin() + 2).volume);
+}
+
+TEST(partGetDynamicTest, allCurrentDynamicsTest) {
+	Part part;
+	Note note;
+	Dynamic dynamics(p);
+	Chord chord;
+	Dynamic dynamics2(ff);
+	Note note2;
+	part.append_note(&note);
+	part.append_dynamic(&dynamics);
+	part.append_chord(&chord);
+	part.append_dynamic(&dynamics2);
+	part.append_note(&note2);
+	std::vector<Dynamic> all = part.get_all_current_dynamics();
+	ASSERT_EQ(5, all.size());
+	for (int i = 0; i < all.size(); i++) {
+		ASSERT_EQ(part.get_current_dynamics(part.begin() + i).volume, all[i].volume);
+	}
+	ASSERT_EQ(mp, all[0].volume);
+	ASSERT_EQ(p, all[2].volume);
+	ASSERT_EQ(ff, all[4].volume);
+}
@@ -0,0 +1,111 @@
+/* 
+ * File:   pitchsettest.cpp
+ * Author: Sam Rappl
+ *
+ */
+
+#include <vector>
+#include "pitch_set.h"
+#include "chord.h"
+#include "composition_metrics.h"
+#include "constants.h"
+#include "gtest/gtest.h"
+
+TEST(pitchSetTest, inlineTest) {
+	PitchSet pitches = {c3, e3, g3};
+	ASSERT_EQ(3, pitches.size());
+	ASSERT_EQ(c3, pitches.front());
+	ASSERT_EQ(g3, pitches.back());
+	ASSERT_EQ(c_major_chord, pitches);
+	pitches.push_back(b3);
+	ASSERT_EQ(c_major_7_chord, pitches.to_vector());
+}
+
+TEST(pitchSetTest, spillTest) {
+	std::vector<int> invec;
+	for (int i = 0; i < 12; i++) {
+		invec.push_back(c2 + i * 5);
+	}
+	PitchSet pitches(invec);
+	ASSERT_EQ(12, pitches.size());
+	ASSERT_EQ(invec, pitches);
+	pitches.transpose(12);
+	for (int i = 0; i < invec.size(); i++) {
+		invec[i] += 12;
+	}
+	ASSERT_EQ(invec, pitches);
+	pitches.rotate_up_octave();
+	invec.push_back(invec[0] + 12);
+	invec.erase(invec.begin());
+	ASSERT_EQ(invec, pitches);
+}
+
+TEST(pitchSetTest, transposeTest) {
+	PitchSet pitches = {c0, e0, g0, b0, d1, f1, a1, c2};
+	pitches.transpose(12);
+	std::vector<int> up = {c1, e1, g1, b1, d2, f2, a2, c3};
+	ASSERT_EQ(up, pitches);
+	pitches.transpose(-12);
+	std::vector<int> down = {c0, e0, g0, b0, d1, f1, a1, c2};
+	ASSERT_EQ(down, pitches);
+	PitchSet small = {a3};
+	small.transpose(-12);
+	ASSERT_EQ(a2, small.front());
+	ASSERT_EQ(1, small.size());
+}
+
+TEST(pitchSetTest, largeChordTest) {
+	std::vector<int> invec = {c2, g2, c3, e3, g3, bf3, c4, d4, e4, g4};
+	Chord chord(invec, whole_note);
+	Chord chord2(invec, whole_note);
+	ASSERT_TRUE(chord.equals(&chord2));
+	ASSERT_TRUE(chord.add_octave());
+	ASSERT_FALSE(chord.equals(&chord2));
+	ASSERT_TRUE(chord.drop_octave());
+	ASSERT_TRUE(chord.equals(&chord2));
+	ASSERT_TRUE(chord.invert());
+	ASSERT_EQ(c2 + 12, chord.pitches.back());
+	ASSERT_EQ(g2, chord.pitches.front());
+}
+
+TEST(pitchSetTest, constantListTest) {
+	static_assert(c_major_7_chord.size() == 4, "chords are constant expressions");
+	static_assert(c_major_7_chord[3] == b3, "chords are constant expressions");
+	static_assert(major_intervals[2] == 1, "scales are constant expressions");
+	PitchSet pitches(gs_minor_7_chord);
+	ASSERT_EQ(4, pitches.size());
+	ASSERT_EQ(gs_minor_7_chord, pitches);
+	std::vector<int> copy = gs_minor_7_chord;
+	ASSERT_EQ(copy, gs_minor_7_chord);
+	ASSERT_TRUE(copy == pitches);
+	ASSERT_TRUE(major_intervals == ionian_intervals);
+	ASSERT_FALSE(major_intervals == minor_intervals);
+	Chord chord(gs_minor_7_chord, half_note);
+	ASSERT_EQ(gs3, chord.pitches.front());
+	Key key(d3, dorian_intervals);
+	Key key2(d3, dorian_intervals.to_vector());
+	ASSERT_TRUE(key.equals(&key2));
+	ASSERT_EQ(dorian_intervals, key.get_intervals());
+}
+
+TEST(pitchSetTest, rangeTest) {
+	PitchSet pitches;
+	ASSERT_THROW(pitches.push_back(-1), std::string);
+	ASSERT_THROW(pitches.push_back(256), std::string);
+	ASSERT_EQ(0, pitches.size());
+	pitches.push_back(255);
+	ASSERT_THROW(pitches.set(0, 300), std::string);
+	ASSERT_EQ(255, pitches[0]);
+	std::vector<int> invec = {c4, 1000};
+	ASSERT_THROW(PitchSet bad(invec), std::string);
+}
+
+TEST(pitchSetTest, manyPitchesTest) {
+	PitchSet pitches;
+	for (int i = 0; i < 300; i++) {
+		pitches.push_back(i % 128);
+	}
+	ASSERT_EQ(300, pitches.size());
+	ASSERT_EQ(299 % 128, pitches.back());
+	ASSERT_EQ(300, pitches.to_vector().size());
+}
@@ -0,0 +1,153 @@
+/* 
+ * File:   processpooltest.cpp
+ * Author: Sam Rappl
+ *
+ */
+
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <signal.h>
+#include <string>
+#include <sys/wait.h>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include "process_pool.h"
+#include "gtest/gtest.h"
+
+#ifndef STANDIN_PACKET
+#define STANDIN_PACKET "../tools/standinpacket"
+#endif
+
+std::vector<std::string> standin_command(const std::string &path) {
+	return std::vector<std::string>{ STANDIN_PACKET, path };
+}
+
+TEST(processPoolTest, framesTest) {
+	int fds[2];
+	ASSERT_EQ(0, pipe(fds));
+	ASSERT_TRUE(write_frame(fds[1], "melody"));
+	ASSERT_TRUE(write_frame(fds[1], ""));
+	ASSERT_TRUE(write_frame(fds[1], std::string("a\0b", 3)));
+	close(fds[1]);
+	std::string data;
+	ASSERT_TRUE(read_frame(fds[0], data));
+	ASSERT_EQ("melody", data);
+	ASSERT_TRUE(read_frame(fds[0], data));
+	ASSERT_EQ("", data);
+	ASSERT_TRUE(read_frame(fds[0], data));
+	ASSERT_EQ(std::string("a\0b", 3), data);
+	ASSERT_FALSE(read_frame(fds[0], data));
+	close(fds[0]);
+}
+
+TEST(processPoolTest, reusesWorkersTest) {
+	ProcessPool pool(standin_command);
+	ASSERT_EQ("{\"metrics\":[],\"parts\":[],\"pattern\":[],\"pattern_segments\":[]}",
+			pool.execute("/driver", "driver", ""));
+	for (int i = 0; i < 5; i++) {
+		std::string out = pool.execute("/melody", "melody", "{\"parts\":[]}");
+		ASSERT_NE(std::string::npos, out.find("\"name\":\"/melody\""));
+	}
+	ASSERT_EQ("{}", pool.execute("/control", "control", "{}"));
+	ASSERT_EQ(3, pool.get_started());
+	ASSERT_EQ(0, pool.get_restarted());
+}
+
+TEST(processPoolTest, errorTest) {
+	ProcessPool pool(standin_command);
+	ASSERT_THROW(pool.execute("/melody", "fail", "{}"), std::string);
+	ASSERT_EQ("{}", pool.execute("/melody", "control", "{}"));
+	ASSERT_EQ(1, pool.get_started());
+}
+
+TEST(processPoolTest, restartTest) {
+	char crash_file[] = "/tmp/processpooltestXXXXXX";
+	close(mkstemp(crash_file));
+	std::string crash = crash_file;
+	ProcessPool pool([crash](const std::string &path) {
+		return std::vector<std::string>{ STANDIN_PACKET, "--crash-file", crash, path };
+	});
+	ASSERT_EQ("{}", pool.execute("/melody", "control", "{}"));
+	ASSERT_EQ(2, pool.get_started());
+	ASSERT_EQ(1, pool.get_restarted());
+	ASSERT_EQ("{}", pool.execute("/melody", "control", "{}"));
+	ASSERT_EQ(2, pool.get_started());
+}
+
+TEST(processPoolTest, missingProgramTest) {
+	ProcessPool pool([](const std::string &path) {
+		return std::vector<std::string>{ "/nonexistent/packet", path };
+	});
+	ASSERT_THROW(pool.execute("/melody", "melody", "{}"), std::string);
+}
+
+TEST(processPoolTest, concurrentTest) {
+	ProcessPool pool([](const std::string &path) {
+		return std::vector<std::string>{ STANDIN_PACKET, "--work-ms", "50", path };
+	}, 2);
+	auto start = std::chrono::steady_clock::now();
+	std::vector<std::thread> threads;
+	std::vector<std::string> outputs(4);
+	for (int i = 0; i < 4; i++) {
+		threads.push_back(std::thread([&pool, &outputs, i]() {
+			outputs[i] = pool.execute("/melody", "control", std::to_string(i));
+		}));
+	}
+	for (int i = 0; i < 4; i++) {
+		threads[i].join();
+		ASSERT_EQ(std::to_string(i), outputs[i]);
+	}
+	double ms = std::chrono::duration<double, std::milli>(
+			std::chrono::steady_clock::now() - start).count();
+	ASSERT_EQ(2, pool.get_started());
+	ASSERT_LT(ms, 190);
+}
+
+TEST(processPoolTest, exitedWorkerTest) {
+	struct sigaction before;
+	ASSERT_EQ(0, sigaction(SIGPIPE, NULL, &before));
+	ProcessPool pool([](const std::string &path) {
+		return std::vector<std::string>{ "true", path };
+	});
+	struct sigaction during;
+	ASSERT_EQ(0, sigaction(SIGPIPE, NULL, &during));
+	ASSERT_EQ(before.sa_handler, during.sa_handler);
+	// Larger than the socket buffer, so the write is still going when the
+	// worker exits.
+	std::string input(8 << 20, 'x');
+	ASSERT_THROW(pool.execute("/melody", "melody", input), std::string);
+	ASSERT_EQ(2, pool.get_started());
+}
+
+TEST(processPoolTest, destroyBusyTest) {
+	std::string error;
+	std::thread thread;
+	auto start = std::chrono::steady_clock::now();
+	{
+		ProcessPool pool([](const std::string &path) {
+			return std::vector<std::string>{ STANDIN_PACKET, "--work-ms", "10000", path };
+		});
+		thread = std::thread([&pool, &error]() {
+			try {
+				pool.execute("/melody", "control", "{}");
+			}
+			catch (std::string &e) {
+				error = e;
+			}
+		});
+		while (pool.get_started() == 0) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(5));
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	}
+	double ms = std::chrono::duration<double, std::milli>(
+			std::chrono::steady_clock::now() - start).count();
+	thread.join();
+	ASSERT_NE("", error);
+	ASSERT_LT(ms, 5000);
+	int status;
+	ASSERT_EQ(-1, waitpid(-1, &status, WNOHANG));
+	ASSERT_EQ(ECHILD, errno);
+}
@@ -0,0 +1,92 @@
+/* 
+ * File:   resultcachetest.cpp
+ * Author: Sam Rappl
+ *
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <dirent.h>
+#include <string>
+#include <unistd.h>
+#include "result_cache.h"
+#include "gtest/gtest.h"
+
+TEST(resultCacheTest, contentHashTest) {
+	// Published MurmurHash3 x64 128 values
+	ASSERT_EQ("00000000000000000000000000000000", content_hash(""));
+	ASSERT_EQ("cbd8a7b341bd9b025b1e906a48ae1d19", content_hash("hello"));
+	ASSERT_EQ("e34bbc7bbc071b6c7a433ca9c49a9347",
+			content_hash("The quick brown fox jumps over the lazy dog"));
+}
+
+TEST(resultCacheTest, keyTest) {
+	std::string key = ResultCache::key("/packet", "melody", "{}", "");
+	ASSERT_EQ(32, key.size());
+	ASSERT_EQ(key, ResultCache::key("/packet", "melody", "{}", ""));
+	ASSERT_NE(key, ResultCache::key("/packet", "melody", "{ }", ""));
+	ASSERT_NE(key, ResultCache::key("/packet", "bass", "{}", ""));
+	ASSERT_NE(key, ResultCache::key("/packet", "melody", "{}", "1"));
+	ASSERT_NE(ResultCache::key("ab", "c", "", ""), ResultCache::key("a", "bc", "", ""));
+}
+
+TEST(resultCacheTest, lruTest) {
+	ResultCache cache(2);
+	std::string output;
+	ASSERT_FALSE(cache.get("a", output));
+	cache.put("a", "1");
+	cache.put("b", "2");
+	ASSERT_TRUE(cache.get("a", output));
+	ASSERT_EQ("1", output);
+	cache.put("c", "3");
+	ASSERT_EQ(2, cache.size());
+	ASSERT_FALSE(cache.get("b", output));
+	ASSERT_TRUE(cache.get("a", output));
+	ASSERT_TRUE(cache.get("c", output));
+	ASSERT_EQ(3, cache.get_hits());
+	ASSERT_EQ(2, cache.get_misses());
+}
+
+TEST(resultCacheTest, directoryTest) {
+	char dir[] = "/tmp/resultcachetestXXXXXX";
+	ASSERT_TRUE(mkdtemp(dir) != NULL);
+	std::string key = ResultCache::key("/packet", "melody", "{}", "");
+	{
+		ResultCache cache(1, dir);
+		cache.put(key, std::string("part\0json", 9));
+		cache.put("other", "x");
+	}
+	ResultCache cache(1, dir);
+	std::string output;
+	ASSERT_TRUE(cache.get(key, output));
+	ASSERT_EQ(std::string("part\0json", 9), output);
+	cache.clear_memory();
+	ASSERT_TRUE(cache.get("other", output));
+	ASSERT_EQ("x", output);
+	int files = 0;
+	DIR *d = opendir(dir);
+	for (dirent *e = readdir(d); e != NULL; e = readdir(d)) {
+		std::string name = e->d_name;
+		if (name != "." && name != "..") {
+			ASSERT_EQ(std::string::npos, name.find(".tmp"));
+			std::remove((std::string(dir) + "/" + name).c_str());
+			files++;
+		}
+	}
+	closedir(d);
+	rmdir(dir);
+	ASSERT_EQ(2, files);
+}
+
+TEST(resultCacheTest, packetStampTest) {
+	char path[] = "/tmp/resultcachestampXXXXXX";
+	close(mkstemp(path));
+	std::string before = packet_stamp(path);
+	ASSERT_NE("", before);
+	FILE *f = std::fopen(path, "a");
+	std::fputs("edited", f);
+	std::fclose(f);
+	ASSERT_NE(before, packet_stamp(path));
+	std::remove(path);
+	ASSERT_EQ("", packet_stamp(path));
+}
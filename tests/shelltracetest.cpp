@@ -0,0 +1,155 @@
+/*
+ * File:    shelltracetest.cpp
+ * Author:  Sam Rappl
+ *
+ */
+
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <nlohmann/json.hpp>
+#include "shell_trace.h"
+#include "gtest/gtest.h"
+
+TraceRecord make_record(std::string path, std::string mode, int64_t start) {
+	TraceRecord r;
+	r.path = path;
+	r.mode = mode;
+	r.start = start;
+	r.call_start = start + 1000;
+	r.call_end = start + 5000;
+	r.end = start + 6000;
+	r.serialize = 800;
+	r.parse = 700;
+	r.bytes_in = 100;
+	r.bytes_out = 40;
+	r.thread = 1;
+	r.call_thread = 2;
+	return r;
+}
+
+TEST(shellTraceTest, chromeTraceTest) {
+	ShellTrace trace;
+	trace.add(make_record("/a \"b\"", "melody", 1000000));
+	TraceRecord play = make_record("", "play", 1010000);
+	play.serialize = 0;
+	play.parse = 0;
+	trace.add(play);
+	std::ostringstream out;
+	trace.write_chrome_trace(out);
+	nlohmann::json j = nlohmann::json::parse(out.str());
+	nlohmann::json events = j.at("traceEvents");
+	// The call, its serializing and parsing, then the play call alone
+	ASSERT_EQ(4, events.size());
+	ASSERT_EQ("/a \"b\"", events[0].at("name"));
+	ASSERT_EQ("melody", events[0].at("cat"));
+	ASSERT_EQ("X", events[0].at("ph"));
+	ASSERT_DOUBLE_EQ(1.0, events[0].at("ts").get<double>());
+	ASSERT_DOUBLE_EQ(4.0, events[0].at("dur").get<double>());
+	ASSERT_EQ(2, events[0].at("tid"));
+	ASSERT_EQ(100, events[0].at("args").at("bytes_in"));
+	ASSERT_EQ("serialize", events[1].at("cat"));
+	ASSERT_DOUBLE_EQ(0.0, events[1].at("ts").get<double>());
+	ASSERT_DOUBLE_EQ(0.8, events[1].at("dur").get<double>());
+	ASSERT_EQ(1, events[1].at("tid"));
+	ASSERT_EQ("parse", events[2].at("cat"));
+	ASSERT_DOUBLE_EQ(5.3, events[2].at("ts").get<double>());
+	ASSERT_EQ("play", events[3].at("name"));
+	trace.clear();
+	std::ostringstream empty;
+	trace.write_chrome_trace(empty);
+	ASSERT_EQ(0, nlohmann::json::parse(empty.str()).at("traceEvents").size());
+}
+
+TEST(shellTraceTest, summaryTest) {
+	ShellTrace trace;
+	trace.add(make_record("/a", "melody", 0));
+	trace.add(make_record("control", "control", 10000));
+	TraceRecord cached = make_record("/a", "melody", 20000);
+	cached.cached = true;
+	trace.add(cached);
+	std::ostringstream out;
+	trace.write_summary(out);
+	std::istringstream lines(out.str());
+	std::string line;
+	std::getline(lines, line);
+	ASSERT_NE(std::string::npos, line.find("bytes out"));
+	std::getline(lines, line);
+	std::istringstream a(line);
+	std::string name;
+	std::string mode;
+	int calls;
+	int num_cached;
+	double wall;
+	a >> name >> mode >> calls >> num_cached >> wall;
+	ASSERT_EQ("/a", name);
+	ASSERT_EQ("(melody)", mode);
+	ASSERT_EQ(2, calls);
+	ASSERT_EQ(1, num_cached);
+	ASSERT_DOUBLE_EQ(0.012, wall);
+	std::getline(lines, line);
+	ASSERT_EQ(0, line.find("control (control)"));
+	std::getline(lines, line);
+	ASSERT_EQ(0, line.find("total"));
+	ASSERT_NE(std::string::npos, line.find(" 300 "));
+}
+
+TEST(shellTraceTest, traceTimerTest) {
+	TraceTimer::take(TraceTimer::PARSE);
+	TraceTimer::take(TraceTimer::SERIALIZE);
+	{
+		TraceTimer outer(TraceTimer::PARSE);
+		TraceTimer inner(TraceTimer::SERIALIZE);
+		std::this_thread::sleep_for(std::chrono::milliseconds(2));
+	}
+	// The inner timer is counted as part of the outer one
+	ASSERT_EQ(0, TraceTimer::take(TraceTimer::SERIALIZE));
+	int64_t parse = TraceTimer::take(TraceTimer::PARSE);
+	ASSERT_GE(parse, 2000000);
+	ASSERT_EQ(0, TraceTimer::take(TraceTimer::PARSE));
+}
+
+TEST(shellTraceTest, traceSpanTest) {
+	ASSERT_TRUE(ShellTrace::compiled_in());
+	ShellTrace trace;
+	TraceSpan span;
+	span.begin(&trace, "/a", "melody");
+	{
+		SHELL_TRACE_SERIALIZE;
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	span.serialized(10);
+	span.call_started();
+	std::thread worker([&span]() {
+		// What the call itself reads is not counted
+		SHELL_TRACE_PARSE;
+		span.call_finished(20, false);
+	});
+	worker.join();
+	{
+		SHELL_TRACE_PARSE;
+	}
+	span.parsing();
+	{
+		SHELL_TRACE_PARSE;
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	span.end();
+	span.end();
+	span.begin(NULL, "/b", "melody");
+	span.end();
+	std::vector<TraceRecord> records = trace.get_records();
+	ASSERT_EQ(1, records.size());
+	const TraceRecord &r = records[0];
+	ASSERT_EQ("/a", r.path);
+	ASSERT_GE(r.serialize, 1000000);
+	ASSERT_GE(r.parse, 1000000);
+	ASSERT_LT(r.parse, r.end - r.call_end);
+	ASSERT_EQ(10, r.bytes_in);
+	ASSERT_EQ(20, r.bytes_out);
+	ASSERT_NE(r.thread, r.call_thread);
+	ASSERT_LE(r.start, r.call_start);
+	ASSERT_LE(r.call_start, r.call_end);
+	ASSERT_LE(r.call_end, r.end);
+}
@@ -0,0 +1,69 @@
+/* 
+ * File:   tempomaptest.cpp
+ * Author: Sam Rappl
+ *
+ */
+
+#include "composition.h"
+#include "tempo_map.h"
+#include "gtest/gtest.h"
+#include <vector>
+
+TEST(tempoMapTest, noMetricsTest) {
+	std::vector<CompositionMetrics*> metrics;
+	TempoMap map(metrics);
+	ASSERT_EQ(1, map.get_num_changes());
+	// The default tempo is 80 quarter notes per minute
+	ASSERT_DOUBLE_EQ(0.75, map.ticks_to_seconds(quarter_note));
+	ASSERT_DOUBLE_EQ(quarter_note, map.seconds_to_ticks(0.75));
+}
+
+TEST(tempoMapTest, tempoChangeTest) {
+	Composition comp;
+	comp.set_initial_tempo(120);
+	comp.add_tempo_change(60, whole_note);
+	comp.add_key_change(Key(d3, major_intervals), 2 * whole_note);
+	comp.add_tempo_change(240, 3 * whole_note);
+	TempoMap map = comp.get_tempo_map();
+	// The key change does not change the tempo
+	ASSERT_EQ(3, map.get_num_changes());
+	ASSERT_DOUBLE_EQ(0.0, map.ticks_to_seconds(0));
+	ASSERT_DOUBLE_EQ(2.0, map.ticks_to_seconds(whole_note));
+	ASSERT_DOUBLE_EQ(3.0, map.ticks_to_seconds(whole_note + quarter_note));
+	ASSERT_DOUBLE_EQ(10.0, map.ticks_to_seconds(3 * whole_note));
+	ASSERT_DOUBLE_EQ(10.5, map.ticks_to_seconds(3 * whole_note + whole_note / 2));
+	for (int ticks = 0; ticks < 4 * whole_note; ticks += 17) {
+		ASSERT_NEAR(ticks, map.seconds_to_ticks(map.ticks_to_seconds(ticks)), 1e-9);
+	}
+	ASSERT_DOUBLE_EQ(whole_note, map.seconds_to_ticks(2.0));
+	ASSERT_DOUBLE_EQ(3 * whole_note, map.seconds_to_ticks(10.0));
+}
+
+TEST(tempoMapTest, batchTest) {
+	Composition comp;
+	comp.set_initial_tempo(90);
+	for (int i = 1; i < 50; i++) {
+		comp.add_tempo_change(60 + i, i * 37);
+	}
+	TempoMap map = comp.get_tempo_map();
+	std::vector<int> ticks;
+	for (int t = 0; t < 3000; t += 5) {
+		ticks.push_back(t);
+	}
+	std::vector<double> seconds = map.ticks_to_seconds(ticks);
+	ASSERT_EQ(ticks.size(), seconds.size());
+	for (int i = 0; i < ticks.size(); i++) {
+		ASSERT_DOUBLE_EQ(map.ticks_to_seconds(ticks[i]), seconds[i]);
+	}
+}
+
+TEST(tempoMapTest, nonPositiveTempoTest) {
+	Composition comp;
+	comp.set_initial_tempo(0);
+	ASSERT_THROW(comp.get_tempo_map(), std::string);
+	comp.set_initial_tempo(120);
+	comp.add_tempo_change(-60, whole_note);
+	ASSERT_THROW(comp.get_tempo_map(), std::string);
+	comp.add_tempo_change(60, whole_note);
+	ASSERT_DOUBLE_EQ(2.0 + 4.0, comp.get_tempo_map().ticks_to_seconds(2 * whole_note));
+}
@@ -4,10 +4,18 @@
  *
  */
 
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <thread>
 #include <vector>
 #include <iostream>
+#include <sstream>
+#include <unistd.h>
 #include <nlohmann/json.hpp>
 #include "utilities.h"
+#include "sax_reader.h"
 #include "gtest/gtest.h"
 
 TEST(utilitiesTest, jsonTest) {
@@ -244,4 +252,1177 @@ TEST(utilitiesTest, compositionJSONTest) {
     to_json(j, comp);
     from_json(j, comp2);
     ASSERT_TRUE(comp.equals(&comp2));
-}
\ No newline at end of file
+}
+
+TEST(utilitiesTest, compositionOwnsPartsTest) {
+    Part p("melody");
+    Note n(e3, quarter_note);
+    Chord c(c_major_chord, half_note);
+    p.append_note(&n);
+    p.append_chord(&c);
+    Composition comp;
+    comp.add_part(p);
+    comp.set_initial_tempo(120);
+    nlohmann::json j;
+    to_json(j, comp);
+    Composition comp2;
+    size_t before = comp2.get_arena().bytes_allocated();
+    from_json(j, comp2);
+    ASSERT_GT(comp2.get_arena().bytes_allocated(), before);
+    ASSERT_EQ(1, comp2.get_parts().size());
+    ASSERT_TRUE(comp2.get_part("melody")->equals(&p));
+}
+
+TEST(utilitiesTest, saxPartTest) {
+    Part p("melody");
+    Dynamic d(mf, 1, 0);
+    Note n(e3, quarter_note, false, true);
+    Chord c(c_major_chord, dotted_quarter_note);
+    c.set_staccato(true);
+    p.append_dynamic(&d);
+    p.append_note(&n);
+    p.append_chord(&c);
+    nlohmann::json j;
+    to_json(j, p);
+    Part p2;
+    sax_from_json(j.dump(), p2);
+    ASSERT_TRUE(p.equals(&p2));
+    Part p3;
+    std::istringstream in(j.dump(4));
+    sax_from_json(in, p3);
+    ASSERT_TRUE(p.equals(&p3));
+}
+
+TEST(utilitiesTest, saxCompositionMetricsTest) {
+    CompositionMetrics c;
+    c.key = Key(f3, lydian_intervals);
+    c.time_signature = TimeSignature(6, 8);
+    c.tempo = 77;
+    c.position = 40;
+    nlohmann::json j;
+    to_json(j, c);
+    CompositionMetrics c2;
+    sax_from_json(j.dump(), c2);
+    ASSERT_TRUE(c.equals(&c2));
+}
+
+TEST(utilitiesTest, saxCompositionTest) {
+    Composition comp;
+    Part p("melody");
+    Note n(e3, quarter_note);
+    Chord c(c_major_chord, half_note);
+    p.append_note(&n);
+    p.append_chord(&c);
+    comp.add_part(p);
+    PatternSegment ps("verse", half_note + quarter_note);
+    ps.set_chord_progression(&p);
+    comp.register_pattern_segment(&ps);
+    comp.add_to_pattern("verse");
+    comp.add_to_pattern("verse");
+    PacketPart root;
+    root.set_packet_path("/");
+    root.set_mode("melody");
+    PacketPart child;
+    child.set_packet_path("/child");
+    child.set_mode("harmony");
+    child.set_part(p);
+    root.append_child(&child);
+    root.execute();
+    child.execute();
+    comp.set_packet_tree_root(&root);
+    CompositionMetrics c0;
+    c0.key = Key(f3, lydian_intervals);
+    c0.tempo = 77;
+    CompositionMetrics c1;
+    c1.key = Key(e3, minor_intervals);
+    c1.time_signature = TimeSignature(5, 4);
+    c1.tempo = 79;
+    c1.position = 40;
+    comp.add_new_composition_metrics(&c0);
+    comp.add_new_composition_metrics(&c1);
+    nlohmann::json j;
+    to_json(j, comp);
+    Composition dom;
+    from_json(j, dom);
+    Composition sax;
+    size_t before = sax.get_arena().bytes_allocated();
+    sax_from_json(j.dump(), sax);
+    ASSERT_GT(sax.get_arena().bytes_allocated(), before);
+    ASSERT_TRUE(comp.equals(&sax));
+    ASSERT_TRUE(dom.equals(&sax));
+    ASSERT_EQ(2, sax.get_pattern().size());
+    // "executed" comes before "mode" and "packet_path", which must not mark
+    // the nodes dirty as they are read
+    ASSERT_TRUE(sax.get_packet_tree_root()->get_dirty().empty());
+    ASSERT_TRUE(dom.get_packet_tree_root()->get_dirty().empty());
+}
+
+TEST(utilitiesTest, saxMalformedTest) {
+    Part p;
+    ASSERT_THROW(sax_from_json("{\"name\": \"melody\", \"events\": [", p),
+            nlohmann::json::parse_error);
+    ASSERT_THROW(sax_from_json("{\"name\": melody}", p), nlohmann::json::parse_error);
+    ASSERT_THROW(sax_from_json("{} {}", p), nlohmann::json::parse_error);
+}
+
+/** A handler which accepts every value, for testing the JSON grammar alone. */
+struct AcceptingHandler {
+    bool null() { return true; }
+    bool boolean(bool) { return true; }
+    bool number_integer(int64_t) { return true; }
+    bool number_unsigned(uint64_t) { return true; }
+    bool number_float(double, const std::string&) { return true; }
+    bool string(std::string&) { return true; }
+    bool start_object(std::size_t) { return true; }
+    bool key(std::string&) { return true; }
+    bool end_object() { return true; }
+    bool start_array(std::size_t) { return true; }
+    bool end_array() { return true; }
+};
+
+TEST(utilitiesTest, saxGrammarTest) {
+    AcceptingHandler h;
+    const char *valid[] = { "0", "-0", "10", "-1.5", "0.25e-3", "2E+10", "1e5",
+            "\"\\ud83c\\udfb5\"" };
+    for (const char *json : valid) {
+        ASSERT_NO_THROW(nlohmann::json::parse(json));
+        ASSERT_TRUE(json_sax_parse(std::string(json), h)) << json;
+    }
+    // Each of these is also rejected by nlohmann::json::parse
+    const char *invalid[] = { "01", "-01", "1.", "1.e5", ".5", "-", "1e", "1e+",
+            "+1", "--1", "1-2", "\"\\ud83c\"", "\"\\ud83c\\u0041\"",
+            "\"\\ud83c\\ud83c\"", "\"\\udfb5\"" };
+    for (const char *json : invalid) {
+        ASSERT_THROW(nlohmann::json::parse(json), nlohmann::json::parse_error) << json;
+        ASSERT_THROW(json_sax_parse(std::string(json), h),
+                nlohmann::json::parse_error) << json;
+    }
+}
+
+TEST(utilitiesTest, saxDepthTest) {
+    typedef JsonSaxParser<JsonStringSource, AcceptingHandler> Parser;
+    AcceptingHandler h;
+    std::string deepest = std::string(Parser::max_depth, '[') +
+            std::string(Parser::max_depth, ']');
+    ASSERT_TRUE(json_sax_parse(deepest, h));
+    std::string too_deep = std::string(Parser::max_depth + 1, '[') +
+            std::string(Parser::max_depth + 1, ']');
+    ASSERT_THROW(json_sax_parse(too_deep, h), nlohmann::json::parse_error);
+    // Deep enough to overflow the stack without the limit
+    std::string huge(1000000, '[');
+    ASSERT_THROW(json_sax_parse(huge, h), nlohmann::json::parse_error);
+    Part p;
+    ASSERT_THROW(sax_from_json("{\"name\": \"x\", \"events\": " + too_deep + "}", p),
+            nlohmann::json::parse_error);
+}
+
+TEST(utilitiesTest, saxEscapeTest) {
+    Part p("caf\u00e9 \"solo\"\n\U0001F3B5");
+    nlohmann::json j;
+    to_json(j, p);
+    Part p2;
+    sax_from_json(j.dump(), p2);
+    ASSERT_EQ(p.get_name(), p2.get_name());
+    Part p3;
+    sax_from_json("{\"name\": \"\\u00e9\\ud83c\\udfb5\\t\", \"events\": []}", p3);
+    ASSERT_EQ("\u00e9\U0001F3B5\t", p3.get_name());
+}
+
+TEST(utilitiesTest, writerMatchesDumpTest) {
+    Part p("café \"solo\"\n\x01");
+    Dynamic d(mf, 1, 1);
+    Note n(e3, quarter_note, true, true);
+    n.set_accented();
+    n.set_slurred();
+    n.set_fermata();
+    Chord c(c_major_chord, dotted_quarter_note);
+    c.set_staccato();
+    c.set_tied();
+    Note rest(-1, eighth_note);
+    p.append_dynamic(&d);
+    p.append_note(&n);
+    p.append_chord(&c);
+    p.append_note(&rest);
+    nlohmann::json j;
+    to_json(j, p);
+    ASSERT_EQ(j.dump(), to_json_string(p));
+    Composition comp;
+    comp.add_part(p);
+    PatternSegment ps("verse", half_note);
+    ps.set_chord_progression(&p);
+    comp.register_pattern_segment(&ps);
+    comp.add_to_pattern("verse");
+    PacketPart root;
+    root.set_packet_path("/");
+    root.set_mode("melody");
+    PacketPart child;
+    child.set_packet_path("/child");
+    child.set_part(p);
+    child.execute();
+    root.append_child(&child);
+    comp.set_packet_tree_root(&root);
+    CompositionMetrics c1;
+    c1.key = Key(e3, minor_intervals);
+    c1.time_signature = TimeSignature(6, 8);
+    c1.position = 40;
+    comp.add_new_composition_metrics(&c1);
+    nlohmann::json j2;
+    to_json(j2, comp);
+    ASSERT_EQ(j2.dump(), to_json_string(comp));
+    std::ostringstream out;
+    write_json(out, comp);
+    ASSERT_EQ(j2.dump(), out.str());
+    std::string cbor;
+    nlohmann::json::to_cbor(j2, cbor);
+    ASSERT_EQ(cbor, to_cbor_string(comp));
+    std::string msgpack;
+    nlohmann::json::to_msgpack(j2, msgpack);
+    ASSERT_EQ(msgpack, to_msgpack_string(comp));
+}
+
+TEST(utilitiesTest, binaryWriterSizesTest) {
+    Part p(std::string(300, 'x'));
+    std::vector<Note> notes;
+    int pitches[] = { 0, 23, 24, 127, 128, 255, 256, 70000, -1, -24, -25, -32, -33,
+            -128, -129, -40000 };
+    for (int i = 0; i < 16; i++) {
+        notes.push_back(Note(pitches[i], whole_note * (i + 1)));
+    }
+    for (int i = 0; i < 16; i++) {
+        p.append_note(&notes[i]);
+    }
+    nlohmann::json j;
+    to_json(j, p);
+    std::string cbor;
+    nlohmann::json::to_cbor(j, cbor);
+    ASSERT_EQ(cbor, to_cbor_string(p));
+    std::string msgpack;
+    nlohmann::json::to_msgpack(j, msgpack);
+    ASSERT_EQ(msgpack, to_msgpack_string(p));
+    Part p2(std::string(70000, 'y'));
+    to_json(j, p2);
+    cbor.clear();
+    nlohmann::json::to_cbor(j, cbor);
+    ASSERT_EQ(cbor, to_cbor_string(p2));
+    msgpack.clear();
+    nlohmann::json::to_msgpack(j, msgpack);
+    ASSERT_EQ(msgpack, to_msgpack_string(p2));
+}
+
+TEST(utilitiesTest, writerEmptyCompositionTest) {
+    Composition comp;
+    nlohmann::json j;
+    to_json(j, comp);
+    ASSERT_EQ(j.dump(), to_json_string(comp));
+}
+
+TEST(utilitiesTest, wireFormatTest) {
+    Composition comp;
+    Part p("melody");
+    Note n(e3, quarter_note);
+    Chord c(c_major_chord, half_note);
+    p.append_note(&n);
+    p.append_chord(&c);
+    comp.add_part(p);
+    comp.set_initial_tempo(96);
+    WireFormat formats[] = { WIRE_JSON, WIRE_CBOR, WIRE_MSGPACK };
+    for (int i = 0; i < 3; i++) {
+        Composition comp2;
+        from_json(decode_wire(encode_wire(comp, formats[i]), formats[i]), comp2);
+        ASSERT_TRUE(comp.equals(&comp2));
+    }
+    ASSERT_LT(encode_wire(comp, WIRE_CBOR).size(), encode_wire(comp, WIRE_JSON).size());
+    ASSERT_LT(encode_wire(comp, WIRE_MSGPACK).size(), encode_wire(comp, WIRE_JSON).size());
+}
+
+/** The wire format used by shell_test_execute. */
+static WireFormat shell_test_format = WIRE_JSON;
+
+/** The number of times shell_test_execute was asked to play. */
+static int shell_test_plays = 0;
+
+/**
+ * Stands in for the driver module, packets and control module: the driver
+ * returns an empty composition, each packet returns a Part named after its
+ * path, and the control module returns the composition unchanged.
+ */
+std::string shell_test_execute(std::string path, std::string mode, std::string input) {
+    if (mode == "driver") {
+        Composition comp;
+        return encode_wire(comp, shell_test_format);
+    }
+    if (mode == "control" || mode == "finalcontrol") {
+        decode_wire(input, shell_test_format);
+        return input;
+    }
+    if (mode == "play") {
+        shell_test_plays++;
+        return "";
+    }
+    Composition comp;
+    from_json(decode_wire(input, shell_test_format), comp);
+    Part p(path);
+    Note n(c4 + comp.get_parts().size(), quarter_note);
+    p.append_note(&n);
+    nlohmann::json j;
+    to_json(j, p);
+    return encode_wire(j, shell_test_format);
+}
+
+TEST(utilitiesTest, executeShellWireFormatTest) {
+    WireFormat formats[] = { WIRE_JSON, WIRE_CBOR, WIRE_MSGPACK };
+    for (int i = 0; i < 3; i++) {
+        PacketPart root;
+        root.set_packet_path("/");
+        PacketPart left;
+        left.set_packet_path("/left");
+        PacketPart right;
+        right.set_packet_path("/right");
+        root.append_child(&left);
+        root.append_child(&right);
+        shell_test_format = formats[i];
+        shell_test_plays = 0;
+        std::string out = executeShell(shell_test_execute, &root, "driver", "control", formats[i]);
+        ASSERT_EQ(1, shell_test_plays);
+        Composition comp;
+        from_json(decode_wire(out, formats[i]), comp);
+        ASSERT_EQ(3, comp.get_parts().size());
+        ASSERT_EQ("/right", comp.get_parts()[2]->get_name());
+        ASSERT_TRUE(right.has_been_executed());
+    }
+}
+
+/** The composition documents the control module has been sent, in order. */
+static std::vector<nlohmann::json> control_docs;
+
+/** The number of control module inputs which were deltas. */
+static int control_deltas = 0;
+
+/**
+ * Stands in for the modules like shell_test_execute, but the control module
+ * rebuilds each composition it is sent from the deltas it receives.
+ */
+std::string delta_test_execute(std::string path, std::string mode, std::string input) {
+    if (mode == "control") {
+        nlohmann::json doc = nlohmann::json::parse(input);
+        if (doc.is_array()) {
+            control_deltas++;
+            doc = control_docs.back().patch(doc);
+        }
+        control_docs.push_back(doc);
+        return input;
+    }
+    return shell_test_execute(path, mode, input);
+}
+
+TEST(utilitiesTest, executeShellDeltaTest) {
+    std::vector<nlohmann::json> expected;
+    for (int pass = 0; pass < 2; pass++) {
+        PacketPart root;
+        root.set_packet_path("/");
+        PacketPart left;
+        left.set_packet_path("/left");
+        PacketPart right;
+        right.set_packet_path("/right");
+        PacketPart grandchild;
+        grandchild.set_packet_path("/right/center");
+        root.append_child(&left);
+        root.append_child(&right);
+        right.append_child(&grandchild);
+        shell_test_format = WIRE_JSON;
+        control_docs.clear();
+        control_deltas = 0;
+        ShellOptions options;
+        if (pass == 1) {
+            options.delta_receivers.insert("control");
+        }
+        executeShell(delta_test_execute, &root, "driver", "control", options);
+        if (pass == 0) {
+            expected = control_docs;
+            ASSERT_EQ(0, control_deltas);
+        }
+        else {
+            ASSERT_EQ(3, control_deltas);
+        }
+    }
+    ASSERT_EQ(4, control_docs.size());
+    for (int i = 0; i < 4; i++) {
+        ASSERT_EQ(expected[i], control_docs[i]);
+    }
+}
+
+/** The inputs of the packets and the final control module, in order. */
+static std::vector<nlohmann::json> extra_key_inputs;
+
+/**
+ * Stands in for the modules like delta_test_execute, but the driver and control
+ * modules add keys which are not part of the composition: the driver a style,
+ * and the control module the number of times it has been called, while it
+ * drops the style once it has been called twice.
+ */
+std::string extra_key_test_execute(std::string path, std::string mode, std::string input) {
+    if (mode == "driver") {
+        nlohmann::json j;
+        to_json(j, Composition());
+        j["style"] = "swing";
+        return j.dump();
+    }
+    if (mode == "control") {
+        delta_test_execute(path, mode, input);
+        nlohmann::json doc = control_docs.back();
+        int calls = doc.value("calls", 0) + 1;
+        doc["calls"] = calls;
+        if (calls == 2) {
+            doc.erase("style");
+        }
+        return doc.dump();
+    }
+    if (mode == "finalcontrol") {
+        extra_key_inputs.push_back(nlohmann::json::parse(input));
+        return input;
+    }
+    if (mode != "play") {
+        extra_key_inputs.push_back(nlohmann::json::parse(input));
+    }
+    return shell_test_execute(path, mode, input);
+}
+
+TEST(utilitiesTest, executeShellExtraKeysTest) {
+    std::vector<nlohmann::json> expected;
+    for (int pass = 0; pass < 2; pass++) {
+        PacketPart root;
+        root.set_packet_path("/");
+        PacketPart left;
+        left.set_packet_path("/left");
+        PacketPart right;
+        right.set_packet_path("/right");
+        root.append_child(&left);
+        root.append_child(&right);
+        shell_test_format = WIRE_JSON;
+        control_docs.clear();
+        control_deltas = 0;
+        extra_key_inputs.clear();
+        ShellOptions options;
+        if (pass == 1) {
+            options.delta_receivers.insert("control");
+        }
+        executeShell(extra_key_test_execute, &root, "driver", "control", options);
+        ASSERT_EQ(4, extra_key_inputs.size());
+        // Each packet is passed the keys of the module output before it
+        ASSERT_EQ("swing", extra_key_inputs[0]["style"]);
+        ASSERT_EQ(0, extra_key_inputs[0].count("calls"));
+        ASSERT_EQ("swing", extra_key_inputs[1]["style"]);
+        ASSERT_EQ(1, extra_key_inputs[1]["calls"]);
+        ASSERT_EQ(0, extra_key_inputs[2].count("style"));
+        ASSERT_EQ(2, extra_key_inputs[2]["calls"]);
+        ASSERT_EQ(3, extra_key_inputs[3]["calls"]);
+        ASSERT_EQ(3, extra_key_inputs[3]["parts"].size());
+        if (pass == 0) {
+            expected = control_docs;
+            ASSERT_EQ(0, control_deltas);
+        }
+        else {
+            ASSERT_EQ(2, control_deltas);
+        }
+    }
+    // The control module is passed the same keys whether or not it accepts deltas
+    ASSERT_EQ(3, control_docs.size());
+    for (int i = 0; i < 3; i++) {
+        ASSERT_EQ(expected[i], control_docs[i]);
+    }
+    ASSERT_EQ(1, control_docs[1]["calls"]);
+    ASSERT_EQ(0, control_docs[2].count("style"));
+}
+
+/** The number of packets parallel_test_execute is running, and the most at once. */
+static std::atomic<int> packets_running(0);
+static std::atomic<int> most_packets_running(0);
+
+/**
+ * Stands in for the modules like delta_test_execute, but each packet takes a
+ * few milliseconds and returns a Part which depends only on its path, so its
+ * siblings may run at the same time. A packet at "/fail" throws.
+ */
+std::string parallel_test_execute(std::string path, std::string mode, std::string input) {
+    if (mode != "melody") {
+        return delta_test_execute(path, mode, input);
+    }
+    if (path == "/fail") {
+        throw std::string("packet failed");
+    }
+    int running = ++packets_running;
+    int most = most_packets_running;
+    while (running > most && !most_packets_running.compare_exchange_weak(most, running)) {
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    packets_running--;
+    Arena arena;
+    ArenaScope scope(&arena);
+    Part *p = arena_make<Part>(path);
+    p->append_note(arena_make<Note>(c4 + path.size(), quarter_note));
+    nlohmann::json j;
+    to_json(j, *p);
+    return j.dump();
+}
+
+TEST(utilitiesTest, executeShellParallelTest) {
+    std::vector<nlohmann::json> expected;
+    std::string expected_out;
+    for (int pass = 0; pass < 3; pass++) {
+        std::vector<PacketPart> nodes(7);
+        const char *paths[] = { "/", "/a", "/b", "/c", "/b/a", "/b/b", "/c/a" };
+        int parents[] = { -1, 0, 0, 0, 2, 2, 3 };
+        for (int i = 0; i < 7; i++) {
+            nodes[i].set_packet_path(paths[i]);
+            nodes[i].set_mode("melody");
+            if (parents[i] >= 0) {
+                nodes[parents[i]].append_child(&nodes[i]);
+            }
+        }
+        shell_test_format = WIRE_JSON;
+        control_docs.clear();
+        most_packets_running = 0;
+        ShellOptions options;
+        if (pass > 0) {
+            options.num_workers = 4;
+            options.independent_packets.insert(paths, paths + 7);
+        }
+        if (pass == 2) {
+            options.delta_receivers.insert("control");
+        }
+        std::string out = executeShell(parallel_test_execute, &nodes[0], "driver", "control",
+                options);
+        if (pass == 0) {
+            expected = control_docs;
+            expected_out = out;
+            ASSERT_EQ(1, most_packets_running);
+        }
+        else {
+            ASSERT_LT(1, most_packets_running);
+            if (pass == 1) {
+                ASSERT_EQ(expected_out, out);
+            }
+            ASSERT_EQ(expected.size(), control_docs.size());
+            for (int i = 0; i < expected.size(); i++) {
+                ASSERT_EQ(expected[i], control_docs[i]);
+            }
+        }
+        for (int i = 0; i < 7; i++) {
+            ASSERT_TRUE(nodes[i].has_been_executed());
+        }
+    }
+    ASSERT_EQ(7, expected.size());
+}
+
+TEST(utilitiesTest, executeShellParallelErrorTest) {
+    PacketPart root;
+    root.set_packet_path("/");
+    root.set_mode("melody");
+    PacketPart fail;
+    fail.set_packet_path("/fail");
+    fail.set_mode("melody");
+    PacketPart other;
+    other.set_packet_path("/other");
+    other.set_mode("melody");
+    root.append_child(&fail);
+    root.append_child(&other);
+    ShellOptions options;
+    options.num_workers = 2;
+    shell_test_format = WIRE_JSON;
+    control_docs.clear();
+    ASSERT_THROW(executeShell(parallel_test_execute, &root, "driver", "control", options),
+            std::string);
+    ASSERT_TRUE(root.has_been_executed());
+    ASSERT_FALSE(fail.has_been_executed());
+}
+
+/** The number of packets sibling_test_execute has run. */
+static std::atomic<int> sibling_packet_calls(0);
+
+/**
+ * Stands in for the modules like shell_test_execute, but the control module
+ * counts its calls in a key which is not part of the composition, and each
+ * packet returns a note which depends on the Parts before it and on that count.
+ */
+std::string sibling_test_execute(std::string path, std::string mode, std::string input) {
+    if (mode == "driver") {
+        nlohmann::json j;
+        to_json(j, Composition());
+        j["calls"] = 0;
+        return j.dump();
+    }
+    if (mode == "play") {
+        return "";
+    }
+    nlohmann::json doc = nlohmann::json::parse(input);
+    if (mode == "control") {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        doc["calls"] = doc["calls"].get<int>() + 1;
+        control_docs.push_back(doc);
+        return doc.dump();
+    }
+    if (mode == "finalcontrol") {
+        return input;
+    }
+    sibling_packet_calls++;
+    Part p(path);
+    Note n(c4 + doc["parts"].size() + doc["calls"].get<int>(), quarter_note);
+    p.append_note(&n);
+    nlohmann::json j;
+    to_json(j, p);
+    return j.dump();
+}
+
+TEST(utilitiesTest, executeShellParallelSiblingsTest) {
+    std::vector<nlohmann::json> expected;
+    std::string expected_out;
+    for (int pass = 0; pass < 3; pass++) {
+        std::vector<PacketPart> nodes(6);
+        const char *paths[] = { "/", "/a", "/b", "/c", "/b/a", "/b/b" };
+        int parents[] = { -1, 0, 0, 0, 2, 2 };
+        for (int i = 0; i < 6; i++) {
+            nodes[i].set_packet_path(paths[i]);
+            nodes[i].set_mode("melody");
+            if (parents[i] >= 0) {
+                nodes[parents[i]].append_child(&nodes[i]);
+            }
+        }
+        control_docs.clear();
+        sibling_packet_calls = 0;
+        ShellOptions options;
+        options.num_workers = 4;
+        std::string out;
+        if (pass == 0) {
+            out = executeShell(sibling_test_execute, &nodes[0], "driver", "control");
+            expected = control_docs;
+            expected_out = out;
+            ASSERT_EQ(6, sibling_packet_calls);
+            continue;
+        }
+        if (pass == 1) {
+            out = executeShell(sibling_test_execute, &nodes[0], "driver", "control", options);
+        }
+        else {
+            WorkerPool pool(2);
+            out = executeShellAsync(make_async_callback(sibling_test_execute, pool), &nodes[0],
+                    "driver", "control", options);
+        }
+        ASSERT_EQ(expected_out, out);
+        ASSERT_EQ(expected.size(), control_docs.size());
+        for (int i = 0; i < expected.size(); i++) {
+            ASSERT_EQ(expected[i], control_docs[i]);
+        }
+        // Every packet after the first started before the count it needed
+        ASSERT_EQ(11, sibling_packet_calls);
+    }
+    ASSERT_EQ(6, expected.size());
+    ASSERT_EQ(6, expected[5]["calls"]);
+}
+
+/** The number of calls to the control module threaded_test_execute is running. */
+static std::atomic<int> controls_running(0);
+
+/** Whether threaded_test_execute started a packet while the control module ran. */
+static std::atomic<bool> packet_overlapped_control(false);
+
+/**
+ * Runs parallel_test_execute on a thread of its own for each call, with the
+ * control module taking a few milliseconds.
+ */
+void threaded_test_execute(std::string path, std::string mode, std::string input,
+        completion_handler done) {
+    bool control = mode == "control";
+    if (control) {
+        controls_running++;
+    }
+    else if (controls_running > 0) {
+        packet_overlapped_control = true;
+    }
+    std::thread([=]() {
+        if (control) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        std::string output;
+        std::exception_ptr error;
+        try {
+            output = parallel_test_execute(path, mode, input);
+        }
+        catch (...) {
+            error = std::current_exception();
+        }
+        if (control) {
+            controls_running--;
+        }
+        done(output, error);
+    }).detach();
+}
+
+TEST(utilitiesTest, executeShellAsyncTest) {
+    std::vector<nlohmann::json> expected;
+    std::string expected_out;
+    for (int pass = 0; pass < 4; pass++) {
+        PacketPart root;
+        root.set_packet_path("/");
+        PacketPart left;
+        left.set_packet_path("/left");
+        PacketPart right;
+        right.set_packet_path("/right");
+        PacketPart grandchild;
+        grandchild.set_packet_path("/right/center");
+        root.append_child(&left);
+        root.append_child(&right);
+        right.append_child(&grandchild);
+        shell_test_format = WIRE_JSON;
+        control_docs.clear();
+        packet_overlapped_control = false;
+        ShellOptions options;
+        if (pass == 3) {
+            options.delta_receivers.insert("control");
+        }
+        std::string out;
+        if (pass == 0) {
+            out = executeShell(delta_test_execute, &root, "driver", "control", options);
+            expected = control_docs;
+            expected_out = out;
+            continue;
+        }
+        if (pass == 1) {
+            out = executeShellAsync(make_async_callback(delta_test_execute), &root, "driver",
+                    "control", options);
+        }
+        else {
+            out = executeShellAsync(threaded_test_execute, &root, "driver", "control",
+                    options);
+            ASSERT_TRUE(packet_overlapped_control);
+        }
+        if (pass < 3) {
+            ASSERT_EQ(expected_out, out);
+        }
+        ASSERT_EQ(expected.size(), control_docs.size());
+        for (int i = 0; i < expected.size(); i++) {
+            ASSERT_EQ(expected[i], control_docs[i]);
+        }
+        ASSERT_TRUE(grandchild.has_been_executed());
+    }
+    ASSERT_EQ(4, expected.size());
+}
+
+TEST(utilitiesTest, executeShellAsyncErrorTest) {
+    PacketPart root;
+    root.set_packet_path("/");
+    root.set_mode("melody");
+    PacketPart fail;
+    fail.set_packet_path("/fail");
+    fail.set_mode("melody");
+    root.append_child(&fail);
+    shell_test_format = WIRE_JSON;
+    control_docs.clear();
+    ASSERT_THROW(executeShellAsync(threaded_test_execute, &root, "driver", "control"),
+            std::string);
+    ASSERT_TRUE(root.has_been_executed());
+    ASSERT_FALSE(fail.has_been_executed());
+}
+
+#ifndef STANDIN_PACKET
+#define STANDIN_PACKET "../tools/standinpacket"
+#endif
+
+/** The ProcessPool process_test_execute runs packets and modules on. */
+static ProcessPool *test_processes = NULL;
+
+std::string process_test_execute(std::string path, std::string mode, std::string input) {
+    return test_processes->execute(path, mode, input);
+}
+
+TEST(utilitiesTest, executeShellProcessPoolTest) {
+    ProcessPool processes([](const std::string &path) {
+        return std::vector<std::string>{ STANDIN_PACKET, path };
+    });
+    test_processes = &processes;
+    std::string outputs[2];
+    for (int pass = 0; pass < 2; pass++) {
+        PacketPart root;
+        root.set_packet_path("/");
+        root.set_mode("melody");
+        PacketPart left;
+        left.set_packet_path("/left");
+        left.set_mode("melody");
+        PacketPart right;
+        right.set_packet_path("/right");
+        right.set_mode("melody");
+        root.append_child(&left);
+        root.append_child(&right);
+        if (pass == 0) {
+            outputs[pass] = executeShell(process_test_execute, &root, "driver", "control");
+        }
+        else {
+            WorkerPool threads(2);
+            outputs[pass] = executeShellAsync(make_async_callback(processes, threads), &root,
+                    "driver", "control");
+        }
+        Composition comp;
+        from_json(nlohmann::json::parse(outputs[pass]), comp);
+        ASSERT_EQ(3, comp.get_parts().size());
+        ASSERT_EQ("/right", comp.get_parts()[2]->get_name());
+    }
+    ASSERT_EQ(outputs[0], outputs[1]);
+    // The driver, control module, three packets and the player
+    ASSERT_EQ(6, processes.get_started());
+}
+
+/**
+ * The number of packet and control module calls cache_test_execute was asked
+ * for. Packets may run on several threads at once.
+ */
+static std::atomic<int> cached_packet_calls(0);
+static std::atomic<int> cached_control_calls(0);
+
+/** Whether cache_test_execute returns text which is not JSON for "/left". */
+static bool corrupt_left = false;
+
+std::string cache_test_execute(std::string path, std::string mode, std::string input) {
+    if (mode == "control") {
+        cached_control_calls++;
+    }
+    else if (mode == "melody") {
+        cached_packet_calls++;
+        if (corrupt_left && path == "/left") {
+            return "not json";
+        }
+    }
+    return shell_test_execute(path, mode, input);
+}
+
+/**
+ * Runs the tree "/", "/left", "/right", "/right/center" with cache_test_execute,
+ * or executeShellAsync if async, with the given path for "/left".
+ */
+std::string run_cache_test(ResultCache *cache, const std::string &left_path, bool async) {
+    PacketPart root;
+    root.set_packet_path("/");
+    root.set_mode("melody");
+    PacketPart left;
+    left.set_packet_path(left_path);
+    left.set_mode("melody");
+    PacketPart right;
+    right.set_packet_path("/right");
+    right.set_mode("melody");
+    PacketPart grandchild;
+    grandchild.set_packet_path("/right/center");
+    grandchild.set_mode("melody");
+    root.append_child(&left);
+    root.append_child(&right);
+    right.append_child(&grandchild);
+    shell_test_format = WIRE_JSON;
+    cached_packet_calls = 0;
+    cached_control_calls = 0;
+    ShellOptions options;
+    options.cache = cache;
+    if (async) {
+        return executeShellAsync(make_async_callback(cache_test_execute), &root, "driver",
+                "control", options);
+    }
+    return executeShell(cache_test_execute, &root, "driver", "control", options);
+}
+
+TEST(utilitiesTest, executeShellCacheTest) {
+    char left[] = "/tmp/shellcachepacketXXXXXX";
+    close(mkstemp(left));
+    std::string expected = run_cache_test(NULL, left, false);
+    ResultCache cache;
+    for (int async = 0; async < 2; async++) {
+        ASSERT_EQ(expected, run_cache_test(&cache, left, async));
+        ASSERT_EQ(async ? 0 : 4, cached_packet_calls);
+        ASSERT_EQ(async ? 0 : 4, cached_control_calls);
+    }
+    // Editing a packet runs it again. It returns the same Part, so the packets
+    // and control module calls after it are still cached.
+    FILE *f = std::fopen(left, "a");
+    std::fputs("edited", f);
+    std::fclose(f);
+    ASSERT_EQ(expected, run_cache_test(&cache, left, false));
+    ASSERT_EQ(1, cached_packet_calls);
+    ASSERT_EQ(0, cached_control_calls);
+    // Every packet is passed the packet tree, so renaming one runs them all
+    run_cache_test(&cache, "/left2", true);
+    ASSERT_EQ(4, cached_packet_calls);
+    std::remove(left);
+}
+
+TEST(utilitiesTest, executeShellCacheBadOutputTest) {
+    std::string expected = run_cache_test(NULL, "/left", false);
+    for (int async = 0; async < 2; async++) {
+        ResultCache cache;
+        corrupt_left = true;
+        ASSERT_ANY_THROW(run_cache_test(&cache, "/left", async));
+        corrupt_left = false;
+        // The output which could not be decoded was not cached, so "/left" runs
+        // again and the shell finishes.
+        ASSERT_EQ(expected, run_cache_test(&cache, "/left", async));
+        ASSERT_EQ(3, cached_packet_calls);
+    }
+}
+
+TEST(utilitiesTest, executeShellCacheDirectoryTest) {
+    char dir[] = "/tmp/shellcachetestXXXXXX";
+    ASSERT_TRUE(mkdtemp(dir) != NULL);
+    std::string expected;
+    {
+        ResultCache cache(16, dir);
+        expected = run_cache_test(&cache, "/left", false);
+    }
+    ResultCache cache(16, dir);
+    ASSERT_EQ(expected, run_cache_test(&cache, "/left", false));
+    ASSERT_EQ(0, cached_packet_calls);
+    ASSERT_EQ(0, cached_control_calls);
+    std::system((std::string("rm -rf ") + dir).c_str());
+}
+
+TEST(utilitiesTest, executeShellIncrementalTest) {
+    const char *paths[] = { "/", "/left", "/right", "/right/center" };
+    for (int workers = 1; workers <= 2; workers++) {
+        std::vector<PacketPart> nodes(4);
+        for (int i = 0; i < 4; i++) {
+            nodes[i].set_packet_path(paths[i]);
+            nodes[i].set_mode("melody");
+        }
+        nodes[0].append_child(&nodes[1]);
+        nodes[0].append_child(&nodes[2]);
+        nodes[2].append_child(&nodes[3]);
+        ShellOptions options;
+        options.num_workers = workers;
+        cached_packet_calls = 0;
+        cached_control_calls = 0;
+        nlohmann::json expected = nlohmann::json::parse(executeShell(cache_test_execute,
+                &nodes[0], "driver", "control", options))["parts"];
+        ASSERT_EQ(4, cached_packet_calls);
+        ASSERT_TRUE(nodes[0].get_dirty().empty());
+        nlohmann::json renamed = expected;
+        renamed[1]["name"] = "/left2";
+        // Nothing is dirty, so the stored Parts are reused and the control
+        // module is passed them once.
+        cached_packet_calls = 0;
+        cached_control_calls = 0;
+        ASSERT_EQ(expected, nlohmann::json::parse(executeShell(cache_test_execute, &nodes[0],
+                "driver", "control", options))["parts"]);
+        ASSERT_EQ(0, cached_packet_calls);
+        ASSERT_EQ(1, cached_control_calls);
+        // Setting a node's packet or mode to what it was changes nothing
+        nodes[1].set_packet_path("/left");
+        nodes[2].set_mode("melody");
+        ASSERT_TRUE(nodes[0].get_dirty().empty());
+        // Renaming a packet makes it and its descendants dirty, here only "/left"
+        nodes[1].set_packet_path("/left2");
+        std::vector<PacketPart*> dirty = nodes[0].get_dirty();
+        ASSERT_EQ(1, dirty.size());
+        ASSERT_EQ(&nodes[1], dirty[0]);
+        cached_packet_calls = 0;
+        cached_control_calls = 0;
+        ASSERT_EQ(renamed, nlohmann::json::parse(executeShell(cache_test_execute, &nodes[0],
+                "driver", "control", options))["parts"]);
+        ASSERT_EQ(1, cached_packet_calls);
+        ASSERT_EQ(2, cached_control_calls);
+        // Changing a mode makes the subtree below it dirty
+        nodes[2].set_mode("harmony");
+        dirty = nodes[0].get_dirty();
+        ASSERT_EQ(2, dirty.size());
+        ASSERT_EQ(&nodes[2], dirty[0]);
+        ASSERT_EQ(&nodes[3], dirty[1]);
+        executeShell(cache_test_execute, &nodes[0], "driver", "control", options);
+        ASSERT_TRUE(nodes[0].get_dirty().empty());
+        // Editing a Part by hand makes only the nodes below it dirty. The edit
+        // is a copy of the Part the last run left, so it shares its events.
+        Part edited = nodes[2].get_part();
+        ASSERT_GT(edited.get_num_events(), 0);
+        edited.set_name("/edited");
+        nlohmann::json before;
+        to_json(before, edited);
+        nodes[2].edit_part(edited);
+        dirty = nodes[0].get_dirty();
+        ASSERT_EQ(1, dirty.size());
+        ASSERT_EQ(&nodes[3], dirty[0]);
+        cached_packet_calls = 0;
+        std::string out = executeShell(cache_test_execute, &nodes[0], "driver", "control",
+                options);
+        ASSERT_EQ(1, cached_packet_calls);
+        Composition comp;
+        from_json(nlohmann::json::parse(out), comp);
+        ASSERT_EQ(4, comp.get_parts().size());
+        ASSERT_EQ("/edited", comp.get_parts()[2]->get_name());
+        nlohmann::json kept;
+        to_json(kept, nodes[2].get_part());
+        ASSERT_EQ(before, kept);
+        ASSERT_EQ(before["events"], nlohmann::json::parse(out)["parts"][2]["events"]);
+    }
+}
+
+TEST(utilitiesTest, executeShellIncrementalMemoryTest) {
+    const char *paths[] = { "/", "/left", "/right", "/right/center" };
+    std::vector<PacketPart> nodes(4);
+    for (int i = 0; i < 4; i++) {
+        nodes[i].set_packet_path(paths[i]);
+        nodes[i].set_mode("melody");
+    }
+    nodes[0].append_child(&nodes[1]);
+    nodes[0].append_child(&nodes[2]);
+    nodes[2].append_child(&nodes[3]);
+    executeShell(shell_test_execute, &nodes[0], "driver", "control");
+    size_t reserved = 0;
+    for (int i = 0; i < 4; i++) {
+        reserved += nodes[i].get_part_arena()->bytes_reserved();
+    }
+    for (int run = 0; run < 20; run++) {
+        std::weak_ptr<Arena> old[4];
+        for (int i = 0; i < 4; i++) {
+            old[i] = nodes[i].get_part_arena();
+        }
+        // Rerunning "/right" replaces its Part and that of "/right/center",
+        // which frees the Arenas of their old Parts once the run is over
+        nodes[2].set_mode(run % 2 == 0 ? "harmony" : "melody");
+        executeShell(shell_test_execute, &nodes[0], "driver", "control");
+        ASSERT_FALSE(old[0].expired());
+        ASSERT_FALSE(old[1].expired());
+        ASSERT_TRUE(old[2].expired());
+        ASSERT_TRUE(old[3].expired());
+        // So does editing a Part by hand
+        std::weak_ptr<Arena> edited = nodes[1].get_part_arena();
+        Part part = nodes[1].get_part();
+        nodes[1].edit_part(part);
+        ASSERT_TRUE(edited.expired());
+        size_t now = 0;
+        for (int i = 0; i < 4; i++) {
+            now += nodes[i].get_part_arena()->bytes_reserved();
+        }
+        ASSERT_EQ(reserved, now);
+    }
+}
+
+TEST(utilitiesTest, executeShellTraceTest) {
+    const char *paths[] = { "/", "/left", "/right", "/right/center" };
+    for (int pass = 0; pass < 3; pass++) {
+        std::vector<PacketPart> nodes(4);
+        for (int i = 0; i < 4; i++) {
+            nodes[i].set_packet_path(paths[i]);
+            nodes[i].set_mode("melody");
+        }
+        nodes[0].append_child(&nodes[1]);
+        nodes[0].append_child(&nodes[2]);
+        nodes[2].append_child(&nodes[3]);
+        shell_test_format = WIRE_JSON;
+        ShellTrace trace;
+        ShellOptions options;
+        options.trace = &trace;
+        if (pass == 1) {
+            options.num_workers = 2;
+        }
+        if (pass == 2) {
+            executeShellAsync(make_async_callback(shell_test_execute), &nodes[0], "driver",
+                    "control", options);
+        }
+        else {
+            executeShell(shell_test_execute, &nodes[0], "driver", "control", options);
+        }
+        std::vector<TraceRecord> records = trace.get_records();
+        // The driver, four packets each followed by the control module, the
+        // final control module and the player
+        ASSERT_EQ(11, records.size());
+        ASSERT_EQ("driver", records[0].mode);
+        ASSERT_GT(records[0].parse, 0);
+        ASSERT_EQ("finalcontrol", records[9].mode);
+        ASSERT_EQ("play", records[10].mode);
+        int packets = 0;
+        for (int i = 1; i < 9; i++) {
+            const TraceRecord &r = records[i];
+            if (r.mode == "melody") {
+                packets++;
+                ASSERT_GT(r.serialize, 0);
+                ASSERT_GT(r.parse, 0);
+                ASSERT_GT(r.bytes_in, 0);
+                ASSERT_GT(r.bytes_out, 0);
+                ASSERT_LE(r.start, r.call_start);
+                ASSERT_LE(r.call_start, r.call_end);
+                ASSERT_LE(r.call_end, r.end);
+            }
+        }
+        ASSERT_EQ(4, packets);
+        if (pass == 0) {
+            ASSERT_EQ("/right/center", records[7].path);
+            ASSERT_EQ("control", records[8].mode);
+        }
+        std::ostringstream chrome;
+        trace.write_chrome_trace(chrome);
+        ASSERT_LE(11, nlohmann::json::parse(chrome.str()).at("traceEvents").size());
+        std::ostringstream summary;
+        trace.write_summary(summary);
+        ASSERT_NE(std::string::npos, summary.str().find("/right/center (melody)"));
+    }
+}
+
+/** Whether checkpoint_test_execute fails the next call to "/right". */
+static bool fail_right = false;
+
+std::string checkpoint_test_execute(std::string path, std::string mode, std::string input) {
+    if (mode == "melody" && path == "/right" && fail_right) {
+        fail_right = false;
+        throw std::string("/right failed");
+    }
+    return cache_test_execute(path, mode, input);
+}
+
+TEST(utilitiesTest, executeShellCheckpointTest) {
+    const char *paths[] = { "/", "/left", "/right", "/right/center" };
+    for (int workers = 1; workers <= 2; workers++) {
+        char dir[] = "/tmp/shellcheckpointtestXXXXXX";
+        ASSERT_TRUE(mkdtemp(dir) != NULL);
+        std::vector<PacketPart> nodes(4);
+        for (int i = 0; i < 4; i++) {
+            nodes[i].set_packet_path(paths[i]);
+            nodes[i].set_mode("melody");
+        }
+        nodes[0].append_child(&nodes[1]);
+        nodes[0].append_child(&nodes[2]);
+        nodes[2].append_child(&nodes[3]);
+        ShellOptions options;
+        options.num_workers = workers;
+        shell_test_format = WIRE_JSON;
+        nlohmann::json expected = nlohmann::json::parse(executeShell(cache_test_execute,
+                &nodes[0], "driver", "control", options))["parts"];
+        for (int i = 0; i < 4; i++) {
+            nodes[i].clear_execution();
+        }
+        options.checkpoint_path = std::string(dir) + "/checkpoint.json";
+        ASSERT_THROW(resume_shell(cache_test_execute, "control", options), std::string);
+        // "/right" fails, so the checkpoint has "/" and perhaps "/left" executed
+        fail_right = true;
+        ASSERT_THROW(executeShell(checkpoint_test_execute, &nodes[0], "driver", "control",
+                options), std::string);
+        Composition saved;
+        load_checkpoint(options.checkpoint_path, saved);
+        ASSERT_TRUE(saved.get_packet_tree_root()->has_been_executed());
+        ASSERT_FALSE(saved.get_packet_tree_root()->get_children()[1]->has_been_executed());
+        int dirty = saved.get_packet_tree_root()->get_dirty().size();
+        if (workers == 1) {
+            ASSERT_EQ(2, dirty);
+        }
+        // Only the packets which had not been executed are run again
+        cached_packet_calls = 0;
+        shell_test_plays = 0;
+        nlohmann::json parts = nlohmann::json::parse(resume_shell(checkpoint_test_execute,
+                "control", options))["parts"];
+        ASSERT_EQ(dirty, cached_packet_calls);
+        ASSERT_EQ(1, shell_test_plays);
+        ASSERT_EQ(4, parts.size());
+        for (int i = 0; i < 4; i++) {
+            ASSERT_EQ(expected[i]["name"], parts[i]["name"]);
+        }
+        if (workers == 1) {
+            ASSERT_EQ(expected, parts);
+        }
+        // The checkpoint now has every packet executed, so resuming again runs
+        // no packets
+        cached_packet_calls = 0;
+        resume_shell(checkpoint_test_execute, "control", options);
+        ASSERT_EQ(0, cached_packet_calls);
+        std::system((std::string("rm -rf ") + dir).c_str());
+    }
+}
@@ -0,0 +1,44 @@
+/* 
+ * File:   workerpooltest.cpp
+ * Author: Sam Rappl
+ *
+ */
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "worker_pool.h"
+#include "gtest/gtest.h"
+
+TEST(workerPoolTest, runsTasksTest) {
+	std::atomic<int> count(0);
+	{
+		WorkerPool pool(3);
+		ASSERT_EQ(3, pool.size());
+		for (int i = 0; i < 100; i++) {
+			pool.submit([&count]() { count++; });
+		}
+		while (count < 100) {
+			std::this_thread::yield();
+		}
+	}
+	ASSERT_EQ(100, count);
+}
+
+TEST(workerPoolTest, discardsQueuedTasksTest) {
+	std::atomic<int> count(0);
+	std::atomic<bool> started(false);
+	{
+		WorkerPool pool(1);
+		pool.submit([&]() {
+			started = true;
+			std::this_thread::sleep_for(std::chrono::milliseconds(20));
+			count++;
+		});
+		pool.submit([&count]() { count++; });
+		while (!started) {
+			std::this_thread::yield();
+		}
+	}
+	ASSERT_EQ(1, count);
+}
@@ -0,0 +1,88 @@
+/*
+ * File:    standinpacket.cpp
+ * Author:  Sam Rappl
+ *
+ * A stand-in packet for running a ProcessPool without real packets. It serves
+ * requests on standard input and output (see serve_packet), in JSON:
+ *
+ *   driver                 returns an empty composition
+ *   control, finalcontrol  return their input
+ *   play                   returns nothing
+ *   fail                   reports an error
+ *   any other mode         returns a Part named after the packet path with one
+ *                          note, whose pitch counts the parts of the input
+ *
+ * Usage: standinpacket [--startup-ms N] [--work-ms N] [--crash-file FILE] [PATH]
+ *
+ *   --startup-ms  sleeps before serving, as loading an interpreter or model does
+ *   --work-ms     sleeps before each response
+ *   --crash-file  exits without responding to a request if FILE exists, after
+ *                 removing it, so the next worker started serves normally
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <nlohmann/json.hpp>
+#include "json_writer.h"
+#include "process_pool.h"
+
+static std::string packet_path;
+static std::string crash_file;
+static int work_ms = 0;
+
+std::string handle(const std::string &mode, const std::string &input) {
+    if (!crash_file.empty() && unlink(crash_file.c_str()) == 0) {
+        _exit(1);
+    }
+    if (work_ms > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(work_ms));
+    }
+    if (mode == "driver") {
+        Composition comp;
+        return to_json_string(comp);
+    }
+    if (mode == "control" || mode == "finalcontrol") {
+        return input;
+    }
+    if (mode == "play") {
+        return "";
+    }
+    if (mode == "fail") {
+        throw std::string("Stand-in packet " + packet_path + " failed.");
+    }
+    nlohmann::json comp = nlohmann::json::parse(input);
+    int num_parts = comp.is_object() && comp.count("parts") ? comp["parts"].size() : 0;
+    Arena arena;
+    ArenaScope scope(&arena);
+    Part *part = arena_make<Part>(packet_path);
+    part->append_note(arena_make<Note>(c4 + num_parts % 12, quarter_note));
+    return to_json_string(*part);
+}
+
+int main(int argc, char **argv) {
+    int startup_ms = 0;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--startup-ms" && i + 1 < argc) {
+            startup_ms = std::atoi(argv[++i]);
+        }
+        else if (arg == "--work-ms" && i + 1 < argc) {
+            work_ms = std::atoi(argv[++i]);
+        }
+        else if (arg == "--crash-file" && i + 1 < argc) {
+            crash_file = argv[++i];
+        }
+        else {
+            packet_path = arg;
+        }
+    }
+    if (startup_ms > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(startup_ms));
+    }
+    serve_packet(handle);
+    return 0;
+}